@@ -0,0 +1,146 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Encodes the same pseudo-random payload with every pattern set and reports
+// how many output bytes ffv1 spends per payload byte, plus encode and decode
+// throughput.
+//
+//   media_storage_bench_patterns [--size <MiB>] [--width <w> --height <h>]
+
+#include "configuration.h"
+#include "dct_common.h"
+#include "encoder.h"
+#include "video_decoder.h"
+#include "video_encoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    struct BenchResult {
+        int64_t frames = 0;
+        uint64_t file_bytes = 0;
+        double encode_seconds = 0.0;
+        double decode_seconds = 0.0;
+        std::size_t packets_decoded = 0;
+    };
+
+    const char *pattern_set_name(const PatternSet set) {
+        switch (set) {
+            case PatternSet::QuantizedCosine: return "quantized";
+            case PatternSet::Step: return "step";
+            default: return "cosine";
+        }
+    }
+
+    std::vector<Packet> make_packets(const std::size_t size_bytes) {
+        Encoder::FileId file_id{};
+        const Encoder encoder(file_id);
+        std::mt19937_64 rng(42);
+
+        std::vector<Packet> packets;
+        const std::size_t chunks = (size_bytes + CHUNK_SIZE_BYTES - 1) / CHUNK_SIZE_BYTES;
+        for (std::size_t i = 0; i < chunks; ++i) {
+            const std::size_t chunk_size = std::min(CHUNK_SIZE_BYTES, size_bytes - i * CHUNK_SIZE_BYTES);
+            std::vector<std::byte> chunk(chunk_size);
+            for (auto &byte: chunk) {
+                byte = static_cast<std::byte>(rng());
+            }
+            auto [chunk_packets, entry] = encoder.encode_chunk(static_cast<uint32_t>(i), chunk, i + 1 == chunks);
+            packets.insert(packets.end(), std::make_move_iterator(chunk_packets.begin()),
+                           std::make_move_iterator(chunk_packets.end()));
+        }
+        return packets;
+    }
+
+    BenchResult run(const std::vector<Packet> &packets, const PatternSet set, const int width, const int height) {
+        using clock = std::chrono::steady_clock;
+        const auto path = (std::filesystem::temp_directory_path() /
+                           (std::string("bench_patterns_") + pattern_set_name(set) + ".mkv")).string();
+        BenchResult result;
+
+        VideoEncoderOptions options;
+        options.pattern_set = set;
+        const auto encode_start = clock::now();
+        {
+            VideoEncoder video_encoder(path, width, height, options);
+            video_encoder.encode_packets(packets);
+            video_encoder.finalize();
+            result.frames = video_encoder.frames_written();
+        }
+        result.encode_seconds = std::chrono::duration<double>(clock::now() - encode_start).count();
+        result.file_bytes = std::filesystem::file_size(path);
+
+        const auto decode_start = clock::now();
+        {
+            VideoDecoder video_decoder(path);
+            while (!video_decoder.is_eof()) {
+                result.packets_decoded += video_decoder.decode_next_frame().size();
+            }
+        }
+        result.decode_seconds = std::chrono::duration<double>(clock::now() - decode_start).count();
+
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return result;
+    }
+}
+
+int main(const int argc, char *argv[]) {
+    std::size_t size_mib = 4;
+    int width = FRAME_WIDTH;
+    int height = FRAME_HEIGHT;
+    for (int i = 1; i < argc; ++i) {
+        if (const std::string arg = argv[i]; arg == "--size" && i + 1 < argc) {
+            size_mib = std::stoull(argv[++i]);
+        } else if (arg == "--width" && i + 1 < argc) {
+            width = std::stoi(argv[++i]);
+        } else if (arg == "--height" && i + 1 < argc) {
+            height = std::stoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: %s [--size <MiB>] [--width <w> --height <h>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const std::size_t payload_bytes = size_mib * 1024 * 1024;
+    const auto packets = make_packets(payload_bytes);
+    const double packet_bytes = static_cast<double>(packets.size() * PACKET_SIZE);
+
+    std::printf("%zu MiB payload, %zu packets, %dx%d frames\n\n", size_mib, packets.size(), width, height);
+    std::printf("%-10s %8s %14s %12s %12s %12s %12s %s\n", "patterns", "frames", "file bytes", "B/payload B",
+                "B/packet B", "enc MiB/s", "dec MiB/s", "decoded");
+
+    for (int set = 0; set < PATTERN_SET_COUNT; ++set) {
+        const auto pattern_set = static_cast<PatternSet>(set);
+        const BenchResult r = run(packets, pattern_set, width, height);
+        const double mib = static_cast<double>(payload_bytes) / (1024.0 * 1024.0);
+        std::printf("%-10s %8lld %14llu %12.2f %12.2f %12.1f %12.1f %zu/%zu\n", pattern_set_name(pattern_set),
+                    static_cast<long long>(r.frames), static_cast<unsigned long long>(r.file_bytes),
+                    static_cast<double>(r.file_bytes) / static_cast<double>(payload_bytes),
+                    static_cast<double>(r.file_bytes) / packet_bytes, mib / r.encode_seconds,
+                    mib / r.decode_seconds, r.packets_decoded, packets.size());
+    }
+    return 0;
+}
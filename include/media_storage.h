@@ -51,6 +51,7 @@ typedef enum {
     MS_ERR_DECODE_FAILED = 5,
     MS_ERR_CRYPTO = 6,
     MS_ERR_INCOMPLETE = 7,
+    MS_ERR_INTEGRITY = 8,
 } ms_status_t;
 
 typedef enum {
@@ -58,6 +59,15 @@ typedef enum {
     MS_HASH_XXHASH32 = 1,
 } ms_hash_algorithm_t;
 
+/* Block design drawn into lossless video frames. Every set decodes the same
+ * way; flatter sets give ffv1 less to code and make smaller files, the cosine
+ * set holds up best if the video is ever re-encoded lossily. */
+typedef enum {
+    MS_PATTERN_COSINE = 0,
+    MS_PATTERN_QUANTIZED_COSINE = 1,
+    MS_PATTERN_STEP = 2,
+} ms_pattern_set_t;
+
 /**
  * Progress callback invoked during encode/decode.
  *
@@ -68,6 +78,16 @@ typedef enum {
  */
 typedef int (*ms_progress_fn)(uint64_t current, uint64_t total, void *user);
 
+/* Hard resource bounds for decoding untrusted input. Packets that would exceed
+ * them are dropped before any decoder state is allocated. 0 keeps the default
+ * (1 MiB chunks, 2^24 chunks, no cap on live decoders or buffered bytes). */
+typedef struct {
+    uint32_t max_chunk_size;
+    uint32_t max_chunk_count;
+    size_t max_live_decoders;
+    size_t max_buffered_bytes;
+} ms_decode_limits_t;
+
 typedef struct {
     const char *input_path;
     const char *output_path;
@@ -80,6 +100,50 @@ typedef struct {
 
     ms_progress_fn progress;
     void *progress_user;
+
+    /* Split the output into several videos of at most this many frames and/or
+     * bytes (0 = no limit). Shards break at chunk boundaries, are encoded
+     * concurrently and are named as ms_shard_path() describes. The byte limit
+     * is planned against uncompressed frames, so shards stay well below it. */
+    uint64_t max_shard_frames;
+    uint64_t max_shard_bytes;
+
+    /* Also store the packet bytes in a raw track next to the video. Local
+     * decodes then only demux that track, while copies re-encoded by a platform
+     * (which drops it) still decode from the pixels. */
+    int raw_packet_track;
+
+    /* Carry more bytes per frame time in a PCM audio track next to the video.
+     * Only for files kept as they are: a platform re-encode of the audio
+     * loses those bytes (the FEC repair symbols in the pixels then have to
+     * make up for them). */
+    int audio_data_track;
+
+    ms_pattern_set_t pattern_set;
+
+    /* Read the video back while it is written: a worker thread decodes each
+     * finished frame through a second codec instance and checks that every
+     * chunk is recoverable and matches what was encoded. The encode then
+     * fails with MS_ERR_INCOMPLETE or MS_ERR_INTEGRITY instead of MS_OK; the
+     * output is kept for inspection. */
+    int verify;
+
+    /* Directory of a content-addressed encode cache (NULL = no cache). An
+     * input whose content and output options match an earlier encode gets
+     * that video as a hard link (or a copy) without encoding anything. With
+     * cache_chunks set, the FEC packets of every chunk are kept as well, so an
+     * input sharing whole 1 MiB chunks with an earlier one only encodes the
+     * chunks that changed. Sharded and encrypted encodes bypass the cache. */
+    const char *cache_dir;
+    int cache_chunks;
+
+    /* ffv1 slices per frame (0 = codec default); see `media_storage tune`. */
+    int ffv1_slices;
+
+    /* Catalog to record the finished encode in (NULL = none): the file's
+     * name, size and digest, its videos and the frame each chunk starts in.
+     * A catalog that cannot be written does not fail the encode. */
+    const char *catalog_path;
 } ms_encode_options_t;
 
 typedef struct {
@@ -91,8 +155,85 @@ typedef struct {
 
     ms_progress_fn progress;
     void *progress_user;
+
+    /* Follow a recording that is still being written: wait for the file to grow
+     * instead of stopping at its current end. Decoding finishes once every chunk
+     * is complete or no new data arrived for follow_idle_timeout_sec (0 = 10s). */
+    int follow;
+    int follow_idle_timeout_sec;
+
+    /* Cap on memory held by partially received chunks (0 = unlimited). Chunks
+     * beyond the budget are spilled to spill_dir (NULL = system temp dir). */
+    size_t memory_budget;
+    const char *spill_dir;
+
+    ms_decode_limits_t limits;
+
+    /* Read these videos one after another instead of input_path, e.g. the
+     * shards of one archive in any order. */
+    const char *const *input_paths;
+    size_t input_count;
+
+    /* Decode from the pixels even if the video carries a raw packet track. */
+    int ignore_raw_packet_track;
+
+    /* FFmpeg decoder threads (0 = by codec: frame threads for H.264, VP9, AV1
+     * and other inter codecs, one slice thread per ffv1 slice). */
+    int decoder_threads;
+    /* Time the decoder against block extraction and FEC decoding over the
+     * first frames and size the extraction threads to leave frame threads the
+     * cores they need. Pays off for lossy renditions downloaded back from a
+     * platform; ffv1 decodes frame by frame and keeps every core. */
+    int adaptive_threads;
 } ms_decode_options_t;
 
+/* Part of an archived file to restore, as offset and length in the original
+ * file. Only the chunks overlapping the range are FEC-decoded; the scan of the
+ * video stops once they are all in hand. */
+typedef struct {
+    const char *input_path;
+    /* Shards of one archive, in any order, instead of input_path. */
+    const char *const *input_paths;
+    size_t input_count;
+
+    const char *password;
+    size_t password_len;
+
+    uint64_t offset;
+    uint64_t length;
+    /* Receives min(length, file size - offset) bytes. */
+    void *buffer;
+
+    int ignore_raw_packet_track;
+
+    /* Catalog holding the archive's frame index (NULL = none). The read then
+     * seeks straight to the first frame of the range and skips shards that
+     * hold none of it, instead of scanning from the start. */
+    const char *catalog_path;
+} ms_read_range_options_t;
+
+/* Budgets of the process-wide cache of decoded, decrypted chunks shared by
+ * ms_decode and ms_read_range (0 = tier off; both off by default). Chunks
+ * evicted from memory move to disk_dir if it is set; those files hold
+ * plaintext and persist until evicted or ms_chunk_cache_clear(). */
+typedef struct {
+    size_t memory_bytes;
+    const char *disk_dir;
+    size_t disk_bytes;
+} ms_chunk_cache_options_t;
+
+typedef struct {
+    uint64_t memory_hits;
+    uint64_t disk_hits;
+    uint64_t misses;
+    uint64_t insertions;
+    uint64_t evictions;
+    uint64_t memory_bytes;
+    uint64_t disk_bytes;
+    /* Hits over lookups, 0 before the first lookup. */
+    double hit_rate;
+} ms_chunk_cache_stats_t;
+
 typedef struct {
     const char *input_path;
     const char *stream_url;
@@ -108,8 +249,57 @@ typedef struct {
 
     ms_progress_fn progress;
     void *progress_user;
+
+    /* Closed-loop repair: listen on this Unix datagram socket for loss reports
+     * from a monitor decoding the published stream (see feedback_socket in
+     * ms_stream_decode_options_t), size the repair of upcoming chunks to the
+     * observed loss and re-send repair for chunks that arrived short. NULL
+     * sends every chunk at max_repair_overhead. */
+    const char *feedback_socket;
+    /* Repair symbols per source symbol (0 = 0.25 and 5.0). The adaptive ratio
+     * starts at the maximum until the first report arrives. */
+    double min_repair_overhead;
+    double max_repair_overhead;
 } ms_stream_encode_options_t;
 
+typedef enum {
+    MS_SINK_FILE = 0,
+    MS_SINK_STREAM = 1,
+} ms_sink_kind_t;
+
+/* One output of a fan-out encode. Every sink carries the same chunks but may
+ * use its own frame size and keep a shorter or longer tail of repair symbols. */
+typedef struct {
+    ms_sink_kind_t kind;
+    /* Output video path for MS_SINK_FILE, RTMP URL for MS_SINK_STREAM. */
+    const char *target;
+
+    /* Frame size, multiples of 8 (0 = 3840x2160). */
+    int width;
+    int height;
+    /* Streams only (0 = 35000). */
+    int bitrate_kbps;
+
+    /* Repair symbols per source symbol, at most 32 (0 = 5.0). */
+    double repair_overhead;
+} ms_sink_t;
+
+typedef struct {
+    const char *input_path;
+
+    const ms_sink_t *sinks;
+    size_t sink_count;
+
+    int encrypt;
+    const char *password;
+    size_t password_len;
+
+    ms_hash_algorithm_t hash_algorithm;
+
+    ms_progress_fn progress;
+    void *progress_user;
+} ms_encode_multi_options_t;
+
 typedef struct {
     const char *stream_url;
     const char *output_path;
@@ -121,16 +311,242 @@ typedef struct {
 
     ms_progress_fn progress;
     void *progress_user;
+
+    ms_decode_limits_t limits;
+
+    /* Act as the monitor of an adaptive stream encode: report the intact
+     * packets received for each chunk to the encoder's feedback socket
+     * (NULL = no reports). */
+    const char *feedback_socket;
 } ms_stream_decode_options_t;
 
+/* One file of a multiplexed stream. */
+typedef struct {
+    const char *input_path;
+
+    int encrypt;
+    const char *password;
+    size_t password_len;
+
+    /* Share of the stream's frame capacity relative to the other jobs while
+     * they all have data queued (0 = 1.0). An idle job's share goes to the
+     * others. */
+    double weight;
+} ms_stream_job_t;
+
+typedef struct {
+    const ms_stream_job_t *jobs;
+    size_t job_count;
+
+    const char *stream_url;
+    ms_hash_algorithm_t hash_algorithm;
+    int bitrate_kbps;
+    int width;
+    int height;
+
+    /* Reports chunks sent over all jobs. */
+    ms_progress_fn progress;
+    void *progress_user;
+} ms_stream_mux_options_t;
+
+typedef struct {
+    const char *stream_url;
+    /* Each file is written to <output_dir>/<file id in hex>.bin. */
+    const char *output_dir;
+
+    /* Password of the encrypted files; they must all share it. */
+    const char *password;
+    size_t password_len;
+
+    int timeout_sec;
+    /* Stop once this many files are complete (0 = at the end of the stream). */
+    size_t expected_files;
+
+    /* Reports frames read, like ms_stream_decode. */
+    ms_progress_fn progress;
+    void *progress_user;
+
+    /* Applied to each file separately. */
+    ms_decode_limits_t limits;
+} ms_stream_demux_options_t;
+
+typedef enum {
+    MS_FRAME_FORMAT_Y4M = 0, /* YUV4MPEG2, read by ffmpeg, x264, SVT-AV1, ... */
+    MS_FRAME_FORMAT_RAW = 1, /* bare planes; both ends must agree on the size */
+} ms_frame_format_t;
+
+typedef enum {
+    MS_PIXEL_FORMAT_GRAY8 = 0,
+    MS_PIXEL_FORMAT_YUV420P = 1, /* mid-grey chroma, for encoders without gray */
+} ms_pixel_format_t;
+
+typedef struct {
+    const char *input_path;
+
+    /* Every output receives every frame: "-" for stdout, or paths such as
+     * named pipes each read by an external encoder process. */
+    const char *const *outputs;
+    size_t output_count;
+
+    ms_frame_format_t format;
+    ms_pixel_format_t pixel_format;
+    /* Frame size, multiples of 8 (0 = 3840x2160). */
+    int width;
+    int height;
+
+    int encrypt;
+    const char *password;
+    size_t password_len;
+
+    ms_hash_algorithm_t hash_algorithm;
+    ms_pattern_set_t pattern_set;
+    /* Repair symbols per source symbol, at most 32 (0 = 5.0). */
+    double repair_overhead;
+
+    ms_progress_fn progress;
+    void *progress_user;
+} ms_export_frames_options_t;
+
+typedef struct {
+    /* Frames from an external decoder: a file, a named pipe or "-" for stdin. */
+    const char *input_path;
+    const char *output_path;
+
+    ms_frame_format_t format;
+    /* Raw frames only; a Y4M header carries its own size and colorspace. */
+    ms_pixel_format_t pixel_format;
+    int width;
+    int height;
+
+    const char *password;
+    size_t password_len;
+
+    /* Reports frames read; the total is unknown and passed as 0. */
+    ms_progress_fn progress;
+    void *progress_user;
+
+    ms_decode_limits_t limits;
+} ms_import_frames_options_t;
+
+typedef struct {
+    const char *input_path;
+
+    /* Number of FEC decode workers; chunks are sharded across them. 0 picks
+     * one per two hardware threads (at most 8). */
+    int threads;
+
+    ms_progress_fn progress;
+    void *progress_user;
+
+    ms_decode_limits_t limits;
+} ms_verify_options_t;
+
+/* Spare-symbol histogram buckets: the ratio of symbols received after a chunk
+ * decoded to its source symbol count k, split at 0.05, 0.1, 0.25, 0.5, 1, 2
+ * and 4. Bucket 0 holds chunks that had (almost) nothing to spare. */
+#define MS_VERIFY_MARGIN_BUCKETS 8
+
+typedef struct {
+    uint64_t total_chunks;
+    uint64_t recoverable_chunks;
+    /* Recoverable chunks whose SHA-256 matched the manifest. */
+    uint64_t verified_chunks;
+    uint64_t hash_mismatches;
+    /* 1 if the archive carried a complete manifest with chunk digests. */
+    int has_manifest;
+    /* 1 if the archive carried a whole-file digest and the decoded chunks
+     * reproduce it. */
+    int file_digest_verified;
+
+    uint64_t total_packets;
+    uint64_t total_frames;
+
+    uint64_t min_spare_symbols;
+    uint64_t min_spare_chunk;
+    double mean_spare_ratio;
+    uint64_t margin_histogram[MS_VERIFY_MARGIN_BUCKETS];
+} ms_verify_result_t;
+
+typedef struct {
+    const char *input_path;
+    const char *output_path;
+
+    ms_progress_fn progress;
+    void *progress_user;
+
+    ms_decode_limits_t limits;
+} ms_refresh_options_t;
+
+/* What an archive holds, as far as its first frames tell. Archives written
+ * before the manifest existed only yield the per-packet fields; chunk_count
+ * and file_size are then 0. */
+typedef struct {
+    uint8_t file_id[16];
+    int encrypted;
+    ms_hash_algorithm_t hash_algorithm;
+    uint64_t file_size;
+    uint64_t chunk_count;
+    uint32_t chunk_size;
+    uint32_t symbol_size;
+    uint32_t frame_width;
+    uint32_t frame_height;
+    /* -1 if the container does not say. */
+    int64_t total_frames;
+    int has_manifest;
+    /* Which part of a sharded archive this video is; shard_count is 0 for an
+     * archive written as a single video. */
+    uint32_t shard_index;
+    uint32_t shard_count;
+    uint64_t shard_first_chunk;
+    uint64_t shard_chunk_count;
+    /* 1 if the video carries a raw packet track (see raw_packet_track). */
+    int has_raw_packet_track;
+    /* 1 if the video carries an audio data track (see audio_data_track). */
+    int has_audio_data_track;
+} ms_info_t;
+
 typedef struct {
     uint64_t input_size;
     uint64_t output_size;
     uint64_t total_chunks;
     uint64_t total_packets;
     uint64_t total_frames;
+    /* Number of videos written by a sharded encode, 0 otherwise. */
+    uint64_t total_shards;
+    /* Merkle root over the SHA-256 of every chunk's stored bytes (ciphertext
+     * when encrypted), built from digests taken while chunks are encoded or
+     * decoded. Decoding fails with MS_ERR_INTEGRITY before writing anything if
+     * it disagrees with the root in the archive manifest. */
+    uint8_t file_digest[32];
+    int has_file_digest;
+    /* 1 if a decode checked file_digest against the archive's FileDigest
+     * segment. 0 for sharded archives, which carry none, and for archives
+     * whose FileDigest segment could not be recovered. */
+    int file_digest_verified;
+    /* Chunks the verifier of an encode with verify set read back intact. */
+    uint64_t verified_chunks;
+    /* 1 if the encode cache supplied the whole video; otherwise the number of
+     * chunks whose packets came from the cache. A cached video is reused as
+     * is, so it keeps the file id of the encode that produced it. */
+    int cache_hit;
+    uint64_t cached_chunks;
+    /* File id of the archive, which tells the files of a multiplexed stream
+     * apart. Set by ms_encode of an unsharded archive, ms_stream_encode,
+     * ms_stream_encode_mux and ms_stream_decode_demux; all zero otherwise. */
+    uint8_t file_id[16];
+    /* Stream encodes: repair ratio the last chunk was sent with, and packets
+     * re-sent for chunks a feedback monitor reported short. */
+    double repair_overhead;
+    uint64_t resent_packets;
 } ms_result_t;
 
+/* Outcome of one file found in a multiplexed stream. */
+typedef struct {
+    ms_status_t status;
+    /* result.file_id identifies the file and names its output. */
+    ms_result_t result;
+} ms_stream_demux_file_t;
+
 /**
  * Encode a file into a lossless video.
  *
@@ -140,15 +556,193 @@ typedef struct {
  */
 MS_API ms_status_t ms_encode(const ms_encode_options_t *options, ms_result_t *result);
 
+/**
+ * Build the file name of one shard of a sharded encode: "<stem>.partNNN<ext>"
+ * next to output_path, e.g. "backup.part007.mkv" for shard 7 of "backup.mkv".
+ *
+ * @param output_path  The output_path given to ms_encode.
+ * @param shard_index  Zero-based shard index.
+ * @param buffer       Receives the NUL-terminated path.
+ * @param buffer_size  Size of buffer in bytes.
+ * @return             MS_OK, or MS_ERR_INVALID_ARGS if the path does not fit.
+ */
+MS_API ms_status_t ms_shard_path(const char *output_path, uint32_t shard_index, char *buffer, size_t buffer_size);
+
 /**
  * Decode a video back into the original file.
  *
+ * Each chunk is hashed as it decodes; those hashes must match the archive's
+ * chunk table, and the whole-file digest folded from them the archive's
+ * FileDigest segment, before the output is written. Reading goes on past the
+ * last chunk until that segment arrives. With the chunk cache enabled, chunks
+ * it holds are not decoded again, the chunk table standing in for their
+ * hashes, and the restored ones are added to it.
+ *
  * @param options  Decoding parameters (input/output paths, password, etc.).
  * @param result   Optional pointer to receive statistics about the operation.
- * @return         MS_OK on success, or an error code.
+ * @return         MS_OK on success, MS_ERR_INTEGRITY if a chunk or the
+ *                 whole-file digest disagrees with the manifest, or another
+ *                 error code.
  */
 MS_API ms_status_t ms_decode(const ms_decode_options_t *options, ms_result_t *result);
 
+/**
+ * Restore a byte range of an archived file into a caller buffer.
+ *
+ * Chunks are served from the chunk cache when possible and added to it when
+ * decoded. Range reads trust FEC and packet checksums (and the cipher for
+ * encrypted archives); the whole-file digest is only checked by ms_decode.
+ *
+ * @param options     Inputs, range and destination buffer.
+ * @param bytes_read  Optional pointer receiving the number of bytes written.
+ * @return            MS_OK on success, MS_ERR_INCOMPLETE if a chunk in the
+ *                    range could not be recovered, or another error code.
+ */
+MS_API ms_status_t ms_read_range(const ms_read_range_options_t *options, uint64_t *bytes_read);
+
+/**
+ * Set the budgets of the decoded chunk cache, shrinking it if needed.
+ *
+ * @return  MS_OK, or MS_ERR_IO if disk_dir cannot be created.
+ */
+MS_API ms_status_t ms_chunk_cache_configure(const ms_chunk_cache_options_t *options);
+
+/** Hit and size counters of the decoded chunk cache. */
+MS_API ms_status_t ms_chunk_cache_stats(ms_chunk_cache_stats_t *stats);
+
+/** Drop every cached chunk, including the disk tier's files. */
+MS_API void ms_chunk_cache_clear(void);
+
+/**
+ * Cap the worker threads of calls made from the calling thread (0 = one per
+ * core, the default). Lets a host running several jobs side by side split the
+ * cores between them instead of oversubscribing.
+ */
+MS_API void ms_set_thread_count(int threads);
+
+/**
+ * Check that an encoded video decodes completely without writing any output.
+ *
+ * Every chunk is FEC-decoded and hashed, then compared with the digest in the
+ * archive manifest; decoded data is discarded immediately. Encrypted archives
+ * verify without a password because the manifest hashes the ciphertext.
+ *
+ * @param options  Verification parameters (input path, worker count, etc.).
+ * @param result   Optional pointer to receive per-chunk statistics.
+ * @return         MS_OK if every chunk is recoverable and matches the manifest,
+ *                 MS_ERR_INCOMPLETE if chunks are missing, MS_ERR_INTEGRITY on
+ *                 a digest mismatch, or another error code.
+ */
+MS_API ms_status_t ms_verify(const ms_verify_options_t *options, ms_verify_result_t *result);
+
+/**
+ * Read an archive's metadata without decoding it.
+ *
+ * Only the first few frames are decoded, which is where the manifest's
+ * FileInfo record lives, so this returns quickly regardless of file size.
+ *
+ * @param input_path  Path of the encoded video.
+ * @param info        Receives the archive metadata.
+ * @return            MS_OK on success, MS_ERR_DECODE_FAILED if no valid packet
+ *                    was found, or another error code.
+ */
+MS_API ms_status_t ms_probe(const char *input_path, ms_info_t *info);
+
+/* One archived file in a catalog. */
+typedef struct {
+    uint8_t file_id[16];
+    /* Original file name, truncated to fit. */
+    char name[256];
+    uint64_t file_size;
+    uint64_t chunk_count;
+    int encrypted;
+    int has_file_digest;
+    uint8_t file_digest[32];
+    /* Videos holding the archive, one per shard; see ms_catalog_video_path(). */
+    uint32_t video_count;
+    /* 1 if range reads can seek straight to the chunks they need. */
+    int has_frame_index;
+    /* Unix time of the last update. */
+    int64_t recorded;
+} ms_catalog_entry_t;
+
+/*
+ * A catalog is a local index of encoded archives, so a file can be found and
+ * restored without probing every video. ms_encode records into one when
+ * catalog_path is set; ms_catalog_add records videos encoded elsewhere. Every
+ * ms_catalog_* function takes the catalog's path, or NULL for the default
+ * location.
+ */
+
+/**
+ * Write the default catalog location into buffer: $MEDIA_STORAGE_CATALOG, or
+ * "media_storage/catalog" under $XDG_DATA_HOME (~/.local/share, or
+ * %LOCALAPPDATA% on Windows).
+ *
+ * @return  MS_ERR_INVALID_ARGS if the buffer is too small or no location is known.
+ */
+MS_API ms_status_t ms_catalog_default_path(char *buffer, size_t buffer_size);
+
+/**
+ * Probe a video and record it, merged with what the catalog already knows
+ * about its archive (e.g. the other shards, or the frame index of an earlier
+ * encode).
+ *
+ * @param info  Optional pointer to receive what ms_probe() found.
+ */
+MS_API ms_status_t ms_catalog_add(const char *catalog_path, const char *video_path, ms_info_t *info);
+
+/**
+ * Look up archives by original file name.
+ *
+ * @param filter    Substring of the name to match; NULL or "" for every archive.
+ * @param entries   Receives up to capacity matches, ordered by name (may be
+ *                  NULL if capacity is 0).
+ * @param count     Receives the total number of matches.
+ */
+MS_API ms_status_t ms_catalog_search(const char *catalog_path, const char *filter, ms_catalog_entry_t *entries,
+                                     size_t capacity, size_t *count);
+
+/** Look up one archive; MS_ERR_FILE_NOT_FOUND if the catalog does not know it. */
+MS_API ms_status_t ms_catalog_find(const char *catalog_path, const uint8_t file_id[16], ms_catalog_entry_t *entry);
+
+/**
+ * Path of one of an archive's videos, index 0 to video_count - 1.
+ *
+ * @return  MS_ERR_FILE_NOT_FOUND for an unknown archive or index,
+ *          MS_ERR_INVALID_ARGS if the buffer is too small.
+ */
+MS_API ms_status_t ms_catalog_video_path(const char *catalog_path, const uint8_t file_id[16], uint32_t index,
+                                         char *buffer, size_t buffer_size);
+
+/** Forget an archive; MS_ERR_FILE_NOT_FOUND if the catalog does not know it. */
+MS_API ms_status_t ms_catalog_remove(const char *catalog_path, const uint8_t file_id[16]);
+
+/**
+ * Forget archives none of whose videos exist any more, and compact the catalog
+ * file.
+ *
+ * @param removed  Optional pointer to receive the number of archives dropped.
+ */
+MS_API ms_status_t ms_catalog_prune(const char *catalog_path, size_t *removed);
+
+/**
+ * Rewrite a degraded video as a healthy one without decoding it to a file.
+ *
+ * Each chunk is recovered from whatever symbols survived and its decoder is
+ * switched straight into an encoder that emits a full fresh set of source and
+ * repair symbols into the new video. Chunk data never leaves memory and
+ * encrypted chunks are re-encoded as ciphertext, so no password is needed.
+ *
+ * @param options  Refresh parameters (input and output video paths, etc.).
+ * @param result   Optional pointer to receive statistics about the new video.
+ * @return         MS_OK on success, MS_ERR_INCOMPLETE if chunks could not be
+ *                 recovered, MS_ERR_INTEGRITY if a chunk disagrees with the
+ *                 manifest, or another error code. The output is removed on
+ *                 failure.
+ */
+MS_API ms_status_t ms_refresh(const ms_refresh_options_t *options, ms_result_t *result);
+
 /**
  * Encode a file and stream it via RTMP to Twitch/YouTube/etc.
  *
@@ -158,6 +752,20 @@ MS_API ms_status_t ms_decode(const ms_decode_options_t *options, ms_result_t *re
  */
 MS_API ms_status_t ms_stream_encode(const ms_stream_encode_options_t *options, ms_result_t *result);
 
+/**
+ * Encode a file once and write it to several videos and/or streams.
+ *
+ * The input is read, encrypted and FEC-encoded a single time at the largest
+ * repair overhead of any sink; each sink then takes the source symbols plus
+ * its own share of the repair symbols of every chunk.
+ *
+ * @param options  Fan-out parameters (input path, sinks, encryption, etc.).
+ * @param results  Optional array of options->sink_count entries receiving
+ *                 per-sink statistics (output_size is 0 for streams).
+ * @return         MS_OK on success, or an error code.
+ */
+MS_API ms_status_t ms_encode_multi(const ms_encode_multi_options_t *options, ms_result_t *results);
+
 /**
  * Decode a live stream back into the original file.
  *
@@ -167,6 +775,61 @@ MS_API ms_status_t ms_stream_encode(const ms_stream_encode_options_t *options, m
  */
 MS_API ms_status_t ms_stream_decode(const ms_stream_decode_options_t *options, ms_result_t *result);
 
+/**
+ * Encode several files into one live stream at the same time.
+ *
+ * Every job is read and FEC-encoded on its own thread, with the cores split
+ * between them, and their packets are interleaved into the stream's frames by
+ * weighted fair sharing. Each file keeps its own file id, manifest and
+ * encryption, so ms_stream_decode_demux() recovers them side by side.
+ *
+ * @param options  Jobs and stream parameters.
+ * @param results  Optional array of options->job_count entries receiving
+ *                 per-job statistics; total_frames is the whole stream's.
+ * @return         MS_OK on success, or an error code. A failing job stops the
+ *                 stream for all of them.
+ */
+MS_API ms_status_t ms_stream_encode_mux(const ms_stream_mux_options_t *options, ms_result_t *results);
+
+/**
+ * Decode every file of a live stream, each into its own output.
+ *
+ * Packets are routed by file id to one decoder per file, each on its own
+ * thread, and a file is written as soon as all of its chunks are in.
+ *
+ * @param files       Receives up to capacity per-file outcomes, in the order
+ *                    the files first appeared (may be NULL if capacity is 0).
+ * @param file_count  Receives the number of files found.
+ * @return            MS_OK if every file found was written, MS_ERR_INCOMPLETE
+ *                    if some were not, or another error code.
+ */
+MS_API ms_status_t ms_stream_decode_demux(const ms_stream_demux_options_t *options, ms_stream_demux_file_t *files,
+                                          size_t capacity, size_t *file_count);
+
+/**
+ * Encode a file into uncompressed frames on a pipe instead of a video.
+ *
+ * The frames carry exactly the pixels ms_encode() would hand to ffv1, so any
+ * external encoder reading Y4M or raw video can compress them, e.g.
+ * `ffmpeg -i - -c:v libx264 out.mp4` reading stdout.
+ *
+ * @param options  Export parameters (input path, outputs, frame format, etc.).
+ * @param result   Optional pointer to receive statistics; output_size is 0.
+ * @return         MS_OK on success, or an error code.
+ */
+MS_API ms_status_t ms_export_frames(const ms_export_frames_options_t *options, ms_result_t *result);
+
+/**
+ * Decode uncompressed frames, e.g. piped from an external decoder, back into
+ * the original file.
+ *
+ * @param options  Import parameters (frame input, output path, etc.).
+ * @param result   Optional pointer to receive statistics about the operation.
+ * @return         MS_OK on success, MS_ERR_INCOMPLETE if chunks could not be
+ *                 recovered, or another error code.
+ */
+MS_API ms_status_t ms_import_frames(const ms_import_frames_options_t *options, ms_result_t *result);
+
 /**
  * Return a human-readable string for the given status code.
  * The returned pointer is valid for the lifetime of the program.
@@ -0,0 +1,226 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "auto_tune.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "media_storage.h"
+
+namespace {
+    struct Trial {
+        double encode_s = 0.0;
+        double decode_s = 0.0;
+    };
+
+    struct TuneRun {
+        const TuneOptions &options;
+        std::ostream &log;
+        std::filesystem::path sample;
+        std::filesystem::path video;
+        std::filesystem::path decoded;
+        std::vector<char> expected;
+    };
+}
+
+static ms_pattern_set_t to_pattern_set(const std::string &patterns) {
+    if (patterns == "quantized") {
+        return MS_PATTERN_QUANTIZED_COSINE;
+    }
+    return patterns == "step" ? MS_PATTERN_STEP : MS_PATTERN_COSINE;
+}
+
+static std::vector<char> read_all(const std::filesystem::path &path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+// Random bytes stand in for the compressed or encrypted files that are
+// typically stored; a compressible sample would flatter the codec.
+static std::vector<char> write_sample(const std::filesystem::path &path, const std::size_t bytes) {
+    std::vector<char> data(bytes);
+    std::mt19937_64 rng(0x6D656469615F7374ull);
+    for (std::size_t i = 0; i < bytes; i += sizeof(uint64_t)) {
+        const uint64_t word = rng();
+        std::memcpy(data.data() + i, &word, std::min(sizeof(word), bytes - i));
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!out) {
+        throw std::runtime_error("cannot write tuning sample " + path.string());
+    }
+    return data;
+}
+
+static double seconds_since(const std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// One encode and decode of the sample, or nullopt if either fails or the
+// decode does not match.
+static std::optional<Trial> run_trial(const TuneRun &run, const HostProfile &profile) {
+    ms_set_thread_count(profile.threads);
+
+    const std::string sample = run.sample.string();
+    const std::string video = run.video.string();
+    const std::string decoded = run.decoded.string();
+
+    ms_encode_options_t encode{};
+    encode.input_path = sample.c_str();
+    encode.output_path = video.c_str();
+    encode.hash_algorithm = profile.hash == "xxhash" ? MS_HASH_XXHASH32 : MS_HASH_CRC32;
+    encode.pattern_set = to_pattern_set(profile.patterns);
+    encode.ffv1_slices = profile.ffv1_slices;
+
+    Trial trial;
+    auto start = std::chrono::steady_clock::now();
+    if (ms_encode(&encode, nullptr) != MS_OK) {
+        return std::nullopt;
+    }
+    trial.encode_s = seconds_since(start);
+
+    const char *inputs[] = {video.c_str()};
+    ms_decode_options_t decode{};
+    decode.input_paths = inputs;
+    decode.input_count = 1;
+    decode.output_path = decoded.c_str();
+
+    start = std::chrono::steady_clock::now();
+    if (ms_decode(&decode, nullptr) != MS_OK) {
+        return std::nullopt;
+    }
+    trial.decode_s = seconds_since(start);
+
+    if (read_all(run.decoded) != run.expected) {
+        return std::nullopt;
+    }
+    return trial;
+}
+
+// Best of the configured repeats; nullopt as soon as one run fails.
+static std::optional<Trial> measure(const TuneRun &run, const HostProfile &profile) {
+    std::optional<Trial> best;
+    for (int i = 0; i < std::max(1, run.options.repeats); ++i) {
+        const auto trial = run_trial(run, profile);
+        if (!trial) {
+            return std::nullopt;
+        }
+        if (!best || trial->encode_s + trial->decode_s < best->encode_s + best->decode_s) {
+            best = trial;
+        }
+    }
+    return best;
+}
+
+static void log_trial(const TuneRun &run, const HostProfile &profile, const std::optional<Trial> &trial) {
+    const double mib = static_cast<double>(run.expected.size()) / (1024.0 * 1024.0);
+    run.log << "  threads=" << std::setw(3) << std::left << profile.threads
+            << " slices=" << std::setw(3) << profile.ffv1_slices
+            << " patterns=" << std::setw(10) << profile.patterns
+            << " hash=" << std::setw(7) << profile.hash << std::right;
+    if (trial) {
+        run.log << std::fixed << std::setprecision(1) << " encode " << mib / trial->encode_s << " MiB/s, decode "
+                << mib / trial->decode_s << " MiB/s\n";
+    } else {
+        run.log << " failed\n";
+    }
+}
+
+HostProfile run_tune(const TuneOptions &options, std::ostream &log) {
+    if (options.target != "local" && options.target != "platform") {
+        throw std::invalid_argument("unknown tuning target " + options.target);
+    }
+
+    TuneRun run{options, log, options.work_dir / "tune_sample.bin", options.work_dir / "tune_video.mkv",
+                options.work_dir / "tune_decoded.bin", {}};
+    std::filesystem::create_directories(options.work_dir);
+    run.expected = write_sample(run.sample, std::max<std::size_t>(1, options.sample_mib) * 1024 * 1024);
+
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> thread_counts{cores};
+    for (int threads = cores / 2; threads >= 1 && thread_counts.size() < 3; threads /= 2) {
+        thread_counts.push_back(threads);
+    }
+
+    HostProfile best;
+    best.target = options.target;
+    best.threads = cores;
+    std::optional<Trial> best_trial;
+
+    // Keeps candidate if it round-trips faster than the best so far.
+    const auto consider = [&](const HostProfile &candidate) {
+        if (!host_profile_meets_target(candidate)) {
+            return;
+        }
+        const auto trial = measure(run, candidate);
+        log_trial(run, candidate, trial);
+        if (trial && (!best_trial ||
+                      trial->encode_s + trial->decode_s < best_trial->encode_s + best_trial->decode_s)) {
+            best = candidate;
+            best_trial = trial;
+        }
+    };
+
+    consider(best);
+    for (const int threads: thread_counts) {
+        if (threads != best.threads) {
+            HostProfile candidate = best;
+            candidate.threads = threads;
+            consider(candidate);
+        }
+    }
+    for (const int slices: {4, 16, 24}) {
+        HostProfile candidate = best;
+        candidate.ffv1_slices = slices;
+        consider(candidate);
+    }
+    for (const char *patterns: {"quantized", "step"}) {
+        HostProfile candidate = best;
+        candidate.patterns = patterns;
+        consider(candidate);
+    }
+    {
+        HostProfile candidate = best;
+        candidate.hash = "xxhash";
+        consider(candidate);
+    }
+
+    ms_set_thread_count(0);
+    std::error_code ec;
+    std::filesystem::remove(run.sample, ec);
+    std::filesystem::remove(run.video, ec);
+    std::filesystem::remove(run.decoded, ec);
+
+    if (!best_trial) {
+        throw std::runtime_error("no setting encoded and decoded the sample correctly");
+    }
+    const double mib = static_cast<double>(run.expected.size()) / (1024.0 * 1024.0);
+    best.encode_mib_s = mib / best_trial->encode_s;
+    best.decode_mib_s = mib / best_trial->decode_s;
+    return best;
+}
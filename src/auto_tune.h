@@ -0,0 +1,44 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <ostream>
+#include <string>
+
+#include "host_profile.h"
+
+struct TuneOptions {
+    std::string target = "local";     // "local" or "platform", see HostProfile
+    std::size_t sample_mib = 8;       // synthetic input per trial
+    int repeats = 2;                  // best of this many runs per setting
+    std::filesystem::path work_dir;   // scratch space for the trial files
+};
+
+// Backend of `media_storage tune`: encodes and decodes a random sample with
+// ms_encode/ms_decode under each candidate setting and keeps the one with the
+// highest combined throughput. The grid is walked one axis at a time (threads,
+// ffv1 slices, pattern set, checksum), each axis starting from the best of the
+// ones before, which needs a dozen trials instead of the full product. A
+// setting only counts if the decode reproduces the sample byte for byte and
+// the profile meets its target. Progress goes to log. Throws
+// std::runtime_error if no setting round-trips.
+[[nodiscard]] HostProfile run_tune(const TuneOptions &options, std::ostream &log);
@@ -0,0 +1,345 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "catalog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+
+static constexpr uint32_t CATALOG_MAGIC = 0x4743534D; // "MSCG"
+static constexpr uint8_t CATALOG_VERSION = 1;
+static constexpr std::size_t CATALOG_HEADER_SIZE = 5;
+static constexpr std::size_t RECORD_HEADER_SIZE = 8;
+static constexpr uint8_t RECORD_PUT = 1;
+static constexpr uint8_t RECORD_REMOVE = 2;
+static constexpr uint8_t FLAG_ENCRYPTED = 0x01;
+static constexpr uint8_t FLAG_HAS_DIGEST = 0x02;
+
+static void append_string(std::vector<std::byte> &out, const std::string &text) {
+    append_value(out, static_cast<uint32_t>(text.size()));
+    const auto *bytes = reinterpret_cast<const std::byte *>(text.data());
+    out.insert(out.end(), bytes, bytes + text.size());
+}
+
+// Bounds-checked reads from one record payload.
+class RecordReader {
+public:
+    explicit RecordReader(const std::span<const std::byte> data) : data_(data) {
+    }
+
+    template<typename T>
+    bool read(T &value) {
+        if (data_.size() - pos_ < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool read_string(std::string &text) {
+        uint32_t size = 0;
+        if (!read(size) || data_.size() - pos_ < size) {
+            return false;
+        }
+        text.assign(reinterpret_cast<const char *>(data_.data() + pos_), size);
+        pos_ += size;
+        return true;
+    }
+
+    [[nodiscard]] std::size_t remaining() const { return data_.size() - pos_; }
+
+private:
+    std::span<const std::byte> data_;
+    std::size_t pos_ = 0;
+};
+
+static std::vector<std::byte> make_record(const std::vector<std::byte> &payload) {
+    std::vector<std::byte> record;
+    record.reserve(RECORD_HEADER_SIZE + payload.size());
+    append_value(record, static_cast<uint32_t>(payload.size()));
+    append_value(record, crc32c(payload));
+    record.insert(record.end(), payload.begin(), payload.end());
+    return record;
+}
+
+static std::vector<std::byte> put_record(const CatalogEntry &entry) {
+    std::vector<std::byte> payload;
+    payload.reserve(128 + entry.name.size() + entry.chunk_frames.size() * sizeof(uint32_t));
+    append_value(payload, RECORD_PUT);
+    payload.insert(payload.end(), entry.file_id.begin(), entry.file_id.end());
+    append_value(payload, static_cast<uint8_t>((entry.encrypted ? FLAG_ENCRYPTED : 0) |
+                                               (entry.has_digest ? FLAG_HAS_DIGEST : 0)));
+    append_value(payload, entry.file_size);
+    append_value(payload, entry.chunk_count);
+    append_value(payload, entry.chunk_size);
+    append_value(payload, entry.shard_count);
+    payload.insert(payload.end(), entry.digest.bytes.begin(), entry.digest.bytes.end());
+    append_value(payload, entry.recorded);
+    append_string(payload, entry.name);
+    append_value(payload, static_cast<uint32_t>(entry.videos.size()));
+    for (const CatalogVideo &video: entry.videos) {
+        append_value(payload, video.shard_index);
+        append_value(payload, video.first_chunk);
+        append_value(payload, video.chunk_count);
+        append_string(payload, video.path);
+    }
+    append_value(payload, static_cast<uint32_t>(entry.chunk_frames.size()));
+    const auto *frames = reinterpret_cast<const std::byte *>(entry.chunk_frames.data());
+    payload.insert(payload.end(), frames, frames + entry.chunk_frames.size() * sizeof(uint32_t));
+    return make_record(payload);
+}
+
+static std::vector<std::byte> remove_record(const std::array<std::byte, 16> &file_id) {
+    std::vector<std::byte> payload;
+    append_value(payload, RECORD_REMOVE);
+    payload.insert(payload.end(), file_id.begin(), file_id.end());
+    return make_record(payload);
+}
+
+static bool read_entry(RecordReader &reader, CatalogEntry &entry) {
+    uint8_t flags = 0;
+    uint32_t video_count = 0;
+    if (!reader.read(entry.file_id) || !reader.read(flags) || !reader.read(entry.file_size) ||
+        !reader.read(entry.chunk_count) || !reader.read(entry.chunk_size) || !reader.read(entry.shard_count) ||
+        !reader.read(entry.digest.bytes) || !reader.read(entry.recorded) || !reader.read_string(entry.name) ||
+        !reader.read(video_count)) {
+        return false;
+    }
+    entry.encrypted = (flags & FLAG_ENCRYPTED) != 0;
+    entry.has_digest = (flags & FLAG_HAS_DIGEST) != 0;
+    for (uint32_t i = 0; i < video_count; ++i) {
+        CatalogVideo video;
+        if (!reader.read(video.shard_index) || !reader.read(video.first_chunk) || !reader.read(video.chunk_count) ||
+            !reader.read_string(video.path)) {
+            return false;
+        }
+        entry.videos.push_back(std::move(video));
+    }
+    uint32_t frame_count = 0;
+    if (!reader.read(frame_count) || reader.remaining() != frame_count * sizeof(uint32_t)) {
+        return false;
+    }
+    entry.chunk_frames.resize(frame_count);
+    for (uint32_t &frame: entry.chunk_frames) {
+        (void) reader.read(frame);
+    }
+    return true;
+}
+
+static std::vector<std::byte> catalog_header() {
+    std::vector<std::byte> header;
+    append_value(header, CATALOG_MAGIC);
+    append_value(header, CATALOG_VERSION);
+    return header;
+}
+
+static void write_file(const std::filesystem::path &path, const std::span<const std::byte> data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!out) {
+        throw std::runtime_error("cannot write catalog " + path.string());
+    }
+}
+
+const CatalogVideo *CatalogEntry::video_for_chunk(const uint32_t chunk_index) const {
+    for (const CatalogVideo &video: videos) {
+        if (chunk_index >= video.first_chunk && chunk_index - video.first_chunk < video.chunk_count) {
+            return &video;
+        }
+    }
+    return nullptr;
+}
+
+Catalog::Catalog(std::filesystem::path path) : path_(std::move(path)) {
+    std::error_code ec;
+    if (!std::filesystem::exists(path_, ec)) {
+        if (path_.has_parent_path()) {
+            std::filesystem::create_directories(path_.parent_path(), ec);
+        }
+        write_file(path_, catalog_header());
+    }
+    load();
+}
+
+std::filesystem::path Catalog::default_path() {
+    if (const char *path = std::getenv("MEDIA_STORAGE_CATALOG"); path && *path) {
+        return path;
+    }
+    std::filesystem::path data;
+    if (const char *xdg = std::getenv("XDG_DATA_HOME"); xdg && *xdg) {
+        data = xdg;
+    } else if (const char *home = std::getenv("HOME"); home && *home) {
+        data = std::filesystem::path(home) / ".local" / "share";
+    } else if (const char *local = std::getenv("LOCALAPPDATA"); local && *local) {
+        data = local;
+    } else {
+        return {};
+    }
+    return data / "media_storage" / "catalog";
+}
+
+void Catalog::load() {
+    std::ifstream in(path_, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::runtime_error("cannot read catalog " + path_.string());
+    }
+    std::vector<std::byte> data(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()))) {
+        throw std::runtime_error("cannot read catalog " + path_.string());
+    }
+    in.close();
+
+    uint32_t magic = 0;
+    if (data.size() < CATALOG_HEADER_SIZE || (std::memcpy(&magic, data.data(), sizeof(magic)), magic) !=
+        CATALOG_MAGIC || static_cast<uint8_t>(data[4]) != CATALOG_VERSION) {
+        throw std::runtime_error("not a catalog: " + path_.string());
+    }
+
+    // A record that fails its size or checksum is damage (a torn append), and
+    // the scan moves on a byte at a time until a record checks out again, so
+    // appends written after the damage are still found. The damage stays in
+    // the file until compact(); cutting it off here could race an append.
+    entries_.clear();
+    std::size_t pos = CATALOG_HEADER_SIZE;
+    while (data.size() - pos >= RECORD_HEADER_SIZE) {
+        uint32_t size = 0;
+        uint32_t crc = 0;
+        std::memcpy(&size, data.data() + pos, sizeof(size));
+        std::memcpy(&crc, data.data() + pos + 4, sizeof(crc));
+        if (size == 0 || data.size() - pos - RECORD_HEADER_SIZE < size) {
+            ++pos;
+            continue;
+        }
+        const std::span<const std::byte> payload(data.data() + pos + RECORD_HEADER_SIZE, size);
+        if (crc32c(payload) != crc) {
+            ++pos;
+            continue;
+        }
+        pos += RECORD_HEADER_SIZE + size;
+
+        // An intact record of an unknown type or layout is skipped whole.
+        RecordReader reader(payload);
+        uint8_t type = 0;
+        (void) reader.read(type);
+        if (type == RECORD_PUT) {
+            CatalogEntry entry;
+            if (read_entry(reader, entry)) {
+                const auto file_id = entry.file_id;
+                entries_[file_id] = std::move(entry);
+            }
+        } else if (type == RECORD_REMOVE) {
+            std::array<std::byte, 16> file_id{};
+            if (reader.read(file_id)) {
+                entries_.erase(file_id);
+            }
+        }
+    }
+}
+
+void Catalog::append(const std::vector<std::byte> &record) {
+    std::ofstream out(path_, std::ios::binary | std::ios::app);
+    out.write(reinterpret_cast<const char *>(record.data()), static_cast<std::streamsize>(record.size()));
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("cannot append to catalog " + path_.string());
+    }
+}
+
+std::optional<CatalogEntry> Catalog::find(const std::array<std::byte, 16> &file_id) const {
+    if (const auto it = entries_.find(file_id); it != entries_.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::vector<CatalogEntry> Catalog::search(const std::string_view filter) const {
+    std::vector<CatalogEntry> found;
+    for (const auto &[file_id, entry]: entries_) {
+        if (entry.name.find(filter) != std::string::npos) {
+            found.push_back(entry);
+        }
+    }
+    std::ranges::stable_sort(found, {}, &CatalogEntry::name);
+    return found;
+}
+
+void Catalog::merge(const CatalogEntry &update) {
+    CatalogEntry entry = update;
+    if (const auto it = entries_.find(update.file_id); it != entries_.end()) {
+        const CatalogEntry &stored = it->second;
+        if (entry.name.empty()) {
+            entry.name = stored.name;
+        }
+        if (!entry.has_digest && stored.has_digest) {
+            entry.has_digest = true;
+            entry.digest = stored.digest;
+        }
+        if (entry.chunk_frames.empty()) {
+            entry.chunk_frames = stored.chunk_frames;
+        }
+        for (const CatalogVideo &video: stored.videos) {
+            if (std::ranges::none_of(entry.videos, [&](const CatalogVideo &v) {
+                return v.shard_index == video.shard_index;
+            })) {
+                entry.videos.push_back(video);
+            }
+        }
+    }
+    std::ranges::sort(entry.videos, {}, &CatalogVideo::shard_index);
+    if (entry.recorded == 0) {
+        entry.recorded = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    append(put_record(entry));
+    entries_[entry.file_id] = std::move(entry);
+}
+
+bool Catalog::remove(const std::array<std::byte, 16> &file_id) {
+    if (!entries_.contains(file_id)) {
+        return false;
+    }
+    append(remove_record(file_id));
+    entries_.erase(file_id);
+    return true;
+}
+
+void Catalog::compact() {
+    load();
+    std::vector<std::byte> data = catalog_header();
+    for (const auto &[file_id, entry]: entries_) {
+        const std::vector<std::byte> record = put_record(entry);
+        data.insert(data.end(), record.begin(), record.end());
+    }
+
+    std::filesystem::path tmp = path_;
+    tmp += ".tmp";
+    write_file(tmp, data);
+    std::error_code ec;
+    std::filesystem::rename(tmp, path_, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        throw std::runtime_error("cannot rewrite catalog " + path_.string());
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "integrity.h"
+
+// One video of an archived file: the whole archive, or one of its shards.
+struct CatalogVideo {
+    std::string path;
+    uint32_t shard_index = 0;
+    uint32_t first_chunk = 0;
+    uint32_t chunk_count = 0;
+};
+
+struct CatalogEntry {
+    std::array<std::byte, 16> file_id{};
+    std::string name; // original file name, without directories
+    uint64_t file_size = 0;
+    uint32_t chunk_count = 0;
+    uint32_t chunk_size = 0;
+    uint32_t shard_count = 0; // 0 for an archive written as a single video
+    bool encrypted = false;
+    bool has_digest = false;
+    Sha256Digest digest; // whole-file digest (Merkle root), if has_digest
+    int64_t recorded = 0; // Unix time of the last update
+    std::vector<CatalogVideo> videos; // ordered by shard index
+    // Frame of its video in which each chunk's first packet is written, so a
+    // range read can seek straight to it. Empty for archives that were only
+    // probed, whose frame layout is unknown.
+    std::vector<uint32_t> chunk_frames;
+
+    // The video holding chunk_index, or nullptr.
+    [[nodiscard]] const CatalogVideo *video_for_chunk(uint32_t chunk_index) const;
+};
+
+// Local index of encoded archives, so a file can be found and restored without
+// probing every video. One file of checksummed records:
+//   header:  {magic u32 "MSCG", version u8}
+//   record:  {size u32, crc32c u32, type u8, payload}
+// Every change appends a record (a full entry, or a removal by file id); on
+// load the last record of a file id wins. Appends are a single write, so
+// several processes may record encodes into one catalog; a record torn by a
+// crash fails its checksum and load skips past it to the next intact record,
+// leaving the file as it is. compact() rewrites the file with one record per
+// entry, dropping any damage.
+class Catalog {
+public:
+    // Loads path, creating an empty catalog if it does not exist. Throws
+    // std::runtime_error if the file is not a catalog or cannot be created.
+    explicit Catalog(std::filesystem::path path);
+
+    // $MEDIA_STORAGE_CATALOG if set, otherwise catalog under
+    // $XDG_DATA_HOME/media_storage (~/.local/share/media_storage, or
+    // %LOCALAPPDATA% on Windows). Empty if none of those variables is set.
+    [[nodiscard]] static std::filesystem::path default_path();
+
+    [[nodiscard]] const std::filesystem::path &path() const { return path_; }
+
+    [[nodiscard]] std::size_t size() const { return entries_.size(); }
+
+    [[nodiscard]] std::optional<CatalogEntry> find(const std::array<std::byte, 16> &file_id) const;
+
+    // Entries whose name contains filter (all for an empty filter), by name.
+    [[nodiscard]] std::vector<CatalogEntry> search(std::string_view filter = {}) const;
+
+    // Adds the entry or updates the one with its file id. Videos are merged
+    // by shard index; a name, digest or frame index the update lacks is kept
+    // from the stored entry. Throws std::runtime_error if the append fails.
+    void merge(const CatalogEntry &update);
+
+    // False if there was no such entry.
+    bool remove(const std::array<std::byte, 16> &file_id);
+
+    // Rereads the file, to pick up records appended by other processes, and
+    // rewrites it with one record per entry.
+    void compact();
+
+private:
+    void load();
+
+    void append(const std::vector<std::byte> &record);
+
+    std::filesystem::path path_;
+    std::map<std::array<std::byte, 16>, CatalogEntry> entries_;
+};
@@ -0,0 +1,311 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "chunk_cache.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "integrity.h"
+
+static constexpr uint32_t CHUNK_CACHE_MAGIC = 0x43445343; // "CSDC"
+static constexpr uint8_t CHUNK_CACHE_VERSION = 1;
+static constexpr std::size_t CHUNK_CACHE_HEADER_SIZE = 13;
+static constexpr std::string_view CHUNK_CACHE_EXTENSION = ".chunk";
+
+// Inverse of disk_path(): "<file id hex>-<key tag hex>-<chunk index>.chunk".
+static std::optional<ChunkCacheKey> parse_disk_name(const std::string &name) {
+    if (!name.ends_with(CHUNK_CACHE_EXTENSION)) {
+        return std::nullopt;
+    }
+    const std::string_view stem(name.data(), name.size() - CHUNK_CACHE_EXTENSION.size());
+    const std::size_t first = stem.find('-');
+    const std::size_t second = stem.find('-', first + 1);
+    if (first == std::string_view::npos || second == std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    ChunkCacheKey key;
+    std::array<std::byte, sizeof(uint64_t)> tag{};
+    if (!from_hex(stem.substr(0, first), key.file_id) || !from_hex(stem.substr(first + 1, second - first - 1), tag)) {
+        return std::nullopt;
+    }
+    std::memcpy(&key.key_tag, tag.data(), sizeof(key.key_tag));
+    const std::string_view index = stem.substr(second + 1);
+    if (const auto [ptr, ec] = std::from_chars(index.data(), index.data() + index.size(), key.chunk_index);
+        ec != std::errc{} || ptr != index.data() + index.size()) {
+        return std::nullopt;
+    }
+    return key;
+}
+
+std::size_t ChunkCacheKeyHash::operator()(const ChunkCacheKey &key) const {
+    uint64_t h = 1469598103934665603ull; // FNV-1a
+    const auto mix = [&h](const std::span<const std::byte> bytes) {
+        for (const std::byte b: bytes) {
+            h = (h ^ std::to_integer<uint8_t>(b)) * 1099511628211ull;
+        }
+    };
+    mix(key.file_id);
+    mix(std::as_bytes(std::span(&key.key_tag, 1)));
+    mix(std::as_bytes(std::span(&key.chunk_index, 1)));
+    return static_cast<std::size_t>(h);
+}
+
+ChunkCache &ChunkCache::shared() {
+    static ChunkCache cache;
+    return cache;
+}
+
+uint64_t ChunkCache::key_tag(const std::span<const std::byte> key) {
+    const Sha256Digest digest = sha256(key);
+    uint64_t tag = 0;
+    std::memcpy(&tag, digest.bytes.data(), sizeof(tag));
+    // 0 marks plaintext archives.
+    return tag == 0 ? 1 : tag;
+}
+
+void ChunkCache::configure(const std::size_t memory_bytes, const std::filesystem::path &disk_dir,
+                           const std::size_t disk_bytes) {
+    std::lock_guard lock(mutex_);
+    memory_budget_ = memory_bytes;
+    disk_budget_ = disk_dir.empty() ? 0 : disk_bytes;
+    if (disk_dir != disk_dir_) {
+        // The old directory's files stay where they are for a later configure.
+        disk_.clear();
+        disk_pos_.clear();
+        stats_.disk_bytes = 0;
+        disk_dir_ = disk_dir;
+        if (!disk_dir_.empty()) {
+            // Cached chunks are decrypted plaintext: keep the directory private.
+            if (std::filesystem::create_directories(disk_dir_)) {
+                std::filesystem::permissions(disk_dir_, std::filesystem::perms::owner_all);
+            }
+            adopt_disk_entries();
+        }
+    }
+    trim();
+}
+
+bool ChunkCache::enabled() const {
+    std::lock_guard lock(mutex_);
+    return memory_budget_ > 0 || disk_budget_ > 0;
+}
+
+std::size_t ChunkCache::capacity() const {
+    std::lock_guard lock(mutex_);
+    return memory_budget_ + disk_budget_;
+}
+
+std::optional<std::vector<std::byte> > ChunkCache::get(const ChunkCacheKey &key) {
+    std::lock_guard lock(mutex_);
+    if (const auto it = memory_pos_.find(key); it != memory_pos_.end()) {
+        memory_.splice(memory_.end(), memory_, it->second);
+        ++stats_.memory_hits;
+        return it->second->data;
+    }
+    if (const auto it = disk_pos_.find(key); it != disk_pos_.end()) {
+        auto data = read_disk(*it->second);
+        erase_disk(it->second);
+        if (data) {
+            ++stats_.disk_hits;
+            insert_memory(key, *data);
+            return data;
+        }
+    }
+    ++stats_.misses;
+    return std::nullopt;
+}
+
+void ChunkCache::put(const ChunkCacheKey &key, std::vector<std::byte> data) {
+    std::lock_guard lock(mutex_);
+    if (memory_budget_ == 0 && disk_budget_ == 0) {
+        return;
+    }
+    if (const auto it = memory_pos_.find(key); it != memory_pos_.end()) {
+        stats_.memory_bytes -= it->second->data.size();
+        memory_.erase(it->second);
+        memory_pos_.erase(it);
+    }
+    if (const auto it = disk_pos_.find(key); it != disk_pos_.end()) {
+        erase_disk(it->second);
+    }
+    ++stats_.insertions;
+    insert_memory(key, std::move(data));
+}
+
+void ChunkCache::erase(const ChunkCacheKey &key) {
+    std::lock_guard lock(mutex_);
+    if (const auto it = memory_pos_.find(key); it != memory_pos_.end()) {
+        stats_.memory_bytes -= it->second->data.size();
+        memory_.erase(it->second);
+        memory_pos_.erase(it);
+    }
+    if (const auto it = disk_pos_.find(key); it != disk_pos_.end()) {
+        erase_disk(it->second);
+    }
+}
+
+void ChunkCache::clear() {
+    std::lock_guard lock(mutex_);
+    memory_.clear();
+    memory_pos_.clear();
+    stats_.memory_bytes = 0;
+    while (!disk_.empty()) {
+        erase_disk(disk_.begin());
+    }
+}
+
+ChunkCacheStats ChunkCache::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+void ChunkCache::reset_stats() {
+    std::lock_guard lock(mutex_);
+    const std::size_t memory_bytes = stats_.memory_bytes;
+    const std::size_t disk_bytes = stats_.disk_bytes;
+    stats_ = ChunkCacheStats{};
+    stats_.memory_bytes = memory_bytes;
+    stats_.disk_bytes = disk_bytes;
+}
+
+std::filesystem::path ChunkCache::disk_path(const ChunkCacheKey &key) const {
+    return disk_dir_ / (to_hex(key.file_id) + "-" + to_hex(std::as_bytes(std::span(&key.key_tag, 1))) + "-" +
+                        std::to_string(key.chunk_index) + std::string(CHUNK_CACHE_EXTENSION));
+}
+
+void ChunkCache::adopt_disk_entries() {
+    struct Found {
+        std::filesystem::file_time_type time;
+        ChunkCacheKey key;
+        std::size_t size;
+    };
+    std::vector<Found> found;
+    std::error_code ec;
+    for (const auto &file: std::filesystem::directory_iterator(disk_dir_, ec)) {
+        const auto key = parse_disk_name(file.path().filename().string());
+        const auto size = file.file_size(ec);
+        if (!key || ec || size < CHUNK_CACHE_HEADER_SIZE) {
+            continue;
+        }
+        found.push_back({file.last_write_time(ec), *key, static_cast<std::size_t>(size) - CHUNK_CACHE_HEADER_SIZE});
+    }
+    std::ranges::sort(found, {}, &Found::time);
+    for (const Found &entry: found) {
+        disk_pos_[entry.key] = disk_.insert(disk_.end(), DiskEntry{entry.key, entry.size});
+        stats_.disk_bytes += entry.size;
+    }
+}
+
+void ChunkCache::insert_memory(const ChunkCacheKey &key, std::vector<std::byte> data) {
+    if (data.size() > memory_budget_) {
+        insert_disk(key, data);
+        return;
+    }
+    stats_.memory_bytes += data.size();
+    memory_pos_[key] = memory_.insert(memory_.end(), MemoryEntry{key, std::move(data)});
+    trim();
+}
+
+void ChunkCache::insert_disk(const ChunkCacheKey &key, const std::span<const std::byte> data) {
+    if (data.size() > disk_budget_) {
+        ++stats_.evictions;
+        return;
+    }
+
+    std::array<std::byte, CHUNK_CACHE_HEADER_SIZE> header{};
+    const uint32_t crc = crc32c(data);
+    const auto size = static_cast<uint32_t>(data.size());
+    std::memcpy(header.data(), &CHUNK_CACHE_MAGIC, sizeof(CHUNK_CACHE_MAGIC));
+    header[4] = std::byte{CHUNK_CACHE_VERSION};
+    std::memcpy(header.data() + 5, &crc, sizeof(crc));
+    std::memcpy(header.data() + 9, &size, sizeof(size));
+
+    const std::filesystem::path path = disk_path(key);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    std::error_code perm_error;
+    std::filesystem::permissions(path, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write,
+                                 perm_error);
+    out.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+    out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!out) {
+        out.close();
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        ++stats_.evictions;
+        return;
+    }
+
+    stats_.disk_bytes += data.size();
+    disk_pos_[key] = disk_.insert(disk_.end(), DiskEntry{key, data.size()});
+    trim_disk();
+}
+
+void ChunkCache::erase_disk(const std::list<DiskEntry>::iterator it) {
+    std::error_code ec;
+    std::filesystem::remove(disk_path(it->key), ec);
+    stats_.disk_bytes -= it->size;
+    disk_pos_.erase(it->key);
+    disk_.erase(it);
+}
+
+std::optional<std::vector<std::byte> > ChunkCache::read_disk(const DiskEntry &entry) const {
+    std::ifstream in(disk_path(entry.key), std::ios::binary);
+    std::array<std::byte, CHUNK_CACHE_HEADER_SIZE> header{};
+    if (!in.read(reinterpret_cast<char *>(header.data()), static_cast<std::streamsize>(header.size()))) {
+        return std::nullopt;
+    }
+    uint32_t magic = 0;
+    uint32_t crc = 0;
+    uint32_t size = 0;
+    std::memcpy(&magic, header.data(), sizeof(magic));
+    std::memcpy(&crc, header.data() + 5, sizeof(crc));
+    std::memcpy(&size, header.data() + 9, sizeof(size));
+    // The size in the header is only trusted as far as the file was long.
+    if (magic != CHUNK_CACHE_MAGIC || header[4] != std::byte{CHUNK_CACHE_VERSION} || size != entry.size) {
+        return std::nullopt;
+    }
+
+    std::vector<std::byte> data(size);
+    if (!in.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(size)) || crc32c(data) != crc) {
+        return std::nullopt;
+    }
+    return data;
+}
+
+void ChunkCache::trim() {
+    while (stats_.memory_bytes > memory_budget_ && !memory_.empty()) {
+        MemoryEntry entry = std::move(memory_.front());
+        memory_pos_.erase(entry.key);
+        memory_.pop_front();
+        stats_.memory_bytes -= entry.data.size();
+        insert_disk(entry.key, entry.data);
+    }
+    trim_disk();
+}
+
+void ChunkCache::trim_disk() {
+    while (stats_.disk_bytes > disk_budget_ && !disk_.empty()) {
+        erase_disk(disk_.begin());
+        ++stats_.evictions;
+    }
+}
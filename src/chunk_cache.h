@@ -0,0 +1,135 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// A decoded chunk is identified by its archive's file id and index. Plaintext
+// of encrypted archives also carries a tag of the key that decrypted it, so a
+// wrong password never reads what the right one put in the cache.
+struct ChunkCacheKey {
+    std::array<std::byte, 16> file_id{};
+    uint64_t key_tag = 0;
+    uint32_t chunk_index = 0;
+
+    bool operator==(const ChunkCacheKey &) const = default;
+};
+
+struct ChunkCacheKeyHash {
+    std::size_t operator()(const ChunkCacheKey &key) const;
+};
+
+struct ChunkCacheStats {
+    uint64_t memory_hits = 0;
+    uint64_t disk_hits = 0;
+    uint64_t misses = 0;
+    uint64_t insertions = 0;
+    uint64_t evictions = 0; // dropped from the last tier
+    std::size_t memory_bytes = 0;
+    std::size_t disk_bytes = 0;
+};
+
+// Size-bounded LRU of decoded, decrypted chunks. Chunks evicted from memory
+// move to the disk tier if one is configured, and are promoted back on a hit.
+// Disk entries are {magic u32, version u8, crc32c u32, size u32, data} files
+// named after their key, readable by the owner only; they outlive the process
+// and are adopted again by the next configure() with the same directory. The
+// cache does not know what a chunk should hash to; callers check what they
+// put and get against their archive's chunk table. All members are
+// thread-safe.
+class ChunkCache {
+public:
+    // Process-wide instance shared by the decode and range read calls.
+    [[nodiscard]] static ChunkCache &shared();
+
+    [[nodiscard]] static uint64_t key_tag(std::span<const std::byte> key);
+
+    // Sets the budgets, shrinking the tiers as needed. A budget of 0 disables
+    // a tier; an empty disk_dir keeps chunks in memory only. Throws
+    // std::filesystem::filesystem_error if disk_dir cannot be created.
+    void configure(std::size_t memory_bytes, const std::filesystem::path &disk_dir, std::size_t disk_bytes);
+
+    [[nodiscard]] bool enabled() const;
+
+    // Combined capacity of both tiers.
+    [[nodiscard]] std::size_t capacity() const;
+
+    [[nodiscard]] std::optional<std::vector<std::byte> > get(const ChunkCacheKey &key);
+
+    void put(const ChunkCacheKey &key, std::vector<std::byte> data);
+
+    // Drops one entry from both tiers, e.g. one that failed a digest check.
+    void erase(const ChunkCacheKey &key);
+
+    // Drops every entry, including the disk tier's files. Keeps the budgets.
+    void clear();
+
+    [[nodiscard]] ChunkCacheStats stats() const;
+
+    void reset_stats();
+
+private:
+    struct MemoryEntry {
+        ChunkCacheKey key;
+        std::vector<std::byte> data;
+    };
+
+    struct DiskEntry {
+        ChunkCacheKey key;
+        std::size_t size; // of the data, as recorded when the entry was found or written
+    };
+
+    [[nodiscard]] std::filesystem::path disk_path(const ChunkCacheKey &key) const;
+
+    void adopt_disk_entries();
+
+    void insert_memory(const ChunkCacheKey &key, std::vector<std::byte> data);
+
+    void insert_disk(const ChunkCacheKey &key, std::span<const std::byte> data);
+
+    void erase_disk(std::list<DiskEntry>::iterator it);
+
+    [[nodiscard]] std::optional<std::vector<std::byte> > read_disk(const DiskEntry &entry) const;
+
+    // Spills memory entries over budget to disk, then drops the oldest disk
+    // entries over budget.
+    void trim();
+
+    void trim_disk();
+
+    mutable std::mutex mutex_;
+    std::size_t memory_budget_ = 0;
+    std::size_t disk_budget_ = 0;
+    std::filesystem::path disk_dir_;
+    // Least recently used first.
+    std::list<MemoryEntry> memory_;
+    std::unordered_map<ChunkCacheKey, std::list<MemoryEntry>::iterator, ChunkCacheKeyHash> memory_pos_;
+    std::list<DiskEntry> disk_;
+    std::unordered_map<ChunkCacheKey, std::list<DiskEntry>::iterator, ChunkCacheKeyHash> disk_pos_;
+    ChunkCacheStats stats_;
+};
@@ -0,0 +1,179 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "chunk_table.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr uint32_t TABLE_MAGIC = 0x5443534D; // "MSCT"
+static constexpr uint8_t TABLE_VERSION = 1;
+
+void ChunkStateTable::grow(const uint32_t chunk_count) {
+    if (chunk_count <= states_.size()) {
+        return;
+    }
+    states_.resize(chunk_count, ChunkState::Missing);
+    live_slots_.resize(chunk_count, NO_SLOT);
+    output_sizes_.resize(chunk_count, 0);
+    bits_.resize((static_cast<std::size_t>(chunk_count) + 63) / 64, 0);
+}
+
+void ChunkStateTable::set_state(const uint32_t chunk_index, const ChunkState state) {
+    if (state == ChunkState::Complete) {
+        throw std::invalid_argument("use mark_complete");
+    }
+    grow(chunk_index + 1);
+    if (is_complete(chunk_index)) {
+        return;
+    }
+    states_[chunk_index] = state;
+}
+
+void ChunkStateTable::set_live_slot(const uint32_t chunk_index, const uint32_t slot) {
+    grow(chunk_index + 1);
+    live_slots_[chunk_index] = slot;
+}
+
+void ChunkStateTable::mark_complete(const uint32_t chunk_index, const uint32_t output_size) {
+    grow(chunk_index + 1);
+    if (is_complete(chunk_index)) {
+        return;
+    }
+    states_[chunk_index] = ChunkState::Complete;
+    output_sizes_[chunk_index] = output_size;
+    bits_[chunk_index >> 6] |= uint64_t{1} << (chunk_index & 63);
+    ++complete_count_;
+}
+
+uint32_t ChunkStateTable::first_missing() const {
+    // Completion is monotonic, so the cursor only ever moves forward.
+    const auto count = size();
+    std::size_t word = first_missing_ >> 6;
+    while (word < bits_.size()) {
+        const uint64_t free_bits = ~bits_[word];
+        if (free_bits != 0) {
+            const auto index = static_cast<uint32_t>(word * 64 + std::countr_zero(free_bits));
+            first_missing_ = std::min(index, count);
+            return first_missing_;
+        }
+        ++word;
+    }
+    first_missing_ = count;
+    return count;
+}
+
+bool ChunkStateTable::range_complete(const uint32_t begin, const uint32_t end) const {
+    if (begin >= end) {
+        return true;
+    }
+    if (end > size()) {
+        return false;
+    }
+    if (first_missing() >= end) {
+        return true;
+    }
+
+    uint32_t i = begin;
+    while (i < end && (i & 63) != 0) {
+        if (!is_complete(i++)) return false;
+    }
+    while (i + 64 <= end) {
+        if (bits_[i >> 6] != ~uint64_t{0}) return false;
+        i += 64;
+    }
+    while (i < end) {
+        if (!is_complete(i++)) return false;
+    }
+    return true;
+}
+
+std::vector<uint32_t> ChunkStateTable::complete_indices() const {
+    std::vector<uint32_t> indices;
+    indices.reserve(complete_count_);
+    for (std::size_t word = 0; word < bits_.size(); ++word) {
+        for (uint64_t bits = bits_[word]; bits != 0; bits &= bits - 1) {
+            indices.push_back(static_cast<uint32_t>(word * 64 + std::countr_zero(bits)));
+        }
+    }
+    return indices;
+}
+
+std::vector<uint64_t> ChunkStateTable::offsets(const uint32_t count) const {
+    std::vector<uint64_t> result(static_cast<std::size_t>(count) + 1);
+    result[0] = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        result[i + 1] = result[i] + output_size(i);
+    }
+    return result;
+}
+
+std::vector<std::byte> ChunkStateTable::serialize() const {
+    const uint32_t count = size();
+    std::vector<std::byte> out(9 + bits_.size() * sizeof(uint64_t) + complete_count_ * sizeof(uint32_t));
+    std::byte *p = out.data();
+    std::memcpy(p, &TABLE_MAGIC, 4);
+    p[4] = static_cast<std::byte>(TABLE_VERSION);
+    std::memcpy(p + 5, &count, 4);
+    p += 9;
+    std::memcpy(p, bits_.data(), bits_.size() * sizeof(uint64_t));
+    p += bits_.size() * sizeof(uint64_t);
+    for (const uint32_t index: complete_indices()) {
+        std::memcpy(p, &output_sizes_[index], sizeof(uint32_t));
+        p += sizeof(uint32_t);
+    }
+    return out;
+}
+
+std::optional<ChunkStateTable> ChunkStateTable::deserialize(const std::span<const std::byte> data) {
+    if (data.size() < 9) {
+        return std::nullopt;
+    }
+    uint32_t magic = 0;
+    uint32_t count = 0;
+    std::memcpy(&magic, data.data(), 4);
+    std::memcpy(&count, data.data() + 5, 4);
+    if (magic != TABLE_MAGIC || static_cast<uint8_t>(data[4]) != TABLE_VERSION) {
+        return std::nullopt;
+    }
+
+    const std::size_t words = (static_cast<std::size_t>(count) + 63) / 64;
+    if (data.size() < 9 + words * sizeof(uint64_t)) {
+        return std::nullopt;
+    }
+
+    ChunkStateTable table;
+    table.grow(count);
+    std::memcpy(table.bits_.data(), data.data() + 9, words * sizeof(uint64_t));
+    if (count % 64 != 0 && words > 0) {
+        table.bits_.back() &= (uint64_t{1} << (count % 64)) - 1;
+    }
+
+    const auto indices = table.complete_indices();
+    const std::byte *sizes = data.data() + 9 + words * sizeof(uint64_t);
+    if (data.size() != 9 + words * sizeof(uint64_t) + indices.size() * sizeof(uint32_t)) {
+        return std::nullopt;
+    }
+    for (const uint32_t index: indices) {
+        std::memcpy(&table.output_sizes_[index], sizes, sizeof(uint32_t));
+        table.states_[index] = ChunkState::Complete;
+        sizes += sizeof(uint32_t);
+    }
+    table.complete_count_ = static_cast<uint32_t>(indices.size());
+    return table;
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+enum class ChunkState : uint8_t {
+    Missing = 0,
+    Receiving = 1,
+    Spilled = 2,
+    Complete = 3,
+};
+
+// Dense per-chunk bookkeeping for the decoder. Chunk indices are 0..N-1, so
+// state lives in flat arrays indexed by chunk: a completion bitmap for fast
+// scans, one state byte per chunk, the slot of its live decoder and the output
+// size of every completed chunk, from which the assembly offsets are derived.
+class ChunkStateTable {
+public:
+    static constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+
+    [[nodiscard]] uint32_t size() const { return static_cast<uint32_t>(states_.size()); }
+
+    void grow(uint32_t chunk_count);
+
+    [[nodiscard]] ChunkState state(uint32_t chunk_index) const {
+        return chunk_index < states_.size() ? states_[chunk_index] : ChunkState::Missing;
+    }
+
+    void set_state(uint32_t chunk_index, ChunkState state);
+
+    // Where the decoder keeps the chunk's live decoder, NO_SLOT if it has none.
+    [[nodiscard]] uint32_t live_slot(uint32_t chunk_index) const {
+        return chunk_index < live_slots_.size() ? live_slots_[chunk_index] : NO_SLOT;
+    }
+
+    void set_live_slot(uint32_t chunk_index, uint32_t slot);
+
+    [[nodiscard]] bool is_complete(uint32_t chunk_index) const {
+        return chunk_index < states_.size() && (bits_[chunk_index >> 6] >> (chunk_index & 63) & 1u) != 0;
+    }
+
+    void mark_complete(uint32_t chunk_index, uint32_t output_size);
+
+    [[nodiscard]] uint32_t output_size(uint32_t chunk_index) const {
+        return chunk_index < output_sizes_.size() ? output_sizes_[chunk_index] : 0;
+    }
+
+    [[nodiscard]] uint32_t complete_count() const { return complete_count_; }
+
+    // Lowest chunk index that is not complete (size() if every tracked chunk is).
+    [[nodiscard]] uint32_t first_missing() const;
+
+    [[nodiscard]] bool range_complete(uint32_t begin, uint32_t end) const;
+
+    [[nodiscard]] std::vector<uint32_t> complete_indices() const;
+
+    // Prefix sums of output sizes over [0, count): entry i is the byte offset of chunk i.
+    [[nodiscard]] std::vector<uint64_t> offsets(uint32_t count) const;
+
+    // Checkpoint format: {magic u32, version u8, count u32, bitmap words, output
+    // sizes of complete chunks}. In-flight states and live slots are not
+    // persisted and come back as Missing.
+    [[nodiscard]] std::vector<std::byte> serialize() const;
+
+    [[nodiscard]] static std::optional<ChunkStateTable> deserialize(std::span<const std::byte> data);
+
+private:
+    std::vector<uint64_t> bits_;
+    std::vector<ChunkState> states_;
+    std::vector<uint32_t> live_slots_;
+    std::vector<uint32_t> output_sizes_;
+    uint32_t complete_count_ = 0;
+    mutable uint32_t first_missing_ = 0;
+};
@@ -28,15 +28,23 @@ constexpr int FRAME_FPS = 30;
 const std::string VIDEO_CODEC = "ffv1";
 const std::string VIDEO_CONTAINER = "mkv";
 
+// Audio Data Track (lossless file targets): 16-bit PCM, one frame time per packet
+constexpr int AUDIO_DATA_SAMPLE_RATE = 48000;
+constexpr int AUDIO_DATA_CHANNELS = 8;
+constexpr int AUDIO_DATA_SAMPLES_PER_FRAME = AUDIO_DATA_SAMPLE_RATE / FRAME_FPS;
+constexpr size_t AUDIO_DATA_BYTES_PER_FRAME = AUDIO_DATA_SAMPLES_PER_FRAME * AUDIO_DATA_CHANNELS * 2;
+
 // Encoding Parameters
 constexpr size_t CHUNK_SIZE_BYTES = 1024ull * 1024ull; // 1 MiB
 constexpr size_t CRYPTO_AEAD_TAG_BYTES = 16;
 inline constexpr size_t CHUNK_SIZE_PLAIN_MAX_ENCRYPTED = CHUNK_SIZE_BYTES - 4 - CRYPTO_AEAD_TAG_BYTES;
 constexpr size_t SYMBOL_SIZE_BYTES = 256;
 constexpr double REPAIR_OVERHEAD = 5.00;
+constexpr double MAX_REPAIR_OVERHEAD = 32.0; // decoders drop ESIs far beyond this
 constexpr bool INCLUDE_SOURCE = true;
 constexpr int BITS_PER_BLOCK = 1;
 constexpr double COEFFICIENT_STRENGTH = 500.0;
+constexpr uint32_t MAX_CHUNK_COUNT = 1u << 24; // 16 TiB of 1 MiB chunks
 
 enum Flags : uint8_t {
     None = 0,
@@ -44,6 +52,7 @@ enum Flags : uint8_t {
     LastChunk = 1 << 1,
     Encrypted = 1 << 2,
     UseXXHash = 1 << 3,
+    Manifest = 1 << 4, // chunk_index is a manifest segment, see manifest.h
 };
 
 // Header Scheme
@@ -199,3 +199,8 @@ void secure_zero(std::span<std::byte> data) {
         sodium_memzero(data.data(), data.size());
     }
 }
+
+void random_bytes(const std::span<std::byte> out) {
+    ensure_sodium_init();
+    randombytes_buf(out.data(), out.size());
+}
@@ -52,3 +52,7 @@ void decrypt_chunk_into(std::span<std::byte> out,
                         uint32_t chunk_index);
 
 void secure_zero(std::span<std::byte> data);
+
+// Cryptographically secure random bytes, e.g. for file ids (which also salt
+// the key derivation).
+void random_bytes(std::span<std::byte> out);
@@ -130,50 +130,91 @@ struct PrecomputedBlocks {
     uint8_t patterns[NUM_PATTERNS][8][8];
 };
 
-inline const PrecomputedBlocks &get_precomputed_blocks() {
-    static const PrecomputedBlocks blocks = [] {
-        PrecomputedBlocks result{};
-        const auto &[data] = get_cosine_table();
+// Block designs the encoder can draw. All of them put the bit into the sign of
+// the block's projection onto the embedding basis, so the decoder reads every
+// set with the same projections and never needs to know which one was used.
+// ffv1 predicts each pixel from its left and top neighbours, so flatter blocks
+// with fewer distinct values compress better.
+enum class PatternSet : uint8_t {
+    Cosine = 0,          // DC plus or minus the cosine basis; survives lossy re-encodes best
+    QuantizedCosine = 1, // the same, with the offsets rounded to multiples of 16
+    Step = 2,            // flat halves at two levels, with the cosine's projection
+};
+
+inline constexpr int PATTERN_SET_COUNT = 3;
 
-        constexpr float dc_value = 0.25f * alpha_f(0) * alpha_f(0) * 64.0f * 128.0f;
+inline PrecomputedBlocks make_precomputed_blocks(const PatternSet set) {
+    PrecomputedBlocks result{};
+    const auto &[data] = get_cosine_table();
 
-        float dc_image[8][8];
+    constexpr float dc_value = 0.25f * alpha_f(0) * alpha_f(0) * 64.0f * 128.0f;
+
+    float dc_image[8][8];
+    for (int x = 0; x < 8; ++x) {
+        for (int y = 0; y < 8; ++y) {
+            dc_image[x][y] = 0.25f * alpha_f(0) * alpha_f(0) * dc_value
+                             * data[x][0] * data[y][0];
+        }
+    }
+
+    float embed_basis[4][8][8]{};
+    for (int b = 0; b < BITS_PER_BLOCK; ++b) {
+        const auto [u, v] = EMBED_POSITIONS[b];
+        const float scale = 0.25f * alpha_f(u) * alpha_f(v)
+                            * static_cast<float>(COEFFICIENT_STRENGTH);
         for (int x = 0; x < 8; ++x) {
             for (int y = 0; y < 8; ++y) {
-                dc_image[x][y] = 0.25f * alpha_f(0) * alpha_f(0) * dc_value
-                                 * data[x][0] * data[y][0];
+                embed_basis[b][x][y] = scale * data[x][u] * data[y][v];
             }
         }
 
-        float embed_basis[4][8][8]{};
-        for (int b = 0; b < BITS_PER_BLOCK; ++b) {
-            const auto [u, v] = EMBED_POSITIONS[b];
-            const float scale = 0.25f * alpha_f(u) * alpha_f(v)
-                                * static_cast<float>(COEFFICIENT_STRENGTH);
+        if (set == PatternSet::Step) {
+            // Replace the basis by its sign, scaled so that its projection onto
+            // the basis (and thus the decoding margin) stays the same.
+            float energy = 0.0f;
+            float magnitude = 0.0f;
             for (int x = 0; x < 8; ++x) {
                 for (int y = 0; y < 8; ++y) {
-                    embed_basis[b][x][y] = scale * data[x][u] * data[y][v];
+                    energy += embed_basis[b][x][y] * embed_basis[b][x][y];
+                    magnitude += std::abs(embed_basis[b][x][y]);
+                }
+            }
+            const float level = energy / magnitude;
+            for (int x = 0; x < 8; ++x) {
+                for (int y = 0; y < 8; ++y) {
+                    embed_basis[b][x][y] = std::copysign(level, embed_basis[b][x][y]);
                 }
             }
         }
+    }
 
-        for (int pattern = 0; pattern < PrecomputedBlocks::NUM_PATTERNS; ++pattern) {
-            for (int y = 0; y < 8; ++y) {
-                for (int x = 0; x < 8; ++x) {
-                    float val = dc_image[y][x];
-                    for (int b = 0; b < BITS_PER_BLOCK; ++b) {
-                        const int bit = (pattern >> (BITS_PER_BLOCK - 1 - b)) & 1;
-                        val += (bit ? 1.0f : -1.0f) * embed_basis[b][y][x];
-                    }
-                    val = std::clamp(val, 0.0f, 255.0f);
-                    result.patterns[pattern][y][x] = static_cast<uint8_t>(val);
+    for (int pattern = 0; pattern < PrecomputedBlocks::NUM_PATTERNS; ++pattern) {
+        for (int y = 0; y < 8; ++y) {
+            for (int x = 0; x < 8; ++x) {
+                float offset = 0.0f;
+                for (int b = 0; b < BITS_PER_BLOCK; ++b) {
+                    const int bit = (pattern >> (BITS_PER_BLOCK - 1 - b)) & 1;
+                    offset += (bit ? 1.0f : -1.0f) * embed_basis[b][y][x];
                 }
+                if (set == PatternSet::QuantizedCosine) {
+                    offset = 16.0f * std::round(offset / 16.0f);
+                }
+                const float val = std::clamp(dc_image[y][x] + offset, 0.0f, 255.0f);
+                result.patterns[pattern][y][x] = static_cast<uint8_t>(val);
             }
         }
+    }
 
-        return result;
-    }();
-    return blocks;
+    return result;
+}
+
+inline const PrecomputedBlocks &get_precomputed_blocks(const PatternSet set = PatternSet::Cosine) {
+    static const PrecomputedBlocks blocks[PATTERN_SET_COUNT] = {
+        make_precomputed_blocks(PatternSet::Cosine),
+        make_precomputed_blocks(PatternSet::QuantizedCosine),
+        make_precomputed_blocks(PatternSet::Step),
+    };
+    return blocks[static_cast<int>(set)];
 }
 
 struct DecoderProjections {
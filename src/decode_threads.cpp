@@ -0,0 +1,48 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "decode_threads.h"
+
+#include <algorithm>
+#include <cmath>
+
+DecoderThreading choose_decoder_threading(const bool intra_only, const int slices, const int requested,
+                                          const int cores) {
+    DecoderThreading threading;
+    if (intra_only) {
+        threading.slice_threads = true;
+        if (slices > 0) {
+            threading.thread_count = std::clamp(slices, 1, std::max(1, cores));
+        }
+    } else {
+        threading.frame_threads = true;
+        threading.slice_threads = true;
+    }
+    if (requested > 0) {
+        threading.thread_count = requested;
+    }
+    return threading;
+}
+
+int balance_extract_threads(const DecodeStageTimes &times, const int cores, const bool concurrent_decoder) {
+    const int available = std::max(1, cores);
+    const double total = times.decode_seconds + times.extract_seconds + times.consume_seconds;
+    if (!concurrent_decoder || times.frames == 0 || !(total > 0.0)) {
+        return available;
+    }
+    const auto share = static_cast<int>(std::lround(available * times.extract_seconds / total));
+    return std::clamp(share, 1, available);
+}
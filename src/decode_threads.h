@@ -0,0 +1,55 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+
+// How a video decoder spreads its work over threads. Kept free of FFmpeg
+// types so the policy can be tested on its own; VideoDecoder maps it onto
+// AVCodecContext::thread_type and thread_count.
+struct DecoderThreading {
+    bool frame_threads = false; // decode several frames at once
+    bool slice_threads = false; // decode the slices of one frame at once
+    int thread_count = 0;       // 0 = let FFmpeg pick one per core
+};
+
+// Picks the threading of a decoder. Intra-only codecs such as ffv1 decode
+// every frame on its own, so slice threads are all they use, and no more of
+// them than the stream has slices (0 = unknown). Inter codecs such as H.264,
+// VP9 and AV1 are mostly encoded with few slices; frame threads pipeline them
+// instead. requested > 0 overrides the thread count.
+[[nodiscard]] DecoderThreading choose_decoder_threading(bool intra_only, int slices, int requested, int cores);
+
+// Wall time each stage of a pixel decode spent over a number of frames: waiting
+// for the codec to hand out a frame, extracting its blocks, and the caller's
+// work on the packets between frames (FEC decoding, writing).
+struct DecodeStageTimes {
+    double decode_seconds = 0.0;
+    double extract_seconds = 0.0;
+    double consume_seconds = 0.0;
+    int64_t frames = 0;
+};
+
+// Size of the OpenMP team that extracts blocks. A sequential decoder leaves
+// every core idle while extraction runs, so it gets all of them. Frame threads
+// keep decoding the next frames meanwhile, so extraction only gets the cores'
+// share its time takes of the whole frame time and the decoder and the caller's
+// FEC work keep the rest. Never below 1.
+[[nodiscard]] int balance_extract_threads(const DecodeStageTimes &times, int cores, bool concurrent_decoder);
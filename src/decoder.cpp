@@ -23,10 +23,13 @@
 #include <algorithm>
 #include <cstring>
 #include <fstream>
+#include <limits>
 #include <mutex>
-#include <ranges>
 #include <stdexcept>
 
+// Decoded manifest segments held back until the segment they depend on arrives.
+static constexpr std::size_t MAX_PENDING_MANIFEST_SEGMENTS = MANIFEST_MAX_SHARD_TABLE_SEGMENTS;
+
 static std::once_flag ensure_init;
 
 static void ensureWirehairInit() {
@@ -54,15 +57,14 @@ static uint32_t readU32LE(const std::span<const std::byte> buffer, const std::si
 }
 
 ChunkDecoder::ChunkDecoder(const uint32_t chunk_index, const uint32_t chunk_size, const uint32_t k,
-                           const uint16_t symbol_size)
+                           const uint16_t symbol_size, const bool buffer_symbols)
     : chunk_index_(chunk_index)
       , chunk_size_(chunk_size)
       , k_(k)
       , symbol_size_(symbol_size) {
     ensureWirehairInit();
-    codec_ = wirehair_decoder_create(nullptr, chunk_size_, symbol_size_);
-    if (!codec_) {
-        throw std::runtime_error("wirehair_decoder_create failed");
+    if (!buffer_symbols) {
+        create_codec();
     }
 }
 
@@ -81,7 +83,10 @@ ChunkDecoder::ChunkDecoder(ChunkDecoder &&other) noexcept
       , codec_(other.codec_)
       , decoded_(other.decoded_)
       , packets_received_(other.packets_received_)
-      , decoded_data_(std::move(other.decoded_data_)) {
+      , decoded_data_(std::move(other.decoded_data_))
+      , buffered_data_(std::move(other.buffered_data_))
+      , buffered_symbols_(std::move(other.buffered_symbols_))
+      , seen_esi_(std::move(other.seen_esi_)) {
     other.codec_ = nullptr;
 }
 
@@ -98,6 +103,9 @@ ChunkDecoder &ChunkDecoder::operator=(ChunkDecoder &&other) noexcept {
         decoded_ = other.decoded_;
         packets_received_ = other.packets_received_;
         decoded_data_ = std::move(other.decoded_data_);
+        buffered_data_ = std::move(other.buffered_data_);
+        buffered_symbols_ = std::move(other.buffered_symbols_);
+        seen_esi_ = std::move(other.seen_esi_);
         other.codec_ = nullptr;
     }
     return *this;
@@ -108,12 +116,54 @@ bool ChunkDecoder::add_packet(const uint32_t esi, const std::span<const std::byt
         return true;
     }
 
-    if (!codec_) {
-        throw std::runtime_error("codec is null");
+    // Duplicate rows make wirehair run out of spare rows (ExtraInsufficient),
+    // so every ESI is fed at most once.
+    const std::size_t word = esi >> 6;
+    const uint64_t bit = uint64_t{1} << (esi & 63);
+    if (word >= seen_esi_.size()) {
+        seen_esi_.resize(word + 1, 0);
+    }
+    if (seen_esi_[word] & bit) {
+        return false;
     }
+    seen_esi_[word] |= bit;
 
     ++packets_received_;
 
+    if (codec_) {
+        return decode_symbol(esi, payload);
+    }
+
+    buffered_symbols_.emplace_back(esi, static_cast<uint32_t>(payload.size()));
+    buffered_data_.insert(buffered_data_.end(), payload.begin(), payload.end());
+    if (buffered_symbols_.size() < k_) {
+        return false;
+    }
+
+    create_codec();
+
+    bool done = false;
+    std::size_t offset = 0;
+    for (const auto &[buffered_esi, length]: buffered_symbols_) {
+        if (decode_symbol(buffered_esi, std::span(buffered_data_).subspan(offset, length))) {
+            done = true;
+            break;
+        }
+        offset += length;
+    }
+    buffered_symbols_ = {};
+    buffered_data_ = {};
+    return done;
+}
+
+void ChunkDecoder::create_codec() {
+    codec_ = wirehair_decoder_create(nullptr, chunk_size_, symbol_size_);
+    if (!codec_) {
+        throw std::runtime_error("wirehair_decoder_create failed");
+    }
+}
+
+bool ChunkDecoder::decode_symbol(const uint32_t esi, const std::span<const std::byte> payload) {
     const auto *payloadData = reinterpret_cast<const uint8_t *>(payload.data());
     const auto payloadSize = static_cast<uint32_t>(payload.size());
 
@@ -145,6 +195,68 @@ bool ChunkDecoder::add_packet(const uint32_t esi, const std::span<const std::byt
     throw std::runtime_error("wirehair_decode failed with error");
 }
 
+std::size_t ChunkDecoder::memory_usage() const {
+    std::size_t bytes = buffered_data_.capacity() +
+                        buffered_symbols_.capacity() * sizeof(buffered_symbols_[0]) +
+                        decoded_data_.capacity() +
+                        seen_esi_.capacity() * sizeof(uint64_t);
+    if (codec_) {
+        // Wirehair keeps roughly one symbol-sized row per source block.
+        bytes += static_cast<std::size_t>(k_) * symbol_size_;
+    }
+    return bytes;
+}
+
+std::vector<SpilledSymbol> ChunkDecoder::take_buffered_symbols() {
+    std::vector<SpilledSymbol> symbols;
+    symbols.reserve(buffered_symbols_.size());
+    std::size_t offset = 0;
+    for (const auto &[esi, length]: buffered_symbols_) {
+        const auto begin = buffered_data_.begin() + static_cast<std::ptrdiff_t>(offset);
+        symbols.push_back(SpilledSymbol{esi, std::vector<std::byte>(begin, begin + length)});
+        offset += length;
+    }
+    buffered_symbols_ = {};
+    buffered_data_ = {};
+    return symbols;
+}
+
+void *ChunkDecoder::release_encoder() {
+    if (!decoded_ || !codec_) {
+        return nullptr;
+    }
+    if (wirehair_decoder_becomes_encoder(static_cast<WirehairCodec>(codec_)) != Wirehair_Success) {
+        throw std::runtime_error("wirehair_decoder_becomes_encoder failed");
+    }
+    void *codec = codec_;
+    codec_ = nullptr;
+    return codec;
+}
+
+RecoveredCodec::~RecoveredCodec() {
+    if (codec_) {
+        wirehair_free(static_cast<WirehairCodec>(codec_));
+    }
+}
+
+RecoveredCodec::RecoveredCodec(RecoveredCodec &&other) noexcept
+    : codec_(other.codec_)
+      , header_(other.header_) {
+    other.codec_ = nullptr;
+}
+
+RecoveredCodec &RecoveredCodec::operator=(RecoveredCodec &&other) noexcept {
+    if (this != &other) {
+        if (codec_) {
+            wirehair_free(static_cast<WirehairCodec>(codec_));
+        }
+        codec_ = other.codec_;
+        header_ = other.header_;
+        other.codec_ = nullptr;
+    }
+    return *this;
+}
+
 std::vector<std::byte> ChunkDecoder::get_decoded_data() const {
     if (!decoded_) {
         throw std::runtime_error("data not yet decoded");
@@ -322,112 +434,369 @@ std::optional<ChunkDecodeResult> Decoder::process_packet(const std::span<const s
         return std::nullopt;
     }
 
-    const PacketHeader &hdr = parsed->header;
+    return route_packet(parsed->header, std::span(parsed->payload.data(), parsed->payload.size()), compute_sha256);
+}
+
+std::optional<ChunkDecodeResult> Decoder::process_packet(const DecodedPacket &packet, const bool compute_sha256) {
+    ++total_packets_;
+    if (!validate_packet_crc(packet)) {
+        return std::nullopt;
+    }
+
+    return route_packet(packet.header, std::span(packet.payload.data(), packet.payload.size()), compute_sha256);
+}
+
+std::optional<ChunkDecodeResult> Decoder::route_packet(const PacketHeader &hdr,
+                                                       const std::span<const std::byte> payload,
+                                                       const bool compute_sha256) {
     if (!id) {
         id = hdr.file_id;
+    }
+    if (hdr.flags & Manifest) {
+        ingest_manifest(hdr, payload);
+        return std::nullopt;
+    }
+    // The manifest is never encrypted, so only data packets decide encryption.
+    if (!data_seen_) {
+        data_seen_ = true;
         encrypted_ = (hdr.flags & Encrypted) != 0;
     }
 
-    if (completed_chunks.contains(hdr.chunk_index)) {
-        return std::nullopt;
+    return ingest_symbol(hdr, payload, compute_sha256);
+}
+
+void Decoder::ingest_manifest(const PacketHeader &hdr, const std::span<const std::byte> payload) {
+    const uint32_t segment = hdr.chunk_index;
+    if (!admit_geometry(hdr) || !manifest_.accepts_segment(segment, chunk_count_limit())) {
+        ++packets_rejected_;
+        return;
+    }
+    if (manifest_segments_done_.contains(segment)) {
+        return;
     }
 
-    auto it = active_decoders.find(hdr.chunk_index);
-    if (it == active_decoders.end()) {
-        auto [inserted_it, success] = active_decoders.emplace(
+    auto it = manifest_decoders_.find(segment);
+    if (it == manifest_decoders_.end()) {
+        it = manifest_decoders_.emplace(
             std::piecewise_construct,
-            std::forward_as_tuple(hdr.chunk_index),
-            std::forward_as_tuple(hdr.chunk_index, hdr.chunk_size, hdr.k, hdr.symbol_size)
-        );
-        it = inserted_it;
-    }
-
-    ChunkDecoder &decoder = it->second;
-    if (const std::span payloadSpan(parsed->payload.data(), parsed->payload.size()); decoder.add_packet(
-        hdr.esi, payloadSpan)) {
-        ChunkDecodeResult result;
-        result.chunk_index = hdr.chunk_index;
-        result.data = decoder.consume_decoded_data();
-        const uint32_t copy_len = std::min(static_cast<uint32_t>(result.data.size()), hdr.original_size);
-        result.data.resize(copy_len);
-        if (compute_sha256) {
-            result.sha256 = sha256(std::span<const std::byte>(result.data.data(), result.data.size()));
+            std::forward_as_tuple(segment),
+            std::forward_as_tuple(segment, hdr.chunk_size, hdr.k, hdr.symbol_size)
+        ).first;
+    } else if (it->second.chunk_size() != hdr.chunk_size || it->second.k() != hdr.k ||
+               it->second.symbol_size() != hdr.symbol_size) {
+        ++packets_rejected_;
+        return;
+    }
+
+    if (!it->second.add_packet(hdr.esi, payload)) {
+        return;
+    }
+
+    auto data = it->second.consume_decoded_data();
+    data.resize(std::min(static_cast<uint32_t>(data.size()), hdr.original_size));
+    manifest_decoders_.erase(it);
+
+    if (!accept_manifest_segment(segment, data)) {
+        // A shard's table can decode before its ShardInfo. Hold it until a
+        // later segment places it; later copies of it still decode meanwhile.
+        if (pending_manifest_.size() < MAX_PENDING_MANIFEST_SEGMENTS || pending_manifest_.contains(segment)) {
+            pending_manifest_[segment] = std::move(data);
         }
-        result.success = true;
-        completed_chunks[hdr.chunk_index] = std::move(result.data);
-        active_decoders.erase(it);
+        return;
+    }
+    pending_manifest_.erase(segment);
 
-        return result;
+    for (bool placed = true; placed;) {
+        placed = false;
+        for (auto pending = pending_manifest_.begin(); pending != pending_manifest_.end();) {
+            if (accept_manifest_segment(pending->first, pending->second)) {
+                pending = pending_manifest_.erase(pending);
+                placed = true;
+            } else {
+                ++pending;
+            }
+        }
     }
+}
 
-    return std::nullopt;
+bool Decoder::accept_manifest_segment(const uint32_t segment, const std::span<const std::byte> data) {
+    if (!manifest_.add_segment(segment, data)) {
+        return false;
+    }
+    manifest_segments_done_.insert(segment);
+    if (segment == MANIFEST_FILE_INFO_SEGMENT) {
+        set_expected_chunk_count(manifest_.file_info()->chunk_count);
+    }
+    return true;
 }
 
-std::optional<ChunkDecodeResult> Decoder::process_packet(const DecodedPacket &packet, const bool compute_sha256) {
-    ++total_packets_;
-    if (!validate_packet_crc(packet)) {
+std::optional<ChunkDecodeResult> Decoder::ingest_symbol(const PacketHeader &hdr,
+                                                        const std::span<const std::byte> payload,
+                                                        const bool compute_sha256) {
+    if (!admit(hdr)) {
+        ++packets_rejected_;
+        return std::nullopt;
+    }
+    if (hdr.flags & LastChunk) {
+        if (last_chunk_esi_ && last_chunk_candidate_ == hdr.chunk_index && *last_chunk_esi_ != hdr.esi) {
+            set_expected_chunk_count(hdr.chunk_index + 1);
+        } else if (!last_chunk_esi_ || last_chunk_candidate_ != hdr.chunk_index) {
+            last_chunk_candidate_ = hdr.chunk_index;
+            last_chunk_esi_ = hdr.esi;
+        }
+    }
+    if (chunk_table_.is_complete(hdr.chunk_index)) {
+        ++margins_[hdr.chunk_index].spare;
         return std::nullopt;
     }
 
-    const PacketHeader &hdr = packet.header;
-    if (!id) {
-        id = hdr.file_id;
-        encrypted_ = (hdr.flags & Encrypted) != 0;
+    std::size_t counted_bytes = 0;
+    uint32_t slot = chunk_table_.live_slot(hdr.chunk_index);
+    if (slot == ChunkStateTable::NO_SLOT) {
+        const bool spilled = chunk_table_.state(hdr.chunk_index) == ChunkState::Spilled;
+        if (spilled && spill_->symbol_count(hdr.chunk_index) + 1 < hdr.k) {
+            // Still cold: keep collecting on disk until the chunk could decode.
+            spill_->append(hdr.chunk_index, hdr.esi, payload);
+            return std::nullopt;
+        }
+
+        const std::size_t incoming_bytes = (spilled ? spill_->symbol_count(hdr.chunk_index) + 1 : 1) * payload.size();
+        if (!make_room(hdr.chunk_index, incoming_bytes, true)) {
+            ++packets_rejected_;
+            if (spilled) {
+                spill_->append(hdr.chunk_index, hdr.esi, payload);
+            }
+            return std::nullopt;
+        }
+
+        slot = open_decoder(hdr);
+        if (spilled) {
+            ++stats_.reingests;
+            ChunkDecoder &reloaded = *live_decoders_[slot].decoder;
+            for (const auto &[esi, data]: spill_->take(hdr.chunk_index)) {
+                if (reloaded.add_packet(esi, data)) {
+                    break;
+                }
+            }
+        }
+    } else {
+        const ChunkDecoder &live = *live_decoders_[slot].decoder;
+        if (live.chunk_size() != hdr.chunk_size || live.k() != hdr.k || live.symbol_size() != hdr.symbol_size ||
+            !make_room(hdr.chunk_index, live.has_codec() ? 0 : payload.size(), false)) {
+            ++packets_rejected_;
+            return std::nullopt;
+        }
+        counted_bytes = live.memory_usage();
+        lru_.splice(lru_.end(), lru_, live_decoders_[slot].lru_pos);
     }
 
-    if (completed_chunks.contains(hdr.chunk_index)) {
+    ChunkDecoder &decoder = *live_decoders_[slot].decoder;
+    if (!decoder.add_packet(hdr.esi, payload)) {
+        live_bytes_ = live_bytes_ - counted_bytes + decoder.memory_usage();
+        stats_.peak_live_bytes = std::max(stats_.peak_live_bytes, live_bytes_);
+        enforce_memory_budget(hdr.chunk_index);
         return std::nullopt;
     }
 
-    auto it = active_decoders.find(hdr.chunk_index);
-    if (it == active_decoders.end()) {
-        auto [inserted_it, success] = active_decoders.emplace(
-            std::piecewise_construct,
-            std::forward_as_tuple(hdr.chunk_index),
-            std::forward_as_tuple(hdr.chunk_index, hdr.chunk_size, hdr.k, hdr.symbol_size)
-        );
-        it = inserted_it;
-    }
-
-    ChunkDecoder &decoder = it->second;
-    if (const std::span payloadSpan(packet.payload.data(), packet.payload.size()); decoder.add_packet(
-        hdr.esi, payloadSpan)) {
-        ChunkDecodeResult result;
-        result.chunk_index = hdr.chunk_index;
-        result.data = decoder.consume_decoded_data();
-        const uint32_t copy_len = std::min(static_cast<uint32_t>(result.data.size()), hdr.original_size);
-        result.data.resize(copy_len);
-        if (compute_sha256) {
-            result.sha256 = sha256(std::span<const std::byte>(result.data.data(), result.data.size()));
+    live_bytes_ -= counted_bytes;
+
+    ChunkDecodeResult result;
+    result.chunk_index = hdr.chunk_index;
+    result.data = decoder.consume_decoded_data();
+    const uint32_t copy_len = std::min(static_cast<uint32_t>(result.data.size()), hdr.original_size);
+    result.data.resize(copy_len);
+    if (compute_sha256) {
+        result.sha256 = sha256(std::span<const std::byte>(result.data.data(), result.data.size()));
+    }
+    result.success = true;
+    if (hand_off_codecs_) {
+        result.codec = RecoveredCodec(decoder.release_encoder(), hdr);
+    }
+
+    // Encrypted chunks carry their plaintext length up front, so output offsets
+    // are known without the key.
+    uint32_t output_size = copy_len;
+    if (encrypted_) {
+        output_size = result.data.size() >= CRYPTO_PLAIN_SIZE_HEADER ? read_plain_size_from_header(result.data) : 0;
+    }
+    if (retain_chunk_data_) {
+        if (chunk_data_.size() <= hdr.chunk_index) {
+            chunk_data_.resize(static_cast<std::size_t>(hdr.chunk_index) + 1);
         }
-        result.success = true;
-        completed_chunks[hdr.chunk_index] = std::move(result.data);
-        active_decoders.erase(it);
+        chunk_data_[hdr.chunk_index] = std::move(result.data);
+    }
+    if (margins_.size() <= hdr.chunk_index) {
+        margins_.resize(static_cast<std::size_t>(hdr.chunk_index) + 1);
+    }
+    margins_[hdr.chunk_index] = ChunkMargin{decoder.k(), decoder.packets_received(), 0};
+    chunk_table_.mark_complete(hdr.chunk_index, output_size);
+    forget(slot);
 
-        return result;
+    return result;
+}
+
+void Decoder::set_memory_budget(const std::size_t bytes, const std::string &spill_dir) {
+    memory_budget_ = bytes;
+    spill_dir_ = spill_dir;
+    enforce_memory_budget(std::numeric_limits<uint32_t>::max());
+}
+
+DecoderMemoryStats Decoder::memory_stats() const {
+    DecoderMemoryStats stats = stats_;
+    stats.live_decoders = live_count_;
+    stats.live_bytes = live_bytes_;
+    if (spill_) {
+        stats.spilled_chunks = spill_->chunk_count();
+        stats.spill_bytes = spill_->bytes_written();
     }
+    return stats;
+}
 
-    return std::nullopt;
+void Decoder::enforce_memory_budget(const uint32_t keep_chunk) {
+    if (memory_budget_ == 0) {
+        return;
+    }
+    while (live_bytes_ > memory_budget_ && evict_one(keep_chunk)) {
+    }
+}
+
+bool Decoder::evict_one(const uint32_t keep_chunk) {
+    // Chunks that already own a codec have k symbols and finish within a
+    // packet or two; their state cannot be spilled, so leave them be.
+    for (const uint32_t chunk_index: lru_) {
+        if (chunk_index == keep_chunk) {
+            continue;
+        }
+        if (const uint32_t slot = chunk_table_.live_slot(chunk_index); !live_decoders_[slot].decoder->has_codec()) {
+            evict(slot);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Decoder::make_room(const uint32_t chunk_index, const std::size_t incoming_bytes, const bool new_decoder) {
+    // Only spill to make room when a spill budget was configured; otherwise the
+    // limits are hard and the packet is dropped.
+    const bool can_spill = memory_budget_ > 0;
+    if (new_decoder && limits_.max_live_decoders > 0) {
+        while (live_count_ >= limits_.max_live_decoders) {
+            if (!can_spill || !evict_one(chunk_index)) {
+                return false;
+            }
+        }
+    }
+    if (limits_.max_buffered_bytes > 0) {
+        while (live_bytes_ + incoming_bytes > limits_.max_buffered_bytes) {
+            if (!can_spill || !evict_one(chunk_index)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool Decoder::admit(const PacketHeader &hdr) const {
+    return hdr.chunk_index < chunk_count_limit() && admit_geometry(hdr);
+}
+
+bool Decoder::admit_geometry(const PacketHeader &hdr) const {
+    if (hdr.symbol_size == 0 || hdr.chunk_size == 0 || hdr.chunk_size > limits_.max_chunk_size ||
+        hdr.original_size > hdr.chunk_size) {
+        return false;
+    }
+    // k is derived from the sizes; anything else would make wirehair allocate
+    // for a geometry the payloads do not match.
+    const uint32_t expected_k = (hdr.chunk_size + hdr.symbol_size - 1) / hdr.symbol_size;
+    return hdr.k == expected_k && hdr.k >= 2 &&
+           static_cast<uint64_t>(hdr.esi) < static_cast<uint64_t>(hdr.k) * MAX_ESI_PER_SOURCE_SYMBOL;
+}
+
+uint32_t Decoder::chunk_count_limit() const {
+    if (expected_chunk_count_ > 0) {
+        return std::min(expected_chunk_count_, limits_.max_chunk_count);
+    }
+    const uint64_t window = static_cast<uint64_t>(chunk_table_.complete_count()) + UNCONFIRMED_CHUNK_WINDOW;
+    return static_cast<uint32_t>(std::min<uint64_t>(limits_.max_chunk_count, window));
+}
+
+void Decoder::set_limits(const DecoderLimits &limits) {
+    limits_ = limits;
+    limits_.max_chunk_count = std::min(limits_.max_chunk_count, MAX_CHUNK_COUNT);
+}
+
+void Decoder::set_expected_chunk_count(const uint32_t chunk_count) {
+    if (chunk_count > 0 && (expected_chunk_count_ == 0 || chunk_count < expected_chunk_count_)) {
+        expected_chunk_count_ = chunk_count;
+    }
+}
+
+uint32_t Decoder::open_decoder(const PacketHeader &hdr) {
+    uint32_t slot;
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(live_decoders_.size());
+        live_decoders_.emplace_back();
+    }
+    LiveDecoder &live = live_decoders_[slot];
+    // Buffering only pays off when the chunk may be evicted or its bytes are
+    // capped; otherwise symbols go straight to wirehair as they arrive.
+    const bool buffer_symbols = memory_budget_ > 0 || limits_.max_buffered_bytes > 0;
+    live.decoder.emplace(hdr.chunk_index, hdr.chunk_size, hdr.k, hdr.symbol_size, buffer_symbols);
+    live.lru_pos = lru_.insert(lru_.end(), hdr.chunk_index);
+    chunk_table_.set_live_slot(hdr.chunk_index, slot);
+    chunk_table_.set_state(hdr.chunk_index, ChunkState::Receiving);
+    ++live_count_;
+    return slot;
+}
+
+void Decoder::evict(const uint32_t slot) {
+    if (!spill_) {
+        spill_ = std::make_unique<SymbolSpill>(spill_dir_);
+    }
+
+    ChunkDecoder &decoder = *live_decoders_[slot].decoder;
+    const uint32_t chunk_index = decoder.chunk_index();
+    live_bytes_ -= decoder.memory_usage();
+    for (const auto &[esi, data]: decoder.take_buffered_symbols()) {
+        spill_->append(chunk_index, esi, data);
+    }
+    ++stats_.evictions;
+    forget(slot);
+    chunk_table_.set_state(chunk_index, ChunkState::Spilled);
+}
+
+void Decoder::forget(const uint32_t slot) {
+    LiveDecoder &live = live_decoders_[slot];
+    chunk_table_.set_live_slot(live.decoder->chunk_index(), ChunkStateTable::NO_SLOT);
+    lru_.erase(live.lru_pos);
+    live.decoder.reset();
+    free_slots_.push_back(slot);
+    --live_count_;
 }
 
 bool Decoder::is_chunk_complete(const uint32_t chunk_index) const {
-    return completed_chunks.contains(chunk_index);
+    return chunk_table_.is_complete(chunk_index);
+}
+
+std::optional<ChunkMargin> Decoder::chunk_margin(const uint32_t chunk_index) const {
+    if (!chunk_table_.is_complete(chunk_index)) {
+        return std::nullopt;
+    }
+    return margins_[chunk_index];
 }
 
 std::optional<std::vector<std::byte> > Decoder::get_chunk_data(const uint32_t chunk_index) const {
-    if (const auto it = completed_chunks.find(chunk_index); it != completed_chunks.end()) {
-        return it->second;
+    if (chunk_table_.is_complete(chunk_index) && chunk_index < chunk_data_.size()) {
+        return chunk_data_[chunk_index];
     }
     return std::nullopt;
 }
 
 std::vector<uint32_t> Decoder::completed_chunk_indices() const {
-    std::vector<uint32_t> indices;
-    indices.reserve(completed_chunks.size());
-    for (const auto &index: completed_chunks | std::views::keys) {
-        indices.push_back(index);
-    }
-    return indices;
+    return chunk_table_.complete_indices();
 }
 
 void Decoder::set_decrypt_key(const std::span<const std::byte, 32> key) {
@@ -443,59 +812,19 @@ void Decoder::clear_decrypt_key() {
 }
 
 namespace {
-    std::optional<std::vector<std::size_t> > compute_chunk_sizes(
-        const std::unordered_map<uint32_t, std::vector<std::byte> > &chunks,
-        const uint32_t expected_chunks,
-        const bool encrypted,
-        const bool decrypt_key_set) {
-        std::vector<std::size_t> sizes(expected_chunks);
-        for (const auto &[idx, chunk]: chunks) {
-            if (idx >= expected_chunks) {
-                return std::nullopt;
-            }
-            if (encrypted && decrypt_key_set) {
-                if (chunk.size() < CRYPTO_PLAIN_SIZE_HEADER) {
-                    return std::nullopt;
-                }
-                sizes[idx] = read_plain_size_from_header(chunk);
-                if (sizes[idx] > CHUNK_SIZE_BYTES) {
-                    return std::nullopt;
-                }
-            } else {
-                sizes[idx] = chunk.size();
-            }
-        }
-        return sizes;
-    }
-
-    std::vector<std::size_t> compute_prefix_offsets(const std::vector<std::size_t> &sizes) {
-        std::vector<std::size_t> offsets(sizes.size() + 1);
-        offsets[0] = 0;
-        for (std::size_t i = 0; i < sizes.size(); ++i) {
-            offsets[i + 1] = offsets[i] + sizes[i];
-        }
-        return offsets;
-    }
-
     void decrypt_and_copy_into(
         std::vector<std::byte> &result,
-        const std::unordered_map<uint32_t, std::vector<std::byte> > &chunks,
+        const std::vector<std::vector<std::byte> > &chunks,
         const uint32_t expected_chunks,
-        const std::vector<std::size_t> &offsets,
-        const std::vector<std::size_t> &sizes,
+        const std::vector<uint64_t> &offsets,
         const bool encrypted,
         const bool decrypt_key_set,
         const std::array<std::byte, 32> &decrypt_key,
         const std::array<std::byte, 16> &file_id) {
-        std::vector<const std::vector<std::byte> *> chunk_ptrs(expected_chunks);
-        for (uint32_t i = 0; i < expected_chunks; ++i) {
-            chunk_ptrs[i] = &chunks.at(i);
-        }
-
 #pragma omp parallel for schedule(static)
         for (int i = 0; i < static_cast<int>(expected_chunks); ++i) {
-            const auto &chunk = *chunk_ptrs[i];
-            const std::size_t copy_size = sizes[i];
+            const auto &chunk = chunks[i];
+            const std::size_t copy_size = offsets[i + 1] - offsets[i];
             if (encrypted && decrypt_key_set) {
                 decrypt_chunk_into(
                     std::span<std::byte>(result.data() + offsets[i], copy_size),
@@ -507,98 +836,97 @@ namespace {
     }
 }
 
-std::optional<std::vector<std::byte> > Decoder::assemble_file(const uint32_t expected_chunks) const {
-    if (completed_chunks.size() != expected_chunks) {
-        return std::nullopt;
-    }
-    for (const auto &idx: completed_chunks | std::views::keys) {
-        if (idx >= expected_chunks) {
-            return std::nullopt;
-        }
+bool Decoder::assembly_ready(const uint32_t expected_chunks, const SuppliedChunks &supplied) const {
+    if (!retain_chunk_data_) {
+        return false;
     }
     if (encrypted_ && !decrypt_key_set_) {
-        return std::nullopt;
+        return false;
     }
     if (!id) {
-        return std::nullopt;
+        return false;
+    }
+    // Every chunk must be decoded or supplied, and none decoded past the end.
+    uint32_t decoded = 0;
+    for (uint32_t i = 0; i < expected_chunks; ++i) {
+        const bool complete = chunk_table_.is_complete(i);
+        decoded += complete ? 1 : 0;
+        if (i < supplied.size() && supplied[i]) {
+            continue;
+        }
+        if (!complete) {
+            return false;
+        }
+        if (encrypted_ && (chunk_data_[i].size() < CRYPTO_PLAIN_SIZE_HEADER ||
+                           chunk_table_.output_size(i) > CHUNK_SIZE_BYTES)) {
+            return false;
+        }
     }
+    return decoded == chunk_table_.complete_count();
+}
 
-    const auto chunk_sizes = compute_chunk_sizes(
-        completed_chunks, expected_chunks, encrypted_, decrypt_key_set_);
-    if (!chunk_sizes) {
+std::optional<std::vector<std::byte> > Decoder::assemble_file(const uint32_t expected_chunks) const {
+    if (!assembly_ready(expected_chunks)) {
         return std::nullopt;
     }
-    const auto offsets = compute_prefix_offsets(*chunk_sizes);
+
+    const auto offsets = chunk_table_.offsets(expected_chunks);
     std::vector<std::byte> result(offsets[expected_chunks]);
-    decrypt_and_copy_into(result, completed_chunks, expected_chunks, offsets,
-                          *chunk_sizes, encrypted_, decrypt_key_set_, decrypt_key_, *id);
+    decrypt_and_copy_into(result, chunk_data_, expected_chunks, offsets,
+                          encrypted_, decrypt_key_set_, decrypt_key_, *id);
     return result;
 }
 
 bool Decoder::write_assembled_file(const std::string &output_path, const uint32_t expected_chunks) const {
-    if (completed_chunks.size() != expected_chunks) {
-        return false;
-    }
-    for (const auto &idx : completed_chunks | std::views::keys) {
-        if (idx >= expected_chunks) {
-            return false;
-        }
-    }
-    if (encrypted_ && !decrypt_key_set_) {
-        return false;
-    }
-    if (!id) {
+    return write_assembled_file(output_path, expected_chunks, {}, {});
+}
+
+bool Decoder::write_assembled_file(const std::string &output_path, const uint32_t expected_chunks,
+                                   const SuppliedChunks &supplied, const WrittenChunkCallback &on_written) const {
+    if (!assembly_ready(expected_chunks, supplied)) {
         return false;
     }
+    const auto is_supplied = [&](const uint32_t i) { return i < supplied.size() && supplied[i].has_value(); };
 
     std::ofstream out(output_path, std::ios::binary);
     if (!out) {
         return false;
     }
 
+    std::vector<std::vector<std::byte>> decrypted_chunks;
     if (encrypted_ && decrypt_key_set_) {
-        std::vector<std::size_t> sizes(expected_chunks);
-        for (uint32_t i = 0; i < expected_chunks; ++i) {
-            const auto &chunk = completed_chunks.at(i);
-            if (chunk.size() < CRYPTO_PLAIN_SIZE_HEADER) {
-                return false;
-            }
-            sizes[i] = read_plain_size_from_header(chunk);
-            if (sizes[i] > CHUNK_SIZE_BYTES) {
-                return false;
-            }
-        }
-
-        std::vector<std::vector<std::byte>> decrypted_chunks(expected_chunks);
+        decrypted_chunks.resize(expected_chunks);
         bool decrypt_error = false;
 
 #pragma omp parallel for schedule(static)
         for (int i = 0; i < static_cast<int>(expected_chunks); ++i) {
-            if (decrypt_error) continue;
+            if (decrypt_error || is_supplied(static_cast<uint32_t>(i))) continue;
             try {
-                decrypted_chunks[i].resize(sizes[i]);
+                const uint32_t size = chunk_table_.output_size(static_cast<uint32_t>(i));
+                decrypted_chunks[i].resize(size);
                 decrypt_chunk_into(
-                    std::span<std::byte>(decrypted_chunks[i].data(), sizes[i]),
-                    completed_chunks.at(static_cast<uint32_t>(i)),
-                    decrypt_key_, *id, static_cast<uint32_t>(i));
+                    std::span<std::byte>(decrypted_chunks[i].data(), size),
+                    chunk_data_[i], decrypt_key_, *id, static_cast<uint32_t>(i));
             } catch (...) {
                 decrypt_error = true;
             }
         }
 
         if (decrypt_error) return false;
+    }
 
-        for (uint32_t i = 0; i < expected_chunks; ++i) {
-            out.write(reinterpret_cast<const char *>(decrypted_chunks[i].data()),
-                      static_cast<std::streamsize>(sizes[i]));
-            if (!out.good()) return false;
-        }
-    } else {
-        for (uint32_t i = 0; i < expected_chunks; ++i) {
-            const auto &chunk = completed_chunks.at(i);
-            out.write(reinterpret_cast<const char *>(chunk.data()),
-                      static_cast<std::streamsize>(chunk.size()));
-            if (!out.good()) return false;
+    for (uint32_t i = 0; i < expected_chunks; ++i) {
+        const bool from_caller = is_supplied(i);
+        const std::vector<std::byte> &chunk = from_caller
+                                                  ? *supplied[i]
+                                                  : decrypted_chunks.empty()
+                                                  ? chunk_data_[i]
+                                                  : decrypted_chunks[i];
+        out.write(reinterpret_cast<const char *>(chunk.data()),
+                  static_cast<std::streamsize>(chunk.size()));
+        if (!out.good()) return false;
+        if (on_written && !from_caller) {
+            on_written(i, chunk);
         }
     }
 
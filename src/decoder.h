@@ -21,14 +21,22 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <span>
 #include <vector>
 
+#include "chunk_table.h"
 #include "configuration.h"
 #include "integrity.h"
+#include "manifest.h"
+#include "symbol_spill.h"
 
 struct PacketHeader {
     uint32_t magic = 0;
@@ -51,16 +59,89 @@ struct DecodedPacket {
     std::array<std::byte, HEADER_SIZE_V2> raw_header{};
 };
 
+// A wirehair codec that was switched from decoding to encoding once its chunk
+// recovered, plus the header of the packet that completed it. Owns the codec.
+class RecoveredCodec {
+public:
+    RecoveredCodec() = default;
+
+    RecoveredCodec(void *codec, const PacketHeader &header) : codec_(codec), header_(header) {
+    }
+
+    ~RecoveredCodec();
+
+    RecoveredCodec(const RecoveredCodec &) = delete;
+
+    RecoveredCodec &operator=(const RecoveredCodec &) = delete;
+
+    RecoveredCodec(RecoveredCodec &&other) noexcept;
+
+    RecoveredCodec &operator=(RecoveredCodec &&other) noexcept;
+
+    [[nodiscard]] void *get() const { return codec_; }
+
+    [[nodiscard]] explicit operator bool() const { return codec_ != nullptr; }
+
+    [[nodiscard]] const PacketHeader &header() const { return header_; }
+
+private:
+    void *codec_ = nullptr;
+    PacketHeader header_{};
+};
+
 struct ChunkDecodeResult {
     uint32_t chunk_index = 0;
     std::vector<std::byte> data;
     Sha256Digest sha256{};
     bool success = false;
+    RecoveredCodec codec; // only with Decoder::set_hand_off_codecs(true)
 };
 
+// Encoding symbol ids are at most N + N * MAX_REPAIR_OVERHEAD; anything past
+// twice that is garbage and would only bloat the per-chunk duplicate bitmap.
+constexpr uint32_t MAX_ESI_PER_SOURCE_SYMBOL = static_cast<uint32_t>(2 * (1 + MAX_REPAIR_OVERHEAD));
+
+// Until FileInfo or the last chunk gives the chunk count, a packet may only
+// name a chunk within this many of those already decoded. The per-chunk tables
+// are dense, so one forged index near MAX_CHUNK_COUNT would otherwise size
+// them for the whole range.
+constexpr uint32_t UNCONFIRMED_CHUNK_WINDOW = 1u << 16;
+
+// Hard bounds on what a single Decoder may allocate, checked for every packet
+// before any decoder state is created. Zero disables a bound.
+struct DecoderLimits {
+    uint32_t max_chunk_size = CHUNK_SIZE_BYTES;
+    uint32_t max_chunk_count = MAX_CHUNK_COUNT;
+    std::size_t max_live_decoders = 0;
+    std::size_t max_buffered_bytes = 0;
+};
+
+struct DecoderMemoryStats {
+    std::size_t live_decoders = 0;
+    std::size_t live_bytes = 0;
+    std::size_t peak_live_bytes = 0;
+    std::size_t spilled_chunks = 0;
+    uint64_t spill_bytes = 0;
+    uint64_t evictions = 0;
+    uint64_t reingests = 0;
+};
+
+// FEC headroom of a completed chunk: how many symbols the decoder consumed
+// before it succeeded and how many more valid symbols arrived afterwards.
+struct ChunkMargin {
+    uint32_t k = 0;
+    uint32_t used = 0;
+    uint32_t spare = 0;
+};
+
+// With buffer_symbols, symbols are buffered until k of them have arrived and
+// the wirehair decoder is only created once decoding can actually succeed.
+// Until then the chunk is cheap to evict because its whole state is the
+// buffered symbols. Without it, every symbol goes straight to wirehair.
 class ChunkDecoder {
 public:
-    explicit ChunkDecoder(uint32_t chunk_index, uint32_t chunk_size, uint32_t k, uint16_t symbol_size);
+    explicit ChunkDecoder(uint32_t chunk_index, uint32_t chunk_size, uint32_t k, uint16_t symbol_size,
+                          bool buffer_symbols = true);
 
     ~ChunkDecoder();
 
@@ -84,6 +165,22 @@ public:
 
     [[nodiscard]] uint32_t packets_received() const { return packets_received_; }
 
+    [[nodiscard]] uint32_t chunk_size() const { return chunk_size_; }
+
+    [[nodiscard]] uint32_t k() const { return k_; }
+
+    [[nodiscard]] uint16_t symbol_size() const { return symbol_size_; }
+
+    [[nodiscard]] bool has_codec() const { return codec_ != nullptr; }
+
+    [[nodiscard]] std::size_t memory_usage() const;
+
+    [[nodiscard]] std::vector<SpilledSymbol> take_buffered_symbols();
+
+    // Switches the codec of a recovered chunk to encoding and gives it away;
+    // nullptr if the chunk is not complete.
+    [[nodiscard]] void *release_encoder();
+
 private:
     uint32_t chunk_index_;
     uint32_t chunk_size_;
@@ -93,6 +190,13 @@ private:
     bool decoded_ = false;
     uint32_t packets_received_ = 0;
     std::vector<std::byte> decoded_data_;
+    std::vector<std::byte> buffered_data_;
+    std::vector<std::pair<uint32_t, uint32_t> > buffered_symbols_; // (esi, length)
+    std::vector<uint64_t> seen_esi_;
+
+    void create_codec();
+
+    [[nodiscard]] bool decode_symbol(uint32_t esi, std::span<const std::byte> payload);
 };
 
 class Decoder {
@@ -119,7 +223,9 @@ public:
 
     [[nodiscard]] size_t total_packets_received() const { return total_packets_; }
 
-    [[nodiscard]] size_t chunks_completed() const { return completed_chunks.size(); }
+    [[nodiscard]] size_t chunks_completed() const { return chunk_table_.complete_count(); }
+
+    [[nodiscard]] const ChunkStateTable &chunk_table() const { return chunk_table_; }
 
     [[nodiscard]] std::vector<uint32_t> completed_chunk_indices() const;
 
@@ -127,18 +233,132 @@ public:
 
     [[nodiscard]] bool write_assembled_file(const std::string &output_path, uint32_t expected_chunks) const;
 
+    // Plaintext of chunks the caller already holds, e.g. from the chunk cache,
+    // by chunk index; the decoder need not have received them.
+    using SuppliedChunks = std::vector<std::optional<std::vector<std::byte> > >;
+
+    // Sees the plaintext of every chunk the decoder itself decoded, in chunk
+    // order, as it is written.
+    using WrittenChunkCallback = std::function<void(uint32_t chunk_index, std::span<const std::byte> plaintext)>;
+
+    // Writes chunk i from supplied[i] when it is set and from the decoded data
+    // otherwise.
+    [[nodiscard]] bool write_assembled_file(const std::string &output_path, uint32_t expected_chunks,
+                                            const SuppliedChunks &supplied,
+                                            const WrittenChunkCallback &on_written) const;
+
     void set_decrypt_key(std::span<const std::byte, 32> key);
 
     void clear_decrypt_key();
 
     [[nodiscard]] bool is_encrypted() const { return encrypted_; }
 
+    // Caps the memory held by partially received chunks. Chunks that are still
+    // buffering symbols are evicted least recently used first to a spill file
+    // in spill_dir (system temp dir if empty) and brought back once they have
+    // enough symbols to decode. A budget of 0 disables eviction.
+    void set_memory_budget(std::size_t bytes, const std::string &spill_dir = {});
+
+    [[nodiscard]] DecoderMemoryStats memory_stats() const;
+
+    void set_limits(const DecoderLimits &limits);
+
+    [[nodiscard]] const DecoderLimits &limits() const { return limits_; }
+
+    // Narrows the accepted chunk index range once the real chunk count is known
+    // (from a confirmed LastChunk packet or the manifest). Never widens it.
+    void set_expected_chunk_count(uint32_t chunk_count);
+
+    [[nodiscard]] uint32_t expected_chunk_count() const { return expected_chunk_count_; }
+
+    [[nodiscard]] uint64_t packets_rejected() const { return packets_rejected_; }
+
+    // Manifest packets never surface from process_packet; their decoded
+    // segments are collected here. A FileInfo segment also fixes the expected
+    // chunk count.
+    [[nodiscard]] const ArchiveManifest &manifest() const { return manifest_; }
+
+    // When false, completed chunks are handed to the caller in the result and
+    // not kept for assembly, so memory stays flat for verification passes.
+    void set_retain_chunk_data(bool retain) { retain_chunk_data_ = retain; }
+
+    [[nodiscard]] std::optional<ChunkMargin> chunk_margin(uint32_t chunk_index) const;
+
+    // Hand each completed chunk's codec to the caller as an encoder so it can
+    // be re-encoded without another pass over its data.
+    void set_hand_off_codecs(bool hand_off) { hand_off_codecs_ = hand_off; }
+
 private:
     std::optional<FileId> id;
     bool encrypted_ = false;
     std::array<std::byte, 32> decrypt_key_{};
     bool decrypt_key_set_ = false;
-    std::unordered_map<uint32_t, ChunkDecoder> active_decoders;
-    std::unordered_map<uint32_t, std::vector<std::byte> > completed_chunks;
+    // Live decoders sit in a slot pool and the chunk table maps each chunk to
+    // its slot, so a packet finds its decoder with two array reads.
+    struct LiveDecoder {
+        std::optional<ChunkDecoder> decoder;
+        std::list<uint32_t>::iterator lru_pos;
+    };
+
+    std::vector<LiveDecoder> live_decoders_;
+    std::vector<uint32_t> free_slots_;
+    std::size_t live_count_ = 0;
+    ChunkStateTable chunk_table_;
+    std::vector<std::vector<std::byte> > chunk_data_;
+    std::vector<ChunkMargin> margins_;
+    bool retain_chunk_data_ = true;
+    bool hand_off_codecs_ = false;
+    bool data_seen_ = false;
     size_t total_packets_ = 0;
+
+    ArchiveManifest manifest_;
+    std::unordered_map<uint32_t, ChunkDecoder> manifest_decoders_;
+    std::unordered_set<uint32_t> manifest_segments_done_;
+    std::map<uint32_t, std::vector<std::byte> > pending_manifest_;
+
+    std::size_t memory_budget_ = 0;
+    std::string spill_dir_;
+    std::unique_ptr<SymbolSpill> spill_;
+    std::list<uint32_t> lru_;
+    std::size_t live_bytes_ = 0;
+    DecoderMemoryStats stats_{};
+    DecoderLimits limits_{};
+    uint32_t expected_chunk_count_ = 0;
+    // LastChunk packets only narrow the range once two distinct ESIs of the
+    // same chunk carry the flag; a lone packet may be damaged or injected.
+    uint32_t last_chunk_candidate_ = 0;
+    std::optional<uint32_t> last_chunk_esi_;
+    uint64_t packets_rejected_ = 0;
+
+    [[nodiscard]] bool admit(const PacketHeader &hdr) const;
+
+    [[nodiscard]] bool admit_geometry(const PacketHeader &hdr) const;
+
+    [[nodiscard]] uint32_t chunk_count_limit() const;
+
+    [[nodiscard]] bool make_room(uint32_t chunk_index, std::size_t incoming_bytes, bool new_decoder);
+
+    [[nodiscard]] bool evict_one(uint32_t keep_chunk);
+
+    [[nodiscard]] std::optional<ChunkDecodeResult> route_packet(const PacketHeader &hdr,
+                                                                std::span<const std::byte> payload,
+                                                                bool compute_sha256);
+
+    void ingest_manifest(const PacketHeader &hdr, std::span<const std::byte> payload);
+
+    bool accept_manifest_segment(uint32_t segment, std::span<const std::byte> data);
+
+    [[nodiscard]] std::optional<ChunkDecodeResult> ingest_symbol(const PacketHeader &hdr,
+                                                                 std::span<const std::byte> payload,
+                                                                 bool compute_sha256);
+
+    void enforce_memory_budget(uint32_t keep_chunk);
+
+    [[nodiscard]] uint32_t open_decoder(const PacketHeader &hdr);
+
+    void evict(uint32_t slot);
+
+    void forget(uint32_t slot);
+
+    [[nodiscard]] bool assembly_ready(uint32_t expected_chunks, const SuppliedChunks &supplied = {}) const;
 };
@@ -29,6 +29,21 @@
 #include <QHeaderView>
 #include <QFileInfo>
 #include <QDateTime>
+#include <QLocale>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+// Dashboard refresh period of the batch queue, however fast jobs report.
+static constexpr int BATCH_REFRESH_MS = 100;
+
+// The catalog encodes are recorded in and the Archives list shows; empty if
+// there is no default location.
+static std::string default_catalog_path() {
+    char buffer[4096];
+    return ms_catalog_default_path(buffer, sizeof(buffer)) == MS_OK ? buffer : "";
+}
 
 WorkerThread::WorkerThread(const Operation op, const QString &input, const QString &output,
                            const bool encrypt, const QString &password,
@@ -39,11 +54,18 @@ WorkerThread::WorkerThread(const Operation op, const QString &input, const QStri
       streamWidth(streamWidth), streamHeight(streamHeight) {
 }
 
+void WorkerThread::reportProgress(const int percentage) {
+    if (percentage != lastPercentage) {
+        lastPercentage = percentage;
+        emit progressUpdated(percentage);
+    }
+}
+
 static int gui_encode_progress(const uint64_t current, const uint64_t total, void *user) {
     auto *thread = static_cast<WorkerThread *>(user);
     if (total > 0) {
         const int pct = 5 + static_cast<int>(90 * (current + 1) / total);
-        emit thread->progressUpdated(pct);
+        thread->reportProgress(pct);
     }
     return 0;
 }
@@ -52,7 +74,7 @@ static int gui_decode_progress(const uint64_t current, const uint64_t total, voi
     auto *thread = static_cast<WorkerThread *>(user);
     if (total > 0) {
         const int pct = 10 + static_cast<int>(70 * current / total);
-        emit thread->progressUpdated(pct);
+        thread->reportProgress(pct);
     }
     return 0;
 }
@@ -61,7 +83,7 @@ static int gui_stream_encode_progress(const uint64_t current, const uint64_t tot
     auto *thread = static_cast<WorkerThread *>(user);
     if (total > 0) {
         const int pct = 5 + static_cast<int>(90 * (current + 1) / total);
-        emit thread->progressUpdated(pct);
+        thread->reportProgress(pct);
     }
     return 0;
 }
@@ -70,9 +92,9 @@ static int gui_stream_decode_progress(const uint64_t current, const uint64_t tot
     auto *thread = static_cast<WorkerThread *>(user);
     if (total > 0) {
         const int pct = 10 + static_cast<int>(70 * current / total);
-        emit thread->progressUpdated(pct);
+        thread->reportProgress(pct);
     } else if (current > 0) {
-        emit thread->progressUpdated(std::min(static_cast<int>(current % 90) + 10, 95));
+        thread->reportProgress(std::min(static_cast<int>(current % 90) + 10, 95));
     }
     return 0;
 }
@@ -99,6 +121,8 @@ void WorkerThread::run() {
         opts.hash_algorithm = MS_HASH_CRC32;
         opts.progress = gui_encode_progress;
         opts.progress_user = this;
+        const std::string catalog = default_catalog_path();
+        opts.catalog_path = catalog.empty() ? nullptr : catalog.c_str();
 
         ms_result_t result{};
 
@@ -114,11 +138,25 @@ void WorkerThread::run() {
         }
     } else if (operation == Decode) {
         emit statusUpdated("Starting decoding process...");
-        emit logMessage("Decoding: " + inputPath + " -> " + outputPath);
         emit progressUpdated(10);
 
+        std::vector<std::string> inputs;
+        std::vector<const char *> input_ptrs;
+        for (const QString &path: inputPaths) {
+            emit logMessage("Decoding: " + path + " -> " + outputPath);
+            inputs.push_back(path.toStdString());
+        }
+        for (const std::string &path: inputs) {
+            input_ptrs.push_back(path.c_str());
+        }
+        if (inputs.empty()) {
+            emit logMessage("Decoding: " + inputPath + " -> " + outputPath);
+        }
+
         ms_decode_options_t opts{};
         opts.input_path = input.c_str();
+        opts.input_paths = input_ptrs.data();
+        opts.input_count = input_ptrs.size();
         opts.output_path = output.c_str();
         opts.password = pw.c_str();
         opts.password_len = pw.size();
@@ -203,6 +241,66 @@ void WorkerThread::run() {
     }
 }
 
+BatchJobThread::BatchJobThread(const int index, BatchJob &job, const QElapsedTimer &clock, const int threads,
+                               const bool encrypt, const QString &password, const std::atomic<bool> &cancel,
+                               QObject *parent)
+    : QThread(parent), index(index), job(job), clock(clock), threads(threads), encrypt(encrypt),
+      password(password), cancel(cancel) {
+}
+
+int BatchJobThread::progress(const uint64_t current, const uint64_t total, void *user) {
+    const auto *thread = static_cast<BatchJobThread *>(user);
+    BatchJob &job = thread->job;
+    job.chunksTotal.store(total, std::memory_order_relaxed);
+    job.chunksDone.store(std::min(current + 1, total), std::memory_order_relaxed);
+    if (total > 0 && current + 1 >= total && job.stage.load() == BatchJob::Encoding) {
+        // The last chunk is in; what remains is flushing the encoder and the
+        // manifest.
+        job.finalizingMs.store(thread->clock.elapsed());
+        job.stage.store(BatchJob::Finalizing);
+    }
+    return thread->cancel.load(std::memory_order_relaxed) ? 1 : 0;
+}
+
+void BatchJobThread::run() {
+    ms_set_thread_count(threads);
+
+    const std::string input = job.inputPath.toStdString();
+    const std::string output = job.outputPath.toStdString();
+    const std::string pw = password.toStdString();
+
+    job.startedMs.store(clock.elapsed());
+    job.stage.store(BatchJob::Encoding);
+
+    ms_encode_options_t opts{};
+    opts.input_path = input.c_str();
+    opts.output_path = output.c_str();
+    opts.encrypt = encrypt ? 1 : 0;
+    opts.password = pw.c_str();
+    opts.password_len = pw.size();
+    opts.hash_algorithm = MS_HASH_CRC32;
+    opts.progress = progress;
+    opts.progress_user = this;
+    const std::string catalog = default_catalog_path();
+    opts.catalog_path = catalog.empty() ? nullptr : catalog.c_str();
+
+    ms_result_t result{};
+    const ms_status_t status = ms_encode(&opts, &result);
+
+    if (job.finalizingMs.load() < 0) {
+        job.finalizingMs.store(clock.elapsed());
+    }
+    job.finishedMs.store(clock.elapsed());
+    job.stage.store(status == MS_OK ? BatchJob::Done : BatchJob::Failed);
+
+    if (status == MS_OK) {
+        emit jobFinished(index, true, QString("%1 chunks in %2 frames").arg(result.total_chunks)
+                         .arg(result.total_frames));
+    } else {
+        emit jobFinished(index, false, QString("Error: %1").arg(ms_status_string(status)));
+    }
+}
+
 DriveManagerUI::DriveManagerUI(QWidget *parent)
     : QMainWindow(parent), isOperationRunning(false) {
     setWindowTitle("YouTube Media Storage - Drive Manager");
@@ -213,6 +311,7 @@ DriveManagerUI::DriveManagerUI(QWidget *parent)
     setupMenuBar();
     setupStatusBar();
     connectSignals();
+    refreshArchives();
 
     resetProgress();
     logMessage("Drive Manager initialized");
@@ -223,6 +322,10 @@ DriveManagerUI::~DriveManagerUI() {
         workerThread->quit();
         workerThread->wait();
     }
+    batchCancel = true;
+    for (const auto &thread: batchThreads) {
+        thread->wait();
+    }
     saveSettings();
 }
 
@@ -278,6 +381,38 @@ void DriveManagerUI::setupUI() {
 
     leftLayout->addWidget(fileOperationsGroup);
 
+    // Archives group: everything recorded in the catalog, restorable without
+    // knowing where its videos are
+    archivesGroup = new QGroupBox("Archives");
+    auto *archivesLayout = new QVBoxLayout(archivesGroup);
+
+    archiveSearchEdit = new QLineEdit();
+    archiveSearchEdit->setPlaceholderText("Search by file name");
+    archiveSearchEdit->setClearButtonEnabled(true);
+    archivesLayout->addWidget(archiveSearchEdit);
+
+    archiveTable = new QTableWidget(0, 4);
+    archiveTable->setHorizontalHeaderLabels({"Name", "Size", "Videos", "Recorded"});
+    archiveTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    archiveTable->verticalHeader()->setVisible(false);
+    archiveTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    archiveTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    archiveTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    archivesLayout->addWidget(archiveTable);
+
+    auto *archiveButtonsLayout = new QHBoxLayout();
+    addArchivesButton = new QPushButton("Add Videos...");
+    addArchivesButton->setToolTip("Record videos encoded elsewhere in the catalog");
+    restoreArchiveButton = new QPushButton("Restore Selected...");
+    restoreArchiveButton->setIcon(QIcon::fromTheme("document-open"));
+    refreshArchivesButton = new QPushButton("Refresh");
+    archiveButtonsLayout->addWidget(addArchivesButton);
+    archiveButtonsLayout->addWidget(restoreArchiveButton);
+    archiveButtonsLayout->addWidget(refreshArchivesButton);
+    archivesLayout->addLayout(archiveButtonsLayout);
+
+    leftLayout->addWidget(archivesGroup);
+
     // Batch operations group
     batchGroup = new QGroupBox("Batch Operations");
     auto *batchLayout = new QVBoxLayout(batchGroup);
@@ -304,6 +439,21 @@ void DriveManagerUI::setupUI() {
     batchOutputLayout->addWidget(batchOutputButton);
     batchLayout->addLayout(batchOutputLayout);
 
+    const int cores = std::max(1, QThread::idealThreadCount());
+    auto *batchConcurrencyLayout = new QHBoxLayout();
+    batchConcurrencyLayout->addWidget(new QLabel("Parallel jobs:"));
+    batchJobsSpinBox = new QSpinBox();
+    batchJobsSpinBox->setRange(1, 16);
+    batchJobsSpinBox->setValue(std::min(2, cores));
+    batchConcurrencyLayout->addWidget(batchJobsSpinBox);
+    batchConcurrencyLayout->addWidget(new QLabel("Thread budget:"));
+    threadBudgetSpinBox = new QSpinBox();
+    threadBudgetSpinBox->setRange(1, cores * 2);
+    threadBudgetSpinBox->setValue(cores);
+    threadBudgetSpinBox->setToolTip("Worker threads shared by all running jobs");
+    batchConcurrencyLayout->addWidget(threadBudgetSpinBox);
+    batchLayout->addLayout(batchConcurrencyLayout);
+
     batchEncodeButton = new QPushButton("Batch Encode All");
     batchEncodeButton->setIcon(QIcon::fromTheme("document-save-all"));
     batchLayout->addWidget(batchEncodeButton);
@@ -379,6 +529,27 @@ void DriveManagerUI::setupUI() {
 
     rightLayout->addWidget(statusGroup);
 
+    // Batch queue group
+    queueGroup = new QGroupBox("Batch Queue");
+    auto *queueLayout = new QVBoxLayout(queueGroup);
+
+    jobTable = new QTableWidget(0, 6);
+    jobTable->setHorizontalHeaderLabels({"File", "Stage", "Progress", "MB/s", "ETA", "Time per stage"});
+    jobTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    jobTable->horizontalHeader()->setSectionResizeMode(5, QHeaderView::ResizeToContents);
+    jobTable->verticalHeader()->setVisible(false);
+    jobTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    jobTable->setSelectionMode(QAbstractItemView::NoSelection);
+    queueLayout->addWidget(jobTable);
+
+    queueSummaryLabel = new QLabel("No batch running");
+    queueLayout->addWidget(queueSummaryLabel);
+
+    rightLayout->addWidget(queueGroup);
+
+    dashboardTimer = new QTimer(this);
+    dashboardTimer->setInterval(BATCH_REFRESH_MS);
+
     // Logs group
     logsGroup = new QGroupBox("Logs");
     auto *logsLayout = new QVBoxLayout(logsGroup);
@@ -437,6 +608,13 @@ void DriveManagerUI::connectSignals() {
     connect(clearFilesButton, &QPushButton::clicked, this, &DriveManagerUI::clearFileList);
     connect(batchOutputButton, &QPushButton::clicked, this, &DriveManagerUI::selectOutputDirectory);
     connect(batchEncodeButton, &QPushButton::clicked, this, &DriveManagerUI::startBatchEncode);
+    connect(dashboardTimer, &QTimer::timeout, this, &DriveManagerUI::refreshBatchDashboard);
+
+    connect(archiveSearchEdit, &QLineEdit::textChanged, this, &DriveManagerUI::refreshArchives);
+    connect(addArchivesButton, &QPushButton::clicked, this, &DriveManagerUI::addArchiveVideos);
+    connect(restoreArchiveButton, &QPushButton::clicked, this, &DriveManagerUI::restoreSelectedArchive);
+    connect(refreshArchivesButton, &QPushButton::clicked, this, &DriveManagerUI::refreshArchives);
+    connect(archiveTable, &QTableWidget::cellDoubleClicked, this, &DriveManagerUI::restoreSelectedArchive);
 
     connect(clearLogsButton, &QPushButton::clicked, this, &DriveManagerUI::clearLogs);
     connect(passwordVisibilityButton, &QPushButton::clicked, this, &DriveManagerUI::togglePasswordVisibility);
@@ -593,20 +771,206 @@ void DriveManagerUI::startBatchEncode() {
         return;
     }
 
-    logMessage("Batch encoding not yet implemented - processing first file only");
+    batchEncrypt = encryptCheckBox->isChecked();
+    batchPassword = passwordEdit->text();
+    if (batchEncrypt && batchPassword.isEmpty()) {
+        QMessageBox::warning(this, "Warning", "Password required when encrypting");
+        return;
+    }
+
+    batchJobs.clear();
+    batchThreads.clear();
+    jobTable->setRowCount(0);
+    QStringList outputs;
+    for (int i = 0; i < fileListWidget->count(); ++i) {
+        auto job = std::make_unique<BatchJob>();
+        job->inputPath = fileListWidget->item(i)->text();
+        const QFileInfo fileInfo(job->inputPath);
+        job->inputSize = fileInfo.size();
+
+        // Files with the same base name from different folders must not
+        // overwrite each other's video.
+        QString outputPath = batchOutputDirEdit->text() + "/" + fileInfo.baseName() + ".mkv";
+        for (int n = 2; outputs.contains(outputPath); ++n) {
+            outputPath = batchOutputDirEdit->text() + "/" + fileInfo.baseName() + QString("_%1.mkv").arg(n);
+        }
+        outputs.append(outputPath);
+        job->outputPath = outputPath;
+
+        const int row = jobTable->rowCount();
+        jobTable->insertRow(row);
+        jobTable->setItem(row, 0, new QTableWidgetItem(fileInfo.fileName()));
+        jobTable->item(row, 0)->setToolTip(job->inputPath + " -> " + job->outputPath);
+        for (int column = 1; column < jobTable->columnCount(); ++column) {
+            if (column == 2) {
+                auto *bar = new QProgressBar();
+                bar->setRange(0, 100);
+                jobTable->setCellWidget(row, column, bar);
+            } else {
+                jobTable->setItem(row, column, new QTableWidgetItem());
+            }
+        }
+        batchJobs.push_back(std::move(job));
+    }
+
+    // Running jobs split the thread budget evenly; the library caps each
+    // job's worker threads at its share.
+    const int parallel = std::min(batchJobsSpinBox->value(), static_cast<int>(batchJobs.size()));
+    batchJobThreads = std::max(1, threadBudgetSpinBox->value() / parallel);
+    nextBatchJob = 0;
+    runningBatchJobs = 0;
+    batchCancel = false;
+
+    isOperationRunning = true;
+    currentOperation = "Batch Encoding";
+    encodeButton->setEnabled(false);
+    decodeButton->setEnabled(false);
+    streamEncodeButton->setEnabled(false);
+    streamDecodeButton->setEnabled(false);
+    batchEncodeButton->setEnabled(false);
+    batchJobsSpinBox->setEnabled(false);
+    threadBudgetSpinBox->setEnabled(false);
+
+    logMessage(QString("Batch encoding %1 files, %2 at a time with %3 threads each")
+        .arg(batchJobs.size()).arg(parallel).arg(batchJobThreads));
+    if (batchEncrypt) {
+        logMessage("Encrypting chunks with password");
+    }
+
+    batchClock.start();
+    launchBatchJobs();
+    refreshBatchDashboard();
+    dashboardTimer->start();
+}
 
-    if (const QListWidgetItem *firstItem = fileListWidget->item(0)) {
-        const QString inputPath = firstItem->text();
-        const QFileInfo fileInfo(inputPath);
-        const QString outputPath = batchOutputDirEdit->text() + "/" + fileInfo.baseName() + ".mkv";
+void DriveManagerUI::launchBatchJobs() {
+    while (runningBatchJobs < batchJobsSpinBox->value() && nextBatchJob < batchJobs.size()) {
+        const int index = static_cast<int>(nextBatchJob++);
+        auto thread = std::make_unique<BatchJobThread>(index, *batchJobs[index], batchClock, batchJobThreads,
+                                                       batchEncrypt, batchPassword, batchCancel, this);
+        connect(thread.get(), &BatchJobThread::jobFinished, this, &DriveManagerUI::onBatchJobFinished);
+        thread->start();
+        batchThreads.push_back(std::move(thread));
+        ++runningBatchJobs;
+    }
+}
 
-        inputFileEdit->setText(inputPath);
-        outputFileEdit->setText(outputPath);
+void DriveManagerUI::onBatchJobFinished(const int index, const bool success, const QString &message) {
+    --runningBatchJobs;
+    const QString name = QFileInfo(batchJobs[index]->inputPath).fileName();
+    logMessage((success ? "✓ " : "✗ ") + name + ": " + message);
 
-        startEncode();
+    launchBatchJobs();
+    if (runningBatchJobs == 0 && nextBatchJob == batchJobs.size()) {
+        finishBatch();
     }
 }
 
+void DriveManagerUI::finishBatch() {
+    dashboardTimer->stop();
+    refreshBatchDashboard();
+    for (const auto &thread: batchThreads) {
+        thread->wait();
+    }
+    batchThreads.clear();
+
+    isOperationRunning = false;
+    encodeButton->setEnabled(true);
+    decodeButton->setEnabled(true);
+    streamEncodeButton->setEnabled(true);
+    streamDecodeButton->setEnabled(true);
+    batchEncodeButton->setEnabled(true);
+    batchJobsSpinBox->setEnabled(true);
+    threadBudgetSpinBox->setEnabled(true);
+
+    const auto failed = std::count_if(batchJobs.begin(), batchJobs.end(), [](const auto &job) {
+        return job->stage.load() == BatchJob::Failed;
+    });
+    const QString message = QString("Batch finished: %1 of %2 files encoded in %3 s")
+            .arg(static_cast<qsizetype>(batchJobs.size()) - failed).arg(batchJobs.size())
+            .arg(static_cast<double>(batchClock.elapsed()) / 1000.0, 0, 'f', 1);
+    batchPassword.clear();
+    resetProgress();
+    refreshArchives();
+    if (failed == 0) {
+        logMessage("✓ " + message);
+        QMessageBox::information(this, "Success", message);
+        passwordEdit->clear();
+    } else {
+        logMessage("✗ " + message);
+        QMessageBox::critical(this, "Error", message);
+    }
+}
+
+static QString format_seconds(const qint64 ms) {
+    const qint64 seconds = (ms + 500) / 1000;
+    return QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+}
+
+void DriveManagerUI::refreshBatchDashboard() const {
+    static const char *stage_names[] = {"Queued", "Encoding", "Finalizing", "Done", "Failed"};
+    const qint64 now = batchClock.elapsed();
+    double doneBytes = 0.0;
+    double totalBytes = 0.0;
+    int finished = 0;
+
+    for (std::size_t row = 0; row < batchJobs.size(); ++row) {
+        const BatchJob &job = *batchJobs[row];
+        const int stage = job.stage.load();
+        const uint64_t total = job.chunksTotal.load(std::memory_order_relaxed);
+        const uint64_t done = job.chunksDone.load(std::memory_order_relaxed);
+        const double fraction = stage == BatchJob::Done
+                                    ? 1.0
+                                    : total > 0 ? static_cast<double>(done) / static_cast<double>(total) : 0.0;
+        const double bytes = fraction * static_cast<double>(job.inputSize);
+        doneBytes += bytes;
+        totalBytes += static_cast<double>(job.inputSize);
+        finished += stage == BatchJob::Done || stage == BatchJob::Failed;
+
+        const qint64 started = job.startedMs.load();
+        const qint64 finalizing = job.finalizingMs.load();
+        const qint64 ended = job.finishedMs.load();
+        const qint64 encodeEnd = finalizing >= 0 ? finalizing : now;
+
+        QString rate;
+        QString eta;
+        if (started >= 0 && encodeEnd > started && bytes > 0.0) {
+            const double bytesPerMs = bytes / static_cast<double>(encodeEnd - started);
+            rate = QString::number(bytesPerMs * 1000.0 / (1024.0 * 1024.0), 'f', 1);
+            if (stage == BatchJob::Encoding) {
+                eta = format_seconds(static_cast<qint64>((static_cast<double>(job.inputSize) - bytes) / bytesPerMs));
+            }
+        }
+
+        QStringList stages;
+        stages << "queued " + format_seconds((started >= 0 ? started : now));
+        if (started >= 0) {
+            stages << "encoding " + format_seconds(encodeEnd - started);
+        }
+        if (finalizing >= 0) {
+            stages << "finalizing " + format_seconds((ended >= 0 ? ended : now) - finalizing);
+        }
+
+        const int r = static_cast<int>(row);
+        jobTable->item(r, 1)->setText(stage_names[stage]);
+        static_cast<QProgressBar *>(jobTable->cellWidget(r, 2))->setValue(static_cast<int>(fraction * 100.0));
+        jobTable->item(r, 3)->setText(rate);
+        jobTable->item(r, 4)->setText(eta);
+        jobTable->item(r, 5)->setText(stages.join(", "));
+    }
+
+    if (!isOperationRunning) {
+        return;
+    }
+    const int percentage = totalBytes > 0.0 ? static_cast<int>(100.0 * doneBytes / totalBytes) : 0;
+    progressBar->setValue(percentage);
+    progressLabel->setText(QString("%1% - %2 (%3/%4 files)").arg(percentage).arg(currentOperation)
+        .arg(finished).arg(batchJobs.size()));
+    const double aggregate = now > 0 ? doneBytes * 1000.0 / static_cast<double>(now) / (1024.0 * 1024.0) : 0.0;
+    queueSummaryLabel->setText(QString("%1 running, %2 queued, %3 MB/s overall")
+        .arg(runningBatchJobs).arg(batchJobs.size() - nextBatchJob).arg(aggregate, 0, 'f', 1));
+}
+
 void DriveManagerUI::onPlatformChanged(const int index) const {
     const QString baseUrl = platformCombo->itemData(index).toString();
     streamUrlEdit->setText(baseUrl);
@@ -762,6 +1126,7 @@ void DriveManagerUI::onOperationCompleted(const bool success, const QString &mes
 
     resetProgress();
     workerThread.reset();
+    refreshArchives();
 }
 
 void DriveManagerUI::onProgressUpdated(const int percentage) const {
@@ -809,6 +1174,122 @@ bool DriveManagerUI::validatePaths() {
     return true;
 }
 
+void DriveManagerUI::refreshArchives() const {
+    const std::string catalog = default_catalog_path();
+    const std::string filter = archiveSearchEdit->text().toStdString();
+    size_t count = 0;
+    std::vector<ms_catalog_entry_t> entries;
+    if (!catalog.empty() && ms_catalog_search(catalog.c_str(), filter.c_str(), nullptr, 0, &count) == MS_OK) {
+        entries.resize(count);
+        if (count > 0 && ms_catalog_search(catalog.c_str(), filter.c_str(), entries.data(), entries.size(),
+                                           &count) == MS_OK) {
+            entries.resize(std::min(entries.size(), count));
+        }
+    }
+
+    archiveTable->setRowCount(static_cast<int>(entries.size()));
+    for (int row = 0; row < static_cast<int>(entries.size()); ++row) {
+        const ms_catalog_entry_t &entry = entries[row];
+        auto *name = new QTableWidgetItem(QString::fromUtf8(entry.name));
+        name->setData(Qt::UserRole, QByteArray(reinterpret_cast<const char *>(entry.file_id),
+                                               sizeof(entry.file_id)));
+        if (entry.encrypted) {
+            name->setIcon(QIcon::fromTheme("security-high"));
+            name->setToolTip("Encrypted");
+        }
+        archiveTable->setItem(row, 0, name);
+        archiveTable->setItem(row, 1, new QTableWidgetItem(QLocale().formattedDataSize(
+                                          static_cast<qint64>(entry.file_size))));
+        archiveTable->setItem(row, 2, new QTableWidgetItem(QString::number(entry.video_count)));
+        archiveTable->setItem(row, 3, new QTableWidgetItem(
+                                  QDateTime::fromSecsSinceEpoch(entry.recorded).toString("yyyy-MM-dd hh:mm")));
+    }
+}
+
+void DriveManagerUI::addArchiveVideos() {
+    const QStringList files = QFileDialog::getOpenFileNames(this, "Add Encoded Videos", QString(),
+                                                            "Video Files (*.mkv *.mp4);;All Files (*)");
+    const std::string catalog = default_catalog_path();
+    if (files.isEmpty() || catalog.empty()) {
+        return;
+    }
+    for (const QString &file: files) {
+        if (const ms_status_t status = ms_catalog_add(catalog.c_str(), file.toStdString().c_str(), nullptr);
+            status == MS_OK) {
+            logMessage("Recorded in catalog: " + file);
+        } else {
+            logMessage(QString("✗ Not recorded: %1 (%2)").arg(file, ms_status_string(status)));
+        }
+    }
+    refreshArchives();
+}
+
+void DriveManagerUI::restoreSelectedArchive() {
+    if (isOperationRunning) {
+        QMessageBox::warning(this, "Warning", "An operation is already in progress");
+        return;
+    }
+    const QList<QTableWidgetItem *> selected = archiveTable->selectedItems();
+    if (selected.isEmpty()) {
+        QMessageBox::warning(this, "Warning", "Select an archive to restore");
+        return;
+    }
+    const QTableWidgetItem *name = archiveTable->item(selected.front()->row(), 0);
+    const QByteArray id = name->data(Qt::UserRole).toByteArray();
+
+    const std::string catalog = default_catalog_path();
+    uint8_t file_id[16];
+    std::memcpy(file_id, id.constData(), std::min<std::size_t>(sizeof(file_id), id.size()));
+    ms_catalog_entry_t entry{};
+    if (const ms_status_t status = ms_catalog_find(catalog.c_str(), file_id, &entry); status != MS_OK) {
+        QMessageBox::critical(this, "Error", QString("Catalog: %1").arg(ms_status_string(status)));
+        refreshArchives();
+        return;
+    }
+    QStringList videos;
+    for (uint32_t i = 0; i < entry.video_count; ++i) {
+        char path[4096];
+        if (ms_catalog_video_path(catalog.c_str(), file_id, i, path, sizeof(path)) == MS_OK) {
+            videos.append(QString::fromUtf8(path));
+        }
+    }
+    if (videos.isEmpty()) {
+        QMessageBox::critical(this, "Error", "The catalog lists no videos for this archive");
+        return;
+    }
+    if (entry.encrypted && passwordEdit->text().isEmpty()) {
+        QMessageBox::warning(this, "Warning", "This archive is encrypted; enter its password first");
+        return;
+    }
+
+    const QString output = QFileDialog::getSaveFileName(this, "Restore Archive As",
+                                                        QDir(QStandardPaths::writableLocation(
+                                                            QStandardPaths::DownloadLocation)).filePath(name->text()));
+    if (output.isEmpty()) {
+        return;
+    }
+
+    isOperationRunning = true;
+    currentOperation = "Restoring";
+    encodeButton->setEnabled(false);
+    decodeButton->setEnabled(false);
+
+    workerThread = std::make_unique<WorkerThread>(WorkerThread::Decode, videos.front(), output, false,
+                                                  passwordEdit->text(), QString(), 35000, 0, 0, this);
+    workerThread->setInputPaths(videos);
+
+    connect(workerThread.get(), &WorkerThread::progressUpdated,
+            this, &DriveManagerUI::onProgressUpdated);
+    connect(workerThread.get(), &WorkerThread::statusUpdated,
+            this, &DriveManagerUI::onStatusUpdated);
+    connect(workerThread.get(), &WorkerThread::operationCompleted,
+            this, &DriveManagerUI::onOperationCompleted);
+    connect(workerThread.get(), &WorkerThread::logMessage,
+            this, &DriveManagerUI::onLogMessage);
+
+    workerThread->start();
+}
+
 void DriveManagerUI::loadSettings() {
     const QSettings settings;
     restoreGeometry(settings.value("geometry").toByteArray());
@@ -35,8 +35,13 @@
 #include <QTimer>
 #include <QThread>
 #include <QCheckBox>
+#include <QTableWidget>
+#include <QElapsedTimer>
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 class WorkerThread : public QThread {
     Q_OBJECT
@@ -55,6 +60,13 @@ public:
                  int streamWidth = 1920, int streamHeight = 1080,
                  QObject *parent = nullptr);
 
+    // Emits progressUpdated only when the percentage changes; library
+    // callbacks fire per chunk or frame, far more often than a bar can show.
+    void reportProgress(int percentage);
+
+    // Decode from several videos (the shards of one archive) instead of input.
+    void setInputPaths(const QStringList &paths) { inputPaths = paths; }
+
 signals:
     void progressUpdated(int percentage);
 
@@ -70,6 +82,7 @@ protected:
 private:
     Operation operation;
     QString inputPath;
+    QStringList inputPaths;
     QString outputPath;
     bool encrypt;
     QString password;
@@ -77,6 +90,56 @@ private:
     int bitrate;
     int streamWidth;
     int streamHeight;
+    int lastPercentage = -1;
+};
+
+// One row of the batch queue. Its worker thread writes the counters and the
+// dashboard timer reads them, so progress never goes through the event loop.
+struct BatchJob {
+    enum Stage {
+        Queued,
+        Encoding,
+        Finalizing,
+        Done,
+        Failed
+    };
+
+    QString inputPath;
+    QString outputPath;
+    qint64 inputSize = 0;
+    std::atomic<int> stage{Queued};
+    std::atomic<uint64_t> chunksDone{0};
+    std::atomic<uint64_t> chunksTotal{0};
+    // Batch clock milliseconds at which each stage began, -1 until it did.
+    std::atomic<qint64> startedMs{-1};
+    std::atomic<qint64> finalizingMs{-1};
+    std::atomic<qint64> finishedMs{-1};
+};
+
+class BatchJobThread : public QThread {
+    Q_OBJECT
+
+public:
+    BatchJobThread(int index, BatchJob &job, const QElapsedTimer &clock, int threads,
+                   bool encrypt, const QString &password, const std::atomic<bool> &cancel,
+                   QObject *parent = nullptr);
+
+signals:
+    void jobFinished(int index, bool success, const QString &message);
+
+protected:
+    void run() override;
+
+private:
+    static int progress(uint64_t current, uint64_t total, void *user);
+
+    int index;
+    BatchJob &job;
+    const QElapsedTimer &clock;
+    int threads;
+    bool encrypt;
+    QString password;
+    const std::atomic<bool> &cancel;
 };
 
 class DriveManagerUI : public QMainWindow {
@@ -129,6 +192,16 @@ slots:
 
     void togglePasswordVisibility() const;
 
+    void onBatchJobFinished(int index, bool success, const QString &message);
+
+    void refreshBatchDashboard() const;
+
+    void refreshArchives() const;
+
+    void addArchiveVideos();
+
+    void restoreSelectedArchive();
+
 private:
     void setupUI();
 
@@ -148,6 +221,10 @@ private:
 
     bool validatePaths();
 
+    void launchBatchJobs();
+
+    void finishBatch();
+
     // UI Components
     QWidget *centralWidget;
     QSplitter *mainSplitter;
@@ -173,6 +250,16 @@ private:
     QPushButton *batchEncodeButton;
     QLineEdit *batchOutputDirEdit;
     QPushButton *batchOutputButton;
+    QSpinBox *batchJobsSpinBox;
+    QSpinBox *threadBudgetSpinBox;
+
+    // Archives group
+    QGroupBox *archivesGroup;
+    QLineEdit *archiveSearchEdit;
+    QTableWidget *archiveTable;
+    QPushButton *addArchivesButton;
+    QPushButton *restoreArchiveButton;
+    QPushButton *refreshArchivesButton;
 
     // Streaming
     QGroupBox *streamGroup;
@@ -190,6 +277,12 @@ private:
     QLabel *statusLabel;
     QLabel *progressLabel;
 
+    // Batch queue dashboard
+    QGroupBox *queueGroup;
+    QTableWidget *jobTable;
+    QLabel *queueSummaryLabel;
+    QTimer *dashboardTimer;
+
     QGroupBox *logsGroup;
     QTextEdit *logTextEdit;
     QPushButton *clearLogsButton;
@@ -204,6 +297,17 @@ private:
     // Worker thread
     std::unique_ptr<WorkerThread> workerThread;
 
+    // Batch queue
+    std::vector<std::unique_ptr<BatchJob> > batchJobs;
+    std::vector<std::unique_ptr<BatchJobThread> > batchThreads;
+    QElapsedTimer batchClock;
+    std::atomic<bool> batchCancel{false};
+    std::size_t nextBatchJob = 0;
+    int runningBatchJobs = 0;
+    int batchJobThreads = 1;
+    bool batchEncrypt = false;
+    QString batchPassword;
+
     // State
     bool isOperationRunning;
     QString currentOperation;
@@ -0,0 +1,287 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "encode_cache.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+static constexpr uint32_t CACHE_META_MAGIC = 0x4D43534D; // "MSCM"
+static constexpr uint32_t CACHE_CHUNK_MAGIC = 0x4343534D; // "MSCC"
+static constexpr uint32_t CACHE_INPUT_MAGIC = 0x4943534D; // "MSCI"
+static constexpr uint8_t CACHE_VERSION = 2;
+static constexpr std::size_t CACHE_META_SIZE = 5 + 4 * sizeof(uint64_t) + 16;
+static constexpr std::size_t CACHE_INPUT_SIZE = 5 + SHA256_HASH_SIZE;
+static constexpr std::size_t CACHE_CHUNK_HEADER_SIZE = 27;
+
+template<typename T>
+static T read_value(const std::vector<std::byte> &data, const std::size_t offset) {
+    T value{};
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+static std::optional<std::vector<std::byte> > read_file(const std::filesystem::path &path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return std::nullopt;
+    }
+    std::vector<std::byte> data(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()))) {
+        return std::nullopt;
+    }
+    return data;
+}
+
+static std::filesystem::path temporary_path(const std::filesystem::path &path) {
+    static std::atomic<uint64_t> counter{0};
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    std::filesystem::path tmp = path;
+    tmp += ".tmp" + std::to_string(stamp) + "_" + std::to_string(counter.fetch_add(1));
+    return tmp;
+}
+
+// Writes data next to path and renames it into place.
+static bool publish(const std::filesystem::path &path, const std::span<const std::byte> data) {
+    const std::filesystem::path tmp = temporary_path(path);
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            std::error_code ec;
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+static bool link_or_copy(const std::filesystem::path &from, const std::filesystem::path &to) {
+    std::error_code ec;
+    std::filesystem::remove(to, ec);
+    std::filesystem::create_hard_link(from, to, ec);
+    if (!ec) {
+        return true;
+    }
+    ec.clear();
+    if (!std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, ec) || ec) {
+        return false;
+    }
+    std::filesystem::permissions(to, std::filesystem::perms::owner_write, std::filesystem::perm_options::add, ec);
+    return true;
+}
+
+EncodeCache::EncodeCache(const std::filesystem::path &root) : root_(root) {
+    std::filesystem::create_directories(root_ / "videos");
+    std::filesystem::create_directories(root_ / "chunks");
+    std::filesystem::create_directories(root_ / "inputs");
+}
+
+Sha256Digest EncodeCache::video_key(const Sha256Digest &content, const std::span<const std::byte> profile) {
+    std::vector<std::byte> data;
+    append_value(data, CACHE_META_MAGIC);
+    append_value(data, CACHE_VERSION);
+    append_value(data, content.bytes);
+    data.insert(data.end(), profile.begin(), profile.end());
+    return sha256(data);
+}
+
+Sha256Digest EncodeCache::input_key(const std::filesystem::path &input, const std::span<const std::byte> profile) {
+    const std::string path = std::filesystem::absolute(input).lexically_normal().string();
+    std::vector<std::byte> data;
+    data.reserve(25 + path.size() + profile.size());
+    append_value(data, CACHE_INPUT_MAGIC);
+    append_value(data, CACHE_VERSION);
+    append_value(data, static_cast<uint64_t>(std::filesystem::file_size(input)));
+    append_value(data, static_cast<int64_t>(std::filesystem::last_write_time(input).time_since_epoch().count()));
+    append_value(data, static_cast<uint32_t>(path.size()));
+    const auto *path_bytes = reinterpret_cast<const std::byte *>(path.data());
+    data.insert(data.end(), path_bytes, path_bytes + path.size());
+    data.insert(data.end(), profile.begin(), profile.end());
+    return sha256(data);
+}
+
+Sha256Digest EncodeCache::chunk_key(const Sha256Digest &chunk_digest, const double repair_overhead) {
+    std::vector<std::byte> data;
+    append_value(data, CACHE_CHUNK_MAGIC);
+    append_value(data, CACHE_VERSION);
+    append_value(data, chunk_digest.bytes);
+    append_value(data, repair_overhead);
+    append_value(data, static_cast<uint32_t>(SYMBOL_SIZE_BYTES));
+    return sha256(data);
+}
+
+std::filesystem::path EncodeCache::video_path(const Sha256Digest &key) const {
+    return root_ / "videos" / key.hexValue();
+}
+
+std::filesystem::path EncodeCache::chunk_path(const Sha256Digest &key) const {
+    const std::string hex = key.hexValue();
+    return root_ / "chunks" / hex.substr(0, 2) / hex;
+}
+
+std::filesystem::path EncodeCache::input_path(const Sha256Digest &key) const {
+    return root_ / "inputs" / key.hexValue();
+}
+
+std::optional<CachedEncode> EncodeCache::fetch_video(const Sha256Digest &key,
+                                                     const std::filesystem::path &output) const {
+    // The meta file is published last, so its presence marks a whole entry.
+    const std::filesystem::path video = video_path(key);
+    std::filesystem::path meta_path = video;
+    meta_path += ".meta";
+    const auto meta = read_file(meta_path);
+    if (!meta || meta->size() != CACHE_META_SIZE || read_value<uint32_t>(*meta, 0) != CACHE_META_MAGIC ||
+        static_cast<uint8_t>((*meta)[4]) != CACHE_VERSION) {
+        return std::nullopt;
+    }
+    if (!link_or_copy(video, output)) {
+        return std::nullopt;
+    }
+
+    CachedEncode stats;
+    stats.total_packets = read_value<uint64_t>(*meta, 5);
+    stats.total_frames = read_value<uint64_t>(*meta, 13);
+    stats.total_chunks = read_value<uint64_t>(*meta, 21);
+    stats.verified_chunks = read_value<uint64_t>(*meta, 29);
+    std::memcpy(stats.file_id.data(), meta->data() + 37, stats.file_id.size());
+    return stats;
+}
+
+bool EncodeCache::store_video(const Sha256Digest &key, const std::filesystem::path &video,
+                              const CachedEncode &stats) const {
+    const std::filesystem::path target = video_path(key);
+    const std::filesystem::path tmp = temporary_path(target);
+    std::error_code ec;
+    if (!link_or_copy(video, tmp)) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    // Read-only, so nothing rewrites the shared inode in place through a link.
+    std::filesystem::permissions(tmp, std::filesystem::perms::owner_write | std::filesystem::perms::group_write |
+                                      std::filesystem::perms::others_write,
+                                 std::filesystem::perm_options::remove, ec);
+    std::filesystem::rename(tmp, target, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+
+    std::vector<std::byte> meta;
+    meta.reserve(CACHE_META_SIZE);
+    append_value(meta, CACHE_META_MAGIC);
+    append_value(meta, CACHE_VERSION);
+    append_value(meta, stats.total_packets);
+    append_value(meta, stats.total_frames);
+    append_value(meta, stats.total_chunks);
+    append_value(meta, stats.verified_chunks);
+    append_value(meta, stats.file_id);
+    std::filesystem::path meta_path = target;
+    meta_path += ".meta";
+    return publish(meta_path, meta);
+}
+
+// Input entries are {magic u32, version u8, content digest}.
+std::optional<Sha256Digest> EncodeCache::find_input(const Sha256Digest &key) const {
+    const auto data = read_file(input_path(key));
+    if (!data || data->size() != CACHE_INPUT_SIZE || read_value<uint32_t>(*data, 0) != CACHE_INPUT_MAGIC ||
+        static_cast<uint8_t>((*data)[4]) != CACHE_VERSION) {
+        return std::nullopt;
+    }
+    Sha256Digest content;
+    std::memcpy(content.bytes.data(), data->data() + 5, content.bytes.size());
+    return content;
+}
+
+bool EncodeCache::store_input(const Sha256Digest &key, const Sha256Digest &content) const {
+    std::vector<std::byte> data;
+    data.reserve(CACHE_INPUT_SIZE);
+    append_value(data, CACHE_INPUT_MAGIC);
+    append_value(data, CACHE_VERSION);
+    append_value(data, content.bytes);
+    return publish(input_path(key), data);
+}
+
+// Chunk entries are {magic u32, version u8, chunk_size u32, original_size u32,
+// N u32, T u16, packet_count u32, crc32c u32 of the packets, packets}.
+std::optional<CachedChunk> EncodeCache::load_chunk(const Sha256Digest &key) const {
+    const auto data = read_file(chunk_path(key));
+    if (!data || data->size() < CACHE_CHUNK_HEADER_SIZE || read_value<uint32_t>(*data, 0) != CACHE_CHUNK_MAGIC ||
+        static_cast<uint8_t>((*data)[4]) != CACHE_VERSION) {
+        return std::nullopt;
+    }
+
+    CachedChunk chunk;
+    chunk.entry.chunk_size = read_value<uint32_t>(*data, 5);
+    chunk.entry.original_size = read_value<uint32_t>(*data, 9);
+    chunk.entry.N = read_value<uint32_t>(*data, 13);
+    chunk.entry.T = read_value<uint16_t>(*data, 17);
+    const auto count = read_value<uint32_t>(*data, 19);
+    const auto crc = read_value<uint32_t>(*data, 23);
+
+    const std::span<const std::byte> body = std::span(*data).subspan(CACHE_CHUNK_HEADER_SIZE);
+    if (body.size() != static_cast<std::size_t>(count) * PACKET_SIZE || crc32c(body) != crc ||
+        chunk.entry.T != SYMBOL_SIZE_BYTES || chunk.entry.original_size > chunk.entry.chunk_size) {
+        return std::nullopt;
+    }
+
+    chunk.packets.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        std::memcpy(chunk.packets[i].bytes.data(), body.data() + static_cast<std::size_t>(i) * PACKET_SIZE,
+                    PACKET_SIZE);
+    }
+    return chunk;
+}
+
+bool EncodeCache::store_chunk(const Sha256Digest &key, const CachedChunk &chunk) const {
+    const std::filesystem::path path = chunk_path(key);
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    if (ec) {
+        return false;
+    }
+
+    std::vector<std::byte> body;
+    body.reserve(chunk.packets.size() * PACKET_SIZE);
+    for (const Packet &packet: chunk.packets) {
+        body.insert(body.end(), packet.bytes.begin(), packet.bytes.end());
+    }
+
+    std::vector<std::byte> data;
+    data.reserve(CACHE_CHUNK_HEADER_SIZE + body.size());
+    append_value(data, CACHE_CHUNK_MAGIC);
+    append_value(data, CACHE_VERSION);
+    append_value(data, chunk.entry.chunk_size);
+    append_value(data, chunk.entry.original_size);
+    append_value(data, chunk.entry.N);
+    append_value(data, chunk.entry.T);
+    append_value(data, static_cast<uint32_t>(chunk.packets.size()));
+    append_value(data, crc32c(body));
+    data.insert(data.end(), body.begin(), body.end());
+    return publish(path, data);
+}
@@ -0,0 +1,103 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "encoder.h"
+#include "integrity.h"
+
+struct CachedEncode {
+    uint64_t total_packets = 0;
+    uint64_t total_frames = 0;
+    uint64_t total_chunks = 0;
+    uint64_t verified_chunks = 0; // 0 unless the encode was read back
+    // File id of the encode that produced the video. A hit reuses the video
+    // as is, so the output carries this id rather than a fresh one.
+    std::array<std::byte, 16> file_id{};
+};
+
+struct CachedChunk {
+    ChunkManifestEntry entry;
+    std::vector<Packet> packets;
+};
+
+// Content-addressed store of encode results under one directory:
+// videos/<key> plus videos/<key>.meta for whole encodes, chunks/<xx>/<key>
+// for the packets of single chunks and inputs/<key> mapping input files to
+// the content digest their last encode produced. Entries are written to a temporary name
+// and renamed into place, so concurrent encodes sharing a cache only ever see
+// complete entries. Cached videos are read-only and shared with the outputs
+// they were linked to, so an output has to be unlinked, not truncated, before
+// it is written again. Nothing is evicted; the directory can be pruned at will.
+class EncodeCache {
+public:
+    // Creates the directory layout; throws std::filesystem::filesystem_error.
+    explicit EncodeCache(const std::filesystem::path &root);
+
+    // Key of a whole encode: the input's content digest (merkle_root over its
+    // chunk digests) and every option that changes the output bytes.
+    [[nodiscard]] static Sha256Digest video_key(const Sha256Digest &content, std::span<const std::byte> profile);
+
+    // Key of an input file by identity rather than content: its absolute path,
+    // size and modification time plus the encode profile. It lets a repeat
+    // encode find its video without reading the input first; like make, it
+    // misses writes that keep both the size and the modification time.
+    // Throws std::filesystem::filesystem_error.
+    [[nodiscard]] static Sha256Digest input_key(const std::filesystem::path &input,
+                                                std::span<const std::byte> profile);
+
+    // Key of one chunk's packets. Only the repair overhead shapes the FEC
+    // payloads; headers are restamped on reuse (Encoder::restamp_chunk).
+    [[nodiscard]] static Sha256Digest chunk_key(const Sha256Digest &chunk_digest, double repair_overhead);
+
+    // Places the cached video at output, as a hard link where the file system
+    // allows and as a copy otherwise. nullopt on a miss.
+    [[nodiscard]] std::optional<CachedEncode> fetch_video(const Sha256Digest &key,
+                                                          const std::filesystem::path &output) const;
+
+    // Best effort: returns false if the entry could not be written.
+    bool store_video(const Sha256Digest &key, const std::filesystem::path &video, const CachedEncode &stats) const;
+
+    // Content digest (merkle_root over the chunk digests) store_input recorded
+    // for an input key; nullopt on a miss.
+    [[nodiscard]] std::optional<Sha256Digest> find_input(const Sha256Digest &key) const;
+
+    bool store_input(const Sha256Digest &key, const Sha256Digest &content) const;
+
+    // nullopt on a miss or if the entry is damaged.
+    [[nodiscard]] std::optional<CachedChunk> load_chunk(const Sha256Digest &key) const;
+
+    bool store_chunk(const Sha256Digest &key, const CachedChunk &chunk) const;
+
+private:
+    [[nodiscard]] std::filesystem::path video_path(const Sha256Digest &key) const;
+
+    [[nodiscard]] std::filesystem::path chunk_path(const Sha256Digest &key) const;
+
+    [[nodiscard]] std::filesystem::path input_path(const Sha256Digest &key) const;
+
+    std::filesystem::path root_;
+};
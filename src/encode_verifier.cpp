@@ -0,0 +1,108 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "encode_verifier.h"
+
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include "video_decoder.h"
+
+// Enough frames to ride out a slow decode without holding many 4K packets.
+static constexpr std::size_t VERIFIER_QUEUE_FRAMES = 8;
+
+EncodeVerifier::EncodeVerifier(const AVCodecParameters *video_params) : queue_(VERIFIER_QUEUE_FRAMES) {
+    decoder_.set_retain_chunk_data(false);
+
+    // The codec parameters belong to the encoder's stream; the worker gets a
+    // copy so it never touches the muxer.
+    AVCodecParameters *params = avcodec_parameters_alloc();
+    if (!params || avcodec_parameters_copy(params, video_params) < 0) {
+        avcodec_parameters_free(&params);
+        throw std::runtime_error("Failed to copy codec parameters");
+    }
+    worker_ = std::thread([this, params]() mutable {
+        run(params);
+        avcodec_parameters_free(&params);
+    });
+}
+
+EncodeVerifier::~EncodeVerifier() {
+    queue_.close();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void EncodeVerifier::submit_video(const AVPacket *packet) {
+    submit(packet, false);
+}
+
+void EncodeVerifier::submit_audio(const AVPacket *packet) {
+    submit(packet, true);
+}
+
+void EncodeVerifier::submit(const AVPacket *packet, const bool audio) {
+    std::unique_ptr<AVPacket, AVPacketFree> ref(av_packet_clone(packet));
+    if (!ref) {
+        throw std::runtime_error("Failed to reference packet");
+    }
+    // A closed queue means the worker failed; finish() reports why.
+    queue_.push(Input{std::move(ref), audio});
+}
+
+void EncodeVerifier::finish() {
+    if (!finished_) {
+        finished_ = true;
+        queue_.close();
+        worker_.join();
+    }
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void EncodeVerifier::run(const AVCodecParameters *video_params) {
+    try {
+        VideoDecoder video_decoder(video_params);
+        while (auto input = queue_.pop()) {
+            const AVPacket *packet = input->packet.get();
+            if (input->audio) {
+                const auto *data = reinterpret_cast<const std::byte *>(packet->data);
+                ingest(video_decoder.decode_audio(std::span(data, static_cast<std::size_t>(packet->size))));
+            } else {
+                ingest(video_decoder.decode_packet(packet));
+            }
+        }
+        ingest(video_decoder.decode_packet(nullptr));
+    } catch (...) {
+        error_ = std::current_exception();
+        queue_.close();
+    }
+}
+
+void EncodeVerifier::ingest(const std::vector<std::vector<std::byte> > &packets) {
+    for (const auto &packet: packets) {
+        if (auto res = decoder_.process_packet(std::span<const std::byte>(packet.data(), packet.size()), true);
+            res && res->success) {
+            if (digests_.size() <= res->chunk_index) {
+                digests_.resize(static_cast<std::size_t>(res->chunk_index) + 1);
+            }
+            digests_[res->chunk_index] = res->sha256;
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include "bounded_queue.h"
+#include "decoder.h"
+#include "integrity.h"
+
+struct AVPacketFree {
+    void operator()(AVPacket *packet) const { av_packet_free(&packet); }
+};
+
+// Reads an encode back while it is being written. VideoEncoder tees every
+// compressed video packet and audio data packet here; a worker thread runs them
+// through a second in-process codec, the pixel extractor and a Decoder, so the
+// verdict covers the bytes that land in the file and costs no second pass.
+class EncodeVerifier {
+public:
+    explicit EncodeVerifier(const AVCodecParameters *video_params);
+
+    ~EncodeVerifier();
+
+    EncodeVerifier(const EncodeVerifier &) = delete;
+
+    EncodeVerifier &operator=(const EncodeVerifier &) = delete;
+
+    EncodeVerifier(EncodeVerifier &&) = delete;
+
+    EncodeVerifier &operator=(EncodeVerifier &&) = delete;
+
+    // Both take a new reference; the caller keeps its packet.
+    void submit_video(const AVPacket *packet);
+
+    void submit_audio(const AVPacket *packet);
+
+    // Drains the codec and waits for the worker. Rethrows a worker failure.
+    void finish();
+
+    [[nodiscard]] const Decoder &decoder() const { return decoder_; }
+
+    // SHA-256 of every chunk recovered so far, by chunk index.
+    [[nodiscard]] const std::vector<std::optional<Sha256Digest> > &chunk_digests() const { return digests_; }
+
+private:
+    struct Input {
+        std::unique_ptr<AVPacket, AVPacketFree> packet;
+        bool audio = false;
+    };
+
+    void submit(const AVPacket *packet, bool audio);
+
+    void run(const AVCodecParameters *video_params);
+
+    void ingest(const std::vector<std::vector<std::byte> > &packets);
+
+    BoundedQueue<Input> queue_;
+    Decoder decoder_;
+    std::vector<std::optional<Sha256Digest> > digests_;
+    std::exception_ptr error_;
+    std::thread worker_;
+    bool finished_ = false;
+};
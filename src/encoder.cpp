@@ -59,54 +59,101 @@ static uint32_t computeRepairCount(const uint32_t numSource, const double overhe
     return static_cast<uint32_t>(std::ceil(repairDouble));
 }
 
-static uint8_t buildFlags(const uint32_t blockId, const uint32_t numSource, const bool isLastChunk,
-                          const bool encrypted) {
+static uint8_t buildChunkFlags(const bool isLastChunk, const bool encrypted, const HashAlgorithm algo) {
     uint8_t flags = None;
-    if (blockId > numSource) {
-        flags |= IsRepairSymbol;
-    }
     if (isLastChunk) {
         flags |= LastChunk;
     }
     if (encrypted) {
         flags |= Encrypted;
     }
+    if (algo == HashAlgorithm::XXHash32) {
+        flags |= UseXXHash;
+    }
     return flags;
 }
 
+// Generates the source and repair symbols of one chunk into packets stamped
+// from the template. The codec stays owned by the caller.
+static std::vector<Packet> encodeSymbols(const WirehairCodec codec, const uint32_t numSource,
+                                         const PacketHeaderTemplate &header, const double repairOverhead) {
+    const uint32_t repairCount = computeRepairCount(numSource, repairOverhead);
+    constexpr uint32_t firstBlockId = INCLUDE_SOURCE ? 1u : (numSource + 1u);
+    const uint32_t lastBlockId = numSource + repairCount;
 
-Encoder::Encoder(const FileId file_id, const HashAlgorithm hash_algo)
-    : id(file_id), algo_(hash_algo) {
+    const uint32_t sourceCount = INCLUDE_SOURCE ? numSource : 0u;
+    const uint32_t packetCount = sourceCount + repairCount;
+
+    std::vector<Packet> packets;
+    packets.reserve(packetCount);
+
+    for (uint32_t blockId = firstBlockId; blockId <= lastBlockId; ++blockId) {
+        packets.emplace_back();
+        auto &packet = packets.back();
+
+        auto *payload_dest = reinterpret_cast<uint8_t *>(packet.bytes.data() + HEADER_SIZE_V2);
+        uint32_t writeLen = 0;
+        if (const WirehairResult result = wirehair_encode(codec, blockId, payload_dest, SYMBOL_SIZE_BYTES, &writeLen); result != Wirehair_Success) {
+            throw std::runtime_error("wirehair_encode() failed");
+        }
+
+        header.stamp(packet.bytes, blockId, blockId > numSource, static_cast<uint16_t>(writeLen));
+    }
+    return packets;
 }
 
-void Encoder::write_packet_header(
-    const std::span<std::byte> dest,
-    const uint32_t chunk_index,
-    const uint32_t chunk_size,
-    const uint32_t original_size,
-    const uint16_t symbol_size,
-    const uint32_t num_source,
-    const uint32_t block_id,
-    const uint16_t payload_length,
-    const uint8_t flags,
-    const std::span<const std::byte> payload) const {
-    writeU32LE(dest, MAGIC_OFF, MAGIC_ID);
-    writeByte(dest, VERSION_OFF, VERSION_ID_V2);
-    writeByte(dest, FLAGS_OFF, flags);
-
-    std::memcpy(dest.data() + FILE_ID_OFF, id.data(), id.size());
-    writeU32LE(dest, CHUNK_INDEX_OFF, chunk_index);
-    writeU32LE(dest, CHUNK_SIZE_OFF, chunk_size);
-    writeU32LE(dest, ORIGINAL_SIZE_OFF, original_size);
-    writeU16LE(dest, SYMBOL_SIZE_OFF, symbol_size);
-    writeU32LE(dest, K_OFF, num_source);
-    writeU32LE(dest, ESI_OFF, block_id);
+PacketHeaderTemplate::PacketHeaderTemplate(const std::array<std::byte, 16> &file_id, const HashAlgorithm algo,
+                                           const uint32_t chunk_index, const uint32_t chunk_size,
+                                           const uint32_t original_size, const uint16_t symbol_size,
+                                           const uint32_t k, const uint8_t flags)
+    : prefix_checksum_{PacketChecksum(algo), PacketChecksum(algo)}
+      , original_size_(original_size)
+      , symbol_size_(symbol_size) {
+    for (std::size_t variant = 0; variant < prefix_.size(); ++variant) {
+        const std::span<std::byte> prefix(prefix_[variant]);
+        writeU32LE(prefix, MAGIC_OFF, MAGIC_ID);
+        writeByte(prefix, VERSION_OFF, VERSION_ID_V2);
+        writeByte(prefix, FLAGS_OFF, variant == 1 ? static_cast<uint8_t>(flags | IsRepairSymbol) : flags);
+        std::memcpy(prefix.data() + FILE_ID_OFF, file_id.data(), file_id.size());
+        writeU32LE(prefix, CHUNK_INDEX_OFF, chunk_index);
+        writeU32LE(prefix, CHUNK_SIZE_OFF, chunk_size);
+        writeU16LE(prefix, SYMBOL_SIZE_OFF, symbol_size);
+        writeU32LE(prefix, K_OFF, k);
+        prefix_checksum_[variant].update(prefix);
+    }
+}
+
+void PacketHeaderTemplate::stamp(const std::span<std::byte> dest, const uint32_t esi, const bool repair,
+                                 const uint16_t payload_length) const {
+    const std::size_t variant = repair ? 1 : 0;
+    std::memcpy(dest.data(), prefix_[variant].data(), ESI_OFF);
+    writeU32LE(dest, ESI_OFF, esi);
     writeU16LE(dest, PAYLOAD_LEN_OFF, payload_length);
+    writeU32LE(dest, ORIGINAL_SIZE_OFF, original_size_);
     writeU32LE(dest, CRC_OFF_V2, 0);
 
-    const std::span<const std::byte> headerSpan(dest.data(), HEADER_SIZE_V2);
-    const uint32_t crc = packet_checksum(headerSpan, payload, CRC_OFF_V2, algo_, CRC_SIZE);
-    writeU32LE(dest, CRC_OFF_V2, crc);
+    // The zeroed CRC field is part of the checksummed bytes, so the tail runs
+    // from ESI through the CRC slot in one go.
+    PacketChecksum checksum = prefix_checksum_[variant];
+    checksum.update(dest.subspan(ESI_OFF, HEADER_SIZE_V2 - ESI_OFF));
+    checksum.update(dest.subspan(HEADER_SIZE_V2, symbol_size_));
+    writeU32LE(dest, CRC_OFF_V2, checksum.digest());
+}
+
+Encoder::Encoder(const FileId file_id, const HashAlgorithm hash_algo)
+    : id(file_id), algo_(hash_algo) {
+}
+
+std::size_t Encoder::packet_count(const std::size_t data_size) const {
+    const uint32_t numSource = computeNumSourceSymbols(std::max(data_size, SYMBOL_SIZE_BYTES * 2), SYMBOL_SIZE_BYTES);
+    return (INCLUDE_SOURCE ? numSource : 0u) + computeRepairCount(numSource, repair_overhead_);
+}
+
+void Encoder::set_repair_overhead(const double overhead) {
+    if (!(overhead >= 0.0 && overhead <= MAX_REPAIR_OVERHEAD)) {
+        throw std::invalid_argument("repair overhead out of range");
+    }
+    repair_overhead_ = overhead;
 }
 
 std::pair<std::vector<Packet>, ChunkManifestEntry>
@@ -115,6 +162,45 @@ Encoder::encode_chunk(
     const std::span<const std::byte> chunk_data,
     const bool is_last_chunk,
     const bool encrypted) const {
+    return encode_block(chunk_index, chunk_data, buildChunkFlags(is_last_chunk, encrypted, algo_));
+}
+
+std::vector<Packet> Encoder::encode_manifest_segment(const uint32_t segment,
+                                                     const std::span<const std::byte> data) const {
+    const auto flags = static_cast<uint8_t>(buildChunkFlags(false, false, algo_) | Manifest);
+    return encode_block(segment, data, flags).first;
+}
+
+std::vector<Packet> Encoder::encode_recovered(void *codec, const uint32_t chunk_index, const uint32_t chunk_size,
+                                              const uint32_t original_size, const uint32_t k,
+                                              const bool is_last_chunk, const bool encrypted) const {
+    if (!codec || original_size > chunk_size || k != computeNumSourceSymbols(chunk_size, SYMBOL_SIZE_BYTES)) {
+        throw std::invalid_argument("recovered chunk does not match the encoder geometry");
+    }
+    const PacketHeaderTemplate header(id, algo_, chunk_index, chunk_size, original_size,
+                                      static_cast<uint16_t>(SYMBOL_SIZE_BYTES), k,
+                                      buildChunkFlags(is_last_chunk, encrypted, algo_));
+    return encodeSymbols(static_cast<WirehairCodec>(codec), k, header, repair_overhead_);
+}
+
+void Encoder::restamp_chunk(const std::span<Packet> packets, const ChunkManifestEntry &entry,
+                            const uint32_t chunk_index, const bool is_last_chunk, const bool encrypted) const {
+    const PacketHeaderTemplate header(id, algo_, chunk_index, entry.chunk_size, entry.original_size, entry.T, entry.N,
+                                      buildChunkFlags(is_last_chunk, encrypted, algo_));
+    for (Packet &packet: packets) {
+        uint32_t esi = 0;
+        uint16_t payload_length = 0;
+        std::memcpy(&esi, packet.bytes.data() + ESI_OFF, sizeof(esi));
+        std::memcpy(&payload_length, packet.bytes.data() + PAYLOAD_LEN_OFF, sizeof(payload_length));
+        header.stamp(packet.bytes, esi, esi > entry.N, payload_length);
+    }
+}
+
+std::pair<std::vector<Packet>, ChunkManifestEntry>
+Encoder::encode_block(
+    const uint32_t chunk_index,
+    const std::span<const std::byte> chunk_data,
+    const uint8_t flags) const {
     ensureWirehairInit();
 
     if (chunk_data.size() > CHUNK_SIZE_BYTES) {
@@ -151,39 +237,16 @@ Encoder::encode_chunk(
         throw std::runtime_error("wirehair_encoder_create() failed");
     }
 
-    const uint32_t repairCount = computeRepairCount(numSource, REPAIR_OVERHEAD);
-    constexpr uint32_t firstBlockId = INCLUDE_SOURCE ? 1u : (numSource + 1u);
-    const uint32_t lastBlockId = numSource + repairCount;
-
-    const uint32_t sourceCount = INCLUDE_SOURCE ? numSource : 0u;
-    const uint32_t packetCount = sourceCount + repairCount;
+    const PacketHeaderTemplate header(id, algo_, chunk_index, chunkSize, manifest.original_size, symbolSize,
+                                      numSource, flags);
 
     std::vector<Packet> packets;
-    packets.reserve(packetCount);
-
-    for (uint32_t blockId = firstBlockId; blockId <= lastBlockId; ++blockId) {
-        packets.emplace_back();
-        auto &packet = packets.back();
-
-        auto *payload_dest = reinterpret_cast<uint8_t *>(packet.bytes.data() + HEADER_SIZE_V2);
-        uint32_t writeLen = 0;
-        if (const WirehairResult result = wirehair_encode(codec, blockId, payload_dest, SYMBOL_SIZE_BYTES, &writeLen); result != Wirehair_Success) {
-            wirehair_free(codec);
-            throw std::runtime_error("wirehair_encode() failed");
-        }
-
-        uint8_t flags = buildFlags(blockId, numSource, is_last_chunk, encrypted);
-        if (algo_ == HashAlgorithm::XXHash32) {
-            flags |= UseXXHash;
-        }
-        const auto payloadLen = static_cast<uint16_t>(writeLen);
-        const std::span<const std::byte> payload_span(packet.bytes.data() + HEADER_SIZE_V2, writeLen);
-
-        write_packet_header(
-            std::span(packet.bytes.data(), HEADER_SIZE_V2),
-            chunk_index, chunkSize, manifest.original_size, symbolSize, numSource, blockId, payloadLen, flags, payload_span);
+    try {
+        packets = encodeSymbols(codec, numSource, header, repair_overhead_);
+    } catch (...) {
+        wirehair_free(codec);
+        throw;
     }
-
     wirehair_free(codec);
 
     return {std::move(packets), manifest};
@@ -41,6 +41,27 @@ struct ChunkManifestEntry {
     uint16_t T = 0;
 };
 
+// Header bytes shared by every packet of one chunk. Only flags, ESI and
+// payload_len vary per packet, and flags only differ between source and repair
+// symbols, so the bytes before ESI and their checksum state are prepared once
+// per variant. Stamping a packet copies that prefix, patches the tail and
+// extends the checksum over the tail and the payload.
+class PacketHeaderTemplate {
+public:
+    PacketHeaderTemplate(const std::array<std::byte, 16> &file_id, HashAlgorithm algo, uint32_t chunk_index,
+                         uint32_t chunk_size, uint32_t original_size, uint16_t symbol_size, uint32_t k,
+                         uint8_t flags);
+
+    // dest holds the header followed by symbol_size payload bytes already in place.
+    void stamp(std::span<std::byte> dest, uint32_t esi, bool repair, uint16_t payload_length) const;
+
+private:
+    std::array<std::array<std::byte, ESI_OFF>, 2> prefix_{};
+    std::array<PacketChecksum, 2> prefix_checksum_;
+    uint32_t original_size_;
+    uint16_t symbol_size_;
+};
+
 class Encoder {
 public:
     using FileId = std::array<std::byte, 16>;
@@ -51,22 +72,39 @@ public:
     encode_chunk(uint32_t chunk_index, std::span<const std::byte> chunk_data, bool is_last_chunk,
                 bool encrypted = false) const;
 
+    // Packets for one manifest segment (see manifest.h). Manifest data is never
+    // encrypted: it only carries sizes and digests of the FEC input.
+    [[nodiscard]] std::vector<Packet> encode_manifest_segment(uint32_t segment, std::span<const std::byte> data) const;
+
+    // Packets for a chunk whose wirehair decoder was switched to encoding after
+    // recovery (ChunkDecoder::release_encoder). Skips the encoder setup and never
+    // touches the chunk data; the codec stays owned by the caller.
+    [[nodiscard]] std::vector<Packet> encode_recovered(void *codec, uint32_t chunk_index, uint32_t chunk_size,
+                                                       uint32_t original_size, uint32_t k, bool is_last_chunk,
+                                                       bool encrypted) const;
+
+    // Re-targets the packets of a chunk encoded under another file id or chunk
+    // position (see EncodeCache): headers are rewritten for this encoder,
+    // payloads are kept since FEC symbols depend on the chunk data alone.
+    void restamp_chunk(std::span<Packet> packets, const ChunkManifestEntry &entry, uint32_t chunk_index,
+                       bool is_last_chunk, bool encrypted = false) const;
+
     [[nodiscard]] const FileId &file_id() const { return id; }
 
+    // Repair symbols generated per source symbol (default REPAIR_OVERHEAD).
+    // Throws std::invalid_argument outside [0, MAX_REPAIR_OVERHEAD].
+    void set_repair_overhead(double overhead);
+
+    [[nodiscard]] double repair_overhead() const { return repair_overhead_; }
+
+    // Packets encode_chunk or encode_manifest_segment emits for data_size bytes.
+    [[nodiscard]] std::size_t packet_count(std::size_t data_size) const;
+
 private:
     FileId id;
     HashAlgorithm algo_;
+    double repair_overhead_ = REPAIR_OVERHEAD;
 
-    void write_packet_header(
-        std::span<std::byte> dest,
-        uint32_t chunk_index,
-        uint32_t chunk_size,
-        uint32_t original_size,
-        uint16_t symbol_size,
-        uint32_t num_source,
-        uint32_t block_id,
-        uint16_t payload_length,
-        uint8_t flags,
-        std::span<const std::byte> payload
-    ) const;
+    [[nodiscard]] std::pair<std::vector<Packet>, ChunkManifestEntry>
+    encode_block(uint32_t chunk_index, std::span<const std::byte> chunk_data, uint8_t flags) const;
 };
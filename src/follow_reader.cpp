@@ -0,0 +1,111 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "follow_reader.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FollowReader::FollowReader(const std::string &path, const int idle_timeout_ms, const int poll_interval_ms)
+    : file_(path, std::ios::binary)
+      , idle_timeout_(std::max(0, idle_timeout_ms))
+      , poll_interval_(std::max(1, poll_interval_ms)) {
+    if (!file_) {
+        throw std::runtime_error("open failed");
+    }
+#ifdef __linux__
+    // Falls back to plain polling if inotify is unavailable (e.g. network filesystems).
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ >= 0 && inotify_add_watch(inotify_fd_, path.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+FollowReader::~FollowReader() {
+#ifdef __linux__
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+#endif
+}
+
+void FollowReader::stop() {
+    stopped_ = true;
+#ifdef __linux__
+    if (wake_fd_ >= 0) {
+        const uint64_t one = 1;
+        [[maybe_unused]] const auto written = ::write(wake_fd_, &one, sizeof(one));
+    }
+#endif
+}
+
+void FollowReader::wait_for_growth(const std::chrono::milliseconds timeout) const {
+#ifdef __linux__
+    if (inotify_fd_ >= 0 || wake_fd_ >= 0) {
+        // A negative fd is ignored by poll(), so a missing watch leaves only the wake-up.
+        pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+        if (poll(fds, 2, static_cast<int>(timeout.count())) > 0 && (fds[0].revents & POLLIN)) {
+            char events[4096];
+            while (::read(inotify_fd_, events, sizeof(events)) > 0) {
+            }
+        }
+        return;
+    }
+#endif
+    std::this_thread::sleep_for(timeout);
+}
+
+std::size_t FollowReader::read(std::byte *dest, const std::size_t size) {
+    const auto idle_since = std::chrono::steady_clock::now();
+
+    while (!stopped_) {
+        file_.read(reinterpret_cast<char *>(dest), static_cast<std::streamsize>(size));
+        if (const auto got = static_cast<std::size_t>(file_.gcount()); got > 0) {
+            position_ += got;
+            file_.clear();
+            return got;
+        }
+
+        // Caught up with the writer: rewind the stream state and wait for more data.
+        file_.clear();
+        file_.seekg(static_cast<std::streamoff>(position_));
+
+        const auto idle = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - idle_since);
+        if (on_wait_ && !on_wait_()) {
+            stop();
+        }
+        if (idle >= idle_timeout_ || stopped_) {
+            break;
+        }
+        wait_for_growth(std::min(poll_interval_, idle_timeout_ - idle));
+    }
+    return 0;
+}
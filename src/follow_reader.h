@@ -0,0 +1,70 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+
+// Reads a file that another process is still appending to. When the reader
+// catches up with the writer, read() waits for the file to grow (inotify on
+// Linux, polling elsewhere) and only reports the end once nothing new arrived
+// for the idle timeout.
+class FollowReader {
+public:
+    explicit FollowReader(const std::string &path, int idle_timeout_ms = 10000, int poll_interval_ms = 200);
+
+    ~FollowReader();
+
+    FollowReader(const FollowReader &) = delete;
+
+    FollowReader &operator=(const FollowReader &) = delete;
+
+    FollowReader(FollowReader &&) = delete;
+
+    FollowReader &operator=(FollowReader &&) = delete;
+
+    [[nodiscard]] std::size_t read(std::byte *dest, std::size_t size);
+
+    // Called each time read() is about to wait for the writer; returning false
+    // stops the reader, e.g. when the caller was cancelled.
+    void set_wait_callback(std::function<bool()> callback) { on_wait_ = std::move(callback); }
+
+    // Makes read() report the end now, waking it if it is waiting. Safe to call
+    // from any thread.
+    void stop();
+
+    [[nodiscard]] uint64_t position() const { return position_; }
+
+private:
+    std::ifstream file_;
+    uint64_t position_ = 0;
+    std::chrono::milliseconds idle_timeout_;
+    std::chrono::milliseconds poll_interval_;
+    std::atomic<bool> stopped_{false};
+    std::function<bool()> on_wait_;
+    int inotify_fd_ = -1;
+    int wake_fd_ = -1;
+
+    void wait_for_growth(std::chrono::milliseconds timeout) const;
+};
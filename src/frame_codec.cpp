@@ -0,0 +1,174 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "frame_codec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <omp.h>
+
+FrameLayout compute_frame_layout() {
+    return compute_frame_layout(FRAME_WIDTH, FRAME_HEIGHT);
+}
+
+FrameLayout compute_frame_layout(const int width, const int height) {
+    FrameLayout layout{};
+    layout.frame_width = width;
+    layout.frame_height = height;
+    layout.blocks_per_row = width / 8;
+    layout.blocks_per_col = height / 8;
+    layout.total_blocks = layout.blocks_per_row * layout.blocks_per_col;
+    layout.bits_per_frame = layout.total_blocks * BITS_PER_BLOCK;
+    layout.bytes_per_frame = layout.bits_per_frame / 8;
+    return layout;
+}
+
+std::size_t max_packet_bytes_per_frame() {
+    return static_cast<std::size_t>(compute_frame_layout().bytes_per_frame);
+}
+
+void embed_frame_data(const std::span<const std::byte> data, const FrameLayout &layout, const PatternSet set,
+                      uint8_t *plane, const int stride) {
+#if defined(__APPLE__) && defined(_OPENMP)
+    const auto &blocks = get_precomputed_blocks(set); // avoid structured bindings on Apple OpenMP
+    const auto &patterns = blocks.patterns;
+#else
+    const auto &patterns = get_precomputed_blocks(set).patterns;
+#endif
+
+    for (int y = 0; y < layout.frame_height; ++y) {
+        std::memset(plane + static_cast<std::ptrdiff_t>(y) * stride, 128, layout.frame_width);
+    }
+
+    const std::size_t total_bits = data.size() * 8;
+    const int total_blocks = layout.blocks_per_row * layout.blocks_per_col;
+    const int active_blocks = static_cast<int>(
+        std::min(static_cast<std::size_t>(total_blocks),
+                 (total_bits + BITS_PER_BLOCK - 1) / BITS_PER_BLOCK));
+    const auto *src = reinterpret_cast<const uint8_t *>(data.data());
+    const int blocks_per_row = layout.blocks_per_row;
+
+#pragma omp parallel for schedule(static)
+    for (int block_idx = 0; block_idx < active_blocks; ++block_idx) {
+        const int block_row = block_idx / blocks_per_row;
+        const int block_col = block_idx % blocks_per_row;
+        const int base_x = block_col * 8;
+        const int base_y = block_row * 8;
+
+        const std::size_t bit_start = static_cast<std::size_t>(block_idx) * BITS_PER_BLOCK;
+        const std::size_t bit_end = std::min(bit_start + BITS_PER_BLOCK, total_bits);
+
+        int pattern = 0;
+        for (std::size_t bit_index = bit_start; bit_index < bit_end; ++bit_index) {
+            const std::size_t byte_idx = bit_index / 8;
+            const int bit_pos = 7 - static_cast<int>(bit_index % 8);
+            const int bit = (src[byte_idx] >> bit_pos) & 1;
+            pattern = (pattern << 1) | bit;
+        }
+
+        const int bits_extracted = static_cast<int>(bit_end - bit_start);
+        pattern <<= (BITS_PER_BLOCK - bits_extracted);
+
+        const auto &block = patterns[pattern];
+        for (int y = 0; y < 8; ++y) {
+            std::memcpy(plane + static_cast<std::ptrdiff_t>(base_y + y) * stride + base_x,
+                        block[y], 8);
+        }
+    }
+}
+
+void extract_frame_data(const uint8_t *plane, const int stride, const FrameLayout &layout,
+                        std::vector<std::byte> &dest, const int threads) {
+#if defined(__APPLE__) && defined(_OPENMP)
+    const auto &projections = get_decoder_projections();
+    const auto &vectors = projections.vectors;
+#else
+    const auto &vectors = get_decoder_projections().vectors;
+#endif
+
+    const int blocks_per_row = layout.blocks_per_row;
+    const int total_blocks = layout.total_blocks;
+    constexpr int blocks_per_byte = 8 / BITS_PER_BLOCK;
+
+    const int total_bytes = total_blocks / blocks_per_byte;
+
+    const std::size_t base = dest.size();
+    dest.resize(base + total_bytes);
+    auto *out = reinterpret_cast<uint8_t *>(dest.data() + base);
+    std::memset(out, 0, total_bytes);
+    const int team = threads > 0 ? threads : omp_get_max_threads();
+
+#pragma omp parallel for schedule(static) num_threads(team)
+    for (int byte_idx = 0; byte_idx < total_bytes; ++byte_idx) {
+        uint8_t current_byte = 0;
+
+        for (int sub = 0; sub < blocks_per_byte; ++sub) {
+            const int block_idx = byte_idx * blocks_per_byte + sub;
+            const int block_row = block_idx / blocks_per_row;
+            const int block_col = block_idx % blocks_per_row;
+            const int base_x = block_col * 8;
+            const int base_y = block_row * 8;
+
+            alignas(32) float block_flat[64];
+            for (int y = 0; y < 8; ++y) {
+                const uint8_t *row = plane + static_cast<std::ptrdiff_t>(base_y + y) * stride + base_x;
+                for (int x = 0; x < 8; ++x)
+                    block_flat[y * 8 + x] = static_cast<float>(row[x]);
+            }
+
+            for (int b = 0; b < BITS_PER_BLOCK; ++b) {
+                const float sum = dot_product_64(block_flat, vectors[b]);
+                current_byte = (current_byte << 1) | (sum > 0.0f ? 1 : 0);
+            }
+        }
+
+        out[byte_idx] = current_byte;
+    }
+}
+
+std::size_t packet_size_at(const std::span<const std::byte> data) {
+    if (data.size() < 5) {
+        return HEADER_SIZE + SYMBOL_SIZE_BYTES;
+    }
+    const auto version = static_cast<uint8_t>(data[4]);
+    return (version == VERSION_ID_V2)
+               ? (HEADER_SIZE_V2 + SYMBOL_SIZE_BYTES)
+               : (HEADER_SIZE + SYMBOL_SIZE_BYTES);
+}
+
+void split_packets(std::vector<std::byte> &accumulated, std::vector<std::vector<std::byte> > &out) {
+    std::size_t offset = 0;
+
+    while (offset + 4 <= accumulated.size()) {
+        uint32_t magic = 0;
+        std::memcpy(&magic, accumulated.data() + offset, sizeof(magic));
+        if (magic == MAGIC_ID) {
+            const std::size_t pkt_size = packet_size_at(
+                std::span<const std::byte>(accumulated.data() + offset,
+                                           accumulated.size() - offset));
+            if (offset + pkt_size > accumulated.size()) break;
+            out.emplace_back(
+                accumulated.begin() + static_cast<std::ptrdiff_t>(offset),
+                accumulated.begin() + static_cast<std::ptrdiff_t>(offset + pkt_size));
+            offset += pkt_size;
+        } else {
+            ++offset;
+        }
+    }
+
+    accumulated.erase(accumulated.begin(),
+                      accumulated.begin() + static_cast<std::ptrdiff_t>(offset));
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "configuration.h"
+#include "dct_common.h"
+
+FrameLayout compute_frame_layout();
+FrameLayout compute_frame_layout(int width, int height);
+
+std::size_t max_packet_bytes_per_frame();
+
+// Draws data into an 8-bit luma plane of the layout's size, BITS_PER_BLOCK
+// bits per 8x8 block in row order. Blocks past the data are mid-grey.
+void embed_frame_data(std::span<const std::byte> data, const FrameLayout &layout, PatternSet set,
+                      uint8_t *plane, int stride);
+
+// Reads every block of a luma plane back and appends the bytes they carry,
+// layout.total_blocks * BITS_PER_BLOCK / 8 of them, to dest. threads sizes the
+// OpenMP team (0 = the current default).
+void extract_frame_data(const uint8_t *plane, int stride, const FrameLayout &layout, std::vector<std::byte> &dest,
+                        int threads = 0);
+
+// Size of the packet starting at data, judged by its header version.
+[[nodiscard]] std::size_t packet_size_at(std::span<const std::byte> data);
+
+// Moves every complete packet at the front of accumulated to out, skipping
+// bytes that do not start one. A trailing partial packet stays for the next
+// frame's bytes.
+void split_packets(std::vector<std::byte> &accumulated, std::vector<std::vector<std::byte> > &out);
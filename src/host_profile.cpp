@@ -0,0 +1,178 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "host_profile.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#include "job_protocol.h"
+
+static constexpr int HOST_PROFILE_VERSION = 1;
+
+static bool valid_target(const std::string_view target) {
+    return target == "local" || target == "platform";
+}
+
+static bool valid_patterns(const std::string_view patterns) {
+    return patterns == "cosine" || patterns == "quantized" || patterns == "step";
+}
+
+static bool valid_hash(const std::string_view hash) {
+    return hash == "crc32" || hash == "xxhash";
+}
+
+static std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t' || text.front() == '\r')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+bool host_profile_meets_target(const HostProfile &profile) {
+    return profile.target != "platform" || profile.patterns == "cosine";
+}
+
+std::string format_host_profile(const HostProfile &profile) {
+    std::ostringstream out;
+    out << "# media_storage host profile, written by `media_storage tune`\n"
+            << "version=" << HOST_PROFILE_VERSION << "\n"
+            << "target=" << profile.target << "\n"
+            << "threads=" << profile.threads << "\n"
+            << "ffv1_slices=" << profile.ffv1_slices << "\n"
+            << "patterns=" << profile.patterns << "\n"
+            << "hash=" << profile.hash << "\n"
+            << "encode_mib_s=" << profile.encode_mib_s << "\n"
+            << "decode_mib_s=" << profile.decode_mib_s << "\n";
+    return out.str();
+}
+
+std::optional<HostProfile> parse_host_profile(const std::string_view text) {
+    HostProfile profile;
+    bool has_version = false;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        const std::string_view line = trim(text.substr(pos, end - pos));
+        pos = end + 1;
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        const std::size_t eq = line.find('=');
+        if (eq == std::string_view::npos) {
+            return std::nullopt;
+        }
+        const std::string_view key = trim(line.substr(0, eq));
+        const std::string_view value = trim(line.substr(eq + 1));
+
+        bool ok = true;
+        if (key == "version") {
+            int version = 0;
+            ok = parse_number(value, version) && version == HOST_PROFILE_VERSION;
+            has_version = true;
+        } else if (key == "target") {
+            ok = valid_target(value);
+            profile.target = value;
+        } else if (key == "threads") {
+            ok = parse_number(value, profile.threads) && profile.threads >= 0;
+        } else if (key == "ffv1_slices") {
+            ok = parse_number(value, profile.ffv1_slices) && profile.ffv1_slices >= 0;
+        } else if (key == "patterns") {
+            ok = valid_patterns(value);
+            profile.patterns = value;
+        } else if (key == "hash") {
+            ok = valid_hash(value);
+            profile.hash = value;
+        } else if (key == "encode_mib_s") {
+            ok = parse_number(value, profile.encode_mib_s);
+        } else if (key == "decode_mib_s") {
+            ok = parse_number(value, profile.decode_mib_s);
+        }
+        if (!ok) {
+            return std::nullopt;
+        }
+    }
+    if (!has_version) {
+        return std::nullopt;
+    }
+    return profile;
+}
+
+std::filesystem::path default_host_profile_path() {
+    if (const char *path = std::getenv("MEDIA_STORAGE_PROFILE"); path && *path) {
+        return path;
+    }
+    std::filesystem::path config;
+    if (const char *xdg = std::getenv("XDG_CONFIG_HOME"); xdg && *xdg) {
+        config = xdg;
+    } else if (const char *home = std::getenv("HOME"); home && *home) {
+        config = std::filesystem::path(home) / ".config";
+    } else if (const char *appdata = std::getenv("APPDATA"); appdata && *appdata) {
+        config = appdata;
+    } else {
+        return {};
+    }
+    return config / "media_storage" / "host_profile";
+}
+
+std::optional<HostProfile> load_host_profile(const std::filesystem::path &path) {
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return std::nullopt;
+    }
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("cannot read host profile " + path.string());
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    auto profile = parse_host_profile(text.str());
+    if (!profile) {
+        throw std::runtime_error("malformed host profile " + path.string());
+    }
+    return profile;
+}
+
+void save_host_profile(const std::filesystem::path &path, const HostProfile &profile) {
+    std::error_code ec;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), ec);
+    }
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out << format_host_profile(profile);
+        if (!out) {
+            std::filesystem::remove(tmp, ec);
+            throw std::runtime_error("cannot write host profile " + path.string());
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        throw std::runtime_error("cannot write host profile " + path.string());
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Encode settings `media_storage tune` measured as fastest on this machine,
+// stored as key=value lines:
+//   version=1
+//   target=platform
+//   threads=8
+//   ffv1_slices=16
+//   patterns=cosine
+//   hash=xxhash
+// Every setting only changes speed, never what a decoder accepts, so a profile
+// can be dropped or replaced at any time. Unknown keys are ignored.
+struct HostProfile {
+    std::string target = "local";   // "local" or "platform" (survives lossy re-encoding)
+    int threads = 0;                // OpenMP threads, 0 = all cores
+    int ffv1_slices = 0;            // 0 = codec default
+    std::string patterns = "cosine"; // cosine, quantized or step
+    std::string hash = "crc32";      // crc32 or xxhash
+    double encode_mib_s = 0.0;       // measured by the tuner, informational
+    double decode_mib_s = 0.0;
+};
+
+// Whether the profile's settings hold up for its target: archives meant for a
+// video platform must use the cosine patterns, the only set that survives
+// lossy re-encoding.
+[[nodiscard]] bool host_profile_meets_target(const HostProfile &profile);
+
+[[nodiscard]] std::string format_host_profile(const HostProfile &profile);
+
+// nullopt for a malformed line, an unknown version or an invalid value.
+[[nodiscard]] std::optional<HostProfile> parse_host_profile(std::string_view text);
+
+// $MEDIA_STORAGE_PROFILE if set, otherwise host_profile under
+// $XDG_CONFIG_HOME/media_storage (~/.config/media_storage, or %APPDATA% on
+// Windows). Empty if none of those variables is set.
+[[nodiscard]] std::filesystem::path default_host_profile_path();
+
+// nullopt if the file does not exist. Throws std::runtime_error if it cannot
+// be read or does not parse.
+[[nodiscard]] std::optional<HostProfile> load_host_profile(const std::filesystem::path &path);
+
+// Creates the parent directory and replaces the file atomically. Throws
+// std::runtime_error on failure.
+void save_host_profile(const std::filesystem::path &path, const HostProfile &profile);
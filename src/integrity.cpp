@@ -23,21 +23,41 @@
 #include "libs/xxhash.h"
 
 #include <array>
+#include <charconv>
 #include <cstring>
+#include <utility>
+#include <vector>
 
-static std::string bytes_to_hex(const std::span<const std::byte> inputBytes) {
-    std::string hexString(inputBytes.size() * 2, 0);
+std::string to_hex(const std::span<const std::byte> bytes, const bool uppercase) {
+    static constexpr char LOWER_CHARACTERS[] = "0123456789abcdef";
+    const char *digits = uppercase ? SHA_CHARACTERS : LOWER_CHARACTERS;
+    std::string hexString(bytes.size() * 2, 0);
     auto outputPosition = hexString.data();
-    for (const auto &currentByte: inputBytes) {
+    for (const auto &currentByte: bytes) {
         const auto byteValue = std::to_integer<unsigned char>(currentByte);
-        *outputPosition++ = SHA_CHARACTERS[byteValue >> 4];
-        *outputPosition++ = SHA_CHARACTERS[byteValue & 0x0F];
+        *outputPosition++ = digits[byteValue >> 4];
+        *outputPosition++ = digits[byteValue & 0x0F];
     }
     return hexString;
 }
 
+bool from_hex(const std::string_view hex, const std::span<std::byte> out) {
+    if (hex.size() != out.size() * 2) {
+        return false;
+    }
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        uint8_t value = 0;
+        if (const auto [ptr, ec] = std::from_chars(hex.data() + i * 2, hex.data() + i * 2 + 2, value, 16);
+            ec != std::errc{} || ptr != hex.data() + i * 2 + 2) {
+            return false;
+        }
+        out[i] = std::byte{value};
+    }
+    return true;
+}
+
 std::string Sha256Digest::hexValue() const {
-    return bytes_to_hex(std::span(bytes.data(), bytes.size()));
+    return to_hex(std::span(bytes.data(), bytes.size()), true);
 }
 
 Sha256Digest sha256(const std::span<const std::byte> data) {
@@ -52,6 +72,40 @@ Sha256Digest sha256(const std::span<const std::byte> data) {
     return digest;
 }
 
+Sha256Digest merkle_root(const std::span<const Sha256Digest> leaves) {
+    static constexpr std::byte NODE_PREFIX{0x01};
+    static constexpr std::byte ROOT_PREFIX{0x02};
+    static constexpr int PARALLEL_MIN_PAIRS = 1024;
+
+    std::vector<Sha256Digest> level(leaves.begin(), leaves.end());
+    while (level.size() > 1) {
+        const auto pairs = static_cast<int>(level.size() / 2);
+        std::vector<Sha256Digest> parents((level.size() + 1) / 2);
+
+#pragma omp parallel for schedule(static) if (pairs >= PARALLEL_MIN_PAIRS)
+        for (int i = 0; i < pairs; ++i) {
+            std::array<std::byte, 1 + 2 * SHA256_HASH_SIZE> node{};
+            node[0] = NODE_PREFIX;
+            std::memcpy(node.data() + 1, level[2 * i].bytes.data(), SHA256_HASH_SIZE);
+            std::memcpy(node.data() + 1 + SHA256_HASH_SIZE, level[2 * i + 1].bytes.data(), SHA256_HASH_SIZE);
+            parents[i] = sha256(node);
+        }
+        if (level.size() % 2 != 0) {
+            parents.back() = level.back();
+        }
+        level = std::move(parents);
+    }
+
+    std::array<std::byte, 1 + sizeof(uint64_t) + SHA256_HASH_SIZE> root{};
+    root[0] = ROOT_PREFIX;
+    const uint64_t count = leaves.size();
+    std::memcpy(root.data() + 1, &count, sizeof(count));
+    if (!level.empty()) {
+        std::memcpy(root.data() + 1 + sizeof(count), level.front().bytes.data(), SHA256_HASH_SIZE);
+    }
+    return sha256(root);
+}
+
 uint32_t crc32c(const std::span<const std::byte> data, const uint32_t seed) {
     if (seed != 0) {
         const uint8_t seedBytes[4] = {
@@ -150,6 +204,34 @@ uint32_t xxhash32_packet(const std::span<const std::byte> header,
     return XXH32_digest(&state);
 }
 
+static_assert(sizeof(XXH32_state_t) <= 48 && alignof(XXH32_state_t) <= 8,
+              "PacketChecksum storage too small for XXH32_state_t");
+
+PacketChecksum::PacketChecksum(const HashAlgorithm algo) : algo_(algo) {
+    if (algo_ == HashAlgorithm::XXHash32) {
+        XXH32_reset(reinterpret_cast<XXH32_state_t *>(xxh_state_.data()), 0);
+    }
+}
+
+void PacketChecksum::update(const std::span<const std::byte> data) {
+    if (algo_ == HashAlgorithm::XXHash32) {
+        XXH32_update(reinterpret_cast<XXH32_state_t *>(xxh_state_.data()), data.data(), data.size());
+        return;
+    }
+    const auto &table = CRC::CRC_32_MPEG2();
+    crc_ = crc_started_
+               ? CRC::Calculate(data.data(), data.size(), table, crc_)
+               : CRC::Calculate(data.data(), data.size(), table);
+    crc_started_ = true;
+}
+
+uint32_t PacketChecksum::digest() const {
+    if (algo_ == HashAlgorithm::XXHash32) {
+        return XXH32_digest(reinterpret_cast<const XXH32_state_t *>(xxh_state_.data()));
+    }
+    return crc_started_ ? crc_ : CRC::Calculate(xxh_state_.data(), 0, CRC::CRC_32_MPEG2());
+}
+
 uint32_t packet_checksum(const std::span<const std::byte> header,
                          const std::span<const std::byte> payload,
                          const std::size_t crc_offset,
@@ -23,6 +23,9 @@
 #include <cstdint>
 #include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 constexpr size_t SHA256_HASH_SIZE = 32;
 
@@ -39,6 +42,21 @@ struct Sha256Digest {
     bool operator==(const Sha256Digest &sha256) const = default;
 };
 
+// Two hex digits per byte, lowercase unless uppercase is set.
+[[nodiscard]] std::string to_hex(std::span<const std::byte> bytes, bool uppercase = false);
+
+// Parses exactly 2 * out.size() hex digits of either case into out.
+[[nodiscard]] bool from_hex(std::string_view hex, std::span<std::byte> out);
+
+// Appends the bytes of value, in host order, to out. The manifest, catalog and
+// encode cache formats are written this way.
+template<typename T>
+void append_value(std::vector<std::byte> &out, const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto *bytes = reinterpret_cast<const std::byte *>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
 uint32_t crc32c(std::span<const std::byte> data, uint32_t seed = 0);
 
 uint32_t crc32c_concat(std::span<const std::byte> first,
@@ -66,4 +84,29 @@ uint32_t packet_checksum(std::span<const std::byte> header,
                          HashAlgorithm algo,
                          std::size_t crc_size = 4);
 
+// Incremental form of packet_checksum. Bytes shared by many packets can be
+// hashed once; copies of the object then continue from that state.
+class PacketChecksum {
+public:
+    explicit PacketChecksum(HashAlgorithm algo = HashAlgorithm::CRC32);
+
+    void update(std::span<const std::byte> data);
+
+    [[nodiscard]] uint32_t digest() const;
+
+    [[nodiscard]] HashAlgorithm algorithm() const { return algo_; }
+
+private:
+    HashAlgorithm algo_;
+    uint32_t crc_ = 0;
+    bool crc_started_ = false;
+    alignas(8) std::array<std::byte, 48> xxh_state_{}; // XXH32_state_t, opaque here
+};
+
 Sha256Digest sha256(std::span<const std::byte> data);
+
+// Whole-file digest over per-chunk SHA-256s. Digests are paired level by level
+// as SHA-256(0x01 || left || right), an odd node moving up unchanged, and the
+// top node is sealed as SHA-256(0x02 || leaf count u64 || node) so the root
+// also commits to the number of chunks. Wide levels are hashed in parallel.
+Sha256Digest merkle_root(std::span<const Sha256Digest> leaves);
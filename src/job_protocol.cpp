@@ -0,0 +1,141 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "job_protocol.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+
+static bool needs_escape(const char c) {
+    return c == '%' || c == '=' || static_cast<unsigned char>(c) <= ' ' || c == 0x7F;
+}
+
+static std::string escape(const std::string_view text) {
+    static constexpr char digits[] = "0123456789ABCDEF";
+    std::string out;
+    out.reserve(text.size());
+    for (const char c: text) {
+        if (needs_escape(c)) {
+            const auto byte = static_cast<unsigned char>(c);
+            out.push_back('%');
+            out.push_back(digits[byte >> 4]);
+            out.push_back(digits[byte & 0x0F]);
+        } else {
+            out.push_back(c);
+        }
+    }
+    return out;
+}
+
+static std::optional<std::string> unescape(const std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '%') {
+            out.push_back(text[i]);
+            continue;
+        }
+        uint8_t byte = 0;
+        if (i + 2 >= text.size()) {
+            return std::nullopt;
+        }
+        if (const auto [ptr, ec] = std::from_chars(text.data() + i + 1, text.data() + i + 3, byte, 16);
+            ec != std::errc{} || ptr != text.data() + i + 3) {
+            return std::nullopt;
+        }
+        out.push_back(static_cast<char>(byte));
+        i += 2;
+    }
+    return out;
+}
+
+void JobMessage::add(std::string key, std::string value) {
+    fields.emplace_back(std::move(key), std::move(value));
+}
+
+const std::string *JobMessage::find(const std::string_view key) const {
+    for (const auto &[k, v]: fields) {
+        if (k == key) {
+            return &v;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string> JobMessage::find_all(const std::string_view key) const {
+    std::vector<std::string> values;
+    for (const auto &[k, v]: fields) {
+        if (k == key) {
+            values.push_back(v);
+        }
+    }
+    return values;
+}
+
+std::string format_job_message(const JobMessage &message) {
+    std::string line = escape(message.verb);
+    for (const auto &[key, value]: message.fields) {
+        line += ' ';
+        line += escape(key);
+        line += '=';
+        line += escape(value);
+    }
+    return line;
+}
+
+std::optional<JobMessage> parse_job_message(std::string_view line) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+
+    JobMessage message;
+    std::size_t pos = 0;
+    bool first = true;
+    while (pos < line.size()) {
+        if (line[pos] == ' ') {
+            ++pos;
+            continue;
+        }
+        const std::size_t end = std::min(line.find(' ', pos), line.size());
+        const std::string_view token = line.substr(pos, end - pos);
+        pos = end;
+
+        if (first) {
+            auto verb = unescape(token);
+            if (!verb) {
+                return std::nullopt;
+            }
+            message.verb = std::move(*verb);
+            first = false;
+            continue;
+        }
+        const std::size_t eq = token.find('=');
+        if (eq == std::string_view::npos || eq == 0) {
+            return std::nullopt;
+        }
+        auto key = unescape(token.substr(0, eq));
+        auto value = unescape(token.substr(eq + 1));
+        if (!key || !value) {
+            return std::nullopt;
+        }
+        message.add(std::move(*key), std::move(*value));
+    }
+    if (first) {
+        return std::nullopt;
+    }
+    return message;
+}
@@ -0,0 +1,77 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Messages of the `serve` socket, one per line: a verb followed by
+// space-separated key=value fields, e.g.
+//   encode input=/data/a.bin output=/data/a.mkv
+//   ok job=3 status=OK output_size=1234
+// Values are percent-encoded where they contain '%', '=', whitespace or
+// control bytes, so any path fits on one line. A key may repeat (decode takes
+// several inputs).
+struct JobMessage {
+    std::string verb;
+    std::vector<std::pair<std::string, std::string> > fields;
+
+    void add(std::string key, std::string value);
+
+    // First value of key, or nullptr.
+    [[nodiscard]] const std::string *find(std::string_view key) const;
+
+    [[nodiscard]] std::vector<std::string> find_all(std::string_view key) const;
+};
+
+// Without the trailing newline.
+[[nodiscard]] std::string format_job_message(const JobMessage &message);
+
+// nullopt for an empty line, a malformed field or a bad escape.
+[[nodiscard]] std::optional<JobMessage> parse_job_message(std::string_view line);
+
+// Parses the whole of text as a decimal number; false if anything is left
+// over or the value does not fit in T. Used for message fields and for the
+// key=value lines of host profiles.
+template<typename T>
+[[nodiscard]] bool parse_number(const std::string_view text, T &value) {
+    if constexpr (std::is_floating_point_v<T>) {
+        // libc++ on Apple platforms has no floating-point from_chars.
+        const std::string terminated(text);
+        char *end = nullptr;
+        errno = 0;
+        const double parsed = std::strtod(terminated.c_str(), &end);
+        if (terminated.empty() || end != terminated.c_str() + terminated.size() || errno == ERANGE) {
+            return false;
+        }
+        value = static_cast<T>(parsed);
+        return true;
+    } else {
+        const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc{} && end == text.data() + text.size();
+    }
+}
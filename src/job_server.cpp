@@ -0,0 +1,539 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "job_server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include "integrity.h"
+#include "media_storage.h"
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static JobMessage error_reply(const std::string &message) {
+    JobMessage reply{"error", {}};
+    reply.add("message", message);
+    return reply;
+}
+
+static std::optional<uint64_t> number_field(const JobMessage &request, const std::string_view key) {
+    const std::string *value = request.find(key);
+    if (!value) {
+        return std::nullopt;
+    }
+    uint64_t number = 0;
+    if (!parse_number(*value, number)) {
+        throw std::invalid_argument(std::string(key) + " is not a number");
+    }
+    return number;
+}
+
+// A size given in MiB, as bytes.
+static uint64_t mebibytes_field(const JobMessage &request, const std::string_view key) {
+    constexpr uint64_t mebibyte = 1024 * 1024;
+    const uint64_t value = number_field(request, key).value_or(0);
+    if (value > std::numeric_limits<uint64_t>::max() / mebibyte) {
+        throw std::invalid_argument(std::string(key) + " is too large");
+    }
+    return value * mebibyte;
+}
+
+static bool flag_field(const JobMessage &request, const std::string_view key) {
+    const std::string *value = request.find(key);
+    return value && *value != "0";
+}
+
+static const std::string &required_field(const JobMessage &request, const std::string_view key) {
+    const std::string *value = request.find(key);
+    if (!value || value->empty()) {
+        throw std::invalid_argument(std::string(key) + " is required");
+    }
+    return *value;
+}
+
+static JobMessage status_reply(const ms_status_t status) {
+    JobMessage reply{status == MS_OK ? "ok" : "error", {}};
+    reply.add("status", ms_status_string(status));
+    return reply;
+}
+
+static void add_result(JobMessage &reply, const ms_result_t &result) {
+    reply.add("input_size", std::to_string(result.input_size));
+    reply.add("output_size", std::to_string(result.output_size));
+    reply.add("chunks", std::to_string(result.total_chunks));
+    reply.add("packets", std::to_string(result.total_packets));
+    reply.add("frames", std::to_string(result.total_frames));
+    if (result.has_file_digest) {
+        reply.add("file_digest", to_hex(std::as_bytes(std::span(result.file_digest))));
+    }
+}
+
+static JobMessage run_encode(const JobMessage &request) {
+    const std::string &input = required_field(request, "input");
+    const std::string &output = required_field(request, "output");
+    const std::string *password = request.find("password");
+    const std::string *cache_dir = request.find("cache_dir");
+
+    ms_encode_options_t opts{};
+    opts.input_path = input.c_str();
+    opts.output_path = output.c_str();
+    if (password) {
+        opts.encrypt = 1;
+        opts.password = password->c_str();
+        opts.password_len = password->size();
+    }
+    if (const std::string *hash = request.find("hash"); hash && *hash == "xxhash") {
+        opts.hash_algorithm = MS_HASH_XXHASH32;
+    }
+    if (const std::string *patterns = request.find("patterns")) {
+        opts.pattern_set = *patterns == "quantized" ? MS_PATTERN_QUANTIZED_COSINE
+                           : *patterns == "step"    ? MS_PATTERN_STEP
+                                                    : MS_PATTERN_COSINE;
+    }
+    opts.max_shard_frames = number_field(request, "max_frames").value_or(0);
+    opts.max_shard_bytes = mebibytes_field(request, "max_size");
+    opts.raw_packet_track = flag_field(request, "raw_track");
+    opts.audio_data_track = flag_field(request, "audio_track");
+    opts.verify = flag_field(request, "verify");
+    opts.cache_dir = cache_dir ? cache_dir->c_str() : nullptr;
+    opts.cache_chunks = flag_field(request, "cache_chunks");
+
+    ms_result_t result{};
+    const ms_status_t status = ms_encode(&opts, &result);
+    JobMessage reply = status_reply(status);
+    if (status == MS_OK) {
+        add_result(reply, result);
+        reply.add("shards", std::to_string(result.total_shards));
+        reply.add("cache_hit", std::to_string(result.cache_hit));
+    }
+    return reply;
+}
+
+static JobMessage run_decode(const JobMessage &request) {
+    const std::vector<std::string> inputs = request.find_all("input");
+    const std::string &output = required_field(request, "output");
+    const std::string *password = request.find("password");
+    const std::string *spill_dir = request.find("spill_dir");
+    if (inputs.empty()) {
+        throw std::invalid_argument("input is required");
+    }
+    std::vector<const char *> input_ptrs;
+    for (const auto &input: inputs) {
+        input_ptrs.push_back(input.c_str());
+    }
+
+    ms_decode_options_t opts{};
+    opts.input_paths = input_ptrs.data();
+    opts.input_count = input_ptrs.size();
+    opts.output_path = output.c_str();
+    if (password) {
+        opts.password = password->c_str();
+        opts.password_len = password->size();
+    }
+    opts.memory_budget = mebibytes_field(request, "memory_budget");
+    opts.spill_dir = spill_dir ? spill_dir->c_str() : nullptr;
+    opts.ignore_raw_packet_track = flag_field(request, "pixels");
+
+    ms_result_t result{};
+    const ms_status_t status = ms_decode(&opts, &result);
+    JobMessage reply = status_reply(status);
+    if (status == MS_OK) {
+        add_result(reply, result);
+    }
+    return reply;
+}
+
+// Largest buffer a read job holds at once. Longer ranges are read and
+// written a block at a time, so the request cannot size the allocation.
+static constexpr uint64_t READ_BLOCK_BYTES = 16 * 1024 * 1024;
+
+static JobMessage run_read(const JobMessage &request) {
+    const std::vector<std::string> inputs = request.find_all("input");
+    const std::string &output = required_field(request, "output");
+    const std::string *password = request.find("password");
+    const auto offset = number_field(request, "offset");
+    const auto length = number_field(request, "length");
+    if (inputs.empty() || !offset || !length) {
+        throw std::invalid_argument("input, offset and length are required");
+    }
+    if (*length > std::numeric_limits<uint64_t>::max() - *offset) {
+        throw std::invalid_argument("offset and length run past the end of any file");
+    }
+    std::vector<const char *> input_ptrs;
+    for (const auto &input: inputs) {
+        input_ptrs.push_back(input.c_str());
+    }
+
+    std::vector<std::byte> buffer(std::min(*length, READ_BLOCK_BYTES));
+    ms_read_range_options_t opts{};
+    opts.input_paths = input_ptrs.data();
+    opts.input_count = input_ptrs.size();
+    if (password) {
+        opts.password = password->c_str();
+        opts.password_len = password->size();
+    }
+    opts.buffer = buffer.data();
+
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    ms_status_t status = out ? MS_OK : MS_ERR_IO;
+    uint64_t total_read = 0;
+    while (status == MS_OK && total_read < *length) {
+        opts.offset = *offset + total_read;
+        opts.length = std::min(*length - total_read, READ_BLOCK_BYTES);
+        uint64_t bytes_read = 0;
+        status = ms_read_range(&opts, &bytes_read);
+        if (status != MS_OK) {
+            break;
+        }
+        out.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(bytes_read));
+        if (!out) {
+            status = MS_ERR_IO;
+        }
+        total_read += bytes_read;
+        if (bytes_read < opts.length) {
+            break; // past the end of the file
+        }
+    }
+    JobMessage reply = status_reply(status);
+    if (status == MS_OK) {
+        reply.add("bytes_read", std::to_string(total_read));
+    }
+    return reply;
+}
+
+static JobMessage run_verify(const JobMessage &request) {
+    const std::string &input = required_field(request, "input");
+    ms_verify_options_t opts{};
+    opts.input_path = input.c_str();
+    opts.threads = static_cast<int>(number_field(request, "threads").value_or(0));
+
+    ms_verify_result_t result{};
+    const ms_status_t status = ms_verify(&opts, &result);
+    JobMessage reply = status_reply(status);
+    reply.add("chunks", std::to_string(result.total_chunks));
+    reply.add("recoverable", std::to_string(result.recoverable_chunks));
+    reply.add("verified", std::to_string(result.verified_chunks));
+    reply.add("hash_mismatches", std::to_string(result.hash_mismatches));
+    reply.add("file_digest_verified", std::to_string(result.file_digest_verified));
+    reply.add("min_spare_symbols", std::to_string(result.min_spare_symbols));
+    return reply;
+}
+
+static JobMessage run_probe(const JobMessage &request) {
+    const std::string &input = required_field(request, "input");
+    ms_info_t info{};
+    const ms_status_t status = ms_probe(input.c_str(), &info);
+    JobMessage reply = status_reply(status);
+    if (status == MS_OK) {
+        reply.add("file_id", to_hex(std::as_bytes(std::span(info.file_id))));
+        reply.add("encrypted", std::to_string(info.encrypted));
+        reply.add("file_size", std::to_string(info.file_size));
+        reply.add("chunks", std::to_string(info.chunk_count));
+        reply.add("frames", std::to_string(info.total_frames));
+        reply.add("has_manifest", std::to_string(info.has_manifest));
+        reply.add("shard_index", std::to_string(info.shard_index));
+        reply.add("shard_count", std::to_string(info.shard_count));
+    }
+    return reply;
+}
+
+static JobMessage run_job(const JobMessage &request) {
+    try {
+        if (request.verb == "encode") return run_encode(request);
+        if (request.verb == "decode") return run_decode(request);
+        if (request.verb == "read") return run_read(request);
+        if (request.verb == "verify") return run_verify(request);
+        if (request.verb == "probe") return run_probe(request);
+        return error_reply("unknown verb");
+    } catch (const std::exception &e) {
+        return error_reply(e.what());
+    }
+}
+
+static bool is_job_verb(const std::string &verb) {
+    return verb == "encode" || verb == "decode" || verb == "read" || verb == "verify" || verb == "probe";
+}
+
+JobServer::JobServer(JobServerOptions options)
+    : options_(std::move(options)), queue_(options_.queue_capacity) {
+    options_.workers = std::max(1, options_.workers);
+}
+
+JobServer::~JobServer() {
+    request_shutdown();
+    join_threads();
+}
+
+void JobServer::join_threads() {
+    for (auto &worker: workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    // Connection threads take the lock on their way out.
+    std::map<uint64_t, std::thread> connections;
+    {
+        std::lock_guard lock(connections_mutex_);
+        connections.swap(connections_);
+        finished_connections_.clear();
+    }
+    for (auto &[id, connection]: connections) {
+        connection.join();
+    }
+}
+
+void JobServer::reap_connections() {
+    std::vector<std::thread> finished;
+    {
+        std::lock_guard lock(connections_mutex_);
+        for (const uint64_t id: finished_connections_) {
+            if (const auto it = connections_.find(id); it != connections_.end()) {
+                finished.push_back(std::move(it->second));
+                connections_.erase(it);
+            }
+        }
+        finished_connections_.clear();
+    }
+    for (auto &connection: finished) {
+        connection.join();
+    }
+}
+
+#ifdef _WIN32
+
+void JobServer::run() {
+    throw std::runtime_error("serve needs Unix domain sockets, which this build does not support");
+}
+
+void JobServer::serve_connection(int, uint64_t) {
+}
+
+void JobServer::request_shutdown() {
+    stopping_ = true;
+    queue_.close();
+}
+
+#else
+
+void JobServer::run() {
+    sockaddr_un address{};
+    if (options_.socket_path.empty() || options_.socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("socket path is empty or too long");
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // A socket file left behind by a server that died is replaced; anything
+    // else at that path is not touched.
+    std::error_code ec;
+    if (std::filesystem::is_socket(options_.socket_path, ec)) {
+        std::filesystem::remove(options_.socket_path, ec);
+    }
+
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error("cannot create socket");
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, options_.socket_path.c_str(), options_.socket_path.size() + 1);
+    const mode_t old_mask = ::umask(0177);
+    const int bound = ::bind(listen_fd_, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+    ::umask(old_mask);
+    if (bound != 0 || ::listen(listen_fd_, 16) != 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        throw std::runtime_error("cannot listen on " + options_.socket_path + ": " + std::strerror(errno));
+    }
+
+    for (int i = 0; i < options_.workers; ++i) {
+        workers_.emplace_back(&JobServer::worker_loop, this);
+    }
+
+    while (!stopping_) {
+        const int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        // A long-running server sees many short connections; join the ones
+        // that are done instead of keeping their threads until shutdown.
+        reap_connections();
+        std::lock_guard lock(connections_mutex_);
+        if (stopping_) {
+            ::close(fd);
+            break;
+        }
+        connection_fds_.push_back(fd);
+        const uint64_t id = next_connection_id_++;
+        connections_.emplace(id, std::thread(&JobServer::serve_connection, this, fd, id));
+    }
+
+    request_shutdown();
+    join_threads();
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    std::filesystem::remove(options_.socket_path, ec);
+}
+
+void JobServer::serve_connection(const int fd, const uint64_t connection_id) {
+    const auto send_line = [fd](const JobMessage &message) {
+        const std::string line = format_job_message(message) + "\n";
+        std::size_t sent = 0;
+        while (sent < line.size()) {
+            const ssize_t n = ::write(fd, line.data() + sent, line.size() - sent);
+            if (n <= 0) return false;
+            sent += static_cast<std::size_t>(n);
+        }
+        return true;
+    };
+
+    std::string pending;
+    char buffer[4096];
+    bool open = true;
+    while (open) {
+        const ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        pending.append(buffer, static_cast<std::size_t>(n));
+
+        std::size_t newline;
+        while (open && (newline = pending.find('\n')) != std::string::npos) {
+            const std::string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+
+            const auto request = parse_job_message(line);
+            JobMessage reply;
+            if (!request) {
+                reply = error_reply("malformed request");
+            } else if (request->verb == "metrics") {
+                reply = metrics();
+            } else if (request->verb == "shutdown") {
+                reply = JobMessage{"ok", {}};
+                open = false;
+                request_shutdown();
+            } else if (is_job_verb(request->verb)) {
+                reply = submit(std::move(*request));
+            } else {
+                reply = error_reply("unknown verb");
+            }
+            open = send_line(reply) && open;
+        }
+    }
+
+    std::lock_guard lock(connections_mutex_);
+    std::erase(connection_fds_, fd);
+    ::close(fd);
+    finished_connections_.push_back(connection_id);
+}
+
+void JobServer::request_shutdown() {
+    if (stopping_.exchange(true)) {
+        return;
+    }
+    queue_.close();
+    // Wakes accept() and every connection blocked in read().
+    if (listen_fd_ >= 0) {
+        ::shutdown(listen_fd_, SHUT_RDWR);
+    }
+    std::lock_guard lock(connections_mutex_);
+    for (const int fd: connection_fds_) {
+        ::shutdown(fd, SHUT_RD);
+    }
+}
+
+#endif
+
+JobMessage JobServer::submit(JobMessage request) {
+    auto job = std::make_shared<Job>();
+    job->id = next_job_id_++;
+    job->request = std::move(request);
+    job->queued = std::chrono::steady_clock::now();
+    std::future<JobMessage> reply = job->reply.get_future();
+
+    const std::string verb = job->request.verb;
+    if (!queue_.try_push(job)) {
+        ++rejected_;
+        JobMessage busy{"busy", {}};
+        busy.add("queued", std::to_string(queue_.size()));
+        return busy;
+    }
+    ++submitted_;
+    {
+        std::lock_guard lock(verb_mutex_);
+        ++jobs_by_verb_[verb];
+    }
+    return reply.get();
+}
+
+void JobServer::worker_loop() {
+    // Split the cores between the workers instead of letting every job's
+    // OpenMP regions claim all of them.
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    ms_set_thread_count(std::max(1, cores / options_.workers));
+
+    while (auto job = queue_.pop()) {
+        const auto started = std::chrono::steady_clock::now();
+        wait_us_ += std::chrono::duration_cast<std::chrono::microseconds>(started - (*job)->queued).count();
+        ++running_;
+        JobMessage reply = run_job((*job)->request);
+        --running_;
+        run_us_ += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started).count();
+
+        ++(reply.verb == "ok" ? completed_ : failed_);
+        reply.fields.insert(reply.fields.begin(), {"job", std::to_string((*job)->id)});
+        (*job)->reply.set_value(std::move(reply));
+    }
+}
+
+JobMessage JobServer::metrics() const {
+    JobMessage reply{"ok", {}};
+    const uint64_t finished = completed_ + failed_;
+    reply.add("workers", std::to_string(options_.workers));
+    reply.add("queue_capacity", std::to_string(options_.queue_capacity));
+    reply.add("queued", std::to_string(queue_.size()));
+    reply.add("running", std::to_string(running_.load()));
+    reply.add("submitted", std::to_string(submitted_.load()));
+    reply.add("completed", std::to_string(completed_.load()));
+    reply.add("failed", std::to_string(failed_.load()));
+    reply.add("rejected", std::to_string(rejected_.load()));
+    reply.add("mean_wait_ms", std::to_string(finished > 0 ? wait_us_ / finished / 1000 : 0));
+    reply.add("mean_run_ms", std::to_string(finished > 0 ? run_us_ / finished / 1000 : 0));
+    {
+        std::lock_guard lock(verb_mutex_);
+        for (const auto &[verb, count]: jobs_by_verb_) {
+            reply.add("jobs_" + verb, std::to_string(count));
+        }
+    }
+    if (ms_chunk_cache_stats_t cache{}; ms_chunk_cache_stats(&cache) == MS_OK) {
+        reply.add("chunk_cache_hits", std::to_string(cache.memory_hits + cache.disk_hits));
+        reply.add("chunk_cache_misses", std::to_string(cache.misses));
+        reply.add("chunk_cache_hit_rate", std::to_string(cache.hit_rate));
+    }
+    return reply;
+}
@@ -0,0 +1,108 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "job_protocol.h"
+
+struct JobServerOptions {
+    std::string socket_path;
+    int workers = 2;                 // jobs run side by side
+    std::size_t queue_capacity = 16; // waiting jobs beyond this are refused
+};
+
+// Backend of `media_storage serve`: a Unix domain socket accepting encode,
+// decode, read, verify and probe jobs (see job_protocol.h) plus `metrics` and
+// `shutdown`. Every connection is served by its own thread, which queues its
+// jobs and blocks until they finish; a fixed set of workers runs them. The
+// process keeps its FEC tables, libsodium state, OpenMP teams and decoded chunk
+// cache warm between jobs, which is what a fresh CLI process pays for each
+// time. Only the owner may connect (the socket is created 0600).
+class JobServer {
+public:
+    explicit JobServer(JobServerOptions options);
+
+    ~JobServer();
+
+    JobServer(const JobServer &) = delete;
+
+    JobServer &operator=(const JobServer &) = delete;
+
+    // Serves until a shutdown request arrives. Throws std::runtime_error if
+    // the socket cannot be set up.
+    void run();
+
+private:
+    struct Job {
+        uint64_t id = 0;
+        JobMessage request;
+        std::promise<JobMessage> reply;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    void serve_connection(int fd, uint64_t connection_id);
+
+    // Joins the threads of connections that have closed.
+    void reap_connections();
+
+    [[nodiscard]] JobMessage submit(JobMessage request);
+
+    void worker_loop();
+
+    [[nodiscard]] JobMessage metrics() const;
+
+    void request_shutdown();
+
+    void join_threads();
+
+    JobServerOptions options_;
+    int listen_fd_ = -1;
+    BoundedQueue<std::shared_ptr<Job> > queue_;
+    std::vector<std::thread> workers_;
+
+    std::mutex connections_mutex_;
+    std::map<uint64_t, std::thread> connections_;
+    std::vector<uint64_t> finished_connections_;
+    std::vector<int> connection_fds_;
+    uint64_t next_connection_id_ = 0;
+
+    std::atomic<bool> stopping_{false};
+    std::atomic<uint64_t> next_job_id_{1};
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> running_{0};
+    std::atomic<uint64_t> wait_us_{0};
+    std::atomic<uint64_t> run_us_{0};
+    mutable std::mutex verb_mutex_;
+    std::map<std::string, uint64_t> jobs_by_verb_;
+};
@@ -14,11 +14,20 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include <filesystem>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <optional>
+#include <span>
 #include <string>
+#include <vector>
 
+#include "auto_tune.h"
+#include "host_profile.h"
+#include "integrity.h"
+#include "job_server.h"
 #include "media_storage.h"
 
 static std::string format_size(const uint64_t bytes) {
@@ -34,6 +43,17 @@ static std::string format_size(const uint64_t bytes) {
     return oss.str();
 }
 
+static void print_file_digest(const ms_result_t &result) {
+    if (!result.has_file_digest) {
+        return;
+    }
+    std::cout << "File digest: " << to_hex(std::as_bytes(std::span(result.file_digest)));
+    if (result.file_digest_verified) {
+        std::cout << " (matches the archive)";
+    }
+    std::cout << "\n";
+}
+
 static int encode_progress(const uint64_t current, const uint64_t total, void *) {
     if (total > 0) {
         std::cout << "\rEncoding chunk " << (current + 1) << "/" << total << "..." << std::flush;
@@ -44,6 +64,26 @@ static int encode_progress(const uint64_t current, const uint64_t total, void *)
 static int decode_progress(const uint64_t current, const uint64_t total, void *) {
     if (total > 0) {
         std::cout << "\rDecoding frame " << current << "/" << total << "..." << std::flush;
+    } else {
+        std::cout << "\rDecoding frame " << current << "..." << std::flush;
+    }
+    return 0;
+}
+
+static int verify_progress(const uint64_t current, const uint64_t total, void *) {
+    if (total > 0) {
+        std::cout << "\rVerifying frame " << current << "/" << total << "..." << std::flush;
+    } else {
+        std::cout << "\rVerifying frame " << current << "..." << std::flush;
+    }
+    return 0;
+}
+
+static int refresh_progress(const uint64_t current, const uint64_t total, void *) {
+    if (total > 0) {
+        std::cout << "\rRefreshing frame " << current << "/" << total << "..." << std::flush;
+    } else {
+        std::cout << "\rRefreshing frame " << current << "..." << std::flush;
     }
     return 0;
 }
@@ -64,19 +104,58 @@ static int stream_decode_progress(const uint64_t current, const uint64_t total,
     return 0;
 }
 
+// Export writes its frames to stdout when asked to, so it reports on stderr.
+static int export_progress(const uint64_t current, const uint64_t total, void *) {
+    if (total > 0) {
+        std::cerr << "\rExporting chunk " << (current + 1) << "/" << total << "..." << std::flush;
+    }
+    return 0;
+}
+
+static int import_progress(const uint64_t current, const uint64_t, void *) {
+    std::cerr << "\rImporting frame " << current << "..." << std::flush;
+    return 0;
+}
+
 static void print_usage(const char *program) {
     std::cerr << "Usage:\n"
             << "  " << program <<
-            " encode --input <file> --output <video> [--encrypt --password <pwd>] [--hash <crc32|xxhash>]\n"
-            << "  " << program << " decode --input <video> --output <file> [--password <pwd>]\n"
+            " encode --input <file> --output <video> [--encrypt --password <pwd>] [--hash <crc32|xxhash>] [--max-frames <n>] [--max-size <MiB>] [--raw-track] [--audio-track] [--patterns <cosine|quantized|step>] [--target <local|platform>] [--verify] [--cache-dir <dir> [--cache-chunks]] [--profile <path> | --no-profile] [--catalog <path> | --no-catalog]\n"
+            << "  " << program << " decode (--input <video> [--input <video> ...] | --name <file> | --id <hex>) --output <file> [--password <pwd>] [--follow [--idle-timeout <sec>]] [--memory-budget <MiB> [--spill-dir <dir>]] [--pixels] [--decoder-threads <n>] [--adaptive-threads] [--chunk-cache <dir> [--chunk-cache-size <MiB>]] [--profile <path> | --no-profile] [--catalog <path>]\n"
             << "  " << program <<
-            " stream-encode --input <file> --url <rtmp://...> [--bitrate <kbps>] [--width <w> --height <h>] [--encrypt --password <pwd>]\n"
-            << "  " << program << " stream-decode --url <stream_url> --output <file> [--password <pwd>]\n";
+            " read (--input <video> [--input <video> ...] | --name <file> | --id <hex>) --output <file> --offset <n> --length <n> [--password <pwd>] [--chunk-cache <dir> [--chunk-cache-size <MiB>]] [--profile <path> | --no-profile] [--catalog <path> | --no-catalog]\n"
+            << "  " << program << " verify --input <video> [--threads <n>]\n"
+            << "  " << program <<
+            " serve --socket <path> [--jobs <n>] [--queue <n>] [--chunk-cache <dir> [--chunk-cache-size <MiB>]]\n"
+            << "  " << program << " tune [--target <local|platform>] [--sample-size <MiB>] [--profile <path>]\n"
+            << "  " << program << " info --input <video> [--catalog <path> | --no-catalog]\n"
+            << "  " << program << " catalog list [--name <filter>] [--catalog <path>]\n"
+            << "  " << program << " catalog add --input <video> [--input <video> ...] [--catalog <path>]\n"
+            << "  " << program << " catalog remove --id <hex> [--catalog <path>]\n"
+            << "  " << program << " catalog prune [--catalog <path>]\n"
+            << "  " << program << " refresh --input <video> --output <video>\n"
+            << "  " << program <<
+            " fanout --input <file> --sink <spec> [--sink <spec> ...] [--encrypt --password <pwd>] [--hash <crc32|xxhash>]\n"
+            << "      <spec> is file=<video> or stream=<rtmp://...>, optionally followed by\n"
+            << "      ,size=<w>x<h> ,bitrate=<kbps> ,repair=<ratio>\n"
+            << "  " << program <<
+            " stream-encode --input <file> [--input <file> --weight <w> ...] --url <rtmp://...> [--bitrate <kbps>] [--width <w> --height <h>] [--encrypt --password <pwd>] [--feedback <socket>] [--min-repair <ratio>] [--max-repair <ratio>]\n"
+            << "      several inputs share the stream, each --weight applying to the preceding --input\n"
+            << "  " << program <<
+            " stream-decode --url <stream_url> (--output <file> | --output-dir <dir> [--files <n>]) [--password <pwd>] [--feedback <socket>]\n"
+            << "  " << program <<
+            " export-frames --input <file> --output <path|-> [--output <path> ...] [--format <y4m|raw>] [--pix-fmt <gray|yuv420p>] [--width <w> --height <h>] [--encrypt --password <pwd>] [--hash <crc32|xxhash>] [--patterns <cosine|quantized|step>] [--repair <ratio>]\n"
+            << "      every output (a file, a named pipe or - for stdout) receives every frame\n"
+            << "  " << program <<
+            " import-frames --input <path|-> --output <file> [--format <y4m|raw>] [--pix-fmt <gray|yuv420p> --width <w> --height <h>] [--password <pwd>]\n";
 }
 
 static int do_encode(const std::string &input_path, const std::string &output_path,
                      const bool encrypt, const std::string &password,
-                     const ms_hash_algorithm_t hash_algo) {
+                     const ms_hash_algorithm_t hash_algo, const uint64_t max_frames,
+                     const uint64_t max_size_mib, const bool raw_track, const bool audio_track,
+                     const ms_pattern_set_t pattern_set, const bool verify, const std::string &cache_dir,
+                     const bool cache_chunks, const int ffv1_slices, const std::string &catalog_path) {
     std::cout << "Input: " << input_path << "\n";
     std::cout << "Output: " << output_path << "\n";
 
@@ -89,10 +168,24 @@ static int do_encode(const std::string &input_path, const std::string &output_pa
     opts.hash_algorithm = hash_algo;
     opts.progress = encode_progress;
     opts.progress_user = nullptr;
+    opts.max_shard_frames = max_frames;
+    opts.max_shard_bytes = max_size_mib * 1024 * 1024;
+    opts.raw_packet_track = raw_track ? 1 : 0;
+    opts.audio_data_track = audio_track ? 1 : 0;
+    opts.pattern_set = pattern_set;
+    opts.verify = verify ? 1 : 0;
+    opts.cache_dir = cache_dir.empty() ? nullptr : cache_dir.c_str();
+    opts.cache_chunks = cache_chunks ? 1 : 0;
+    opts.ffv1_slices = ffv1_slices;
+    opts.catalog_path = catalog_path.empty() ? nullptr : catalog_path.c_str();
 
     ms_result_t result{};
     if (const ms_status_t status = ms_encode(&opts, &result); status != MS_OK) {
         std::cout << "\n";
+        if (verify && (status == MS_ERR_INCOMPLETE || status == MS_ERR_INTEGRITY)) {
+            std::cerr << "Verify: only " << result.verified_chunks << "/" << result.total_chunks
+                    << " chunks read back intact from " << output_path << "\n";
+        }
         std::cerr << "Error: " << ms_status_string(status) << "\n";
         return 1;
     }
@@ -102,23 +195,57 @@ static int do_encode(const std::string &input_path, const std::string &output_pa
     std::cout << "Chunks: " << result.total_chunks
             << "  Packets: " << result.total_packets
             << "  Frames: " << result.total_frames << "\n";
-    std::cout << "Written to: " << output_path << "\n";
+    print_file_digest(result);
+    if (result.cache_hit) {
+        std::cout << "Cache: reused an earlier encode of the same input\n";
+    } else if (result.cached_chunks > 0) {
+        std::cout << "Cache: reused " << result.cached_chunks << "/" << result.total_chunks << " chunks\n";
+    }
+    if (verify) {
+        std::cout << "Verified: " << result.verified_chunks << "/" << result.total_chunks
+                << " chunks read back intact\n";
+    }
+    if (result.total_shards > 0) {
+        char shard[4096];
+        std::cout << "Written to " << result.total_shards << " shards:\n";
+        for (uint32_t i = 0; i < result.total_shards; ++i) {
+            if (ms_shard_path(output_path.c_str(), i, shard, sizeof(shard)) == MS_OK) {
+                std::cout << "  " << shard << "\n";
+            }
+        }
+    } else {
+        std::cout << "Written to: " << output_path << "\n";
+    }
 
     return 0;
 }
 
-static int do_decode(const std::string &input_path, const std::string &output_path,
-                     const std::string &password) {
-    std::cout << "Input: " << input_path << "\n";
+static int do_decode(const std::vector<std::string> &input_paths, const std::string &output_path,
+                     const std::string &password, const bool follow, const int idle_timeout_sec,
+                     const std::size_t memory_budget_mib, const std::string &spill_dir,
+                     const bool pixels_only, const int decoder_threads, const bool adaptive_threads) {
+    std::vector<const char *> inputs;
+    for (const auto &input_path: input_paths) {
+        std::cout << "Input: " << input_path << "\n";
+        inputs.push_back(input_path.c_str());
+    }
     std::cout << "Output: " << output_path << "\n";
 
     ms_decode_options_t opts{};
-    opts.input_path = input_path.c_str();
+    opts.input_paths = inputs.data();
+    opts.input_count = inputs.size();
     opts.output_path = output_path.c_str();
     opts.password = password.c_str();
     opts.password_len = password.size();
     opts.progress = decode_progress;
     opts.progress_user = nullptr;
+    opts.follow = follow ? 1 : 0;
+    opts.follow_idle_timeout_sec = idle_timeout_sec;
+    opts.memory_budget = memory_budget_mib * 1024 * 1024;
+    opts.spill_dir = spill_dir.empty() ? nullptr : spill_dir.c_str();
+    opts.ignore_raw_packet_track = pixels_only ? 1 : 0;
+    opts.decoder_threads = decoder_threads;
+    opts.adaptive_threads = adaptive_threads ? 1 : 0;
 
     ms_result_t result{};
     if (const ms_status_t status = ms_decode(&opts, &result); status != MS_OK) {
@@ -132,15 +259,530 @@ static int do_decode(const std::string &input_path, const std::string &output_pa
     std::cout << "Chunks: " << result.total_chunks
             << "  Packets: " << result.total_packets
             << "  Frames: " << result.total_frames << "\n";
+    print_file_digest(result);
+    std::cout << "Written to: " << output_path << "\n";
+
+    return 0;
+}
+
+// The CLI runs one call per process, so only the disk tier carries chunks
+// over to the next run; the memory tier just fronts it.
+static bool configure_chunk_cache(const std::string &cache_dir, const std::size_t cache_size_mib) {
+    if (cache_dir.empty()) {
+        return true;
+    }
+    ms_chunk_cache_options_t opts{};
+    opts.memory_bytes = 64ull * 1024 * 1024;
+    opts.disk_dir = cache_dir.c_str();
+    opts.disk_bytes = cache_size_mib * 1024 * 1024;
+    if (const ms_status_t status = ms_chunk_cache_configure(&opts); status != MS_OK) {
+        std::cerr << "Error: chunk cache: " << ms_status_string(status) << "\n";
+        return false;
+    }
+    return true;
+}
+
+static void print_chunk_cache_stats() {
+    ms_chunk_cache_stats_t stats{};
+    if (ms_chunk_cache_stats(&stats) != MS_OK || stats.memory_hits + stats.disk_hits + stats.misses == 0) {
+        return;
+    }
+    std::cout << "Chunk cache: " << stats.memory_hits + stats.disk_hits << " hits, " << stats.misses
+            << " misses (" << static_cast<int>(stats.hit_rate * 100.0 + 0.5) << "%), "
+            << format_size(stats.disk_bytes) << " on disk\n";
+}
+
+static int do_read(const std::vector<std::string> &input_paths, const std::string &output_path,
+                   const std::string &password, const uint64_t offset, const uint64_t length,
+                   const bool pixels_only, const std::string &catalog_path) {
+    std::vector<const char *> inputs;
+    for (const auto &input_path: input_paths) {
+        inputs.push_back(input_path.c_str());
+    }
+
+    std::vector<std::byte> buffer(length);
+    ms_read_range_options_t opts{};
+    opts.input_paths = inputs.data();
+    opts.input_count = inputs.size();
+    opts.password = password.c_str();
+    opts.password_len = password.size();
+    opts.offset = offset;
+    opts.length = length;
+    opts.buffer = buffer.data();
+    opts.ignore_raw_packet_track = pixels_only ? 1 : 0;
+    opts.catalog_path = catalog_path.empty() ? nullptr : catalog_path.c_str();
+
+    uint64_t bytes_read = 0;
+    if (const ms_status_t status = ms_read_range(&opts, &bytes_read); status != MS_OK) {
+        std::cerr << "Error: " << ms_status_string(status) << "\n";
+        return 1;
+    }
+
+    std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(bytes_read));
+    if (!out) {
+        std::cerr << "Error: cannot write " << output_path << "\n";
+        return 1;
+    }
+    std::cout << "Read " << format_size(bytes_read) << " at offset " << offset << " into " << output_path << "\n";
+    print_chunk_cache_stats();
+    return 0;
+}
+
+// The catalog to record into and look up in: --catalog, or the default
+// location. Empty if there is none.
+static std::string catalog_location(const std::string &catalog_path) {
+    if (!catalog_path.empty()) {
+        return catalog_path;
+    }
+    char buffer[4096];
+    return ms_catalog_default_path(buffer, sizeof(buffer)) == MS_OK ? buffer : "";
+}
+
+static bool parse_file_id(const std::string &hex, uint8_t (&file_id)[16]) {
+    return from_hex(hex, std::as_writable_bytes(std::span(file_id)));
+}
+
+// The videos of the archive named by --id, or by --name: an exact file name
+// if one archive has it, otherwise a unique partial match.
+static std::optional<std::vector<std::string> > catalog_inputs(const std::string &catalog_path,
+                                                               const std::string &name, const std::string &id) {
+    const char *catalog = catalog_path.empty() ? nullptr : catalog_path.c_str();
+    ms_catalog_entry_t entry{};
+    if (!id.empty()) {
+        if (!parse_file_id(id, entry.file_id)) {
+            std::cerr << "Error: --id must be 32 hex digits\n";
+            return std::nullopt;
+        }
+        if (const ms_status_t status = ms_catalog_find(catalog, entry.file_id, &entry); status != MS_OK) {
+            std::cerr << "Error: catalog: " << ms_status_string(status) << "\n";
+            return std::nullopt;
+        }
+    } else {
+        size_t count = 0;
+        if (const ms_status_t status = ms_catalog_search(catalog, name.c_str(), nullptr, 0, &count);
+            status != MS_OK) {
+            std::cerr << "Error: catalog: " << ms_status_string(status) << "\n";
+            return std::nullopt;
+        }
+        std::vector<ms_catalog_entry_t> found(count);
+        if (count > 0 && ms_catalog_search(catalog, name.c_str(), found.data(), found.size(), &count) != MS_OK) {
+            return std::nullopt;
+        }
+        found.resize(std::min(found.size(), count));
+        std::vector<ms_catalog_entry_t> exact;
+        for (const ms_catalog_entry_t &candidate: found) {
+            if (name == candidate.name) {
+                exact.push_back(candidate);
+            }
+        }
+        const std::vector<ms_catalog_entry_t> &matches = exact.empty() ? found : exact;
+        if (matches.size() != 1) {
+            std::cerr << "Error: " << (matches.empty() ? "no" : "more than one") << " archive in the catalog matches '"
+                    << name << "'";
+            for (const ms_catalog_entry_t &match: matches) {
+                std::cerr << "\n  " << to_hex(std::as_bytes(std::span(match.file_id))) << "  " << match.name;
+            }
+            std::cerr << (matches.empty() ? "\n" : "\nPick one with --id\n");
+            return std::nullopt;
+        }
+        entry = matches.front();
+    }
+
+    std::vector<std::string> inputs;
+    for (uint32_t i = 0; i < entry.video_count; ++i) {
+        char path[4096];
+        if (ms_catalog_video_path(catalog, entry.file_id, i, path, sizeof(path)) == MS_OK) {
+            inputs.emplace_back(path);
+        }
+    }
+    if (inputs.empty()) {
+        std::cerr << "Error: the catalog lists no videos for " << entry.name << "\n";
+        return std::nullopt;
+    }
+    return inputs;
+}
+
+static int do_catalog(const std::string &subcommand, const std::string &catalog_path,
+                      const std::vector<std::string> &input_paths, const std::string &name, const std::string &id) {
+    const char *catalog = catalog_path.empty() ? nullptr : catalog_path.c_str();
+    if (subcommand == "list") {
+        size_t count = 0;
+        if (const ms_status_t status = ms_catalog_search(catalog, name.c_str(), nullptr, 0, &count); status != MS_OK) {
+            std::cerr << "Error: catalog: " << ms_status_string(status) << "\n";
+            return 1;
+        }
+        std::vector<ms_catalog_entry_t> entries(count);
+        if (count > 0 && ms_catalog_search(catalog, name.c_str(), entries.data(), entries.size(), &count) != MS_OK) {
+            std::cerr << "Error: catalog changed while listing it\n";
+            return 1;
+        }
+        for (std::size_t i = 0; i < std::min(entries.size(), count); ++i) {
+            const ms_catalog_entry_t &entry = entries[i];
+            std::cout << to_hex(std::as_bytes(std::span(entry.file_id))) << "  " << std::setw(10)
+                    << format_size(entry.file_size) << "  " << entry.video_count
+                    << (entry.video_count == 1 ? " video " : " videos") << "  " << entry.name;
+            if (entry.encrypted) {
+                std::cout << " (encrypted)";
+            }
+            if (!entry.has_frame_index) {
+                std::cout << " (no frame index)";
+            }
+            std::cout << "\n";
+        }
+        return 0;
+    }
+    if (subcommand == "add") {
+        int failures = 0;
+        for (const auto &input_path: input_paths) {
+            ms_info_t info{};
+            if (const ms_status_t status = ms_catalog_add(catalog, input_path.c_str(), &info); status != MS_OK) {
+                std::cerr << "Error: " << input_path << ": " << ms_status_string(status) << "\n";
+                ++failures;
+                continue;
+            }
+            std::cout << "Added " << input_path << " (" << to_hex(std::as_bytes(std::span(info.file_id))) << ")\n";
+        }
+        return failures > 0 ? 1 : 0;
+    }
+    if (subcommand == "remove") {
+        uint8_t file_id[16];
+        if (!parse_file_id(id, file_id)) {
+            std::cerr << "Error: --id must be 32 hex digits\n";
+            return 1;
+        }
+        if (const ms_status_t status = ms_catalog_remove(catalog, file_id); status != MS_OK) {
+            std::cerr << "Error: catalog: " << ms_status_string(status) << "\n";
+            return 1;
+        }
+        std::cout << "Removed " << id << "\n";
+        return 0;
+    }
+    size_t removed = 0;
+    if (const ms_status_t status = ms_catalog_prune(catalog, &removed); status != MS_OK) {
+        std::cerr << "Error: catalog: " << ms_status_string(status) << "\n";
+        return 1;
+    }
+    std::cout << "Pruned " << removed << (removed == 1 ? " archive" : " archives") << " whose videos are gone\n";
+    return 0;
+}
+
+static int do_serve(const std::string &socket_path, const int jobs, const std::size_t queue) {
+    JobServerOptions options;
+    options.socket_path = socket_path;
+    options.workers = jobs > 0 ? jobs : 2;
+    options.queue_capacity = queue > 0 ? queue : 16;
+
+    std::cout << "Serving on " << socket_path << " (" << options.workers << " workers, queue of "
+            << options.queue_capacity << ")\n";
+    try {
+        JobServer server(options);
+        server.run();
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    std::cout << "Server stopped\n";
+    return 0;
+}
+
+static std::filesystem::path host_profile_path(const std::string &profile_path) {
+    return profile_path.empty() ? default_host_profile_path() : std::filesystem::path(profile_path);
+}
+
+// The profile saved by `tune`, if any. A broken profile only costs speed, so
+// it is reported and skipped rather than failing the run.
+static std::optional<HostProfile> load_profile(const std::string &profile_path, const bool no_profile) {
+    if (no_profile) {
+        return std::nullopt;
+    }
+    const std::filesystem::path path = host_profile_path(profile_path);
+    if (path.empty()) {
+        return std::nullopt;
+    }
+    try {
+        auto profile = load_host_profile(path);
+        if (profile) {
+            std::cout << "Host profile: " << path.string() << " (threads " << profile->threads << ", slices "
+                    << profile->ffv1_slices << ", " << profile->patterns << ", " << profile->hash << ")\n";
+            ms_set_thread_count(profile->threads);
+        }
+        return profile;
+    } catch (const std::exception &e) {
+        std::cerr << "Warning: ignoring host profile: " << e.what() << "\n";
+        return std::nullopt;
+    }
+}
+
+static ms_pattern_set_t profile_pattern_set(const HostProfile &profile) {
+    if (profile.patterns == "step") {
+        return MS_PATTERN_STEP;
+    }
+    return profile.patterns == "quantized" ? MS_PATTERN_QUANTIZED_COSINE : MS_PATTERN_COSINE;
+}
+
+static int do_tune(const std::string &target, const std::size_t sample_mib, const std::string &profile_path) {
+    const std::filesystem::path path = host_profile_path(profile_path);
+    if (path.empty()) {
+        std::cerr << "Error: no default profile location (set HOME or pass --profile)\n";
+        return 1;
+    }
+
+    TuneOptions options;
+    options.target = target;
+    options.sample_mib = sample_mib;
+    options.work_dir = std::filesystem::temp_directory_path() / "media_storage_tune";
+
+    std::cout << "Tuning for " << target << " archives with a " << sample_mib << " MiB sample...\n";
+    HostProfile profile;
+    try {
+        profile = run_tune(options, std::cout);
+        save_host_profile(path, profile);
+    } catch (const std::exception &e) {
+        std::error_code ec;
+        std::filesystem::remove_all(options.work_dir, ec);
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(options.work_dir, ec);
+
+    std::cout << std::fixed << std::setprecision(1) << "\nBest: threads " << profile.threads << ", slices "
+            << profile.ffv1_slices << ", " << profile.patterns << ", " << profile.hash << " (encode "
+            << profile.encode_mib_s << " MiB/s, decode " << profile.decode_mib_s << " MiB/s)\n";
+    std::cout << "Saved to " << path.string() << "\n";
+    return 0;
+}
+
+static int do_verify(const std::string &input_path, const int threads) {
+    std::cout << "Input: " << input_path << "\n";
+
+    ms_verify_options_t opts{};
+    opts.input_path = input_path.c_str();
+    opts.threads = threads;
+    opts.progress = verify_progress;
+    opts.progress_user = nullptr;
+
+    ms_verify_result_t result{};
+    const ms_status_t status = ms_verify(&opts, &result);
+    std::cout << "\n";
+    if (status != MS_OK && status != MS_ERR_INCOMPLETE && status != MS_ERR_INTEGRITY) {
+        std::cerr << "Error: " << ms_status_string(status) << "\n";
+        return 1;
+    }
+
+    std::cout << "\nChunks: " << result.recoverable_chunks << "/" << result.total_chunks << " recoverable";
+    if (result.has_manifest) {
+        std::cout << ", " << result.verified_chunks << " match the manifest";
+        if (result.hash_mismatches > 0) {
+            std::cout << ", " << result.hash_mismatches << " MISMATCHED";
+        }
+        if (result.file_digest_verified) {
+            std::cout << ", whole-file digest verified";
+        }
+    } else {
+        std::cout << " (no manifest, hashes not checked)";
+    }
+    std::cout << "\nPackets: " << result.total_packets << "  Frames: " << result.total_frames << "\n";
+
+    if (result.recoverable_chunks > 0) {
+        static constexpr const char *bucket_labels[MS_VERIFY_MARGIN_BUCKETS] = {
+            "< 0.05k", "< 0.1k", "< 0.25k", "< 0.5k", "< 1k", "< 2k", "< 4k", ">= 4k",
+        };
+        std::cout << "Spare symbols: min " << result.min_spare_symbols << " (chunk " << result.min_spare_chunk
+                << "), mean " << std::fixed << std::setprecision(2) << result.mean_spare_ratio << "k\n";
+        for (int i = 0; i < MS_VERIFY_MARGIN_BUCKETS; ++i) {
+            if (result.margin_histogram[i] > 0) {
+                std::cout << "  " << std::setw(8) << bucket_labels[i] << "  " << result.margin_histogram[i] << "\n";
+            }
+        }
+    }
+
+    if (status != MS_OK) {
+        std::cerr << "Error: " << ms_status_string(status) << "\n";
+        return 1;
+    }
+    std::cout << "Archive OK\n";
+    return 0;
+}
+
+static int do_info(const std::string &input_path, const std::string &catalog_path) {
+    ms_info_t info{};
+    if (const ms_status_t status = ms_probe(input_path.c_str(), &info); status != MS_OK) {
+        std::cerr << "Error: " << ms_status_string(status) << "\n";
+        return 1;
+    }
+    if (!catalog_path.empty() && info.has_manifest) {
+        if (const ms_status_t status = ms_catalog_add(catalog_path.c_str(), input_path.c_str(), nullptr);
+            status != MS_OK) {
+            std::cerr << "Warning: not recorded in the catalog: " << ms_status_string(status) << "\n";
+        }
+    }
+
+    std::cout << "File ID:     " << to_hex(std::as_bytes(std::span(info.file_id))) << "\n";
+    if (info.has_manifest) {
+        std::cout << "Size:        " << format_size(info.file_size) << " (" << info.file_size << " bytes)\n";
+        std::cout << "Chunks:      " << info.chunk_count << " x " << format_size(info.chunk_size) << "\n";
+        if (info.shard_count > 0) {
+            std::cout << "Shard:       " << info.shard_index + 1 << " of " << info.shard_count << ", chunks "
+                    << info.shard_first_chunk << ".." << info.shard_first_chunk + info.shard_chunk_count - 1 << "\n";
+        }
+    } else {
+        std::cout << "Size:        unknown (archive has no manifest)\n";
+    }
+    std::cout << "Encrypted:   " << (info.encrypted ? "yes" : "no") << "\n";
+    std::cout << "Checksum:    " << (info.hash_algorithm == MS_HASH_XXHASH32 ? "xxhash" : "crc32") << "\n";
+    std::cout << "Symbol size: " << info.symbol_size << "\n";
+    std::cout << "Video:       " << info.frame_width << "x" << info.frame_height;
+    if (info.total_frames >= 0) {
+        std::cout << ", " << info.total_frames << " frames";
+    }
+    if (info.has_raw_packet_track) {
+        std::cout << ", raw packet track";
+    }
+    if (info.has_audio_data_track) {
+        std::cout << ", audio data track";
+    }
+    std::cout << "\n";
+    return 0;
+}
+
+static int do_refresh(const std::string &input_path, const std::string &output_path) {
+    std::cout << "Input: " << input_path << "\n";
+    std::cout << "Output: " << output_path << "\n";
+
+    ms_refresh_options_t opts{};
+    opts.input_path = input_path.c_str();
+    opts.output_path = output_path.c_str();
+    opts.progress = refresh_progress;
+    opts.progress_user = nullptr;
+
+    ms_result_t result{};
+    if (const ms_status_t status = ms_refresh(&opts, &result); status != MS_OK) {
+        std::cout << "\n";
+        std::cerr << "Error: " << ms_status_string(status) << "\n";
+        return 1;
+    }
+
+    std::cout << "\n\nRefresh complete: " << format_size(result.input_size) << " -> "
+            << format_size(result.output_size) << "\n";
+    std::cout << "Chunks: " << result.total_chunks
+            << "  Packets: " << result.total_packets
+            << "  Frames: " << result.total_frames << "\n";
+    print_file_digest(result);
     std::cout << "Written to: " << output_path << "\n";
 
     return 0;
 }
 
+struct SinkSpec {
+    ms_sink_kind_t kind = MS_SINK_FILE;
+    std::string target;
+    int width = 0;
+    int height = 0;
+    int bitrate_kbps = 0;
+    double repair_overhead = 0.0;
+};
+
+// Parses "file=<path>" or "stream=<url>" followed by optional ",key=value"
+// settings (size=<w>x<h>, bitrate=<kbps>, repair=<ratio>).
+static std::optional<SinkSpec> parse_sink(const std::string &text) {
+    SinkSpec spec;
+    std::stringstream fields(text);
+    std::string field;
+    bool first = true;
+    try {
+        while (std::getline(fields, field, ',')) {
+            const auto eq = field.find('=');
+            if (eq == std::string::npos) {
+                return std::nullopt;
+            }
+            const std::string key = field.substr(0, eq);
+            const std::string value = field.substr(eq + 1);
+            if (first) {
+                if (key != "file" && key != "stream") {
+                    return std::nullopt;
+                }
+                spec.kind = key == "file" ? MS_SINK_FILE : MS_SINK_STREAM;
+                spec.target = value;
+                first = false;
+            } else if (key == "size") {
+                const auto x = value.find('x');
+                if (x == std::string::npos) {
+                    return std::nullopt;
+                }
+                spec.width = std::stoi(value.substr(0, x));
+                spec.height = std::stoi(value.substr(x + 1));
+            } else if (key == "bitrate") {
+                spec.bitrate_kbps = std::stoi(value);
+            } else if (key == "repair") {
+                spec.repair_overhead = std::stod(value);
+            } else {
+                return std::nullopt;
+            }
+        }
+    } catch (const std::exception &) {
+        return std::nullopt;
+    }
+    if (first || spec.target.empty()) {
+        return std::nullopt;
+    }
+    return spec;
+}
+
+static int do_fanout(const std::string &input_path, const std::vector<SinkSpec> &specs,
+                     const bool encrypt, const std::string &password,
+                     const ms_hash_algorithm_t hash_algo) {
+    std::cout << "Input: " << input_path << "\n";
+
+    std::vector<ms_sink_t> sinks(specs.size());
+    for (std::size_t i = 0; i < specs.size(); ++i) {
+        sinks[i].kind = specs[i].kind;
+        sinks[i].target = specs[i].target.c_str();
+        sinks[i].width = specs[i].width;
+        sinks[i].height = specs[i].height;
+        sinks[i].bitrate_kbps = specs[i].bitrate_kbps;
+        sinks[i].repair_overhead = specs[i].repair_overhead;
+        std::cout << (specs[i].kind == MS_SINK_FILE ? "Output: " : "Stream URL: ") << specs[i].target << "\n";
+    }
+
+    ms_encode_multi_options_t opts{};
+    opts.input_path = input_path.c_str();
+    opts.sinks = sinks.data();
+    opts.sink_count = sinks.size();
+    opts.encrypt = encrypt ? 1 : 0;
+    opts.password = password.c_str();
+    opts.password_len = password.size();
+    opts.hash_algorithm = hash_algo;
+    opts.progress = encode_progress;
+    opts.progress_user = nullptr;
+
+    std::vector<ms_result_t> results(sinks.size());
+    if (const ms_status_t status = ms_encode_multi(&opts, results.data()); status != MS_OK) {
+        std::cout << "\n";
+        std::cerr << "Error: " << ms_status_string(status) << "\n";
+        return 1;
+    }
+
+    std::cout << "\n\nEncode complete: " << format_size(results[0].input_size)
+            << "  Chunks: " << results[0].total_chunks << "\n";
+    for (std::size_t i = 0; i < specs.size(); ++i) {
+        std::cout << specs[i].target << ": Packets: " << results[i].total_packets
+                << "  Frames: " << results[i].total_frames;
+        if (specs[i].kind == MS_SINK_FILE) {
+            std::cout << "  Size: " << format_size(results[i].output_size);
+        }
+        std::cout << "\n";
+    }
+
+    return 0;
+}
+
 static int do_stream_encode(const std::string &input_path, const std::string &stream_url,
                             const bool encrypt, const std::string &password,
                             const ms_hash_algorithm_t hash_algo, const int bitrate_kbps,
-                            const int width, const int height) {
+                            const int width, const int height, const std::string &feedback_socket,
+                            const double min_repair, const double max_repair) {
     std::cout << "Input: " << input_path << "\n";
     std::cout << "Stream URL: " << stream_url << "\n";
     std::cout << "Resolution: " << width << "x" << height << "\n";
@@ -158,6 +800,12 @@ static int do_stream_encode(const std::string &input_path, const std::string &st
     opts.height = height;
     opts.progress = stream_encode_progress;
     opts.progress_user = nullptr;
+    opts.feedback_socket = feedback_socket.empty() ? nullptr : feedback_socket.c_str();
+    opts.min_repair_overhead = min_repair;
+    opts.max_repair_overhead = max_repair;
+    if (!feedback_socket.empty()) {
+        std::cout << "Repair feedback: " << feedback_socket << "\n";
+    }
 
     ms_result_t result{};
     if (const ms_status_t status = ms_stream_encode(&opts, &result); status != MS_OK) {
@@ -170,12 +818,17 @@ static int do_stream_encode(const std::string &input_path, const std::string &st
     std::cout << "Chunks: " << result.total_chunks
             << "  Packets: " << result.total_packets
             << "  Frames: " << result.total_frames << "\n";
+    if (!feedback_socket.empty()) {
+        std::cout << "Final repair ratio: " << result.repair_overhead
+                << "  Re-sent packets: " << result.resent_packets << "\n";
+    }
+    print_file_digest(result);
 
     return 0;
 }
 
 static int do_stream_decode(const std::string &stream_url, const std::string &output_path,
-                            const std::string &password) {
+                            const std::string &password, const std::string &feedback_socket) {
     std::cout << "Stream URL: " << stream_url << "\n";
     std::cout << "Output: " << output_path << "\n";
     std::cout << "Waiting for stream...\n";
@@ -188,6 +841,7 @@ static int do_stream_decode(const std::string &stream_url, const std::string &ou
     opts.timeout_sec = 30;
     opts.progress = stream_decode_progress;
     opts.progress_user = nullptr;
+    opts.feedback_socket = feedback_socket.empty() ? nullptr : feedback_socket.c_str();
 
     ms_result_t result{};
     if (const ms_status_t status = ms_stream_decode(&opts, &result); status != MS_OK) {
@@ -200,11 +854,180 @@ static int do_stream_decode(const std::string &stream_url, const std::string &ou
     std::cout << "Chunks: " << result.total_chunks
             << "  Packets: " << result.total_packets
             << "  Frames: " << result.total_frames << "\n";
+    print_file_digest(result);
     std::cout << "Written to: " << output_path << "\n";
 
     return 0;
 }
 
+static int do_export_frames(const std::string &input_path, const std::vector<std::string> &output_paths,
+                            const ms_frame_format_t format, const ms_pixel_format_t pixel_format,
+                            const int width, const int height, const bool encrypt, const std::string &password,
+                            const ms_hash_algorithm_t hash_algo, const ms_pattern_set_t pattern_set,
+                            const double repair_overhead) {
+    std::cerr << "Input: " << input_path << "\n";
+    for (const std::string &output: output_paths) {
+        std::cerr << "Output: " << (output == "-" ? "stdout" : output) << "\n";
+    }
+    std::cerr << "Resolution: " << width << "x" << height << "\n";
+
+    std::vector<const char *> outputs;
+    for (const std::string &output: output_paths) {
+        outputs.push_back(output.c_str());
+    }
+
+    ms_export_frames_options_t opts{};
+    opts.input_path = input_path.c_str();
+    opts.outputs = outputs.data();
+    opts.output_count = outputs.size();
+    opts.format = format;
+    opts.pixel_format = pixel_format;
+    opts.width = width;
+    opts.height = height;
+    opts.encrypt = encrypt ? 1 : 0;
+    opts.password = password.c_str();
+    opts.password_len = password.size();
+    opts.hash_algorithm = hash_algo;
+    opts.pattern_set = pattern_set;
+    opts.repair_overhead = repair_overhead;
+    opts.progress = export_progress;
+    opts.progress_user = nullptr;
+
+    ms_result_t result{};
+    if (const ms_status_t status = ms_export_frames(&opts, &result); status != MS_OK) {
+        std::cerr << "\nError: " << ms_status_string(status) << "\n";
+        return 1;
+    }
+
+    std::cerr << "\n\nExport complete: " << format_size(result.input_size) << "\n";
+    std::cerr << "Chunks: " << result.total_chunks
+            << "  Packets: " << result.total_packets
+            << "  Frames: " << result.total_frames << "\n";
+    if (result.has_file_digest) {
+        std::cerr << "File digest: " << to_hex(std::as_bytes(std::span(result.file_digest))) << "\n";
+    }
+
+    return 0;
+}
+
+static int do_import_frames(const std::string &input_path, const std::string &output_path,
+                            const ms_frame_format_t format, const ms_pixel_format_t pixel_format,
+                            const int width, const int height, const std::string &password) {
+    std::cerr << "Input: " << (input_path == "-" ? "stdin" : input_path) << "\n";
+    std::cerr << "Output: " << output_path << "\n";
+
+    ms_import_frames_options_t opts{};
+    opts.input_path = input_path.c_str();
+    opts.output_path = output_path.c_str();
+    opts.format = format;
+    opts.pixel_format = pixel_format;
+    opts.width = width;
+    opts.height = height;
+    opts.password = password.c_str();
+    opts.password_len = password.size();
+    opts.progress = import_progress;
+    opts.progress_user = nullptr;
+
+    ms_result_t result{};
+    if (const ms_status_t status = ms_import_frames(&opts, &result); status != MS_OK) {
+        std::cerr << "\nError: " << ms_status_string(status) << "\n";
+        return 1;
+    }
+
+    std::cout << "\n\nImport complete: -> " << format_size(result.output_size) << "\n";
+    std::cout << "Chunks: " << result.total_chunks
+            << "  Packets: " << result.total_packets
+            << "  Frames: " << result.total_frames << "\n";
+    print_file_digest(result);
+    std::cout << "Written to: " << output_path << "\n";
+
+    return 0;
+}
+
+static int do_stream_encode_mux(const std::vector<std::string> &input_paths, const std::vector<double> &weights,
+                                const std::string &stream_url, const bool encrypt, const std::string &password,
+                                const ms_hash_algorithm_t hash_algo, const int bitrate_kbps,
+                                const int width, const int height) {
+    std::vector<ms_stream_job_t> jobs(input_paths.size());
+    for (std::size_t i = 0; i < input_paths.size(); ++i) {
+        jobs[i].input_path = input_paths[i].c_str();
+        jobs[i].encrypt = encrypt ? 1 : 0;
+        jobs[i].password = password.c_str();
+        jobs[i].password_len = password.size();
+        jobs[i].weight = weights[i];
+        std::cout << "Input: " << input_paths[i] << " (weight " << weights[i] << ")\n";
+    }
+    std::cout << "Stream URL: " << stream_url << "\n";
+    std::cout << "Resolution: " << width << "x" << height << "\n";
+    std::cout << "Bitrate: " << bitrate_kbps << " kbps\n";
+
+    ms_stream_mux_options_t opts{};
+    opts.jobs = jobs.data();
+    opts.job_count = jobs.size();
+    opts.stream_url = stream_url.c_str();
+    opts.hash_algorithm = hash_algo;
+    opts.bitrate_kbps = bitrate_kbps;
+    opts.width = width;
+    opts.height = height;
+    opts.progress = stream_encode_progress;
+    opts.progress_user = nullptr;
+
+    std::vector<ms_result_t> results(jobs.size());
+    if (const ms_status_t status = ms_stream_encode_mux(&opts, results.data()); status != MS_OK) {
+        std::cout << "\n";
+        std::cerr << "Error: " << ms_status_string(status) << "\n";
+        return 1;
+    }
+
+    std::cout << "\n\nStream encode complete: " << results[0].total_frames << " frames\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        std::cout << "  " << input_paths[i] << ": " << format_size(results[i].input_size)
+                << "  Chunks: " << results[i].total_chunks
+                << "  Packets: " << results[i].total_packets
+                << "  Id: " << to_hex(std::as_bytes(std::span(results[i].file_id))) << "\n";
+    }
+
+    return 0;
+}
+
+static int do_stream_decode_demux(const std::string &stream_url, const std::string &output_dir,
+                                  const std::size_t expected_files, const std::string &password) {
+    std::cout << "Stream URL: " << stream_url << "\n";
+    std::cout << "Output directory: " << output_dir << "\n";
+    std::cout << "Waiting for stream...\n";
+
+    ms_stream_demux_options_t opts{};
+    opts.stream_url = stream_url.c_str();
+    opts.output_dir = output_dir.c_str();
+    opts.password = password.c_str();
+    opts.password_len = password.size();
+    opts.timeout_sec = 30;
+    opts.expected_files = expected_files;
+    opts.progress = stream_decode_progress;
+    opts.progress_user = nullptr;
+
+    std::vector<ms_stream_demux_file_t> files(64);
+    std::size_t file_count = 0;
+    const ms_status_t status = ms_stream_decode_demux(&opts, files.data(), files.size(), &file_count);
+    std::cout << "\n\n";
+    for (std::size_t i = 0; i < std::min(file_count, files.size()); ++i) {
+        const ms_stream_demux_file_t &file = files[i];
+        std::cout << "  " << to_hex(std::as_bytes(std::span(file.result.file_id))) << ": ";
+        if (file.status == MS_OK) {
+            std::cout << format_size(file.result.output_size) << "  Chunks: " << file.result.total_chunks << "\n";
+        } else {
+            std::cout << ms_status_string(file.status) << "\n";
+        }
+    }
+    if (status != MS_OK) {
+        std::cerr << "Error: " << ms_status_string(status) << "\n";
+        return 1;
+    }
+
+    std::cout << "Stream decode complete: " << file_count << " files written to " << output_dir << "\n";
+    return 0;
+}
+
 int main(const int argc, char *argv[]) {
     if (argc < 2) {
         print_usage(argv[0]);
@@ -213,15 +1036,19 @@ int main(const int argc, char *argv[]) {
 
     const std::string command = argv[1];
 
-    if (command != "encode" && command != "decode" &&
-        command != "stream-encode" && command != "stream-decode") {
+    if (command != "encode" && command != "decode" && command != "read" && command != "verify" && command != "info" &&
+        command != "serve" && command != "tune" && command != "refresh" && command != "fanout" && command != "stream-encode" &&
+        command != "stream-decode" && command != "catalog" && command != "export-frames" &&
+        command != "import-frames") {
         std::cerr << "Error: unknown command '" << command << "'\n";
         print_usage(argv[0]);
         return 1;
     }
 
     std::string input_path;
+    std::vector<std::string> input_paths;
     std::string output_path;
+    std::vector<std::string> output_paths;
     std::string stream_url;
     bool encrypt = false;
     std::string password;
@@ -229,25 +1056,206 @@ int main(const int argc, char *argv[]) {
     int bitrate_kbps = 35000;
     int stream_width = 1920;
     int stream_height = 1080;
+    bool size_given = false;
+    bool follow = false;
+    int idle_timeout_sec = 0;
+    std::size_t memory_budget_mib = 0;
+    std::string spill_dir;
+    int threads = 0;
+    std::vector<SinkSpec> sinks;
+    uint64_t max_frames = 0;
+    uint64_t max_size_mib = 0;
+    bool raw_track = false;
+    bool audio_track = false;
+    auto pattern_set = MS_PATTERN_COSINE;
+    bool pixels_only = false;
+    int decoder_threads = 0;
+    bool adaptive_threads = false;
+    bool verify = false;
+    std::string cache_dir;
+    bool cache_chunks = false;
+    std::string chunk_cache_dir;
+    std::size_t chunk_cache_mib = 1024;
+    std::optional<uint64_t> range_offset;
+    std::optional<uint64_t> range_length;
+    std::string socket_path;
+    int jobs = 0;
+    std::size_t queue = 0;
+    std::optional<std::string> target;
+    std::size_t sample_mib = 8;
+    std::string profile_path;
+    bool no_profile = false;
+    bool hash_given = false;
+    bool patterns_given = false;
+    std::string catalog_path;
+    bool no_catalog = false;
+    std::string archive_name;
+    std::string archive_id;
+    std::vector<double> weights;
+    std::string output_dir;
+    std::size_t expected_files = 0;
+    std::string feedback_socket;
+    double min_repair = 0.0;
+    double max_repair = 0.0;
+    double repair_overhead = 0.0;
+    auto frame_format = MS_FRAME_FORMAT_Y4M;
+    auto pixel_format = MS_PIXEL_FORMAT_GRAY8;
+
+    int first_option = 2;
+    std::string subcommand;
+    if (command == "catalog") {
+        subcommand = argc > 2 ? argv[2] : "";
+        if (subcommand != "list" && subcommand != "add" && subcommand != "remove" && subcommand != "prune") {
+            std::cerr << "Error: catalog needs list, add, remove or prune\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+        first_option = 3;
+    }
 
-    for (int i = 2; i < argc; ++i) {
+    for (int i = first_option; i < argc; ++i) {
         if (const std::string arg = argv[i]; (arg == "--input" || arg == "-i") && i + 1 < argc) {
             input_path = argv[++i];
+            input_paths.push_back(input_path);
+            weights.push_back(1.0);
         } else if ((arg == "--output" || arg == "-o") && i + 1 < argc) {
             output_path = argv[++i];
+            output_paths.push_back(output_path);
         } else if ((arg == "--url" || arg == "-u") && i + 1 < argc) {
             stream_url = argv[++i];
         } else if ((arg == "--bitrate" || arg == "-b") && i + 1 < argc) {
             bitrate_kbps = std::stoi(argv[++i]);
         } else if (arg == "--width" && i + 1 < argc) {
             stream_width = std::stoi(argv[++i]);
+            size_given = true;
         } else if (arg == "--height" && i + 1 < argc) {
             stream_height = std::stoi(argv[++i]);
+            size_given = true;
         } else if ((arg == "--encrypt" || arg == "-e")) {
             encrypt = true;
         } else if ((arg == "--password" || arg == "-p") && i + 1 < argc) {
             password = argv[++i];
+        } else if (arg == "--follow" || arg == "-f") {
+            follow = true;
+        } else if (arg == "--idle-timeout" && i + 1 < argc) {
+            idle_timeout_sec = std::stoi(argv[++i]);
+        } else if (arg == "--memory-budget" && i + 1 < argc) {
+            memory_budget_mib = std::stoull(argv[++i]);
+        } else if (arg == "--spill-dir" && i + 1 < argc) {
+            spill_dir = argv[++i];
+        } else if (arg == "--max-frames" && i + 1 < argc) {
+            max_frames = std::stoull(argv[++i]);
+        } else if (arg == "--max-size" && i + 1 < argc) {
+            max_size_mib = std::stoull(argv[++i]);
+        } else if (arg == "--raw-track") {
+            raw_track = true;
+        } else if (arg == "--audio-track") {
+            audio_track = true;
+        } else if (arg == "--patterns" && i + 1 < argc) {
+            patterns_given = true;
+            if (const std::string set = argv[++i]; set == "cosine") {
+                pattern_set = MS_PATTERN_COSINE;
+            } else if (set == "quantized") {
+                pattern_set = MS_PATTERN_QUANTIZED_COSINE;
+            } else if (set == "step") {
+                pattern_set = MS_PATTERN_STEP;
+            } else {
+                std::cerr << "Error: unknown pattern set '" << set << "' (use cosine, quantized or step)\n";
+                return 1;
+            }
+        } else if (arg == "--pixels") {
+            pixels_only = true;
+        } else if (arg == "--decoder-threads" && i + 1 < argc) {
+            decoder_threads = std::stoi(argv[++i]);
+        } else if (arg == "--adaptive-threads") {
+            adaptive_threads = true;
+        } else if (arg == "--verify") {
+            verify = true;
+        } else if (arg == "--cache-dir" && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (arg == "--cache-chunks") {
+            cache_chunks = true;
+        } else if (arg == "--chunk-cache" && i + 1 < argc) {
+            chunk_cache_dir = argv[++i];
+        } else if (arg == "--chunk-cache-size" && i + 1 < argc) {
+            chunk_cache_mib = std::stoull(argv[++i]);
+        } else if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            jobs = std::stoi(argv[++i]);
+        } else if (arg == "--queue" && i + 1 < argc) {
+            queue = std::stoull(argv[++i]);
+        } else if (arg == "--target" && i + 1 < argc) {
+            target = argv[++i];
+            if (target != "local" && target != "platform") {
+                std::cerr << "Error: unknown target '" << *target << "' (use local or platform)\n";
+                return 1;
+            }
+        } else if (arg == "--sample-size" && i + 1 < argc) {
+            sample_mib = std::stoull(argv[++i]);
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (arg == "--no-profile") {
+            no_profile = true;
+        } else if (arg == "--catalog" && i + 1 < argc) {
+            catalog_path = argv[++i];
+        } else if (arg == "--no-catalog") {
+            no_catalog = true;
+        } else if (arg == "--name" && i + 1 < argc) {
+            archive_name = argv[++i];
+        } else if (arg == "--id" && i + 1 < argc) {
+            archive_id = argv[++i];
+        } else if (arg == "--weight" && i + 1 < argc) {
+            if (weights.empty()) {
+                std::cerr << "Error: --weight must follow an --input\n";
+                return 1;
+            }
+            weights.back() = std::stod(argv[++i]);
+        } else if (arg == "--feedback" && i + 1 < argc) {
+            feedback_socket = argv[++i];
+        } else if (arg == "--min-repair" && i + 1 < argc) {
+            min_repair = std::stod(argv[++i]);
+        } else if (arg == "--max-repair" && i + 1 < argc) {
+            max_repair = std::stod(argv[++i]);
+        } else if (arg == "--repair" && i + 1 < argc) {
+            repair_overhead = std::stod(argv[++i]);
+        } else if (arg == "--format" && i + 1 < argc) {
+            if (const std::string format = argv[++i]; format == "y4m") {
+                frame_format = MS_FRAME_FORMAT_Y4M;
+            } else if (format == "raw") {
+                frame_format = MS_FRAME_FORMAT_RAW;
+            } else {
+                std::cerr << "Error: unknown frame format '" << format << "' (use y4m or raw)\n";
+                return 1;
+            }
+        } else if (arg == "--pix-fmt" && i + 1 < argc) {
+            if (const std::string format = argv[++i]; format == "gray") {
+                pixel_format = MS_PIXEL_FORMAT_GRAY8;
+            } else if (format == "yuv420p") {
+                pixel_format = MS_PIXEL_FORMAT_YUV420P;
+            } else {
+                std::cerr << "Error: unknown pixel format '" << format << "' (use gray or yuv420p)\n";
+                return 1;
+            }
+        } else if (arg == "--output-dir" && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if (arg == "--files" && i + 1 < argc) {
+            expected_files = std::stoull(argv[++i]);
+        } else if (arg == "--offset" && i + 1 < argc) {
+            range_offset = std::stoull(argv[++i]);
+        } else if (arg == "--length" && i + 1 < argc) {
+            range_length = std::stoull(argv[++i]);
+        } else if (arg == "--sink" && i + 1 < argc) {
+            auto spec = parse_sink(argv[++i]);
+            if (!spec) {
+                std::cerr << "Error: invalid sink '" << argv[i] << "'\n";
+                return 1;
+            }
+            sinks.push_back(std::move(*spec));
+        } else if ((arg == "--threads" || arg == "-j") && i + 1 < argc) {
+            threads = std::stoi(argv[++i]);
         } else if ((arg == "--hash" || arg == "-H") && i + 1 < argc) {
+            hash_given = true;
             if (const std::string algo_str = argv[++i]; algo_str == "xxhash") {
                 hash_algo = MS_HASH_XXHASH32;
             } else if (algo_str == "crc32") {
@@ -263,6 +1271,17 @@ int main(const int argc, char *argv[]) {
         }
     }
 
+    const std::string catalog = no_catalog ? "" : catalog_location(catalog_path);
+    if ((command == "decode" || command == "read") && input_paths.empty() &&
+        (!archive_name.empty() || !archive_id.empty())) {
+        auto inputs = catalog_inputs(catalog_location(catalog_path), archive_name, archive_id);
+        if (!inputs) {
+            return 1;
+        }
+        input_paths = std::move(*inputs);
+        input_path = input_paths.front();
+    }
+
     if (command == "encode") {
         if (input_path.empty() || output_path.empty()) {
             std::cerr << "Error: both --input and --output must be specified\n";
@@ -273,14 +1292,106 @@ int main(const int argc, char *argv[]) {
             std::cerr << "Error: --encrypt requires --password\n";
             return 1;
         }
-        return do_encode(input_path, output_path, encrypt, password, hash_algo);
+        if (cache_chunks && cache_dir.empty()) {
+            std::cerr << "Error: --cache-chunks requires --cache-dir\n";
+            return 1;
+        }
+        int ffv1_slices = 0;
+        if (const auto profile = load_profile(profile_path, no_profile)) {
+            ffv1_slices = profile->ffv1_slices;
+            if (!hash_given) {
+                hash_algo = profile->hash == "xxhash" ? MS_HASH_XXHASH32 : MS_HASH_CRC32;
+            }
+            // Patterns tuned for local storage may not survive a platform's
+            // re-encoding, so they only apply to encodes for the same target.
+            // Encodes default to the platform-safe target.
+            if (!patterns_given && profile->target == target.value_or("platform")) {
+                pattern_set = profile_pattern_set(*profile);
+            }
+        }
+        return do_encode(input_path, output_path, encrypt, password, hash_algo, max_frames, max_size_mib, raw_track,
+                         audio_track, pattern_set, verify, cache_dir, cache_chunks, ffv1_slices, catalog);
     } else if (command == "decode") {
+        if (input_path.empty() || output_path.empty()) {
+            std::cerr << "Error: --input (or --name or --id) and --output must be specified\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (!configure_chunk_cache(chunk_cache_dir, chunk_cache_mib)) {
+            return 1;
+        }
+        (void) load_profile(profile_path, no_profile);
+        return do_decode(input_paths, output_path, password, follow, idle_timeout_sec, memory_budget_mib,
+                         spill_dir, pixels_only, decoder_threads, adaptive_threads);
+    } else if (command == "read") {
+        if (input_path.empty() || output_path.empty() || !range_offset || !range_length) {
+            std::cerr << "Error: read needs --input (or --name or --id), --output, --offset and --length\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (!configure_chunk_cache(chunk_cache_dir, chunk_cache_mib)) {
+            return 1;
+        }
+        (void) load_profile(profile_path, no_profile);
+        return do_read(input_paths, output_path, password, *range_offset, *range_length, pixels_only, catalog);
+    } else if (command == "serve") {
+        if (socket_path.empty()) {
+            std::cerr << "Error: --socket must be specified for serve\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (!configure_chunk_cache(chunk_cache_dir, chunk_cache_mib)) {
+            return 1;
+        }
+        return do_serve(socket_path, jobs, queue);
+    } else if (command == "tune") {
+        if (sample_mib == 0) {
+            std::cerr << "Error: --sample-size must be at least 1 MiB\n";
+            return 1;
+        }
+        return do_tune(target.value_or("local"), sample_mib, profile_path);
+    } else if (command == "verify") {
+        if (input_path.empty()) {
+            std::cerr << "Error: --input must be specified for verify\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+        return do_verify(input_path, threads);
+    } else if (command == "info") {
+        if (input_path.empty()) {
+            std::cerr << "Error: --input must be specified for info\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+        return do_info(input_path, catalog);
+    } else if (command == "catalog") {
+        if (subcommand == "add" && input_paths.empty()) {
+            std::cerr << "Error: catalog add needs --input\n";
+            return 1;
+        }
+        if (subcommand == "remove" && archive_id.empty()) {
+            std::cerr << "Error: catalog remove needs --id\n";
+            return 1;
+        }
+        return do_catalog(subcommand, catalog_location(catalog_path), input_paths, archive_name, archive_id);
+    } else if (command == "refresh") {
         if (input_path.empty() || output_path.empty()) {
             std::cerr << "Error: both --input and --output must be specified\n";
             print_usage(argv[0]);
             return 1;
         }
-        return do_decode(input_path, output_path, password);
+        return do_refresh(input_path, output_path);
+    } else if (command == "fanout") {
+        if (input_path.empty() || sinks.empty()) {
+            std::cerr << "Error: --input and at least one --sink must be specified for fanout\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (encrypt && password.empty()) {
+            std::cerr << "Error: --encrypt requires --password\n";
+            return 1;
+        }
+        return do_fanout(input_path, sinks, encrypt, password, hash_algo);
     } else if (command == "stream-encode") {
         if (input_path.empty() || stream_url.empty()) {
             std::cerr << "Error: --input and --url must be specified for stream-encode\n";
@@ -291,14 +1402,42 @@ int main(const int argc, char *argv[]) {
             std::cerr << "Error: --encrypt requires --password\n";
             return 1;
         }
+        if (input_paths.size() > 1) {
+            return do_stream_encode_mux(input_paths, weights, stream_url, encrypt, password, hash_algo,
+                                        bitrate_kbps, stream_width, stream_height);
+        }
         return do_stream_encode(input_path, stream_url, encrypt, password, hash_algo, bitrate_kbps,
-                                stream_width, stream_height);
+                                stream_width, stream_height, feedback_socket, min_repair, max_repair);
+    } else if (command == "export-frames") {
+        if (input_path.empty() || output_paths.empty()) {
+            std::cerr << "Error: --input and at least one --output must be specified for export-frames\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (encrypt && password.empty()) {
+            std::cerr << "Error: --encrypt requires --password\n";
+            return 1;
+        }
+        return do_export_frames(input_path, output_paths, frame_format, pixel_format,
+                                size_given ? stream_width : 3840, size_given ? stream_height : 2160, encrypt, password,
+                                hash_algo, pattern_set, repair_overhead);
+    } else if (command == "import-frames") {
+        if (input_path.empty() || output_path.empty()) {
+            std::cerr << "Error: both --input and --output must be specified for import-frames\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+        return do_import_frames(input_path, output_path, frame_format, pixel_format,
+                                size_given ? stream_width : 3840, size_given ? stream_height : 2160, password);
     } else {
-        if (stream_url.empty() || output_path.empty()) {
-            std::cerr << "Error: --url and --output must be specified for stream-decode\n";
+        if (stream_url.empty() || output_path.empty() == output_dir.empty()) {
+            std::cerr << "Error: --url and one of --output or --output-dir must be specified for stream-decode\n";
             print_usage(argv[0]);
             return 1;
         }
-        return do_stream_decode(stream_url, output_path, password);
+        if (!output_dir.empty()) {
+            return do_stream_decode_demux(stream_url, output_dir, expected_files, password);
+        }
+        return do_stream_decode(stream_url, output_path, password, feedback_socket);
     }
 }
@@ -0,0 +1,346 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "manifest.h"
+
+#include <algorithm>
+#include <cstring>
+
+static constexpr uint32_t FILE_INFO_MAGIC = 0x4946534D; // "MSFI"
+static constexpr uint32_t CHUNK_TABLE_MAGIC = 0x4843534D; // "MSCH"
+static constexpr uint32_t SHARD_INFO_MAGIC = 0x4853534D; // "MSSH"
+static constexpr uint32_t FILE_DIGEST_MAGIC = 0x4446534D; // "MSFD"
+static constexpr uint8_t MANIFEST_VERSION = 1;
+
+enum FileInfoTag : uint16_t {
+    TagFileId = 1,
+    TagFileSize = 2,
+    TagChunkCount = 3,
+    TagChunkSize = 4,
+    TagSymbolSize = 5,
+    TagEncrypted = 6,
+    TagHashAlgorithm = 7,
+    TagFrameWidth = 8,
+    TagFrameHeight = 9,
+    TagShardCount = 10,
+};
+
+template<typename T>
+static void append_record(std::vector<std::byte> &out, const FileInfoTag tag, const T &value) {
+    append_value(out, static_cast<uint16_t>(tag));
+    append_value(out, static_cast<uint16_t>(sizeof(T)));
+    append_value(out, value);
+}
+
+template<typename T>
+static bool read_value(const std::span<const std::byte> value, T &out) {
+    if (value.size() != sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&out, value.data(), sizeof(T));
+    return true;
+}
+
+std::vector<std::byte> serialize_file_info(const FileInfo &info) {
+    std::vector<std::byte> out;
+    append_value(out, FILE_INFO_MAGIC);
+    append_value(out, MANIFEST_VERSION);
+    append_record(out, TagFileId, info.file_id);
+    append_record(out, TagFileSize, info.file_size);
+    append_record(out, TagChunkCount, info.chunk_count);
+    append_record(out, TagChunkSize, info.chunk_size);
+    append_record(out, TagSymbolSize, info.symbol_size);
+    append_record(out, TagEncrypted, static_cast<uint8_t>(info.encrypted ? 1 : 0));
+    append_record(out, TagHashAlgorithm, static_cast<uint8_t>(info.hash_algorithm));
+    append_record(out, TagFrameWidth, info.frame_width);
+    append_record(out, TagFrameHeight, info.frame_height);
+    if (info.shard_count > 0) {
+        append_record(out, TagShardCount, info.shard_count);
+    }
+    return out;
+}
+
+std::optional<FileInfo> parse_file_info(const std::span<const std::byte> data) {
+    uint32_t magic = 0;
+    if (data.size() < 5 || !read_value(data.first(4), magic) || magic != FILE_INFO_MAGIC ||
+        static_cast<uint8_t>(data[4]) != MANIFEST_VERSION) {
+        return std::nullopt;
+    }
+
+    FileInfo info;
+    bool has_id = false;
+    bool has_count = false;
+    std::size_t pos = 5;
+    while (pos + 4 <= data.size()) {
+        uint16_t tag = 0;
+        uint16_t length = 0;
+        std::memcpy(&tag, data.data() + pos, 2);
+        std::memcpy(&length, data.data() + pos + 2, 2);
+        pos += 4;
+        if (pos + length > data.size()) {
+            return std::nullopt;
+        }
+        const auto value = data.subspan(pos, length);
+        pos += length;
+
+        bool ok = true;
+        uint8_t byte = 0;
+        switch (tag) {
+            case TagFileId: ok = has_id = read_value(value, info.file_id); break;
+            case TagFileSize: ok = read_value(value, info.file_size); break;
+            case TagChunkCount: ok = has_count = read_value(value, info.chunk_count); break;
+            case TagChunkSize: ok = read_value(value, info.chunk_size); break;
+            case TagSymbolSize: ok = read_value(value, info.symbol_size); break;
+            case TagEncrypted:
+                ok = read_value(value, byte);
+                info.encrypted = byte != 0;
+                break;
+            case TagHashAlgorithm:
+                ok = read_value(value, byte) && byte <= static_cast<uint8_t>(HashAlgorithm::XXHash32);
+                info.hash_algorithm = static_cast<HashAlgorithm>(byte);
+                break;
+            case TagFrameWidth: ok = read_value(value, info.frame_width); break;
+            case TagFrameHeight: ok = read_value(value, info.frame_height); break;
+            case TagShardCount:
+                ok = read_value(value, info.shard_count) && info.shard_count <= MAX_SHARD_COUNT;
+                break;
+            default: break;
+        }
+        if (!ok) {
+            return std::nullopt;
+        }
+    }
+
+    if (!has_id || !has_count || info.chunk_count == 0 || info.chunk_count > MAX_CHUNK_COUNT) {
+        return std::nullopt;
+    }
+    return info;
+}
+
+std::vector<std::byte> serialize_shard_info(const ShardInfo &info) {
+    std::vector<std::byte> out;
+    out.reserve(SHARD_INFO_SIZE);
+    append_value(out, SHARD_INFO_MAGIC);
+    append_value(out, MANIFEST_VERSION);
+    append_value(out, info.shard_index);
+    append_value(out, info.shard_count);
+    append_value(out, info.first_chunk);
+    append_value(out, info.chunk_count);
+    return out;
+}
+
+std::optional<ShardInfo> parse_shard_info(const std::span<const std::byte> data) {
+    uint32_t magic = 0;
+    if (data.size() != SHARD_INFO_SIZE || !read_value(data.first(4), magic) || magic != SHARD_INFO_MAGIC ||
+        static_cast<uint8_t>(data[4]) != MANIFEST_VERSION) {
+        return std::nullopt;
+    }
+
+    ShardInfo info;
+    std::memcpy(&info.shard_index, data.data() + 5, 4);
+    std::memcpy(&info.shard_count, data.data() + 9, 4);
+    std::memcpy(&info.first_chunk, data.data() + 13, 4);
+    std::memcpy(&info.chunk_count, data.data() + 17, 4);
+    if (info.shard_count == 0 || info.shard_count > MAX_SHARD_COUNT || info.shard_index >= info.shard_count ||
+        info.chunk_count == 0 || info.chunk_count > MAX_CHUNKS_PER_SHARD ||
+        static_cast<uint64_t>(info.first_chunk) + info.chunk_count > MAX_CHUNK_COUNT) {
+        return std::nullopt;
+    }
+    return info;
+}
+
+std::vector<std::byte> serialize_file_digest(const FileDigest &digest) {
+    std::vector<std::byte> out;
+    out.reserve(FILE_DIGEST_SIZE);
+    append_value(out, FILE_DIGEST_MAGIC);
+    append_value(out, MANIFEST_VERSION);
+    append_value(out, digest.chunk_count);
+    append_value(out, digest.root.bytes);
+    return out;
+}
+
+std::optional<FileDigest> parse_file_digest(const std::span<const std::byte> data) {
+    uint32_t magic = 0;
+    if (data.size() != FILE_DIGEST_SIZE || !read_value(data.first(4), magic) || magic != FILE_DIGEST_MAGIC ||
+        static_cast<uint8_t>(data[4]) != MANIFEST_VERSION) {
+        return std::nullopt;
+    }
+
+    FileDigest digest;
+    std::memcpy(&digest.chunk_count, data.data() + 5, 4);
+    std::memcpy(digest.root.bytes.data(), data.data() + 9, SHA256_HASH_SIZE);
+    if (digest.chunk_count == 0 || digest.chunk_count > MAX_CHUNK_COUNT) {
+        return std::nullopt;
+    }
+    return digest;
+}
+
+uint32_t manifest_table_segment_count(const uint32_t chunk_count) {
+    return static_cast<uint32_t>((chunk_count + MANIFEST_DIGESTS_PER_SEGMENT - 1) / MANIFEST_DIGESTS_PER_SEGMENT);
+}
+
+std::vector<std::vector<std::byte> > serialize_chunk_table(const std::span<const Sha256Digest> digests,
+                                                           const uint32_t first_chunk) {
+    std::vector<std::vector<std::byte> > segments;
+    for (std::size_t first = 0; first < digests.size(); first += MANIFEST_DIGESTS_PER_SEGMENT) {
+        const auto count = static_cast<uint32_t>(std::min(MANIFEST_DIGESTS_PER_SEGMENT, digests.size() - first));
+        std::vector<std::byte> &out = segments.emplace_back();
+        out.reserve(MANIFEST_TABLE_HEADER_SIZE + count * sizeof(Sha256Digest));
+        append_value(out, CHUNK_TABLE_MAGIC);
+        append_value(out, MANIFEST_VERSION);
+        append_value(out, static_cast<uint32_t>(first_chunk + first));
+        append_value(out, count);
+        for (uint32_t i = 0; i < count; ++i) {
+            append_value(out, digests[first + i].bytes);
+        }
+    }
+    return segments;
+}
+
+bool ArchiveManifest::add_segment(const uint32_t segment, const std::span<const std::byte> data) {
+    if (segment == MANIFEST_FILE_INFO_SEGMENT) {
+        if (info_) {
+            return true;
+        }
+        auto info = parse_file_info(data);
+        if (!info) {
+            return false;
+        }
+        for (const auto &[index, shard]: shards_) {
+            if (shard.shard_count != info->shard_count ||
+                static_cast<uint64_t>(shard.first_chunk) + shard.chunk_count > info->chunk_count) {
+                return false;
+            }
+        }
+        if (digest_ && digest_->chunk_count != info->chunk_count) {
+            return false;
+        }
+        info_ = info;
+        return true;
+    }
+    if (segment == MANIFEST_FILE_DIGEST_SEGMENT) {
+        if (digest_) {
+            return true;
+        }
+        const auto digest = parse_file_digest(data);
+        if (!digest || (info_ && digest->chunk_count != info_->chunk_count)) {
+            return false;
+        }
+        digest_ = digest;
+        return true;
+    }
+    if (segment >= MANIFEST_SHARD_SEGMENT_BASE) {
+        return add_shard_segment(segment, data);
+    }
+
+    // Segment s always starts at (s - 1) * MANIFEST_DIGESTS_PER_SEGMENT, which
+    // also bounds how far a forged segment can make the table grow.
+    const uint64_t expected_first = static_cast<uint64_t>(segment - MANIFEST_FIRST_TABLE_SEGMENT) *
+                                    MANIFEST_DIGESTS_PER_SEGMENT;
+    return add_digests(data, expected_first, info_ ? info_->chunk_count : MAX_CHUNK_COUNT);
+}
+
+bool ArchiveManifest::add_shard_segment(const uint32_t segment, const std::span<const std::byte> data) {
+    const uint32_t shard_index = (segment - MANIFEST_SHARD_SEGMENT_BASE) / MANIFEST_SEGMENTS_PER_SHARD;
+    const uint32_t part = (segment - MANIFEST_SHARD_SEGMENT_BASE) % MANIFEST_SEGMENTS_PER_SHARD;
+
+    if (part == 0) {
+        const auto shard = parse_shard_info(data);
+        if (!shard || shard->shard_index != shard_index ||
+            (info_ && (shard->shard_count != info_->shard_count ||
+                       static_cast<uint64_t>(shard->first_chunk) + shard->chunk_count > info_->chunk_count))) {
+            return false;
+        }
+        shards_.try_emplace(shard_index, *shard);
+        return true;
+    }
+
+    // A shard's digests are placed by its own ShardInfo, which it writes first.
+    const auto it = shards_.find(shard_index);
+    if (it == shards_.end()) {
+        return false;
+    }
+    const ShardInfo &shard = it->second;
+    const uint64_t expected_first = shard.first_chunk + static_cast<uint64_t>(part - 1) * MANIFEST_DIGESTS_PER_SEGMENT;
+    return add_digests(data, expected_first, static_cast<uint64_t>(shard.first_chunk) + shard.chunk_count);
+}
+
+bool ArchiveManifest::add_digests(const std::span<const std::byte> data, const uint64_t expected_first,
+                                  const uint64_t limit) {
+    uint32_t magic = 0;
+    uint32_t first = 0;
+    uint32_t count = 0;
+    if (data.size() < MANIFEST_TABLE_HEADER_SIZE || !read_value(data.first(4), magic) ||
+        magic != CHUNK_TABLE_MAGIC || static_cast<uint8_t>(data[4]) != MANIFEST_VERSION) {
+        return false;
+    }
+    std::memcpy(&first, data.data() + 5, 4);
+    std::memcpy(&count, data.data() + 9, 4);
+
+    const uint64_t end = static_cast<uint64_t>(first) + count;
+    if (first != expected_first || count == 0 || count > MANIFEST_DIGESTS_PER_SEGMENT || end > MAX_CHUNK_COUNT ||
+        data.size() != MANIFEST_TABLE_HEADER_SIZE + static_cast<std::size_t>(count) * sizeof(Sha256Digest) ||
+        end > limit) {
+        return false;
+    }
+
+    if (digests_.size() < end) {
+        digests_.resize(end);
+        known_.resize(end, false);
+    }
+    const std::byte *src = data.data() + MANIFEST_TABLE_HEADER_SIZE;
+    for (uint32_t i = first; i < end; ++i, src += sizeof(Sha256Digest)) {
+        if (known_[i]) {
+            continue;
+        }
+        std::memcpy(digests_[i].bytes.data(), src, sizeof(Sha256Digest));
+        known_[i] = true;
+        ++known_digests_;
+    }
+    return true;
+}
+
+bool ArchiveManifest::accepts_segment(const uint32_t segment, const uint32_t chunk_count_limit) const {
+    if (segment == MANIFEST_FILE_DIGEST_SEGMENT) {
+        return true;
+    }
+    if (segment < MANIFEST_SHARD_SEGMENT_BASE) {
+        const uint32_t chunk_count = info_ ? info_->chunk_count : chunk_count_limit;
+        return segment < MANIFEST_FIRST_TABLE_SEGMENT + manifest_table_segment_count(chunk_count);
+    }
+    const uint32_t shard_limit = info_ ? info_->shard_count : MAX_SHARD_COUNT;
+    return (segment - MANIFEST_SHARD_SEGMENT_BASE) / MANIFEST_SEGMENTS_PER_SHARD < shard_limit;
+}
+
+bool ArchiveManifest::has_chunk_digests() const {
+    return info_ && has_chunk_digests(0, info_->chunk_count);
+}
+
+bool ArchiveManifest::has_chunk_digests(const uint32_t first_chunk, const uint32_t count) const {
+    const uint64_t end = static_cast<uint64_t>(first_chunk) + count;
+    if (count == 0 || known_.size() < end) {
+        return false;
+    }
+    return std::all_of(known_.begin() + first_chunk, known_.begin() + static_cast<std::ptrdiff_t>(end),
+                       [](const bool known) { return known; });
+}
+
+std::optional<Sha256Digest> ArchiveManifest::chunk_digest(const uint32_t chunk_index) const {
+    if (chunk_index >= known_.size() || !known_[chunk_index]) {
+        return std::nullopt;
+    }
+    return digests_[chunk_index];
+}
@@ -0,0 +1,156 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "configuration.h"
+#include "integrity.h"
+
+// The archive manifest travels in the video as ordinary FEC-coded segments
+// whose packets carry the Manifest flag; their chunk_index field is the segment
+// number. Segment 0 is the FileInfo record written before any data, segments
+// 1..M hold the SHA-256 of every chunk's FEC input and are written after the
+// last data chunk, followed by the FileDigest segment that seals them all.
+constexpr uint32_t MANIFEST_FILE_INFO_SEGMENT = 0;
+constexpr uint32_t MANIFEST_FIRST_TABLE_SEGMENT = 1;
+constexpr uint32_t MANIFEST_FILE_DIGEST_SEGMENT = 0xFFFF;
+
+constexpr std::size_t MANIFEST_TABLE_HEADER_SIZE = 13;
+constexpr std::size_t MANIFEST_DIGESTS_PER_SEGMENT =
+        (CHUNK_SIZE_BYTES - MANIFEST_TABLE_HEADER_SIZE) / sizeof(Sha256Digest);
+
+// A sharded archive spreads its chunks over several videos. Every shard
+// repeats the same FileInfo record, so segment 0 merges when shards are decoded
+// together, and adds segments of its own numbered from
+// MANIFEST_SHARD_SEGMENT_BASE so that no two shards ever share a segment: part
+// 0 is the shard's ShardInfo written first, parts 1.. hold the digests of its
+// own chunks and are written last. Unsharded archives use neither.
+constexpr uint32_t MANIFEST_SHARD_SEGMENT_BASE = 1u << 16;
+constexpr uint32_t MANIFEST_MAX_SHARD_TABLE_SEGMENTS = 64;
+constexpr uint32_t MANIFEST_SEGMENTS_PER_SHARD = 1 + MANIFEST_MAX_SHARD_TABLE_SEGMENTS;
+constexpr uint32_t MAX_SHARD_COUNT = 1u << 16;
+constexpr uint32_t MAX_CHUNKS_PER_SHARD = MANIFEST_MAX_SHARD_TABLE_SEGMENTS * MANIFEST_DIGESTS_PER_SEGMENT;
+constexpr std::size_t SHARD_INFO_SIZE = 21;
+constexpr std::size_t FILE_DIGEST_SIZE = 41;
+
+static_assert(MANIFEST_FIRST_TABLE_SEGMENT + (MAX_CHUNK_COUNT + MANIFEST_DIGESTS_PER_SEGMENT - 1) /
+              MANIFEST_DIGESTS_PER_SEGMENT <= MANIFEST_FILE_DIGEST_SEGMENT);
+static_assert(MANIFEST_FILE_DIGEST_SEGMENT < MANIFEST_SHARD_SEGMENT_BASE);
+
+[[nodiscard]] constexpr uint32_t manifest_shard_segment(const uint32_t shard_index, const uint32_t part) {
+    return MANIFEST_SHARD_SEGMENT_BASE + shard_index * MANIFEST_SEGMENTS_PER_SHARD + part;
+}
+
+struct FileInfo {
+    std::array<std::byte, 16> file_id{};
+    uint64_t file_size = 0;
+    uint32_t chunk_count = 0;
+    uint32_t chunk_size = 0; // input bytes per chunk before encryption
+    uint16_t symbol_size = 0;
+    bool encrypted = false;
+    HashAlgorithm hash_algorithm = HashAlgorithm::CRC32;
+    uint32_t frame_width = 0;
+    uint32_t frame_height = 0;
+    uint32_t shard_count = 0; // 0 if the archive is a single video
+};
+
+// merkle_root() over the digests of the chunk table. Sharded archives encode
+// their shards concurrently and carry none, since no shard sees every chunk.
+struct FileDigest {
+    uint32_t chunk_count = 0;
+    Sha256Digest root;
+};
+
+struct ShardInfo {
+    uint32_t shard_index = 0;
+    uint32_t shard_count = 0;
+    uint32_t first_chunk = 0;
+    uint32_t chunk_count = 0;
+};
+
+// FileInfo is a list of {tag u16, length u16, value} records behind a magic and
+// version byte. Readers skip tags they do not know, so fields can be added
+// without bumping the version.
+[[nodiscard]] std::vector<std::byte> serialize_file_info(const FileInfo &info);
+
+[[nodiscard]] std::optional<FileInfo> parse_file_info(std::span<const std::byte> data);
+
+// ShardInfo is a fixed {magic u32, version u8, shard_index u32, shard_count
+// u32, first_chunk u32, chunk_count u32} record.
+[[nodiscard]] std::vector<std::byte> serialize_shard_info(const ShardInfo &info);
+
+[[nodiscard]] std::optional<ShardInfo> parse_shard_info(std::span<const std::byte> data);
+
+// FileDigest is a fixed {magic u32, version u8, chunk_count u32, root} record.
+[[nodiscard]] std::vector<std::byte> serialize_file_digest(const FileDigest &digest);
+
+[[nodiscard]] std::optional<FileDigest> parse_file_digest(std::span<const std::byte> data);
+
+[[nodiscard]] uint32_t manifest_table_segment_count(uint32_t chunk_count);
+
+// Splits per-chunk digests into table segments of {magic u32, version u8,
+// first_chunk u32, count u32, digests}. digests[0] belongs to first_chunk.
+[[nodiscard]] std::vector<std::vector<std::byte> > serialize_chunk_table(std::span<const Sha256Digest> digests,
+                                                                         uint32_t first_chunk = 0);
+
+// Collects decoded manifest segments on the decoding side.
+class ArchiveManifest {
+public:
+    // Returns false if the segment is malformed or disagrees with FileInfo.
+    bool add_segment(uint32_t segment, std::span<const std::byte> data);
+
+    [[nodiscard]] const std::optional<FileInfo> &file_info() const { return info_; }
+
+    [[nodiscard]] const std::optional<FileDigest> &file_digest() const { return digest_; }
+
+    // Whether a segment number can belong to this archive, before decoding it.
+    [[nodiscard]] bool accepts_segment(uint32_t segment, uint32_t chunk_count_limit) const;
+
+    // Shards whose ShardInfo was decoded, by shard index.
+    [[nodiscard]] const std::map<uint32_t, ShardInfo> &shards() const { return shards_; }
+
+    // True once FileInfo and every table segment it announces have arrived.
+    [[nodiscard]] bool has_chunk_digests() const;
+
+    // True once the digests of chunks [first_chunk, first_chunk + count) are known.
+    [[nodiscard]] bool has_chunk_digests(uint32_t first_chunk, uint32_t count) const;
+
+    [[nodiscard]] std::optional<Sha256Digest> chunk_digest(uint32_t chunk_index) const;
+
+    [[nodiscard]] uint32_t known_digest_count() const { return known_digests_; }
+
+private:
+    bool add_shard_segment(uint32_t segment, std::span<const std::byte> data);
+
+    bool add_digests(std::span<const std::byte> data, uint64_t expected_first, uint64_t limit);
+
+    std::optional<FileInfo> info_;
+    std::optional<FileDigest> digest_;
+    std::map<uint32_t, ShardInfo> shards_;
+    std::vector<Sha256Digest> digests_;
+    std::vector<bool> known_;
+    uint32_t known_digests_ = 0;
+};
@@ -18,34 +18,63 @@
 
 #include "media_storage.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
+#include <exception>
 #include <future>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <omp.h>
+#include <optional>
 #include <span>
 #include <string>
 #include <thread>
+#include <unordered_map>
 
+#include "bounded_queue.h"
+#include "catalog.h"
+#include "chunk_cache.h"
 #include "chunker.h"
 #include "configuration.h"
 #include "crypto.h"
 #include "decoder.h"
+#include "encode_cache.h"
 #include "encoder.h"
+#include "manifest.h"
+#include "packet_sink.h"
+#include "raw_frames.h"
+#include "repair_controller.h"
+#include "repair_feedback.h"
+#include "shard_plan.h"
 #include "stream.h"
+#include "stream_mux.h"
 #include "video_decoder.h"
 #include "video_encoder.h"
 
 static std::array<std::byte, 16> make_file_id() {
     std::array<std::byte, 16> id{};
-    for (int i = 0; i < 16; ++i) {
-        id[i] = static_cast<std::byte>(i);
-    }
+    random_bytes(id);
     return id;
 }
 
+// Archives written before file ids were random all carry 00 01 .. 0f, so their
+// id cannot key the decoded chunk cache.
+static bool has_unique_file_id(const std::array<std::byte, 16> &id) {
+    for (std::size_t i = 0; i < id.size(); ++i) {
+        if (id[i] != static_cast<std::byte>(i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static HashAlgorithm to_internal_hash(const ms_hash_algorithm_t algo) {
     switch (algo) {
         case MS_HASH_XXHASH32: return HashAlgorithm::XXHash32;
@@ -53,6 +82,477 @@ static HashAlgorithm to_internal_hash(const ms_hash_algorithm_t algo) {
     }
 }
 
+static PatternSet to_internal_patterns(const ms_pattern_set_t set) {
+    switch (set) {
+        case MS_PATTERN_QUANTIZED_COSINE: return PatternSet::QuantizedCosine;
+        case MS_PATTERN_STEP: return PatternSet::Step;
+        default: return PatternSet::Cosine;
+    }
+}
+
+static DecoderLimits to_internal_limits(const ms_decode_limits_t &limits) {
+    DecoderLimits internal;
+    if (limits.max_chunk_size > 0) internal.max_chunk_size = limits.max_chunk_size;
+    if (limits.max_chunk_count > 0) internal.max_chunk_count = limits.max_chunk_count;
+    internal.max_live_decoders = limits.max_live_decoders;
+    internal.max_buffered_bytes = limits.max_buffered_bytes;
+    return internal;
+}
+
+static FileInfo make_file_info(const std::array<std::byte, 16> &file_id, const FileChunkReader &reader,
+                               const bool encrypt, const HashAlgorithm algo, const int width, const int height) {
+    FileInfo info;
+    info.file_id = file_id;
+    info.file_size = reader.file_size();
+    info.chunk_count = static_cast<uint32_t>(reader.num_chunks());
+    info.chunk_size = static_cast<uint32_t>(reader.chunk_size());
+    info.symbol_size = static_cast<uint16_t>(SYMBOL_SIZE_BYTES);
+    info.encrypted = encrypt;
+    info.hash_algorithm = algo;
+    info.frame_width = static_cast<uint32_t>(width);
+    info.frame_height = static_cast<uint32_t>(height);
+    return info;
+}
+
+static std::size_t encode_manifest(const Encoder &encoder, const uint32_t first_segment,
+                                   const std::vector<std::vector<std::byte> > &segments, PacketSink &sink) {
+    std::size_t packets = 0;
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        const auto segment_packets = encoder.encode_manifest_segment(
+            first_segment + static_cast<uint32_t>(i), segments[i]);
+        packets += segment_packets.size();
+        sink.encode_packets(segment_packets);
+    }
+    return packets;
+}
+
+static FileDigest make_file_digest(const std::span<const Sha256Digest> digests) {
+    return FileDigest{static_cast<uint32_t>(digests.size()), merkle_root(digests)};
+}
+
+// Ends an archive: the chunk table, then the FileDigest segment sealing it.
+static std::size_t encode_manifest_tail(const Encoder &encoder, const std::span<const Sha256Digest> digests,
+                                        PacketSink &sink, FileDigest &file_digest) {
+    std::size_t packets = encode_manifest(encoder, MANIFEST_FIRST_TABLE_SEGMENT, serialize_chunk_table(digests), sink);
+    file_digest = make_file_digest(digests);
+    packets += encode_manifest(encoder, MANIFEST_FILE_DIGEST_SEGMENT, {serialize_file_digest(file_digest)}, sink);
+    return packets;
+}
+
+static void set_file_digest(ms_result_t *result, const Sha256Digest &root) {
+    std::memcpy(result->file_digest, root.bytes.data(), sizeof(result->file_digest));
+    result->has_file_digest = 1;
+}
+
+// Checks the SHA-256 taken as each chunk decoded against the chunk table, then
+// folds them into the whole-file digest and checks it against the one the
+// archive carries, if any.
+static bool check_file_digest(const ArchiveManifest &manifest, std::vector<Sha256Digest> &chunk_digests,
+                              const uint32_t expected_chunks, Sha256Digest &root) {
+    chunk_digests.resize(expected_chunks);
+    for (uint32_t i = 0; i < expected_chunks; ++i) {
+        if (const auto stored = manifest.chunk_digest(i); stored && *stored != chunk_digests[i]) {
+            return false;
+        }
+    }
+    root = merkle_root(chunk_digests);
+    const auto &expected = manifest.file_digest();
+    return !expected || (expected->chunk_count == expected_chunks && expected->root == root);
+}
+
+// Whether a decode has read everything it checks: every data chunk and, for
+// an unsharded archive, the chunk table and FileDigest segment written after
+// them. Archives without FileInfo carry neither.
+static bool decode_complete(const ArchiveManifest &manifest, const std::size_t decoded_chunks,
+                            const bool found_last_chunk, const uint32_t last_chunk_index) {
+    if (!found_last_chunk || decoded_chunks < static_cast<std::size_t>(last_chunk_index) + 1) {
+        return false;
+    }
+    const auto &info = manifest.file_info();
+    return !info || info->shard_count != 0 || manifest.file_digest().has_value();
+}
+
+// Compares what an encode verifier read back with the digests the encode made
+// for chunks [first_chunk, first_chunk + digests.size()), and checks that the
+// manifest came back too.
+static ms_status_t check_verified_encode(const EncodeVerifier &verifier, const uint32_t first_chunk,
+                                         const std::span<const Sha256Digest> digests, uint64_t &verified) {
+    const auto &recovered = verifier.chunk_digests();
+    uint64_t matched = 0;
+    bool mismatch = false;
+    for (std::size_t i = 0; i < digests.size(); ++i) {
+        const std::size_t index = first_chunk + i;
+        if (index < recovered.size() && recovered[index]) {
+            if (*recovered[index] == digests[i]) {
+                ++matched;
+            } else {
+                mismatch = true;
+            }
+        }
+    }
+    verified += matched;
+
+    const ArchiveManifest &manifest = verifier.decoder().manifest();
+    if (const auto &file_digest = manifest.file_digest(); file_digest && file_digest->root != merkle_root(digests)) {
+        mismatch = true;
+    }
+    if (mismatch) {
+        return MS_ERR_INTEGRITY;
+    }
+    if (matched < digests.size() || !manifest.file_info() ||
+        !manifest.has_chunk_digests(first_chunk, static_cast<uint32_t>(digests.size()))) {
+        return MS_ERR_INCOMPLETE;
+    }
+    return MS_OK;
+}
+
+static std::string shard_path(const std::string &output_path, const uint32_t shard_index) {
+    const std::filesystem::path path(output_path);
+    char part[32];
+    std::snprintf(part, sizeof(part), ".part%03u", shard_index);
+    std::filesystem::path shard = path.parent_path() / (path.stem().string() + part + path.extension().string());
+    return shard.string();
+}
+
+static int shard_worker_count(const std::size_t shards) {
+    const int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    return static_cast<int>(std::min<std::size_t>(shards, std::clamp(hardware / 2, 1, 8)));
+}
+
+// Packets a shard may hold under the frame and byte limits. ffv1 never grows a
+// frame much past its raw size, so the byte limit is planned against raw
+// frames plus an eighth for the range coder and the container.
+static uint64_t shard_packet_budget(const ms_encode_options_t &options) {
+    uint64_t frames = options.max_shard_frames > 0 ? options.max_shard_frames : UINT64_MAX;
+    if (options.max_shard_bytes > 0) {
+        uint64_t frame_bytes = static_cast<uint64_t>(FRAME_WIDTH) * FRAME_HEIGHT * 9 / 8;
+        if (options.audio_data_track) {
+            frame_bytes += AUDIO_DATA_BYTES_PER_FRAME;
+        }
+        frames = std::min(frames, options.max_shard_bytes / frame_bytes);
+    }
+    auto packets_per_frame = static_cast<uint64_t>(VideoEncoder::packets_per_frame());
+    if (options.audio_data_track) {
+        packets_per_frame += static_cast<uint64_t>(VideoEncoder::audio_packets_per_frame());
+    }
+    return frames > UINT64_MAX / packets_per_frame ? UINT64_MAX : frames * packets_per_frame;
+}
+
+// Catalog calls serialize within the process; across processes the catalog's
+// single-write appends keep records whole.
+static std::mutex catalog_mutex;
+
+template<typename Fn>
+static ms_status_t with_catalog(const char *catalog_path, Fn &&fn) {
+    const std::filesystem::path path = catalog_path ? std::filesystem::path(catalog_path) : Catalog::default_path();
+    if (path.empty()) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    try {
+        const std::lock_guard lock(catalog_mutex);
+        Catalog catalog(path);
+        return fn(catalog);
+    } catch (...) {
+        return MS_ERR_IO;
+    }
+}
+
+static std::string absolute_path(const std::string &path) {
+    std::error_code ec;
+    const auto absolute = std::filesystem::absolute(path, ec);
+    return ec ? path : absolute.lexically_normal().string();
+}
+
+// Records a finished encode. The catalog is an index kept beside the archive,
+// so failing to write it does not fail the encode.
+static void catalog_encode(const ms_encode_options_t &options, const FileInfo &info, const Sha256Digest &digest,
+                           std::vector<CatalogVideo> videos, std::vector<uint32_t> chunk_frames) {
+    if (!options.catalog_path) {
+        return;
+    }
+    CatalogEntry entry;
+    entry.file_id = info.file_id;
+    entry.name = std::filesystem::path(options.input_path).filename().string();
+    entry.file_size = info.file_size;
+    entry.chunk_count = info.chunk_count;
+    entry.chunk_size = info.chunk_size;
+    entry.shard_count = info.shard_count;
+    entry.encrypted = info.encrypted;
+    entry.has_digest = true;
+    entry.digest = digest;
+    for (CatalogVideo &video: videos) {
+        video.path = absolute_path(video.path);
+    }
+    entry.videos = std::move(videos);
+    entry.chunk_frames = std::move(chunk_frames);
+    (void) with_catalog(options.catalog_path, [&](Catalog &catalog) {
+        catalog.merge(entry);
+        return MS_OK;
+    });
+}
+
+// Probes a video and merges what its manifest says into the catalog. The
+// frame layout is not in the manifest, so only an earlier encode's record
+// gives the entry a frame index.
+static ms_status_t catalog_probe(Catalog &catalog, const std::string &video_path, std::string name,
+                                 const Sha256Digest *digest, ms_info_t &info) {
+    if (const ms_status_t status = ms_probe(video_path.c_str(), &info); status != MS_OK) {
+        return status;
+    }
+    if (!info.has_manifest) {
+        return MS_ERR_DECODE_FAILED;
+    }
+
+    CatalogEntry entry;
+    std::memcpy(entry.file_id.data(), info.file_id, entry.file_id.size());
+    if (name.empty() && !catalog.find(entry.file_id)) {
+        name = std::filesystem::path(video_path).filename().string();
+    }
+    entry.name = std::move(name);
+    entry.file_size = info.file_size;
+    entry.chunk_count = static_cast<uint32_t>(info.chunk_count);
+    entry.chunk_size = info.chunk_size;
+    entry.shard_count = info.shard_count;
+    entry.encrypted = info.encrypted != 0;
+    if (digest) {
+        entry.has_digest = true;
+        entry.digest = *digest;
+    }
+    CatalogVideo video{absolute_path(video_path), 0, 0, entry.chunk_count};
+    if (info.shard_count > 0) {
+        video.shard_index = info.shard_index;
+        video.first_chunk = info.shard_first_chunk;
+        video.chunk_count = info.shard_chunk_count;
+    }
+    entry.videos.push_back(std::move(video));
+    catalog.merge(entry);
+    return MS_OK;
+}
+
+// Sharded variant of ms_encode: the chunks are split into consecutive ranges up
+// front and every range is written to its own video by an independent worker,
+// so shards are produced concurrently and each is decodable on its own.
+static ms_status_t encode_sharded(const ms_encode_options_t &options, ms_result_t *result) {
+    const std::string input_path(options.input_path);
+    const std::string output_path(options.output_path);
+
+    const auto input_size = std::filesystem::file_size(input_path);
+    const bool encrypt = options.encrypt != 0;
+    const std::size_t chunk_size = encrypt ? CHUNK_SIZE_PLAIN_MAX_ENCRYPTED : 0;
+    const FileChunkReader reader(input_path.c_str(), chunk_size);
+    const std::size_t num_chunks = reader.num_chunks();
+
+    const auto file_id = make_file_id();
+    const HashAlgorithm hash_algo = to_internal_hash(options.hash_algorithm);
+    const Encoder encoder(file_id, hash_algo);
+
+    FileInfo info = make_file_info(file_id, reader, encrypt, hash_algo, FRAME_WIDTH, FRAME_HEIGHT);
+    info.shard_count = 1; // only the presence of the record affects its size
+
+    const std::size_t crypto_overhead = encrypt ? CRYPTO_PLAIN_SIZE_HEADER + CRYPTO_AEAD_TAG_BYTES : 0;
+    ShardPlanParams params;
+    params.chunk_count = static_cast<uint32_t>(num_chunks);
+    params.chunk_bytes = reader.chunk_size() + crypto_overhead;
+    params.last_chunk_bytes = reader.file_size() - (num_chunks - 1) * reader.chunk_size() + crypto_overhead;
+    params.file_info_bytes = serialize_file_info(info).size();
+    params.max_packets = shard_packet_budget(options);
+
+    const std::vector<ShardRange> plan = plan_shards(encoder, params);
+    if (plan.empty()) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    info.shard_count = static_cast<uint32_t>(plan.size());
+    const std::vector<std::byte> file_info = serialize_file_info(info);
+
+    std::array<std::byte, CRYPTO_KEY_BYTES> key{};
+    if (encrypt) {
+        const std::span pw(reinterpret_cast<const std::byte *>(options.password),
+                           options.password_len);
+        key = derive_key(pw, file_id);
+    }
+
+    VideoEncoderOptions video_options;
+    video_options.raw_packet_track = options.raw_packet_track != 0;
+    video_options.audio_data_track = options.audio_data_track != 0;
+    video_options.pattern_set = to_internal_patterns(options.pattern_set);
+    video_options.verify = options.verify != 0;
+    video_options.slices = options.ffv1_slices;
+
+    const int workers = shard_worker_count(plan.size());
+    const int threads_per_worker = std::max(1, omp_get_max_threads() / workers);
+    std::vector<int64_t> shard_frames(plan.size(), 0);
+    std::vector<std::size_t> shard_packets(plan.size(), 0);
+    std::vector<Sha256Digest> file_digests(num_chunks);
+    std::vector<uint32_t> chunk_frames(num_chunks, 0);
+    std::atomic<std::size_t> next_shard{0};
+    std::atomic<std::size_t> chunks_done{0};
+    std::atomic<int> running{workers};
+    std::atomic<bool> stop{false};
+    std::atomic<bool> failed{false};
+    std::atomic<uint64_t> verified_chunks{0};
+    std::atomic<ms_status_t> verify_status{MS_OK};
+
+    const auto encode_shard = [&](const uint32_t shard_index) {
+        const ShardRange &range = plan[shard_index];
+        const FileChunkReader shard_reader(input_path.c_str(), chunk_size);
+        VideoEncoder video_encoder(shard_path(output_path, shard_index), FRAME_WIDTH, FRAME_HEIGHT, video_options);
+
+        ShardInfo shard;
+        shard.shard_index = shard_index;
+        shard.shard_count = static_cast<uint32_t>(plan.size());
+        shard.first_chunk = range.first_chunk;
+        shard.chunk_count = range.chunk_count;
+
+        std::size_t packets = encode_manifest(encoder, MANIFEST_FILE_INFO_SEGMENT, {file_info}, video_encoder);
+        packets += encode_manifest(encoder, manifest_shard_segment(shard_index, 0), {serialize_shard_info(shard)},
+                                   video_encoder);
+
+        std::vector<Sha256Digest> digests(range.chunk_count);
+        for (uint32_t batch_start = 0; batch_start < range.chunk_count && !stop; batch_start += threads_per_worker) {
+            const int batch_count = static_cast<int>(std::min<uint32_t>(threads_per_worker,
+                                                                        range.chunk_count - batch_start));
+
+            std::vector<std::vector<std::byte>> chunk_datas(batch_count);
+            for (int j = 0; j < batch_count; ++j) {
+                chunk_datas[j] = shard_reader.read_chunk(range.first_chunk + batch_start + j);
+            }
+
+            std::vector<std::pair<std::vector<Packet>, ChunkManifestEntry>> results(batch_count);
+            bool batch_error = false;
+
+#pragma omp parallel for schedule(dynamic)
+            for (int j = 0; j < batch_count; ++j) {
+                if (batch_error) continue;
+                try {
+                    const uint32_t i = range.first_chunk + batch_start + j;
+                    std::span<const std::byte> data_to_encode(chunk_datas[j]);
+                    std::vector<std::byte> encrypted_buf;
+                    if (encrypt) {
+                        encrypted_buf = encrypt_chunk(data_to_encode, key, file_id, i);
+                        data_to_encode = encrypted_buf;
+                    }
+                    results[j] = encoder.encode_chunk(i, data_to_encode, i == num_chunks - 1, encrypt);
+                } catch (...) {
+                    batch_error = true;
+                }
+            }
+
+            if (batch_error) {
+                throw std::runtime_error("batch FEC encoding failed");
+            }
+
+            for (int j = 0; j < batch_count; ++j) {
+                packets += results[j].first.size();
+                chunk_frames[range.first_chunk + batch_start + j] =
+                        static_cast<uint32_t>(video_encoder.frames_written());
+                video_encoder.encode_packets(results[j].first);
+                digests[batch_start + j] = results[j].second.sha256;
+                file_digests[range.first_chunk + batch_start + j] = results[j].second.sha256;
+            }
+            chunks_done += batch_count;
+        }
+
+        packets += encode_manifest(encoder, manifest_shard_segment(shard_index, 1),
+                                   serialize_chunk_table(digests, range.first_chunk), video_encoder);
+        video_encoder.finalize();
+        shard_frames[shard_index] = video_encoder.frames_written();
+        shard_packets[shard_index] = packets;
+
+        if (const EncodeVerifier *verifier = video_encoder.verifier()) {
+            uint64_t verified = 0;
+            if (const ms_status_t status = check_verified_encode(*verifier, range.first_chunk, digests, verified);
+                status != MS_OK) {
+                verify_status = status;
+            }
+            verified_chunks += verified;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (int w = 0; w < workers; ++w) {
+        threads.emplace_back([&] {
+            // Workers split the cores instead of each spawning a full team.
+            omp_set_num_threads(threads_per_worker);
+            for (std::size_t s = next_shard++; s < plan.size() && !stop; s = next_shard++) {
+                try {
+                    encode_shard(static_cast<uint32_t>(s));
+                } catch (...) {
+                    failed = true;
+                    stop = true;
+                }
+            }
+            --running;
+        });
+    }
+
+    bool cancelled = false;
+    while (options.progress && running > 0) {
+        if (!cancelled && options.progress(chunks_done, num_chunks, options.progress_user) != 0) {
+            cancelled = true;
+            stop = true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    if (encrypt) secure_zero(std::span<std::byte>(key));
+
+    if (failed || cancelled) {
+        for (uint32_t s = 0; s < plan.size(); ++s) {
+            std::error_code ec;
+            std::filesystem::remove(shard_path(output_path, s), ec);
+        }
+        return MS_ERR_ENCODE_FAILED;
+    }
+
+    if (result) {
+        result->input_size = input_size;
+        result->output_size = 0;
+        result->total_packets = 0;
+        result->total_frames = 0;
+        for (uint32_t s = 0; s < plan.size(); ++s) {
+            result->output_size += std::filesystem::file_size(shard_path(output_path, s));
+            result->total_packets += shard_packets[s];
+            result->total_frames += static_cast<uint64_t>(shard_frames[s]);
+        }
+        result->total_chunks = num_chunks;
+        result->total_shards = plan.size();
+        set_file_digest(result, merkle_root(file_digests));
+        result->verified_chunks = verified_chunks;
+    }
+
+    if (verify_status == MS_OK) {
+        std::vector<CatalogVideo> videos;
+        for (uint32_t s = 0; s < plan.size(); ++s) {
+            videos.push_back(CatalogVideo{shard_path(output_path, s), s, plan[s].first_chunk, plan[s].chunk_count});
+        }
+        catalog_encode(options, info, merkle_root(file_digests), std::move(videos), std::move(chunk_frames));
+    }
+    return verify_status;
+}
+
+// Every option that changes the bytes of an unsharded, unencrypted encode of a
+// given input, for the encode cache key.
+static std::vector<std::byte> encode_profile(const ms_encode_options_t &options, const Encoder &encoder) {
+    const std::string extension = std::filesystem::path(options.output_path).extension().string();
+    const std::array<int32_t, 8> fields{
+        1, FRAME_WIDTH, FRAME_HEIGHT, static_cast<int32_t>(options.hash_algorithm),
+        static_cast<int32_t>(options.pattern_set), options.raw_packet_track != 0, options.audio_data_track != 0,
+        std::max(0, options.ffv1_slices)
+    };
+    const double repair_overhead = encoder.repair_overhead();
+
+    std::vector<std::byte> profile(sizeof(fields) + sizeof(repair_overhead));
+    std::memcpy(profile.data(), fields.data(), sizeof(fields));
+    std::memcpy(profile.data() + sizeof(fields), &repair_overhead, sizeof(repair_overhead));
+    const auto *ext = reinterpret_cast<const std::byte *>(extension.data());
+    profile.insert(profile.end(), ext, ext + extension.size());
+    return profile;
+}
+
 ms_status_t ms_encode(const ms_encode_options_t *options, ms_result_t *result) {
     if (!options || !options->input_path || !options->output_path) {
         return MS_ERR_INVALID_ARGS;
@@ -67,6 +567,13 @@ ms_status_t ms_encode(const ms_encode_options_t *options, ms_result_t *result) {
     if (!std::filesystem::exists(input_path)) {
         return MS_ERR_FILE_NOT_FOUND;
     }
+    if (options->max_shard_frames > 0 || options->max_shard_bytes > 0) {
+        try {
+            return encode_sharded(*options, result);
+        } catch (...) {
+            return MS_ERR_ENCODE_FAILED;
+        }
+    }
 
     const auto input_size = std::filesystem::file_size(input_path);
     const bool encrypt = options->encrypt != 0;
@@ -75,7 +582,8 @@ ms_status_t ms_encode(const ms_encode_options_t *options, ms_result_t *result) {
     const std::size_t num_chunks = reader.num_chunks();
 
     const auto file_id = make_file_id();
-    const Encoder encoder(file_id, to_internal_hash(options->hash_algorithm));
+    const HashAlgorithm hash_algo = to_internal_hash(options->hash_algorithm);
+    const Encoder encoder(file_id, hash_algo);
 
     std::array<std::byte, CRYPTO_KEY_BYTES> key{};
     if (encrypt) {
@@ -86,9 +594,78 @@ ms_status_t ms_encode(const ms_encode_options_t *options, ms_result_t *result) {
 
     std::size_t total_packets = 0;
     int64_t total_frames = 0;
+    std::vector<Sha256Digest> digests(num_chunks);
+    std::vector<uint32_t> chunk_frames(num_chunks, 0);
+    FileDigest file_digest;
+    uint64_t verified_chunks = 0;
+    ms_status_t verify_status = MS_OK;
+
+    // Only unencrypted encodes use the cache: their packets depend on nothing
+    // but the chunk data, and caching them for encrypted input would keep a
+    // plaintext-derived copy of the file around.
+    std::optional<EncodeCache> cache;
+    std::vector<std::byte> profile;
+    Sha256Digest input_key;
+    uint64_t cached_chunks = 0;
+    if (options->cache_dir && !encrypt) {
+        try {
+            cache.emplace(options->cache_dir);
+            profile = encode_profile(*options, encoder);
+            // Looked up by the input's identity, so a hit does not read the
+            // input at all; the content digest comes from the encode that
+            // stored the video.
+            input_key = EncodeCache::input_key(input_path, profile);
+            const auto content = cache->find_input(input_key);
+            if (const auto hit = content
+                                     ? cache->fetch_video(EncodeCache::video_key(*content, profile), output_path)
+                                     : std::nullopt;
+                hit && (!options->verify || hit->verified_chunks == num_chunks)) {
+                if (result) {
+                    result->input_size = input_size;
+                    result->output_size = std::filesystem::file_size(output_path);
+                    result->total_chunks = hit->total_chunks;
+                    result->total_packets = hit->total_packets;
+                    result->total_frames = hit->total_frames;
+                    set_file_digest(result, *content);
+                    result->verified_chunks = hit->verified_chunks;
+                    result->cache_hit = 1;
+                    result->cached_chunks = hit->total_chunks;
+                    std::memcpy(result->file_id, hit->file_id.data(), sizeof(result->file_id));
+                }
+                if (options->catalog_path) {
+                    // The cached video carries the file id of the encode that
+                    // produced it, which the catalog may already know.
+                    (void) with_catalog(options->catalog_path, [&](Catalog &catalog) {
+                        ms_info_t probed{};
+                        return catalog_probe(catalog, output_path,
+                                             std::filesystem::path(input_path).filename().string(), &*content,
+                                             probed);
+                    });
+                }
+                return MS_OK;
+            }
+        } catch (...) {
+            return MS_ERR_IO;
+        }
+    }
+    const bool chunk_cache = cache && options->cache_chunks;
+    const FileInfo info = make_file_info(file_id, reader, encrypt, hash_algo, FRAME_WIDTH, FRAME_HEIGHT);
+
+    // The output may be a hard link into the cache from an earlier encode.
+    std::error_code remove_error;
+    std::filesystem::remove(output_path, remove_error);
 
     try {
-        VideoEncoder video_encoder(output_path);
+        VideoEncoderOptions video_options;
+        video_options.raw_packet_track = options->raw_packet_track != 0;
+        video_options.audio_data_track = options->audio_data_track != 0;
+        video_options.pattern_set = to_internal_patterns(options->pattern_set);
+        video_options.verify = options->verify != 0;
+        video_options.slices = options->ffv1_slices;
+        VideoEncoder video_encoder(output_path, FRAME_WIDTH, FRAME_HEIGHT, video_options);
+
+        total_packets += encode_manifest(encoder, MANIFEST_FILE_INFO_SEGMENT, {serialize_file_info(info)},
+                                         video_encoder);
 
         const int batch_size = std::max(1, omp_get_max_threads());
 
@@ -115,6 +692,7 @@ ms_status_t ms_encode(const ms_encode_options_t *options, ms_result_t *result) {
 
             std::vector<std::pair<std::vector<Packet>, ChunkManifestEntry>>
                 results(batch_count);
+            std::vector<char> from_cache(batch_count, 0);
             bool batch_error = false;
 
 #pragma omp parallel for schedule(dynamic)
@@ -122,6 +700,21 @@ ms_status_t ms_encode(const ms_encode_options_t *options, ms_result_t *result) {
                 if (batch_error) continue;
                 try {
                     const std::size_t i = batch_start + j;
+                    const bool is_last = (i == num_chunks - 1);
+                    if (chunk_cache) {
+                        const Sha256Digest chunk_digest = sha256(chunk_datas[j]);
+                        if (auto cached = cache->load_chunk(
+                                EncodeCache::chunk_key(chunk_digest, encoder.repair_overhead()));
+                            cached && cached->entry.original_size == chunk_datas[j].size()) {
+                            encoder.restamp_chunk(cached->packets, cached->entry,
+                                                  static_cast<uint32_t>(i), is_last);
+                            cached->entry.chunk_index = static_cast<uint32_t>(i);
+                            cached->entry.sha256 = chunk_digest;
+                            results[j] = {std::move(cached->packets), cached->entry};
+                            from_cache[j] = 1;
+                            continue;
+                        }
+                    }
                     std::span<const std::byte> data_to_encode(chunk_datas[j]);
                     std::vector<std::byte> encrypted_buf;
                     if (encrypt) {
@@ -130,7 +723,6 @@ ms_status_t ms_encode(const ms_encode_options_t *options, ms_result_t *result) {
                             static_cast<uint32_t>(i));
                         data_to_encode = encrypted_buf;
                     }
-                    const bool is_last = (i == num_chunks - 1);
                     results[j] = encoder.encode_chunk(
                         static_cast<uint32_t>(i), data_to_encode,
                         is_last, encrypt);
@@ -145,13 +737,27 @@ ms_status_t ms_encode(const ms_encode_options_t *options, ms_result_t *result) {
             }
 
             for (int j = 0; j < batch_count; ++j) {
+                if (from_cache[j]) {
+                    ++cached_chunks;
+                } else if (chunk_cache) {
+                    cache->store_chunk(EncodeCache::chunk_key(results[j].second.sha256, encoder.repair_overhead()),
+                                       CachedChunk{results[j].second, results[j].first});
+                }
                 total_packets += results[j].first.size();
+                chunk_frames[batch_start + j] = static_cast<uint32_t>(video_encoder.frames_written());
                 video_encoder.encode_packets(results[j].first);
+                digests[batch_start + j] = results[j].second.sha256;
             }
         }
 
+        total_packets += encode_manifest_tail(encoder, digests, video_encoder, file_digest);
+
         video_encoder.finalize();
         total_frames = video_encoder.frames_written();
+
+        if (const EncodeVerifier *verifier = video_encoder.verifier()) {
+            verify_status = check_verified_encode(*verifier, 0, digests, verified_chunks);
+        }
     } catch (...) {
         if (encrypt) secure_zero(std::span<std::byte>(key));
         return MS_ERR_ENCODE_FAILED;
@@ -159,31 +765,184 @@ ms_status_t ms_encode(const ms_encode_options_t *options, ms_result_t *result) {
 
     if (encrypt) secure_zero(std::span<std::byte>(key));
 
+    if (cache && verify_status == MS_OK) {
+        // Keyed by the digests the encode itself took. The input entry is
+        // left out if the input changed while it was being read.
+        const bool stored = cache->store_video(EncodeCache::video_key(file_digest.root, profile), output_path,
+                                               CachedEncode{total_packets, static_cast<uint64_t>(total_frames),
+                                                            num_chunks, verified_chunks, file_id});
+        try {
+            if (stored && EncodeCache::input_key(input_path, profile) == input_key) {
+                cache->store_input(input_key, file_digest.root);
+            }
+        } catch (const std::filesystem::filesystem_error &) {
+            // The input is gone; there is nothing left to key it by.
+        }
+    }
+
     if (result) {
         result->input_size = input_size;
         result->output_size = std::filesystem::file_size(output_path);
         result->total_chunks = num_chunks;
         result->total_packets = total_packets;
         result->total_frames = static_cast<uint64_t>(total_frames);
+        set_file_digest(result, file_digest.root);
+        result->verified_chunks = verified_chunks;
+        result->cache_hit = 0;
+        result->cached_chunks = cached_chunks;
+        std::memcpy(result->file_id, file_id.data(), sizeof(result->file_id));
+    }
+
+    if (verify_status == MS_OK) {
+        catalog_encode(*options, info, file_digest.root,
+                       {CatalogVideo{output_path, 0, 0, static_cast<uint32_t>(num_chunks)}}, std::move(chunk_frames));
+    }
+    return verify_status;
+}
+
+ms_status_t ms_shard_path(const char *output_path, const uint32_t shard_index, char *buffer,
+                          const size_t buffer_size) {
+    if (!output_path || !buffer) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    const std::string path = shard_path(output_path, shard_index);
+    if (path.size() + 1 > buffer_size) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    std::memcpy(buffer, path.c_str(), path.size() + 1);
+    return MS_OK;
+}
+
+// The chunk cache as one ms_decode call sees it. Chunks it already holds are
+// looked up once FileInfo names the archive; their packets are then skipped
+// and their plaintext written as is. Chunks that are decoded go into the cache
+// as they are written, as many as it can hold.
+struct DecodeCache {
+    bool started = false;
+    bool enabled = false;
+    std::array<std::byte, 16> file_id{};
+    uint64_t key_tag = 0;
+    std::size_t budget = 0;
+    Decoder::SuppliedChunks chunks;
+    uint32_t hits = 0;
+
+    [[nodiscard]] bool holds(const uint32_t chunk_index) const {
+        return chunk_index < chunks.size() && chunks[chunk_index].has_value();
+    }
+};
+
+static void start_decode_cache(DecodeCache &cache, const std::array<std::byte, 16> &file_id,
+                               const uint64_t key_tag) {
+    const ChunkCache &shared = ChunkCache::shared();
+    cache.started = true;
+    cache.enabled = shared.enabled() && has_unique_file_id(file_id);
+    cache.file_id = file_id;
+    cache.key_tag = key_tag;
+    cache.budget = cache.enabled ? shared.capacity() : 0;
+}
+
+// Digest the chunk table holds for a chunk whose plaintext is cached: that of
+// the plaintext itself, or of the ciphertext the key and file id fix it to.
+static Sha256Digest stored_chunk_digest(const std::span<const std::byte> plaintext, const bool encrypted,
+                                        const std::array<std::byte, CRYPTO_KEY_BYTES> &key,
+                                        const std::array<std::byte, 16> &file_id, const uint32_t chunk_index) {
+    if (!encrypted) {
+        return sha256(plaintext);
+    }
+    return sha256(encrypt_chunk(plaintext, key, file_id, chunk_index));
+}
+
+// Takes every chunk of [0, chunk_count) the decoder has not decoded yet from
+// the cache, if it has it.
+static void take_cached_chunks(DecodeCache &cache, const Decoder &decoder, const uint32_t chunk_count) {
+    if (!cache.enabled) {
+        return;
+    }
+    ChunkCache &shared = ChunkCache::shared();
+    cache.chunks.resize(chunk_count);
+    for (uint32_t i = 0; i < chunk_count; ++i) {
+        if (!decoder.is_chunk_complete(i)) {
+            cache.chunks[i] = shared.get(ChunkCacheKey{cache.file_id, cache.key_tag, i});
+            cache.hits += cache.chunks[i] ? 1 : 0;
+        }
+    }
+}
+
+// Best effort: the first chunk that does not fit in what is left ends it.
+// Only chunks the chunk table vouched for are cached; check_file_digest has
+// compared their decoded digests with it by the time they are written.
+static void cache_written_chunk(DecodeCache &cache, const ArchiveManifest &manifest, const uint32_t chunk_index,
+                                const std::span<const std::byte> plaintext) {
+    if (!manifest.chunk_digest(chunk_index)) {
+        return;
+    }
+    if (!cache.enabled || plaintext.size() > cache.budget) {
+        cache.enabled = false;
+        return;
     }
+    cache.budget -= plaintext.size();
+    try {
+        ChunkCache::shared().put(ChunkCacheKey{cache.file_id, cache.key_tag, chunk_index},
+                                 std::vector<std::byte>(plaintext.begin(), plaintext.end()));
+    } catch (...) {
+        cache.enabled = false;
+    }
+}
 
+// Cached chunks are not decoded again; their digests are taken from the cached
+// bytes and checked against the chunk table instead. An entry that disagrees
+// is dropped from the cache, so the next decode reads the chunk from the video.
+static ms_status_t verify_cached_chunks(const DecodeCache &cache, const ArchiveManifest &manifest,
+                                        const bool encrypted, const std::array<std::byte, CRYPTO_KEY_BYTES> &key,
+                                        std::vector<Sha256Digest> &chunk_digests) {
+    if (cache.hits == 0) {
+        return MS_OK;
+    }
+    if (chunk_digests.size() < cache.chunks.size()) {
+        chunk_digests.resize(cache.chunks.size());
+    }
+    for (uint32_t i = 0; i < cache.chunks.size(); ++i) {
+        if (!cache.holds(i)) {
+            continue;
+        }
+        const auto stored = manifest.chunk_digest(i);
+        if (!stored) {
+            return MS_ERR_INCOMPLETE;
+        }
+        chunk_digests[i] = stored_chunk_digest(*cache.chunks[i], encrypted, key, cache.file_id, i);
+        if (chunk_digests[i] != *stored) {
+            ChunkCache::shared().erase(ChunkCacheKey{cache.file_id, cache.key_tag, i});
+            return MS_ERR_INTEGRITY;
+        }
+    }
     return MS_OK;
 }
 
 ms_status_t ms_decode(const ms_decode_options_t *options, ms_result_t *result) {
-    if (!options || !options->input_path || !options->output_path) {
+    if (!options || (!options->input_path && options->input_count == 0) || !options->output_path ||
+        (options->input_count > 0 && !options->input_paths) || options->decoder_threads < 0) {
         return MS_ERR_INVALID_ARGS;
     }
 
-    const std::string input_path(options->input_path);
+    std::vector<std::string> input_paths;
+    if (options->input_count > 0) {
+        for (std::size_t i = 0; i < options->input_count; ++i) {
+            if (!options->input_paths[i]) {
+                return MS_ERR_INVALID_ARGS;
+            }
+            input_paths.emplace_back(options->input_paths[i]);
+        }
+    } else {
+        input_paths.emplace_back(options->input_path);
+    }
     const std::string output_path(options->output_path);
 
-    if (!std::filesystem::exists(input_path)) {
-        return MS_ERR_FILE_NOT_FOUND;
+    for (const auto &input_path: input_paths) {
+        if (!std::filesystem::exists(input_path)) {
+            return MS_ERR_FILE_NOT_FOUND;
+        }
     }
 
-    const auto video_size = std::filesystem::file_size(input_path);
-
     Decoder decoder;
     std::size_t total_extracted = 0;
     std::size_t decoded_chunks = 0;
@@ -191,305 +950,2073 @@ ms_status_t ms_decode(const ms_decode_options_t *options, ms_result_t *result) {
     bool found_last_chunk = false;
     uint32_t last_chunk_index = 0;
     int64_t total_frames_read = 0;
+    std::vector<Sha256Digest> chunk_digests;
+    DecodeCache cache;
+    std::array<std::byte, CRYPTO_KEY_BYTES> key{};
+    bool have_key = false;
+    const auto fail = [&](const ms_status_t status) {
+        secure_zero(std::span<std::byte>(key));
+        return status;
+    };
+    // Cached chunks need the chunk table that vouches for them as well.
+    const auto finished = [&] {
+        return decode_complete(decoder.manifest(), decoded_chunks, found_last_chunk, last_chunk_index) &&
+               (cache.hits == 0 || decoder.manifest().has_chunk_digests());
+    };
 
     try {
-        VideoDecoder video_decoder(input_path);
-        const int64_t total = video_decoder.total_frames();
-
-        while (!video_decoder.is_eof()) {
-            if (found_last_chunk && decoded_chunks >= last_chunk_index + 1)
-                break;
+        decoder.set_limits(to_internal_limits(options->limits));
+        if (options->memory_budget > 0) {
+            decoder.set_memory_budget(options->memory_budget, options->spill_dir ? options->spill_dir : "");
+        }
 
+        VideoDecoderOptions video_options;
+        video_options.use_raw_packet_track = !options->ignore_raw_packet_track;
+        video_options.decoder_threads = options->decoder_threads;
+        video_options.adaptive_threads = options->adaptive_threads != 0;
+        const VideoDecoder *following = nullptr;
+        bool cancelled = false;
+        if (options->follow) {
+            video_options.follow = true;
+            if (options->follow_idle_timeout_sec > 0) {
+                video_options.follow_idle_timeout_ms = options->follow_idle_timeout_sec * 1000;
+            }
+            // The progress callback is the cancel path; keep asking it while
+            // the reader waits for the recording to grow.
             if (options->progress) {
-                const auto cur = static_cast<uint64_t>(video_decoder.frames_read());
-                if (const uint64_t tot = total >= 0 ? static_cast<uint64_t>(total) : 0; options->progress(cur, tot, options->progress_user) != 0) {
-                    return MS_ERR_DECODE_FAILED;
-                }
+                video_options.follow_wait = [&] {
+                    const int64_t read = following ? following->frames_read() : 0;
+                    cancelled = options->progress(static_cast<uint64_t>(total_frames_read + read), 0,
+                                                  options->progress_user) != 0;
+                    return !cancelled;
+                };
             }
+        }
 
-            auto frame_packets = video_decoder.decode_next_frame();
-            if (frame_packets.empty()) continue;
+        for (const auto &input_path: input_paths) {
+            if (finished())
+                break;
 
-            for (auto &pkt_data : frame_packets) {
-                ++total_extracted;
+            VideoDecoder video_decoder(input_path, video_options);
+            following = &video_decoder;
+            const int64_t total = video_decoder.total_frames();
 
-                if (pkt_data.size() >= HEADER_SIZE &&
-                    Decoder::validate_raw_packet_crc(
-                        std::span<const std::byte>(pkt_data.data(), pkt_data.size()))) {
-                    const auto flags = static_cast<uint8_t>(pkt_data[FLAGS_OFF]);
-                    uint32_t chunk_idx = 0;
-                    std::memcpy(&chunk_idx, pkt_data.data() + CHUNK_INDEX_OFF,
-                                sizeof(chunk_idx));
-                    if (chunk_idx > max_chunk_index) max_chunk_index = chunk_idx;
-                    if (flags & LastChunk) {
-                        found_last_chunk = true;
-                        last_chunk_index = chunk_idx;
+            while (!video_decoder.is_eof()) {
+                if (finished())
+                    break;
+
+                if (options->progress) {
+                    const auto cur = static_cast<uint64_t>(total_frames_read + video_decoder.frames_read());
+                    if (const uint64_t tot = total >= 0 ? static_cast<uint64_t>(total_frames_read + total) : 0; options->progress(cur, tot, options->progress_user) != 0) {
+                        return fail(MS_ERR_DECODE_FAILED);
                     }
                 }
 
-                const std::span<const std::byte> data(pkt_data.data(), pkt_data.size());
-                if (auto res = decoder.process_packet(data, false);
-                    res && res->success) {
-                    ++decoded_chunks;
+                auto frame_packets = video_decoder.decode_next_frame();
+                if (frame_packets.empty()) continue;
+
+                for (auto &pkt_data : frame_packets) {
+                    ++total_extracted;
+
+                    if (pkt_data.size() >= HEADER_SIZE &&
+                        Decoder::validate_raw_packet_crc(
+                            std::span<const std::byte>(pkt_data.data(), pkt_data.size()))) {
+                        const auto flags = static_cast<uint8_t>(pkt_data[FLAGS_OFF]);
+                        uint32_t chunk_idx = 0;
+                        std::memcpy(&chunk_idx, pkt_data.data() + CHUNK_INDEX_OFF,
+                                    sizeof(chunk_idx));
+                        if (!(flags & Manifest)) {
+                            if (chunk_idx > max_chunk_index) max_chunk_index = chunk_idx;
+                            if (flags & LastChunk) {
+                                found_last_chunk = true;
+                                last_chunk_index = chunk_idx;
+                            }
+                            if (cache.holds(chunk_idx)) {
+                                continue;
+                            }
+                        }
+                    }
+
+                    const std::span<const std::byte> data(pkt_data.data(), pkt_data.size());
+                    if (auto res = decoder.process_packet(data, true);
+                        res && res->success && !cache.holds(res->chunk_index)) {
+                        ++decoded_chunks;
+                        if (chunk_digests.size() <= res->chunk_index) {
+                            chunk_digests.resize(static_cast<std::size_t>(res->chunk_index) + 1);
+                        }
+                        chunk_digests[res->chunk_index] = res->sha256;
+                    }
+
+                    // Plaintext of an encrypted archive is cached under its
+                    // key, so the key is needed before anything is looked up.
+                    if (const auto &info = decoder.manifest().file_info(); !cache.started && info) {
+                        if (info->encrypted && options->password && options->password_len > 0) {
+                            key = derive_key(std::span(reinterpret_cast<const std::byte *>(options->password),
+                                                       options->password_len), info->file_id);
+                            have_key = true;
+                        }
+                        start_decode_cache(cache, info->file_id, have_key ? ChunkCache::key_tag(key) : 0);
+                        if (info->encrypted && !have_key) {
+                            cache.enabled = false;
+                        }
+                        take_cached_chunks(cache, decoder, info->chunk_count);
+                        decoded_chunks += cache.hits;
+                    }
                 }
             }
-        }
 
-        total_frames_read = video_decoder.frames_read();
+            following = nullptr;
+            if (cancelled) {
+                return fail(MS_ERR_DECODE_FAILED);
+            }
+            total_frames_read += video_decoder.frames_read();
+        }
     } catch (...) {
-        return MS_ERR_DECODE_FAILED;
+        return fail(MS_ERR_DECODE_FAILED);
     }
 
     if (total_extracted == 0) {
-        return MS_ERR_DECODE_FAILED;
+        return fail(MS_ERR_DECODE_FAILED);
     }
 
-    const uint32_t expected_chunks = found_last_chunk
+    const auto &file_info = decoder.manifest().file_info();
+    const uint32_t expected_chunks = file_info
+        ? file_info->chunk_count
+        : found_last_chunk
         ? last_chunk_index + 1
         : max_chunk_index + 1;
 
     if (decoded_chunks < expected_chunks) {
-        return MS_ERR_INCOMPLETE;
+        return fail(MS_ERR_INCOMPLETE);
+    }
+    if (const ms_status_t status = verify_cached_chunks(cache, decoder.manifest(), file_info && file_info->encrypted,
+                                                        key, chunk_digests);
+        status != MS_OK) {
+        return fail(status);
+    }
+
+    Sha256Digest file_digest;
+    if (!check_file_digest(decoder.manifest(), chunk_digests, expected_chunks, file_digest)) {
+        return fail(MS_ERR_INTEGRITY);
     }
 
     if (decoder.is_encrypted()) {
         if (!options->password || options->password_len == 0) {
-            return MS_ERR_CRYPTO;
+            return fail(MS_ERR_CRYPTO);
+        }
+        if (!have_key) {
+            const std::span<const std::byte> pw(
+                reinterpret_cast<const std::byte *>(options->password),
+                options->password_len);
+            key = derive_key(pw, *decoder.file_id());
+            have_key = true;
         }
-        const std::span<const std::byte> pw(
-            reinterpret_cast<const std::byte *>(options->password),
-            options->password_len);
-        auto key = derive_key(pw, *decoder.file_id());
         decoder.set_decrypt_key(key);
-        secure_zero(std::span<std::byte>(key));
     }
-
-    if (!decoder.write_assembled_file(output_path, expected_chunks)) {
-        if (decoder.is_encrypted()) decoder.clear_decrypt_key();
-        return MS_ERR_DECODE_FAILED;
+    if (!cache.started && decoder.file_id()) {
+        start_decode_cache(cache, *decoder.file_id(), have_key ? ChunkCache::key_tag(key) : 0);
     }
 
+    const bool written = decoder.write_assembled_file(
+        output_path, expected_chunks, cache.chunks,
+        [&](const uint32_t chunk_index, const std::span<const std::byte> plaintext) {
+            cache_written_chunk(cache, decoder.manifest(), chunk_index, plaintext);
+        });
     if (decoder.is_encrypted()) decoder.clear_decrypt_key();
+    secure_zero(std::span<std::byte>(key));
+    if (!written) {
+        return MS_ERR_DECODE_FAILED;
+    }
 
     if (result) {
-        result->input_size = video_size;
+        result->input_size = 0;
+        for (const auto &input_path: input_paths) {
+            result->input_size += std::filesystem::file_size(input_path);
+        }
         result->output_size = std::filesystem::file_size(output_path);
         result->total_chunks = expected_chunks;
         result->total_packets = total_extracted;
         result->total_frames = static_cast<uint64_t>(total_frames_read);
+        set_file_digest(result, file_digest);
+        result->file_digest_verified = decoder.manifest().file_digest() ? 1 : 0;
     }
 
     return MS_OK;
 }
 
-ms_status_t ms_stream_encode(const ms_stream_encode_options_t *options, ms_result_t *result) {
-    if (!options || !options->input_path || !options->stream_url) {
+// Chunks of one ms_read_range call: those overlapping the range, filled from
+// the chunk cache first and then from the video.
+struct RangeRead {
+    FileInfo info;
+    uint64_t end = 0; // one past the last byte to copy
+    uint32_t first_chunk = 0;
+    std::vector<std::optional<std::vector<std::byte> > > chunks;
+    std::size_t pending = 0;
+    std::array<std::byte, CRYPTO_KEY_BYTES> key{};
+    uint64_t key_tag = 0;
+    bool use_cache = false;
+    std::vector<char> from_cache;
+};
+
+static ms_status_t start_range_read(const ms_read_range_options_t &options, const FileInfo &info, RangeRead &read) {
+    read.info = info;
+    if (info.chunk_size == 0 || options.offset >= info.file_size) {
+        return MS_OK;
+    }
+    read.end = options.offset + std::min<uint64_t>(options.length, info.file_size - options.offset);
+    if (read.end == options.offset) {
+        return MS_OK;
+    }
+    read.first_chunk = static_cast<uint32_t>(options.offset / info.chunk_size);
+    const auto last_chunk = static_cast<uint32_t>((read.end - 1) / info.chunk_size);
+    if (last_chunk >= info.chunk_count) {
+        return MS_ERR_DECODE_FAILED;
+    }
+
+    if (info.encrypted) {
+        if (!options.password || options.password_len == 0) {
+            return MS_ERR_CRYPTO;
+        }
+        const std::span pw(reinterpret_cast<const std::byte *>(options.password), options.password_len);
+        read.key = derive_key(pw, info.file_id);
+        read.key_tag = ChunkCache::key_tag(read.key);
+    }
+
+    ChunkCache &cache = ChunkCache::shared();
+    read.use_cache = cache.enabled() && has_unique_file_id(info.file_id);
+    read.chunks.resize(last_chunk - read.first_chunk + 1);
+    read.from_cache.assign(read.chunks.size(), 0);
+    for (std::size_t j = 0; j < read.chunks.size(); ++j) {
+        if (read.use_cache) {
+            read.chunks[j] = cache.get(
+                ChunkCacheKey{info.file_id, read.key_tag, read.first_chunk + static_cast<uint32_t>(j)});
+        }
+        if (read.chunks[j]) {
+            read.from_cache[j] = 1;
+        } else {
+            ++read.pending;
+        }
+    }
+    return MS_OK;
+}
+
+static bool wants_chunk(const RangeRead &read, const uint32_t chunk_index) {
+    return chunk_index >= read.first_chunk && chunk_index - read.first_chunk < read.chunks.size() &&
+           !read.chunks[chunk_index - read.first_chunk];
+}
+
+// MS_ERR_CRYPTO if the chunk does not decrypt, i.e. the password is wrong,
+// and MS_ERR_INTEGRITY if it disagrees with the chunk table. A range read stops long before the chunk table at the end of the video, so a chunk
+// is cached only if it has been checked some other way: against the table
+// when it happens to be known, or by decrypting, which authenticates it under
+// the key its cache entry is tagged with. Unencrypted chunks the table has
+// not vouched for are served but not cached.
+static ms_status_t finish_range_chunk(RangeRead &read, const ArchiveManifest &manifest, const uint32_t chunk_index,
+                                      std::vector<std::byte> data, const Sha256Digest &digest) {
+    const auto stored = manifest.chunk_digest(chunk_index);
+    if (stored && *stored != digest) {
+        return MS_ERR_INTEGRITY;
+    }
+    if (read.info.encrypted) {
+        try {
+            data = decrypt_chunk(data, read.key, read.info.file_id, chunk_index);
+        } catch (...) {
+            return MS_ERR_CRYPTO;
+        }
+    }
+    if (read.use_cache && (stored || read.info.encrypted)) {
+        ChunkCache::shared().put(ChunkCacheKey{read.info.file_id, read.key_tag, chunk_index}, data);
+    }
+    read.chunks[chunk_index - read.first_chunk] = std::move(data);
+    --read.pending;
+    return MS_OK;
+}
+
+// Cached chunks were checked when they were put in the cache; check them again
+// against the chunk table if the read got as far as it.
+static ms_status_t verify_range_hits(const RangeRead &read, const ArchiveManifest &manifest) {
+    for (std::size_t j = 0; j < read.chunks.size(); ++j) {
+        const auto chunk_index = read.first_chunk + static_cast<uint32_t>(j);
+        const auto stored = manifest.chunk_digest(chunk_index);
+        if (!read.from_cache[j] || !stored) {
+            continue;
+        }
+        if (stored_chunk_digest(*read.chunks[j], read.info.encrypted, read.key, read.info.file_id, chunk_index) !=
+            *stored) {
+            ChunkCache::shared().erase(ChunkCacheKey{read.info.file_id, read.key_tag, chunk_index});
+            return MS_ERR_INTEGRITY;
+        }
+    }
+    return MS_OK;
+}
+
+// Copies the overlap of every chunk with [offset, end) into the buffer.
+static bool copy_range(const RangeRead &read, const uint64_t offset, std::byte *buffer) {
+    for (std::size_t j = 0; j < read.chunks.size(); ++j) {
+        const uint64_t chunk_start = static_cast<uint64_t>(read.first_chunk + j) * read.info.chunk_size;
+        const std::vector<std::byte> &data = *read.chunks[j];
+        const uint64_t from = std::max(offset, chunk_start);
+        const uint64_t to = std::min(read.end, chunk_start + data.size());
+        if (to < std::min(read.end, chunk_start + read.info.chunk_size)) {
+            return false; // shorter than the file size says
+        }
+        std::memcpy(buffer + (from - offset), data.data() + (from - chunk_start), to - from);
+    }
+    return true;
+}
+
+// Frame to seek video_path to for the chunks the read still needs, from the
+// catalog's frame index: the earliest frame any of them starts in. -1 if the
+// video holds none of them, nullopt if the catalog does not index this video.
+static std::optional<int64_t> range_seek_frame(const CatalogEntry &entry, const std::string &video_path,
+                                               const RangeRead &read) {
+    const CatalogVideo *video = nullptr;
+    for (const CatalogVideo &candidate: entry.videos) {
+        std::error_code ec;
+        if (std::filesystem::equivalent(candidate.path, video_path, ec)) {
+            video = &candidate;
+            break;
+        }
+    }
+    if (!video) {
+        return std::nullopt;
+    }
+    int64_t frame = -1;
+    for (std::size_t j = 0; j < read.chunks.size(); ++j) {
+        const auto chunk_index = read.first_chunk + static_cast<uint32_t>(j);
+        if (!read.chunks[j] && entry.video_for_chunk(chunk_index) == video) {
+            const int64_t start = entry.chunk_frames[chunk_index];
+            frame = frame < 0 ? start : std::min(frame, start);
+        }
+    }
+    return frame;
+}
+
+ms_status_t ms_read_range(const ms_read_range_options_t *options, uint64_t *bytes_read) {
+    if (!options || (!options->input_path && options->input_count == 0) ||
+        (options->input_count > 0 && !options->input_paths) || (options->length > 0 && !options->buffer)) {
         return MS_ERR_INVALID_ARGS;
     }
-    if (options->encrypt && (!options->password || options->password_len == 0)) {
+    if (bytes_read) {
+        *bytes_read = 0;
+    }
+
+    std::vector<std::string> input_paths;
+    if (options->input_count > 0) {
+        for (std::size_t i = 0; i < options->input_count; ++i) {
+            if (!options->input_paths[i]) {
+                return MS_ERR_INVALID_ARGS;
+            }
+            input_paths.emplace_back(options->input_paths[i]);
+        }
+    } else {
+        input_paths.emplace_back(options->input_path);
+    }
+    for (const auto &input_path: input_paths) {
+        if (!std::filesystem::exists(input_path)) {
+            return MS_ERR_FILE_NOT_FOUND;
+        }
+    }
+
+    // Chunks outside the range are never FEC-decoded; only their packets'
+    // headers are looked at.
+    Decoder decoder;
+    decoder.set_retain_chunk_data(false);
+    RangeRead read;
+    bool started = false;
+    std::optional<CatalogEntry> indexed;
+
+    try {
+        VideoDecoderOptions video_options;
+        video_options.use_raw_packet_track = !options->ignore_raw_packet_track;
+
+        for (const auto &input_path: input_paths) {
+            if (started && read.pending == 0) {
+                break;
+            }
+            VideoDecoder video_decoder(input_path, video_options);
+            bool seek_checked = false;
+            bool seeked = false;
+            while (!(started && read.pending == 0)) {
+                // With a frame index, jump past the chunks before the range
+                // once the FileInfo is known, and skip videos it rules out.
+                if (started && indexed && !seek_checked) {
+                    seek_checked = true;
+                    if (const auto frame = range_seek_frame(*indexed, input_path, read)) {
+                        if (*frame < 0) {
+                            break;
+                        }
+                        seeked = *frame > video_decoder.frames_read() && video_decoder.seek_to_frame(*frame);
+                    }
+                }
+                if (video_decoder.is_eof()) {
+                    // Chunks a seek overshot fall back to a full pass.
+                    if (!seeked || range_seek_frame(*indexed, input_path, read).value_or(-1) < 0 ||
+                        !video_decoder.seek_to_frame(0)) {
+                        break;
+                    }
+                    seeked = false;
+                }
+                for (const auto &pkt_data: video_decoder.decode_next_frame()) {
+                    const std::span<const std::byte> data(pkt_data.data(), pkt_data.size());
+                    if (started) {
+                        if (pkt_data.size() < HEADER_SIZE || !Decoder::validate_raw_packet_crc(data)) {
+                            continue;
+                        }
+                        uint32_t chunk_index = 0;
+                        std::memcpy(&chunk_index, pkt_data.data() + CHUNK_INDEX_OFF, sizeof(chunk_index));
+                        if ((static_cast<uint8_t>(pkt_data[FLAGS_OFF]) & Manifest) ||
+                            !wants_chunk(read, chunk_index)) {
+                            continue;
+                        }
+                    }
+                    auto res = decoder.process_packet(data, false);
+                    if (res && res->success && started && wants_chunk(read, res->chunk_index)) {
+                        if (const ms_status_t status = finish_range_chunk(read, decoder.manifest(), res->chunk_index,
+                                                                          std::move(res->data), res->sha256);
+                            status != MS_OK) {
+                            secure_zero(std::span<std::byte>(read.key));
+                            return status;
+                        }
+                    }
+                    if (!started && decoder.manifest().file_info()) {
+                        if (const ms_status_t status = start_range_read(*options, *decoder.manifest().file_info(),
+                                                                        read); status != MS_OK) {
+                            secure_zero(std::span<std::byte>(read.key));
+                            return status;
+                        }
+                        started = true;
+                        if (options->catalog_path) {
+                            (void) with_catalog(options->catalog_path, [&](const Catalog &catalog) {
+                                indexed = catalog.find(read.info.file_id);
+                                return MS_OK;
+                            });
+                            if (indexed && (indexed->chunk_frames.size() != read.info.chunk_count ||
+                                            indexed->chunk_count != read.info.chunk_count)) {
+                                indexed.reset();
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    } catch (...) {
+        secure_zero(std::span<std::byte>(read.key));
+        return MS_ERR_DECODE_FAILED;
+    }
+    const ms_status_t cache_status = started ? verify_range_hits(read, decoder.manifest()) : MS_OK;
+    secure_zero(std::span<std::byte>(read.key));
+    if (cache_status != MS_OK) {
+        return cache_status;
+    }
+
+    if (!started) {
+        return MS_ERR_DECODE_FAILED;
+    }
+    if (read.pending > 0) {
+        return MS_ERR_INCOMPLETE;
+    }
+    if (read.chunks.empty()) {
+        return MS_OK;
+    }
+    if (!copy_range(read, options->offset, static_cast<std::byte *>(options->buffer))) {
+        return MS_ERR_DECODE_FAILED;
+    }
+    if (bytes_read) {
+        *bytes_read = read.end - options->offset;
+    }
+    return MS_OK;
+}
+
+ms_status_t ms_chunk_cache_configure(const ms_chunk_cache_options_t *options) {
+    if (!options) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    try {
+        ChunkCache::shared().configure(options->memory_bytes, options->disk_dir ? options->disk_dir : "",
+                                       options->disk_bytes);
+    } catch (...) {
+        return MS_ERR_IO;
+    }
+    return MS_OK;
+}
+
+ms_status_t ms_chunk_cache_stats(ms_chunk_cache_stats_t *stats) {
+    if (!stats) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    const ChunkCacheStats internal = ChunkCache::shared().stats();
+    stats->memory_hits = internal.memory_hits;
+    stats->disk_hits = internal.disk_hits;
+    stats->misses = internal.misses;
+    stats->insertions = internal.insertions;
+    stats->evictions = internal.evictions;
+    stats->memory_bytes = internal.memory_bytes;
+    stats->disk_bytes = internal.disk_bytes;
+    const uint64_t hits = internal.memory_hits + internal.disk_hits;
+    const uint64_t lookups = hits + internal.misses;
+    stats->hit_rate = lookups > 0 ? static_cast<double>(hits) / static_cast<double>(lookups) : 0.0;
+    return MS_OK;
+}
+
+void ms_chunk_cache_clear(void) {
+    ChunkCache::shared().clear();
+}
+
+void ms_set_thread_count(const int threads) {
+    omp_set_num_threads(threads > 0 ? threads : omp_get_num_procs());
+}
+
+using PacketBatch = std::vector<std::vector<std::byte> >;
+
+struct VerifyShard {
+    Decoder decoder;
+    std::vector<std::pair<uint32_t, Sha256Digest> > digests;
+    std::exception_ptr error;
+};
+
+static int verify_worker_count(const int requested) {
+    if (requested > 0) {
+        return requested;
+    }
+    const auto hardware = static_cast<int>(std::thread::hardware_concurrency());
+    return std::clamp(hardware / 2, 1, 8);
+}
+
+static std::size_t margin_bucket(const ChunkMargin &margin) {
+    static constexpr double bounds[] = {0.05, 0.1, 0.25, 0.5, 1.0, 2.0, 4.0};
+    static_assert(std::size(bounds) + 1 == MS_VERIFY_MARGIN_BUCKETS);
+    const double ratio = margin.k > 0 ? static_cast<double>(margin.spare) / margin.k : 0.0;
+    std::size_t bucket = 0;
+    while (bucket < std::size(bounds) && ratio >= bounds[bucket]) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+ms_status_t ms_verify(const ms_verify_options_t *options, ms_verify_result_t *result) {
+    if (!options || !options->input_path) {
+        return MS_ERR_INVALID_ARGS;
+    }
+
+    const std::string input_path(options->input_path);
+    if (!std::filesystem::exists(input_path)) {
+        return MS_ERR_FILE_NOT_FOUND;
+    }
+
+    const int workers = verify_worker_count(options->threads);
+    const DecoderLimits limits = to_internal_limits(options->limits);
+
+    // Chunks are sharded by index so every worker owns its chunk decoders
+    // outright; the demuxing thread only routes packets and decodes the small
+    // manifest. Each worker keeps a 36-byte digest record per decoded chunk and
+    // nothing of the chunk itself.
+    std::vector<VerifyShard> shards(workers);
+    std::vector<std::unique_ptr<BoundedQueue<PacketBatch> > > queues;
+    Decoder manifest_decoder;
+    manifest_decoder.set_limits(limits);
+    for (auto &shard: shards) {
+        shard.decoder.set_limits(limits);
+        shard.decoder.set_retain_chunk_data(false);
+        queues.push_back(std::make_unique<BoundedQueue<PacketBatch> >(4));
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (int w = 0; w < workers; ++w) {
+        threads.emplace_back([&shard = shards[w], &queue = *queues[w]] {
+            try {
+                while (auto batch = queue.pop()) {
+                    for (const auto &pkt_data: *batch) {
+                        const std::span<const std::byte> data(pkt_data.data(), pkt_data.size());
+                        if (auto res = shard.decoder.process_packet(data, true); res && res->success) {
+                            shard.digests.emplace_back(res->chunk_index, res->sha256);
+                        }
+                    }
+                }
+            } catch (...) {
+                shard.error = std::current_exception();
+                queue.close();
+            }
+        });
+    }
+
+    std::size_t total_extracted = 0;
+    int64_t total_frames_read = 0;
+    bool failed = false;
+
+    try {
+        VideoDecoder video_decoder(input_path);
+        const int64_t total = video_decoder.total_frames();
+
+        while (!failed && !video_decoder.is_eof()) {
+            if (options->progress) {
+                const auto cur = static_cast<uint64_t>(video_decoder.frames_read());
+                if (const uint64_t tot = total >= 0 ? static_cast<uint64_t>(total) : 0; options->progress(cur, tot, options->progress_user) != 0) {
+                    failed = true;
+                    break;
+                }
+            }
+
+            auto frame_packets = video_decoder.decode_next_frame();
+            if (frame_packets.empty()) continue;
+
+            std::vector<PacketBatch> batches(workers);
+            for (auto &pkt_data: frame_packets) {
+                ++total_extracted;
+                if (pkt_data.size() < HEADER_SIZE) continue;
+
+                if (static_cast<uint8_t>(pkt_data[FLAGS_OFF]) & Manifest) {
+                    (void) manifest_decoder.process_packet(
+                        std::span<const std::byte>(pkt_data.data(), pkt_data.size()), false);
+                    continue;
+                }
+                uint32_t chunk_idx = 0;
+                std::memcpy(&chunk_idx, pkt_data.data() + CHUNK_INDEX_OFF, sizeof(chunk_idx));
+                batches[chunk_idx % workers].push_back(std::move(pkt_data));
+            }
+            for (int w = 0; w < workers; ++w) {
+                if (!batches[w].empty() && !queues[w]->push(std::move(batches[w]))) {
+                    failed = true;
+                }
+            }
+        }
+
+        total_frames_read = video_decoder.frames_read();
+    } catch (...) {
+        failed = true;
+    }
+
+    for (const auto &queue: queues) {
+        queue->close();
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    if (failed || total_extracted == 0 ||
+        std::any_of(shards.begin(), shards.end(), [](const VerifyShard &shard) { return shard.error != nullptr; })) {
+        return MS_ERR_DECODE_FAILED;
+    }
+
+    const ArchiveManifest &manifest = manifest_decoder.manifest();
+    uint32_t expected_chunks = 0;
+    if (manifest.file_info()) {
+        expected_chunks = manifest.file_info()->chunk_count;
+    } else {
+        for (const auto &shard: shards) {
+            expected_chunks = std::max(expected_chunks, shard.decoder.expected_chunk_count());
+        }
+        if (expected_chunks == 0) {
+            for (const auto &shard: shards) {
+                for (const uint32_t index: shard.decoder.completed_chunk_indices()) {
+                    expected_chunks = std::max(expected_chunks, index + 1);
+                }
+            }
+        }
+    }
+
+    bool has_digests = manifest.has_chunk_digests();
+
+    // A shard only owes the chunks its ShardInfo announces.
+    const auto &shard_ranges = manifest.shards();
+    if (!shard_ranges.empty()) {
+        expected_chunks = 0;
+        has_digests = true;
+        for (const auto &[index, shard]: shard_ranges) {
+            expected_chunks += shard.chunk_count;
+            has_digests = has_digests && manifest.has_chunk_digests(shard.first_chunk, shard.chunk_count);
+        }
+    }
+    const auto chunk_in_scope = [&](const uint32_t chunk_index) {
+        if (shard_ranges.empty()) {
+            return chunk_index < expected_chunks;
+        }
+        return std::any_of(shard_ranges.begin(), shard_ranges.end(), [chunk_index](const auto &entry) {
+            return chunk_index >= entry.second.first_chunk &&
+                   chunk_index - entry.second.first_chunk < entry.second.chunk_count;
+        });
+    };
+
+    ms_verify_result_t stats{};
+    stats.total_chunks = expected_chunks;
+    stats.has_manifest = has_digests ? 1 : 0;
+    stats.total_packets = total_extracted;
+    stats.total_frames = static_cast<uint64_t>(total_frames_read);
+    stats.min_spare_symbols = UINT64_MAX;
+
+    double ratio_sum = 0.0;
+    for (const auto &shard: shards) {
+        for (const auto &[chunk_index, digest]: shard.digests) {
+            if (!chunk_in_scope(chunk_index)) continue;
+            ++stats.recoverable_chunks;
+            if (has_digests) {
+                if (manifest.chunk_digest(chunk_index) == digest) {
+                    ++stats.verified_chunks;
+                } else {
+                    ++stats.hash_mismatches;
+                }
+            }
+
+            const ChunkMargin margin = *shard.decoder.chunk_margin(chunk_index);
+            ++stats.margin_histogram[margin_bucket(margin)];
+            ratio_sum += margin.k > 0 ? static_cast<double>(margin.spare) / margin.k : 0.0;
+            if (margin.spare < stats.min_spare_symbols) {
+                stats.min_spare_symbols = margin.spare;
+                stats.min_spare_chunk = chunk_index;
+            }
+        }
+    }
+    if (stats.recoverable_chunks > 0) {
+        stats.mean_spare_ratio = ratio_sum / static_cast<double>(stats.recoverable_chunks);
+    } else {
+        stats.min_spare_symbols = 0;
+    }
+
+    bool file_digest_mismatch = false;
+    if (manifest.file_digest() && stats.recoverable_chunks == expected_chunks) {
+        std::vector<Sha256Digest> chunk_digests(expected_chunks);
+        for (const auto &shard: shards) {
+            for (const auto &[chunk_index, digest]: shard.digests) {
+                if (chunk_index < expected_chunks) {
+                    chunk_digests[chunk_index] = digest;
+                }
+            }
+        }
+        Sha256Digest root;
+        file_digest_mismatch = !check_file_digest(manifest, chunk_digests, expected_chunks, root);
+        stats.file_digest_verified = file_digest_mismatch ? 0 : 1;
+    }
+
+    if (result) {
+        *result = stats;
+    }
+
+    if (stats.recoverable_chunks < expected_chunks) {
+        return MS_ERR_INCOMPLETE;
+    }
+    if (stats.hash_mismatches > 0 || file_digest_mismatch) {
+        return MS_ERR_INTEGRITY;
+    }
+    return MS_OK;
+}
+
+ms_status_t ms_refresh(const ms_refresh_options_t *options, ms_result_t *result) {
+    if (!options || !options->input_path || !options->output_path) {
         return MS_ERR_INVALID_ARGS;
     }
 
-    const std::string input_path(options->input_path);
-    const std::string stream_url(options->stream_url);
-
-    if (!std::filesystem::exists(input_path)) {
-        return MS_ERR_FILE_NOT_FOUND;
+    const std::string input_path(options->input_path);
+    const std::string output_path(options->output_path);
+
+    if (!std::filesystem::exists(input_path)) {
+        return MS_ERR_FILE_NOT_FOUND;
+    }
+
+    Decoder decoder;
+    decoder.set_limits(to_internal_limits(options->limits));
+    decoder.set_retain_chunk_data(false);
+    decoder.set_hand_off_codecs(true);
+
+    // The file id is kept: encryption nonces and keys are derived from it.
+    std::unique_ptr<Encoder> encoder;
+    HashAlgorithm hash_algo = HashAlgorithm::CRC32;
+    std::vector<Sha256Digest> digests;
+    bool wrote_file_info = false;
+    bool wrote_shard_info = false;
+    std::size_t total_packets = 0;
+    int64_t total_frames = 0;
+
+    const auto discard_output = [&output_path] {
+        std::error_code ec;
+        std::filesystem::remove(output_path, ec);
+    };
+
+    try {
+        VideoDecoder video_decoder(input_path);
+        VideoEncoderOptions video_options;
+        video_options.raw_packet_track = video_decoder.has_raw_packet_track();
+        video_options.audio_data_track = video_decoder.has_audio_data_track();
+        VideoEncoder video_encoder(output_path, FRAME_WIDTH, FRAME_HEIGHT, video_options);
+        const int64_t total = video_decoder.total_frames();
+
+        while (!video_decoder.is_eof()) {
+            if (options->progress) {
+                const auto cur = static_cast<uint64_t>(video_decoder.frames_read());
+                if (const uint64_t tot = total >= 0 ? static_cast<uint64_t>(total) : 0; options->progress(cur, tot, options->progress_user) != 0) {
+                    video_encoder.finalize();
+                    discard_output();
+                    return MS_ERR_DECODE_FAILED;
+                }
+            }
+
+            std::vector<ChunkDecodeResult> recovered;
+            for (const auto &pkt_data: video_decoder.decode_next_frame()) {
+                const std::span<const std::byte> data(pkt_data.data(), pkt_data.size());
+                if (auto res = decoder.process_packet(data, true); res && res->success) {
+                    recovered.push_back(std::move(*res));
+                }
+            }
+            if (recovered.empty()) continue;
+
+            if (!encoder) {
+                const auto &file_info = decoder.manifest().file_info();
+                hash_algo = file_info
+                                ? file_info->hash_algorithm
+                                : (recovered.front().codec.header().flags & UseXXHash)
+                                ? HashAlgorithm::XXHash32
+                                : HashAlgorithm::CRC32;
+                encoder = std::make_unique<Encoder>(*decoder.file_id(), hash_algo);
+                if (file_info) {
+                    FileInfo info = *file_info;
+                    info.frame_width = FRAME_WIDTH;
+                    info.frame_height = FRAME_HEIGHT;
+                    total_packets += encode_manifest(*encoder, MANIFEST_FILE_INFO_SEGMENT,
+                                                     {serialize_file_info(info)}, video_encoder);
+                    wrote_file_info = true;
+                    // A shard keeps its ShardInfo right behind the FileInfo.
+                    if (const auto &shards = decoder.manifest().shards(); shards.size() == 1) {
+                        const ShardInfo &shard = shards.begin()->second;
+                        total_packets += encode_manifest(*encoder, manifest_shard_segment(shard.shard_index, 0),
+                                                         {serialize_shard_info(shard)}, video_encoder);
+                        wrote_shard_info = true;
+                    }
+                }
+            }
+
+            std::vector<std::vector<Packet> > fresh(recovered.size());
+            bool batch_error = false;
+
+#pragma omp parallel for schedule(dynamic)
+            for (int j = 0; j < static_cast<int>(recovered.size()); ++j) {
+                if (batch_error) continue;
+                try {
+                    const RecoveredCodec &codec = recovered[j].codec;
+                    const PacketHeader &hdr = codec.header();
+                    fresh[j] = encoder->encode_recovered(codec.get(), hdr.chunk_index, hdr.chunk_size,
+                                                         hdr.original_size, hdr.k, (hdr.flags & LastChunk) != 0,
+                                                         (hdr.flags & Encrypted) != 0);
+                } catch (...) {
+                    batch_error = true;
+                }
+            }
+
+            if (batch_error) {
+                video_encoder.finalize();
+                discard_output();
+                return MS_ERR_ENCODE_FAILED;
+            }
+
+            for (std::size_t j = 0; j < recovered.size(); ++j) {
+                total_packets += fresh[j].size();
+                video_encoder.encode_packets(fresh[j]);
+                const uint32_t chunk_index = recovered[j].chunk_index;
+                if (digests.size() <= chunk_index) {
+                    digests.resize(static_cast<std::size_t>(chunk_index) + 1);
+                }
+                digests[chunk_index] = recovered[j].sha256;
+            }
+        }
+
+        const ArchiveManifest &manifest = decoder.manifest();
+        const auto &file_info = manifest.file_info();
+
+        // A shard only owes the chunks its ShardInfo announces; without that
+        // record there is no telling which range it was meant to hold.
+        std::optional<ShardInfo> shard;
+        if (file_info && file_info->shard_count != 0) {
+            if (manifest.shards().size() != 1) {
+                video_encoder.finalize();
+                discard_output();
+                return MS_ERR_INCOMPLETE;
+            }
+            shard = manifest.shards().begin()->second;
+        }
+
+        const uint32_t first_chunk = shard ? shard->first_chunk : 0;
+        uint32_t expected_chunks = shard
+                                       ? shard->chunk_count
+                                       : file_info
+                                       ? file_info->chunk_count
+                                       : decoder.expected_chunk_count();
+        if (expected_chunks == 0 && !shard) {
+            expected_chunks = static_cast<uint32_t>(digests.size());
+        }
+
+        const ChunkStateTable &table = decoder.chunk_table();
+        if (!encoder || table.complete_count() < expected_chunks ||
+            !table.range_complete(first_chunk, first_chunk + expected_chunks)) {
+            video_encoder.finalize();
+            discard_output();
+            return MS_ERR_INCOMPLETE;
+        }
+        digests.resize(static_cast<std::size_t>(first_chunk) + expected_chunks);
+
+        const bool has_digests = shard
+                                     ? manifest.has_chunk_digests(first_chunk, expected_chunks)
+                                     : manifest.has_chunk_digests();
+        if (has_digests) {
+            for (uint32_t i = first_chunk; i < first_chunk + expected_chunks; ++i) {
+                if (manifest.chunk_digest(i) != digests[i]) {
+                    video_encoder.finalize();
+                    discard_output();
+                    return MS_ERR_INTEGRITY;
+                }
+            }
+        }
+        Sha256Digest file_digest;
+        if (!shard && !check_file_digest(manifest, digests, expected_chunks, file_digest)) {
+            video_encoder.finalize();
+            discard_output();
+            return MS_ERR_INTEGRITY;
+        }
+
+        if (!wrote_file_info && file_info) {
+            // FileInfo only arrived after the first data chunk.
+            FileInfo info = *file_info;
+            info.frame_width = FRAME_WIDTH;
+            info.frame_height = FRAME_HEIGHT;
+            total_packets += encode_manifest(*encoder, MANIFEST_FILE_INFO_SEGMENT, {serialize_file_info(info)},
+                                             video_encoder);
+        } else if (!wrote_file_info) {
+            // No FileInfo survived ahead of the data; rebuild it from the
+            // chunks and append it with the table so probing still works
+            // after a full scan.
+            FileInfo info;
+            info.file_id = *decoder.file_id();
+            info.file_size = table.offsets(expected_chunks).back();
+            info.chunk_count = expected_chunks;
+            info.encrypted = decoder.is_encrypted();
+            info.chunk_size = static_cast<uint32_t>(info.encrypted ? CHUNK_SIZE_PLAIN_MAX_ENCRYPTED : CHUNK_SIZE_BYTES);
+            info.symbol_size = static_cast<uint16_t>(SYMBOL_SIZE_BYTES);
+            info.hash_algorithm = hash_algo;
+            info.frame_width = FRAME_WIDTH;
+            info.frame_height = FRAME_HEIGHT;
+            total_packets += encode_manifest(*encoder, MANIFEST_FILE_INFO_SEGMENT, {serialize_file_info(info)},
+                                             video_encoder);
+        }
+        if (shard) {
+            if (!wrote_shard_info) {
+                total_packets += encode_manifest(*encoder, manifest_shard_segment(shard->shard_index, 0),
+                                                 {serialize_shard_info(*shard)}, video_encoder);
+            }
+            const std::span<const Sha256Digest> shard_digests(digests.data() + first_chunk, expected_chunks);
+            total_packets += encode_manifest(*encoder, manifest_shard_segment(shard->shard_index, 1),
+                                             serialize_chunk_table(shard_digests, first_chunk), video_encoder);
+        } else {
+            total_packets += encode_manifest(*encoder, MANIFEST_FIRST_TABLE_SEGMENT, serialize_chunk_table(digests),
+                                             video_encoder);
+            total_packets += encode_manifest(*encoder, MANIFEST_FILE_DIGEST_SEGMENT,
+                                             {serialize_file_digest(FileDigest{expected_chunks, file_digest})},
+                                             video_encoder);
+        }
+
+        video_encoder.finalize();
+        total_frames = video_encoder.frames_written();
+
+        if (result) {
+            result->input_size = std::filesystem::file_size(input_path);
+            result->output_size = std::filesystem::file_size(output_path);
+            result->total_chunks = expected_chunks;
+            result->total_packets = total_packets;
+            result->total_frames = static_cast<uint64_t>(total_frames);
+            if (!shard) {
+                set_file_digest(result, file_digest);
+            }
+        }
+    } catch (...) {
+        discard_output();
+        return MS_ERR_DECODE_FAILED;
+    }
+
+    return MS_OK;
+}
+
+// FileInfo is the first thing written and fits in one frame; the extra frames
+// only give repair symbols a chance when the first one is damaged.
+static constexpr int PROBE_FRAME_LIMIT = 4;
+
+ms_status_t ms_probe(const char *input_path, ms_info_t *info) {
+    if (!input_path || !info) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    if (!std::filesystem::exists(input_path)) {
+        return MS_ERR_FILE_NOT_FOUND;
+    }
+
+    ms_info_t probed{};
+    probed.total_frames = -1;
+    Decoder decoder;
+    std::optional<PacketHeader> first_data;
+
+    // A shard writes its ShardInfo right behind the FileInfo.
+    const auto manifest_read = [&manifest = decoder.manifest()] {
+        return manifest.file_info() && (manifest.file_info()->shard_count == 0 || !manifest.shards().empty());
+    };
+
+    try {
+        VideoDecoder video_decoder(input_path);
+        probed.total_frames = video_decoder.total_frames();
+        probed.frame_width = static_cast<uint32_t>(video_decoder.frame_width());
+        probed.frame_height = static_cast<uint32_t>(video_decoder.frame_height());
+        probed.has_raw_packet_track = video_decoder.has_raw_packet_track() ? 1 : 0;
+        probed.has_audio_data_track = video_decoder.has_audio_data_track() ? 1 : 0;
+
+        while (!video_decoder.is_eof() && video_decoder.frames_read() < PROBE_FRAME_LIMIT && !manifest_read()) {
+            bool saw_manifest = false;
+            for (const auto &pkt_data: video_decoder.decode_next_frame()) {
+                const std::span<const std::byte> data(pkt_data.data(), pkt_data.size());
+                const auto parsed = Decoder::parse_packet(data);
+                if (!parsed || !Decoder::validate_packet_crc(*parsed)) continue;
+
+                if (parsed->header.flags & Manifest) {
+                    saw_manifest = true;
+                    (void) decoder.process_packet(*parsed, false);
+                } else if (!first_data) {
+                    first_data = parsed->header;
+                }
+            }
+            // Archives without a manifest start straight with chunk data.
+            if (first_data && !saw_manifest) break;
+        }
+    } catch (...) {
+        return MS_ERR_DECODE_FAILED;
+    }
+
+    if (const auto &file_info = decoder.manifest().file_info()) {
+        std::memcpy(probed.file_id, file_info->file_id.data(), sizeof(probed.file_id));
+        probed.encrypted = file_info->encrypted ? 1 : 0;
+        probed.hash_algorithm = file_info->hash_algorithm == HashAlgorithm::XXHash32 ? MS_HASH_XXHASH32 : MS_HASH_CRC32;
+        probed.file_size = file_info->file_size;
+        probed.chunk_count = file_info->chunk_count;
+        probed.chunk_size = file_info->chunk_size;
+        probed.symbol_size = file_info->symbol_size;
+        probed.has_manifest = 1;
+        probed.shard_count = file_info->shard_count;
+        if (!decoder.manifest().shards().empty()) {
+            const ShardInfo &shard = decoder.manifest().shards().begin()->second;
+            probed.shard_index = shard.shard_index;
+            probed.shard_first_chunk = shard.first_chunk;
+            probed.shard_chunk_count = shard.chunk_count;
+        }
+    } else if (first_data) {
+        std::memcpy(probed.file_id, first_data->file_id.data(), sizeof(probed.file_id));
+        probed.encrypted = (first_data->flags & Encrypted) ? 1 : 0;
+        probed.hash_algorithm = (first_data->flags & UseXXHash) ? MS_HASH_XXHASH32 : MS_HASH_CRC32;
+        probed.symbol_size = first_data->symbol_size;
+    } else {
+        return MS_ERR_DECODE_FAILED;
+    }
+
+    *info = probed;
+    return MS_OK;
+}
+
+static void to_catalog_entry(const CatalogEntry &entry, ms_catalog_entry_t &out) {
+    out = ms_catalog_entry_t{};
+    std::memcpy(out.file_id, entry.file_id.data(), sizeof(out.file_id));
+    const std::size_t name_size = std::min(entry.name.size(), sizeof(out.name) - 1);
+    std::memcpy(out.name, entry.name.data(), name_size);
+    out.file_size = entry.file_size;
+    out.chunk_count = entry.chunk_count;
+    out.encrypted = entry.encrypted ? 1 : 0;
+    out.has_file_digest = entry.has_digest ? 1 : 0;
+    std::memcpy(out.file_digest, entry.digest.bytes.data(), sizeof(out.file_digest));
+    out.video_count = static_cast<uint32_t>(entry.videos.size());
+    out.has_frame_index = entry.chunk_count > 0 && entry.chunk_frames.size() == entry.chunk_count ? 1 : 0;
+    out.recorded = entry.recorded;
+}
+
+static std::array<std::byte, 16> to_file_id(const uint8_t file_id[16]) {
+    std::array<std::byte, 16> id{};
+    std::memcpy(id.data(), file_id, id.size());
+    return id;
+}
+
+ms_status_t ms_catalog_default_path(char *buffer, const size_t buffer_size) {
+    if (!buffer) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    const std::string path = Catalog::default_path().string();
+    if (path.empty() || path.size() >= buffer_size) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    std::memcpy(buffer, path.c_str(), path.size() + 1);
+    return MS_OK;
+}
+
+ms_status_t ms_catalog_add(const char *catalog_path, const char *video_path, ms_info_t *info) {
+    if (!video_path) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    if (!std::filesystem::exists(video_path)) {
+        return MS_ERR_FILE_NOT_FOUND;
+    }
+    return with_catalog(catalog_path, [&](Catalog &catalog) {
+        ms_info_t probed{};
+        const ms_status_t status = catalog_probe(catalog, video_path, {}, nullptr, probed);
+        if (status == MS_OK && info) {
+            *info = probed;
+        }
+        return status;
+    });
+}
+
+ms_status_t ms_catalog_search(const char *catalog_path, const char *filter, ms_catalog_entry_t *entries,
+                              const size_t capacity, size_t *count) {
+    if (!count || (capacity > 0 && !entries)) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    return with_catalog(catalog_path, [&](const Catalog &catalog) {
+        const std::vector<CatalogEntry> found = catalog.search(filter ? filter : "");
+        for (std::size_t i = 0; i < found.size() && i < capacity; ++i) {
+            to_catalog_entry(found[i], entries[i]);
+        }
+        *count = found.size();
+        return MS_OK;
+    });
+}
+
+ms_status_t ms_catalog_find(const char *catalog_path, const uint8_t file_id[16], ms_catalog_entry_t *entry) {
+    if (!file_id || !entry) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    return with_catalog(catalog_path, [&](const Catalog &catalog) {
+        const auto found = catalog.find(to_file_id(file_id));
+        if (!found) {
+            return MS_ERR_FILE_NOT_FOUND;
+        }
+        to_catalog_entry(*found, *entry);
+        return MS_OK;
+    });
+}
+
+ms_status_t ms_catalog_video_path(const char *catalog_path, const uint8_t file_id[16], const uint32_t index,
+                                  char *buffer, const size_t buffer_size) {
+    if (!file_id || !buffer) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    return with_catalog(catalog_path, [&](const Catalog &catalog) {
+        const auto found = catalog.find(to_file_id(file_id));
+        if (!found || index >= found->videos.size()) {
+            return MS_ERR_FILE_NOT_FOUND;
+        }
+        const std::string &path = found->videos[index].path;
+        if (path.size() >= buffer_size) {
+            return MS_ERR_INVALID_ARGS;
+        }
+        std::memcpy(buffer, path.c_str(), path.size() + 1);
+        return MS_OK;
+    });
+}
+
+ms_status_t ms_catalog_remove(const char *catalog_path, const uint8_t file_id[16]) {
+    if (!file_id) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    return with_catalog(catalog_path, [&](Catalog &catalog) {
+        return catalog.remove(to_file_id(file_id)) ? MS_OK : MS_ERR_FILE_NOT_FOUND;
+    });
+}
+
+ms_status_t ms_catalog_prune(const char *catalog_path, size_t *removed) {
+    if (removed) {
+        *removed = 0;
+    }
+    return with_catalog(catalog_path, [&](Catalog &catalog) {
+        for (const CatalogEntry &entry: catalog.search()) {
+            const bool gone = std::ranges::none_of(entry.videos, [](const CatalogVideo &video) {
+                std::error_code ec;
+                return std::filesystem::exists(video.path, ec);
+            });
+            if (gone && catalog.remove(entry.file_id) && removed) {
+                ++*removed;
+            }
+        }
+        catalog.compact();
+        return MS_OK;
+    });
+}
+
+// One file's part of a live stream: FileInfo, every chunk, the chunk table
+// and the file digest, written into sink without finalizing it. Reading and
+// FEC encoding of the next batch overlap with writing the current one.
+using BatchResults = std::vector<std::pair<std::vector<Packet>, ChunkManifestEntry> >;
+
+// Reads, encrypts (when key is set) and FEC-encodes every chunk of reader in
+// batches of `threads` chunks. The next batch is encoded on its own thread
+// while consume takes the current one, so batches arrive in chunk order.
+// Returns false if progress asked to stop; throws on errors. Either way the
+// batch in flight has finished by the time it returns.
+static bool encode_chunk_batches(const FileChunkReader &reader, const Encoder &encoder,
+                                 const std::array<std::byte, CRYPTO_KEY_BYTES> *key, const int threads,
+                                 const std::function<bool(uint64_t, uint64_t)> &progress,
+                                 const std::function<void(std::size_t, BatchResults &)> &consume) {
+    const std::size_t num_chunks = reader.num_chunks();
+    const int batch_size = std::max(1, threads);
+
+    auto fec_encode_batch = [&](const std::size_t batch_start, const int batch_count) -> BatchResults {
+        // The batch runs on its own thread, which has not inherited the
+        // caller's thread count.
+        omp_set_num_threads(batch_size);
+        std::vector<std::vector<std::byte>> chunk_datas(batch_count);
+        for (int j = 0; j < batch_count; ++j) {
+            chunk_datas[j] = reader.read_chunk(batch_start + j);
+        }
+
+        BatchResults results(batch_count);
+        bool batch_error = false;
+
+#pragma omp parallel for schedule(dynamic)
+        for (int j = 0; j < batch_count; ++j) {
+            if (batch_error) continue;
+            try {
+                const std::size_t i = batch_start + j;
+                std::span<const std::byte> data_to_encode(chunk_datas[j]);
+                std::vector<std::byte> encrypted_buf;
+                if (key) {
+                    encrypted_buf = encrypt_chunk(
+                        data_to_encode, *key, encoder.file_id(),
+                        static_cast<uint32_t>(i));
+                    data_to_encode = encrypted_buf;
+                }
+                const bool is_last = (i == num_chunks - 1);
+                results[j] = encoder.encode_chunk(
+                    static_cast<uint32_t>(i), data_to_encode,
+                    is_last, key != nullptr);
+            } catch (...) {
+                batch_error = true;
+            }
+        }
+
+        if (batch_error) throw std::runtime_error("batch FEC encoding failed");
+        return results;
+    };
+
+    std::future<BatchResults> pending;
+    try {
+        const auto first_end = std::min(static_cast<std::size_t>(batch_size), num_chunks);
+        pending = std::async(std::launch::async, fec_encode_batch,
+                             static_cast<std::size_t>(0), static_cast<int>(first_end));
+
+        for (std::size_t batch_start = 0; batch_start < num_chunks;
+             batch_start += batch_size) {
+            if (progress && !progress(static_cast<uint64_t>(batch_start), static_cast<uint64_t>(num_chunks))) {
+                if (pending.valid()) pending.wait();
+                return false;
+            }
+
+            auto results = pending.get();
+
+            if (const std::size_t next_start = batch_start + batch_size; next_start < num_chunks) {
+                const auto next_end = std::min(
+                    next_start + static_cast<std::size_t>(batch_size), num_chunks);
+                const int next_count = static_cast<int>(next_end - next_start);
+                pending = std::async(std::launch::async,
+                                     fec_encode_batch, next_start, next_count);
+            }
+
+            consume(batch_start, results);
+        }
+    } catch (...) {
+        if (pending.valid()) pending.wait();
+        throw;
+    }
+    return true;
+}
+
+struct StreamFileJob {
+    std::string input_path;
+    bool encrypt = false;
+    std::span<const std::byte> password;
+    HashAlgorithm hash_algo = HashAlgorithm::CRC32;
+    int width = FRAME_WIDTH;
+    int height = FRAME_HEIGHT;
+    int threads = 0; // FEC threads, 0 = the caller's OpenMP setting
+    double repair_overhead = REPAIR_OVERHEAD;
+    std::optional<Encoder::FileId> file_id;
+    // Adaptive repair: sizes each chunk's share of repair_overhead and asks
+    // for re-sends. Null sends every packet.
+    RepairController *repair = nullptr;
+};
+
+// Returns false if progress asked to stop. Throws on errors.
+static bool stream_file(const StreamFileJob &job, PacketSink &sink,
+                        const std::function<bool(uint64_t, uint64_t)> &progress, ms_result_t &result) {
+    const FileChunkReader reader(job.input_path.c_str(), job.encrypt ? CHUNK_SIZE_PLAIN_MAX_ENCRYPTED : 0);
+    const std::size_t num_chunks = reader.num_chunks();
+
+    const auto file_id = job.file_id ? *job.file_id : make_file_id();
+    Encoder encoder(file_id, job.hash_algo);
+    encoder.set_repair_overhead(job.repair ? job.repair->options().max_overhead : job.repair_overhead);
+
+    std::array<std::byte, CRYPTO_KEY_BYTES> key{};
+    if (job.encrypt) {
+        key = derive_key(job.password, file_id);
+    }
+
+    std::size_t total_packets = 0;
+    std::vector<Sha256Digest> digests(num_chunks);
+    const int threads = job.threads > 0 ? job.threads : omp_get_max_threads();
+
+    // Re-sends re-read and re-encode the chunk rather than keep every chunk's
+    // repair tail in memory; encryption and FEC are deterministic, so the
+    // packets past first_packet are the ones the stream has not carried yet.
+    // A chunk whose content changed since is skipped. The prefetch thread owns
+    // reader, so re-sends read through a second one.
+    std::optional<FileChunkReader> resend_reader;
+    const auto send_resends = [&] {
+        for (const RepairResend &resend: job.repair->take_resends()) {
+            const uint32_t i = resend.chunk_index;
+            if (!resend_reader) {
+                resend_reader.emplace(job.input_path.c_str(), job.encrypt ? CHUNK_SIZE_PLAIN_MAX_ENCRYPTED : 0);
+            }
+            auto data = resend_reader->read_chunk(i);
+            if (job.encrypt) {
+                data = encrypt_chunk(data, key, file_id, i);
+            }
+            const auto [packets, entry] = encoder.encode_chunk(i, data, i == num_chunks - 1, job.encrypt);
+            if (entry.sha256 != digests[i] || resend.first_packet >= packets.size()) {
+                continue;
+            }
+            const std::size_t count = std::min(resend.packets, packets.size() - resend.first_packet);
+            sink.encode_packets(std::span<const Packet>(packets).subspan(resend.first_packet, count));
+            job.repair->resent(i, count);
+            total_packets += count;
+        }
+    };
+
+    const auto consume = [&](const std::size_t batch_start, BatchResults &results) {
+        for (std::size_t j = 0; j < results.size(); ++j) {
+            const auto &[packets, entry] = results[j];
+            digests[batch_start + j] = entry.sha256;
+            if (!job.repair) {
+                total_packets += packets.size();
+                sink.encode_packets(packets);
+                continue;
+            }
+            const double overhead = job.repair->overhead();
+            const std::size_t count = repair_prefix_length(entry.N, overhead, packets.size());
+            sink.encode_packets(std::span<const Packet>(packets).first(count));
+            job.repair->chunk_sent(static_cast<uint32_t>(batch_start + j), entry.N, count);
+            total_packets += count;
+            result.repair_overhead = overhead;
+        }
+        if (job.repair) {
+            send_resends();
+        }
+    };
+
+    bool finished = false;
+    try {
+        const FileInfo info = make_file_info(file_id, reader, job.encrypt, job.hash_algo, job.width, job.height);
+        total_packets += encode_manifest(encoder, MANIFEST_FILE_INFO_SEGMENT, {serialize_file_info(info)}, sink);
+        finished = encode_chunk_batches(reader, encoder, job.encrypt ? &key : nullptr, threads, progress, consume);
+    } catch (...) {
+        if (job.encrypt) secure_zero(std::span<std::byte>(key));
+        throw;
+    }
+    if (job.encrypt) secure_zero(std::span<std::byte>(key));
+    if (!finished) {
+        return false;
+    }
+
+    FileDigest file_digest;
+    total_packets += encode_manifest_tail(encoder, digests, sink, file_digest);
+
+    result.input_size = reader.file_size();
+    result.output_size = 0;
+    result.total_chunks = num_chunks;
+    result.total_packets = total_packets;
+    set_file_digest(&result, file_digest.root);
+    std::memcpy(result.file_id, file_id.data(), sizeof(result.file_id));
+    if (job.repair) {
+        result.resent_packets = job.repair->resent_packets();
+    } else {
+        result.repair_overhead = job.repair_overhead;
+    }
+    return true;
+}
+
+ms_status_t ms_stream_encode(const ms_stream_encode_options_t *options, ms_result_t *result) {
+    if (!options || !options->input_path || !options->stream_url) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    if (options->encrypt && (!options->password || options->password_len == 0)) {
+        return MS_ERR_INVALID_ARGS;
+    }
+
+    const std::string stream_url(options->stream_url);
+    if (!std::filesystem::exists(options->input_path)) {
+        return MS_ERR_FILE_NOT_FOUND;
+    }
+
+    StreamFileJob job;
+    job.input_path = options->input_path;
+    job.encrypt = options->encrypt != 0;
+    if (job.encrypt) {
+        job.password = std::span(reinterpret_cast<const std::byte *>(options->password), options->password_len);
+    }
+    job.hash_algo = to_internal_hash(options->hash_algorithm);
+    job.width = options->width > 0 ? options->width : FRAME_WIDTH;
+    job.height = options->height > 0 ? options->height : FRAME_HEIGHT;
+    const int bitrate = options->bitrate_kbps > 0 ? options->bitrate_kbps : 35000;
+
+    RepairControllerOptions repair_options;
+    if (options->min_repair_overhead > 0.0) repair_options.min_overhead = options->min_repair_overhead;
+    if (options->max_repair_overhead > 0.0) repair_options.max_overhead = options->max_repair_overhead;
+    if (repair_options.min_overhead > repair_options.max_overhead ||
+        repair_options.max_overhead > MAX_REPAIR_OVERHEAD) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    job.repair_overhead = repair_options.max_overhead;
+
+    std::function<bool(uint64_t, uint64_t)> progress;
+    if (options->progress) {
+        progress = [options](const uint64_t current, const uint64_t total) {
+            return options->progress(current, total, options->progress_user) == 0;
+        };
+    }
+
+    ms_result_t stats{};
+    std::optional<RepairController> repair;
+    std::unique_ptr<RepairFeedbackReceiver> feedback;
+    std::atomic<bool> listening{true};
+    std::thread listener;
+    // Reports for other files, e.g. a previous run still being monitored, are
+    // ignored by file id.
+    const auto stop_listener = [&] {
+        listening = false;
+        if (listener.joinable()) listener.join();
+    };
+
+    try {
+        if (options->feedback_socket) {
+            repair.emplace(repair_options);
+            feedback = std::make_unique<RepairFeedbackReceiver>(options->feedback_socket);
+            job.file_id = make_file_id();
+            job.repair = &*repair;
+            listener = std::thread([&] {
+                while (listening) {
+                    if (const auto report = feedback->receive(std::chrono::milliseconds(100));
+                        report && report->file_id == *job.file_id) {
+                        repair->report(report->chunk_index, report->received);
+                    }
+                }
+            });
+        }
+
+        StreamEncoder stream_encoder(stream_url, bitrate, job.width, job.height);
+        if (!stream_file(job, stream_encoder, progress, stats)) {
+            stop_listener();
+            return MS_ERR_ENCODE_FAILED;
+        }
+        stream_encoder.finalize();
+        stats.total_frames = static_cast<uint64_t>(stream_encoder.frames_written());
+        stop_listener();
+    } catch (const std::exception &e) {
+        stop_listener();
+        fprintf(stderr, "Stream encode error: %s\n", e.what());
+        return MS_ERR_ENCODE_FAILED;
+    } catch (...) {
+        stop_listener();
+        fprintf(stderr, "Stream encode error: unknown exception\n");
+        return MS_ERR_ENCODE_FAILED;
+    }
+
+    if (result) {
+        *result = stats;
+    }
+    return MS_OK;
+}
+
+// Packets a job may queue ahead of the stream: a couple of frames, so the
+// scheduler always has something to choose from without buffering a chunk.
+static constexpr std::size_t MUX_LANE_FRAMES = 4;
+
+ms_status_t ms_stream_encode_mux(const ms_stream_mux_options_t *options, ms_result_t *results) {
+    if (!options || !options->stream_url || options->job_count == 0 || !options->jobs) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    std::vector<StreamFileJob> jobs(options->job_count);
+    std::vector<double> weights(options->job_count);
+    for (std::size_t i = 0; i < options->job_count; ++i) {
+        const ms_stream_job_t &spec = options->jobs[i];
+        if (!spec.input_path || (spec.encrypt && (!spec.password || spec.password_len == 0)) ||
+            spec.weight < 0.0 || !std::isfinite(spec.weight)) {
+            return MS_ERR_INVALID_ARGS;
+        }
+        if (!std::filesystem::exists(spec.input_path)) {
+            return MS_ERR_FILE_NOT_FOUND;
+        }
+        jobs[i].input_path = spec.input_path;
+        jobs[i].encrypt = spec.encrypt != 0;
+        if (jobs[i].encrypt) {
+            jobs[i].password = std::span(reinterpret_cast<const std::byte *>(spec.password), spec.password_len);
+        }
+        jobs[i].hash_algo = to_internal_hash(options->hash_algorithm);
+        jobs[i].width = options->width > 0 ? options->width : FRAME_WIDTH;
+        jobs[i].height = options->height > 0 ? options->height : FRAME_HEIGHT;
+        jobs[i].threads = std::max(1, omp_get_max_threads() / static_cast<int>(options->job_count));
+        weights[i] = spec.weight > 0.0 ? spec.weight : 1.0;
+    }
+    const int bitrate = options->bitrate_kbps > 0 ? options->bitrate_kbps : 35000;
+
+    std::vector<ms_result_t> stats(jobs.size());
+    std::vector<std::atomic<uint64_t> > chunks_done(jobs.size());
+    std::vector<std::atomic<uint64_t> > chunks_total(jobs.size());
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> failed{false};
+    std::atomic<std::size_t> running{jobs.size()};
+
+    try {
+        StreamEncoder stream_encoder(options->stream_url, bitrate, jobs[0].width, jobs[0].height);
+        const auto packets_per_frame = static_cast<std::size_t>(StreamEncoder::packets_per_frame());
+        StreamMultiplexer mux(stream_encoder, packets_per_frame, packets_per_frame * MUX_LANE_FRAMES);
+        std::vector<std::unique_ptr<StreamMultiplexer::LaneSink> > lanes;
+        for (std::size_t i = 0; i < jobs.size(); ++i) {
+            lanes.push_back(std::make_unique<StreamMultiplexer::LaneSink>(mux, mux.add_lane(weights[i])));
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve(jobs.size());
+        for (std::size_t i = 0; i < jobs.size(); ++i) {
+            threads.emplace_back([&, i] {
+                const auto progress = [&](const uint64_t current, const uint64_t total) {
+                    chunks_done[i] = current;
+                    chunks_total[i] = total;
+                    return !cancelled;
+                };
+                try {
+                    if (stream_file(jobs[i], *lanes[i], progress, stats[i])) {
+                        chunks_done[i] = stats[i].total_chunks;
+                        lanes[i]->finalize();
+                    } else {
+                        mux.stop();
+                    }
+                } catch (...) {
+                    failed = true;
+                    mux.stop();
+                }
+                --running;
+            });
+        }
+
+        // The multiplexer feeds the stream on this thread; progress is polled
+        // from a helper so a stalled stream cannot hide a cancel.
+        std::thread reporter([&] {
+            while (options->progress && running > 0 && !cancelled) {
+                uint64_t done = 0;
+                uint64_t total = 0;
+                for (std::size_t i = 0; i < jobs.size(); ++i) {
+                    done += chunks_done[i];
+                    total += chunks_total[i];
+                }
+                if (options->progress(done, total, options->progress_user) != 0) {
+                    cancelled = true;
+                    mux.stop();
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        });
+
+        try {
+            mux.run();
+        } catch (...) {
+            failed = true;
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        reporter.join();
+
+        if (failed || cancelled) {
+            return MS_ERR_ENCODE_FAILED;
+        }
+        for (ms_result_t &job_stats: stats) {
+            job_stats.total_frames = static_cast<uint64_t>(stream_encoder.frames_written());
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Stream encode error: %s\n", e.what());
+        return MS_ERR_ENCODE_FAILED;
+    } catch (...) {
+        fprintf(stderr, "Stream encode error: unknown exception\n");
+        return MS_ERR_ENCODE_FAILED;
+    }
+
+    if (results) {
+        std::ranges::copy(stats, results);
+    }
+    return MS_OK;
+}
+
+static bool valid_sink(const ms_sink_t &sink) {
+    if (!sink.target || (sink.kind != MS_SINK_FILE && sink.kind != MS_SINK_STREAM)) {
+        return false;
+    }
+    if (sink.width < 0 || sink.height < 0 || sink.width % 8 != 0 || sink.height % 8 != 0 || sink.bitrate_kbps < 0) {
+        return false;
+    }
+    if (!(sink.repair_overhead >= 0.0 && sink.repair_overhead <= MAX_REPAIR_OVERHEAD)) {
+        return false;
+    }
+    const int width = sink.width > 0 ? sink.width : FRAME_WIDTH;
+    const int height = sink.height > 0 ? sink.height : FRAME_HEIGHT;
+    return static_cast<std::size_t>(compute_frame_layout(width, height).bytes_per_frame) >= PACKET_SIZE;
+}
+
+ms_status_t ms_encode_multi(const ms_encode_multi_options_t *options, ms_result_t *results) {
+    if (!options || !options->input_path || !options->sinks || options->sink_count == 0) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    if (options->encrypt && (!options->password || options->password_len == 0)) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    const std::span<const ms_sink_t> sink_options(options->sinks, options->sink_count);
+    if (!std::all_of(sink_options.begin(), sink_options.end(), valid_sink)) {
+        return MS_ERR_INVALID_ARGS;
+    }
+
+    const std::string input_path(options->input_path);
+
+    if (!std::filesystem::exists(input_path)) {
+        return MS_ERR_FILE_NOT_FOUND;
+    }
+
+    const auto input_size = std::filesystem::file_size(input_path);
+    const bool encrypt = options->encrypt != 0;
+    const std::size_t chunk_size = encrypt ? CHUNK_SIZE_PLAIN_MAX_ENCRYPTED : 0;
+    const FileChunkReader reader(input_path.c_str(), chunk_size);
+    const std::size_t num_chunks = reader.num_chunks();
+
+    const auto file_id = make_file_id();
+    const HashAlgorithm hash_algo = to_internal_hash(options->hash_algorithm);
+    Encoder encoder(file_id, hash_algo);
+
+    std::array<std::byte, CRYPTO_KEY_BYTES> key{};
+    if (encrypt) {
+        const std::span pw(reinterpret_cast<const std::byte *>(options->password),
+                           options->password_len);
+        key = derive_key(pw, file_id);
+    }
+
+    std::vector<std::unique_ptr<PacketSink> > sinks;
+    std::vector<int64_t> frames(sink_options.size(), 0);
+    std::vector<std::size_t> packets(sink_options.size(), 0);
+    std::vector<Sha256Digest> digests(num_chunks);
+    FileDigest file_digest;
+    bool finished = false;
+
+    try {
+        PacketFanOut fan_out;
+        for (const ms_sink_t &sink: sink_options) {
+            const int width = sink.width > 0 ? sink.width : FRAME_WIDTH;
+            const int height = sink.height > 0 ? sink.height : FRAME_HEIGHT;
+            if (sink.kind == MS_SINK_FILE) {
+                sinks.push_back(std::make_unique<VideoEncoder>(sink.target, width, height));
+            } else {
+                const int bitrate = sink.bitrate_kbps > 0 ? sink.bitrate_kbps : 35000;
+                sinks.push_back(std::make_unique<StreamEncoder>(sink.target, bitrate, width, height));
+            }
+            fan_out.add_sink(*sinks.back(), sink.repair_overhead > 0.0 ? sink.repair_overhead : REPAIR_OVERHEAD);
+
+            // Each sink announces its own frame geometry.
+            const FileInfo info = make_file_info(file_id, reader, encrypt, hash_algo, width, height);
+            fan_out.write_to(fan_out.size() - 1,
+                             encoder.encode_manifest_segment(MANIFEST_FILE_INFO_SEGMENT, serialize_file_info(info)));
+        }
+        encoder.set_repair_overhead(fan_out.max_repair_overhead());
+
+        std::function<bool(uint64_t, uint64_t)> progress;
+        if (options->progress) {
+            progress = [options](const uint64_t current, const uint64_t total) {
+                return options->progress(current, total, options->progress_user) == 0;
+            };
+        }
+        const auto consume = [&](const std::size_t batch_start, BatchResults &batch_results) {
+            for (std::size_t j = 0; j < batch_results.size(); ++j) {
+                fan_out.write_chunk(batch_results[j].first, batch_results[j].second.N);
+                digests[batch_start + j] = batch_results[j].second.sha256;
+            }
+        };
+        finished = encode_chunk_batches(reader, encoder, encrypt ? &key : nullptr, omp_get_max_threads(),
+                                        progress, consume);
+        if (finished) {
+            encode_manifest_tail(encoder, digests, fan_out, file_digest);
+            fan_out.finalize();
+            for (std::size_t i = 0; i < sinks.size(); ++i) {
+                frames[i] = sinks[i]->frames_written();
+                packets[i] = fan_out.packets_written(i);
+            }
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Multi-sink encode error: %s\n", e.what());
+        if (encrypt) secure_zero(std::span<std::byte>(key));
+        return MS_ERR_ENCODE_FAILED;
+    } catch (...) {
+        fprintf(stderr, "Multi-sink encode error: unknown exception\n");
+        if (encrypt) secure_zero(std::span<std::byte>(key));
+        return MS_ERR_ENCODE_FAILED;
+    }
+
+    if (encrypt) secure_zero(std::span<std::byte>(key));
+    if (!finished) {
+        return MS_ERR_ENCODE_FAILED;
+    }
+
+    if (results) {
+        for (std::size_t i = 0; i < sink_options.size(); ++i) {
+            ms_result_t &result = results[i];
+            result.input_size = input_size;
+            result.output_size = sink_options[i].kind == MS_SINK_FILE
+                                     ? std::filesystem::file_size(sink_options[i].target)
+                                     : 0;
+            result.total_chunks = num_chunks;
+            result.total_packets = packets[i];
+            result.total_frames = static_cast<uint64_t>(frames[i]);
+            set_file_digest(&result, file_digest.root);
+        }
+    }
+
+    return MS_OK;
+}
+
+// Decode state of one file received from a live stream.
+struct StreamFileDecode {
+    Decoder decoder;
+    std::size_t packets = 0;
+    std::size_t decoded_chunks = 0;
+    uint32_t max_chunk_index = 0;
+    bool found_last_chunk = false;
+    uint32_t last_chunk_index = 0;
+    std::vector<Sha256Digest> chunk_digests;
+
+    // header_ok: the packet's raw header CRC checked out, so its flags and
+    // chunk index can be trusted before decoding.
+    void feed(const std::span<const std::byte> data, const bool header_ok) {
+        ++packets;
+        if (header_ok) {
+            const auto flags = static_cast<uint8_t>(data[FLAGS_OFF]);
+            uint32_t chunk_idx = 0;
+            std::memcpy(&chunk_idx, data.data() + CHUNK_INDEX_OFF, sizeof(chunk_idx));
+            if (!(flags & Manifest)) {
+                if (chunk_idx > max_chunk_index) max_chunk_index = chunk_idx;
+                if (flags & LastChunk) {
+                    found_last_chunk = true;
+                    last_chunk_index = chunk_idx;
+                }
+            }
+        }
+
+        if (auto res = decoder.process_packet(data, true); res && res->success) {
+            ++decoded_chunks;
+            if (chunk_digests.size() <= res->chunk_index) {
+                chunk_digests.resize(static_cast<std::size_t>(res->chunk_index) + 1);
+            }
+            chunk_digests[res->chunk_index] = res->sha256;
+        }
+    }
+
+    [[nodiscard]] bool complete() const {
+        return decode_complete(decoder.manifest(), decoded_chunks, found_last_chunk, last_chunk_index);
     }
 
-    const auto input_size = std::filesystem::file_size(input_path);
-    const bool encrypt = options->encrypt != 0;
-    const std::size_t chunk_size = encrypt ? CHUNK_SIZE_PLAIN_MAX_ENCRYPTED : 0;
-    const FileChunkReader reader(input_path.c_str(), chunk_size);
-    const std::size_t num_chunks = reader.num_chunks();
+    // Verifies and writes the file. Fills everything in result but
+    // total_frames, which belongs to the stream.
+    ms_status_t finish(const std::string &output_path, const char *password, const size_t password_len,
+                       ms_result_t &result) {
+        if (packets == 0) {
+            return MS_ERR_DECODE_FAILED;
+        }
 
-    const auto file_id = make_file_id();
-    const Encoder encoder(file_id, to_internal_hash(options->hash_algorithm));
+        const auto &file_info = decoder.manifest().file_info();
+        const uint32_t expected_chunks = file_info
+            ? file_info->chunk_count
+            : found_last_chunk
+            ? last_chunk_index + 1
+            : max_chunk_index + 1;
 
-    std::array<std::byte, CRYPTO_KEY_BYTES> key{};
-    if (encrypt) {
-        const std::span pw(reinterpret_cast<const std::byte *>(options->password),
-                           options->password_len);
-        key = derive_key(pw, file_id);
+        if (decoded_chunks < expected_chunks) {
+            return MS_ERR_INCOMPLETE;
+        }
+
+        Sha256Digest file_digest;
+        if (!check_file_digest(decoder.manifest(), chunk_digests, expected_chunks, file_digest)) {
+            return MS_ERR_INTEGRITY;
+        }
+
+        if (decoder.is_encrypted()) {
+            if (!password || password_len == 0) {
+                return MS_ERR_CRYPTO;
+            }
+            const std::span<const std::byte> pw(reinterpret_cast<const std::byte *>(password), password_len);
+            auto key = derive_key(pw, *decoder.file_id());
+            decoder.set_decrypt_key(key);
+            secure_zero(std::span<std::byte>(key));
+        }
+
+        if (!decoder.write_assembled_file(output_path, expected_chunks)) {
+            if (decoder.is_encrypted()) decoder.clear_decrypt_key();
+            return MS_ERR_DECODE_FAILED;
+        }
+
+        if (decoder.is_encrypted()) decoder.clear_decrypt_key();
+
+        result.input_size = 0;
+        result.output_size = std::filesystem::file_size(output_path);
+        result.total_chunks = expected_chunks;
+        result.total_packets = packets;
+        set_file_digest(&result, file_digest);
+        result.file_digest_verified = decoder.manifest().file_digest() ? 1 : 0;
+        if (const auto id = decoder.file_id()) {
+            std::memcpy(result.file_id, id->data(), sizeof(result.file_id));
+        }
+        return MS_OK;
     }
+};
 
-    std::size_t total_packets = 0;
-    int64_t total_frames = 0;
-    const int bitrate = options->bitrate_kbps > 0 ? options->bitrate_kbps : 35000;
-    const int width = options->width > 0 ? options->width : FRAME_WIDTH;
-    const int height = options->height > 0 ? options->height : FRAME_HEIGHT;
+// File id of a raw packet whose header checks out; packets are routed by it
+// before they reach a decoder.
+static std::optional<Encoder::FileId> raw_packet_file_id(const std::span<const std::byte> data) {
+    if (data.size() < HEADER_SIZE || !Decoder::validate_raw_packet_crc(data)) {
+        return std::nullopt;
+    }
+    Encoder::FileId id{};
+    std::memcpy(id.data(), data.data() + FILE_ID_OFF, id.size());
+    return id;
+}
 
-    try {
-        StreamEncoder stream_encoder(stream_url, bitrate, width, height);
+// A stream may not be up yet when decoding starts; retry once a second.
+static std::unique_ptr<VideoDecoder> open_stream(const std::string &stream_url, const int timeout_sec) {
+    const int max_retries = timeout_sec > 0 ? timeout_sec : 30;
+    for (int attempt = 0;; ++attempt) {
+        try {
+            return std::make_unique<VideoDecoder>(stream_url);
+        } catch (...) {
+            if (attempt + 1 >= max_retries) throw;
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+    }
+}
 
-        const int batch_size = std::max(1, omp_get_max_threads());
+// Longest run of missing chunks a monitor reports as lost; a longer jump is
+// more likely a damaged index than a gap.
+static constexpr uint32_t MAX_REPORTED_GAP = 64;
 
-        using BatchResults = std::vector<std::pair<std::vector<Packet>, ChunkManifestEntry>>;
+ms_status_t ms_stream_decode(const ms_stream_decode_options_t *options, ms_result_t *result) {
+    if (!options || !options->stream_url || !options->output_path) {
+        return MS_ERR_INVALID_ARGS;
+    }
 
-        auto fec_encode_batch = [&](const std::size_t batch_start, const int batch_count) -> BatchResults {
-            std::vector<std::vector<std::byte>> chunk_datas(batch_count);
-            for (int j = 0; j < batch_count; ++j) {
-                chunk_datas[j] = reader.read_chunk(batch_start + j);
-            }
+    const std::string stream_url(options->stream_url);
+    const std::string output_path(options->output_path);
 
-            BatchResults results(batch_count);
-            bool batch_error = false;
+    StreamFileDecode file;
+    std::optional<Encoder::FileId> stream_id;
+    int64_t total_frames_read = 0;
 
-#pragma omp parallel for schedule(dynamic)
-            for (int j = 0; j < batch_count; ++j) {
-                if (batch_error) continue;
-                try {
-                    const std::size_t i = batch_start + j;
-                    std::span<const std::byte> data_to_encode(chunk_datas[j]);
-                    std::vector<std::byte> encrypted_buf;
-                    if (encrypt) {
-                        encrypted_buf = encrypt_chunk(
-                            data_to_encode, key, file_id,
-                            static_cast<uint32_t>(i));
-                        data_to_encode = encrypted_buf;
-                    }
-                    const bool is_last = (i == num_chunks - 1);
-                    results[j] = encoder.encode_chunk(
-                        static_cast<uint32_t>(i), data_to_encode,
-                        is_last, encrypt);
-                } catch (...) {
-                    batch_error = true;
-                }
-            }
+    // Monitor mode: intact packets per chunk, reported whenever the stream
+    // moves on to another chunk. A chunk that comes back with re-sent repair is
+    // reported again with its new total.
+    std::unique_ptr<RepairFeedbackSender> feedback;
+    std::unordered_map<uint32_t, std::size_t> chunk_packets;
+    std::optional<uint32_t> current_chunk;
+    const auto report_chunk = [&] {
+        if (feedback && current_chunk && stream_id) {
+            feedback->send(RepairReport{*stream_id, *current_chunk, chunk_packets[*current_chunk]});
+        }
+    };
+    if (options->feedback_socket) {
+        feedback = std::make_unique<RepairFeedbackSender>(options->feedback_socket);
+    }
 
-            if (batch_error) throw std::runtime_error("batch FEC encoding failed");
-            return results;
-        };
+    try {
+        file.decoder.set_limits(to_internal_limits(options->limits));
+        const auto vdec = open_stream(stream_url, options->timeout_sec);
 
-        const auto first_end = std::min(static_cast<std::size_t>(batch_size), num_chunks);
-        std::future<BatchResults> pending =
-            std::async(std::launch::async, fec_encode_batch,
-                       static_cast<std::size_t>(0), static_cast<int>(first_end));
+        const int64_t total = vdec->total_frames();
 
-        for (std::size_t batch_start = 0; batch_start < num_chunks;
-             batch_start += batch_size) {
-            const std::size_t batch_end =
-                std::min(batch_start + static_cast<std::size_t>(batch_size),
-                         num_chunks);
-            const int batch_count = static_cast<int>(batch_end - batch_start);
+        while (!vdec->is_eof()) {
+            if (file.complete())
+                break;
 
             if (options->progress) {
-                if (options->progress(static_cast<uint64_t>(batch_start),
-                                      static_cast<uint64_t>(num_chunks),
-                                      options->progress_user) != 0) {
-                    if (pending.valid()) pending.wait();
-                    if (encrypt) secure_zero(std::span<std::byte>(key));
-                    return MS_ERR_ENCODE_FAILED;
+                const auto cur = static_cast<uint64_t>(vdec->frames_read());
+                if (const uint64_t tot = total >= 0 ? static_cast<uint64_t>(total) : 0; options->progress(cur, tot, options->progress_user) != 0) {
+                    return MS_ERR_DECODE_FAILED;
                 }
             }
 
-            auto results = pending.get();
+            auto frame_packets = vdec->decode_next_frame();
+            if (frame_packets.empty()) continue;
 
-            if (const std::size_t next_start = batch_start + batch_size; next_start < num_chunks) {
-                const auto next_end = std::min(
-                    next_start + static_cast<std::size_t>(batch_size), num_chunks);
-                const int next_count = static_cast<int>(next_end - next_start);
-                pending = std::async(std::launch::async,
-                                     fec_encode_batch, next_start, next_count);
-            }
+            for (auto &pkt_data : frame_packets) {
+                const std::span<const std::byte> data(pkt_data.data(), pkt_data.size());
+                const auto id = raw_packet_file_id(data);
+                // A multiplexed stream carries several files; follow the first.
+                if (id) {
+                    if (!stream_id) {
+                        stream_id = id;
+                    } else if (*id != *stream_id) {
+                        continue;
+                    }
+                }
+                file.feed(data, id.has_value());
 
-            for (int j = 0; j < batch_count; ++j) {
-                total_packets += results[j].first.size();
-                stream_encoder.encode_packets(results[j].first);
+                if (feedback && id && !(static_cast<uint8_t>(data[FLAGS_OFF]) & Manifest)) {
+                    uint32_t chunk_idx = 0;
+                    std::memcpy(&chunk_idx, data.data() + CHUNK_INDEX_OFF, sizeof(chunk_idx));
+                    if (current_chunk != chunk_idx) {
+                        report_chunk();
+                        // Chunks skipped over lost every packet.
+                        if (current_chunk && chunk_idx > *current_chunk &&
+                            chunk_idx - *current_chunk <= MAX_REPORTED_GAP) {
+                            for (uint32_t c = *current_chunk + 1; c < chunk_idx; ++c) {
+                                if (!chunk_packets.contains(c)) {
+                                    feedback->send(RepairReport{*stream_id, c, 0});
+                                }
+                            }
+                        }
+                        current_chunk = chunk_idx;
+                    }
+                    ++chunk_packets[chunk_idx];
+                }
             }
         }
+        report_chunk();
 
-        stream_encoder.finalize();
-        total_frames = stream_encoder.frames_written();
+        total_frames_read = vdec->frames_read();
     } catch (const std::exception &e) {
-        fprintf(stderr, "Stream encode error: %s\n", e.what());
-        if (encrypt) secure_zero(std::span<std::byte>(key));
-        return MS_ERR_ENCODE_FAILED;
+        fprintf(stderr, "Stream decode error: %s\n", e.what());
+        return MS_ERR_DECODE_FAILED;
     } catch (...) {
-        fprintf(stderr, "Stream encode error: unknown exception\n");
-        if (encrypt) secure_zero(std::span<std::byte>(key));
-        return MS_ERR_ENCODE_FAILED;
+        fprintf(stderr, "Stream decode error: unknown exception\n");
+        return MS_ERR_DECODE_FAILED;
     }
 
-    if (encrypt) secure_zero(std::span<std::byte>(key));
-
+    ms_result_t stats{};
+    if (const ms_status_t status = file.finish(output_path, options->password, options->password_len, stats);
+        status != MS_OK) {
+        return status;
+    }
+    stats.total_frames = static_cast<uint64_t>(total_frames_read);
     if (result) {
-        result->input_size = input_size;
-        result->output_size = 0;
-        result->total_chunks = num_chunks;
-        result->total_packets = total_packets;
-        result->total_frames = static_cast<uint64_t>(total_frames);
+        *result = stats;
     }
-
     return MS_OK;
 }
 
-ms_status_t ms_stream_decode(const ms_stream_decode_options_t *options, ms_result_t *result) {
-    if (!options || !options->stream_url || !options->output_path) {
+// Files told apart in one stream. Packets of further file ids are dropped, so
+// a damaged stream cannot start a decoder per bogus id.
+static constexpr std::size_t MAX_DEMUX_FILES = 64;
+// Frames of packets a file's decoder may fall behind the stream reader.
+static constexpr std::size_t DEMUX_QUEUE_FRAMES = 16;
+
+namespace {
+    struct DemuxFile {
+        Encoder::FileId id{};
+        StreamFileDecode file;
+        BoundedQueue<PacketBatch> queue{DEMUX_QUEUE_FRAMES};
+        std::thread worker;
+        std::atomic<bool> done{false};
+        ms_status_t status = MS_ERR_INCOMPLETE;
+        ms_result_t result{};
+    };
+}
+
+ms_status_t ms_stream_decode_demux(const ms_stream_demux_options_t *options, ms_stream_demux_file_t *files,
+                                   const size_t capacity, size_t *file_count) {
+    if (!options || !options->stream_url || !options->output_dir || (capacity > 0 && !files)) {
         return MS_ERR_INVALID_ARGS;
     }
 
-    const std::string stream_url(options->stream_url);
-    const std::string output_path(options->output_path);
+    const std::filesystem::path output_dir(options->output_dir);
+    std::error_code ec;
+    std::filesystem::create_directories(output_dir, ec);
+    if (!std::filesystem::is_directory(output_dir)) {
+        return MS_ERR_IO;
+    }
 
-    Decoder decoder;
-    std::size_t total_extracted = 0;
-    std::size_t decoded_chunks = 0;
-    uint32_t max_chunk_index = 0;
-    bool found_last_chunk = false;
-    uint32_t last_chunk_index = 0;
+    std::vector<std::unique_ptr<DemuxFile> > targets;
+    std::atomic<bool> cancelled{false};
+    std::atomic<std::size_t> finished{0};
     int64_t total_frames_read = 0;
+    ms_status_t status = MS_OK;
 
-    try {
-        const int max_retries = options->timeout_sec > 0 ? options->timeout_sec : 30;
-        std::unique_ptr<VideoDecoder> vdec;
-        for (int attempt = 0; attempt < max_retries; ++attempt) {
+    // Each file decodes on its own thread and is written as soon as its last
+    // chunk is in; whatever is still open at the end of the stream is
+    // finished with the chunks it got.
+    const auto start_worker = [&](DemuxFile *target) {
+        target->worker = std::thread([&, target] {
             try {
-                vdec = std::make_unique<VideoDecoder>(stream_url);
-                break;
-            } catch (...) {
-                if (attempt + 1 >= max_retries) throw;
-                std::this_thread::sleep_for(std::chrono::seconds(1));
+                while (auto batch = target->queue.pop()) {
+                    for (const auto &pkt_data: *batch) {
+                        const std::span<const std::byte> data(pkt_data.data(), pkt_data.size());
+                        target->file.feed(data, true);
+                    }
+                    if (target->file.complete()) break;
+                }
+                target->queue.close();
+                if (!cancelled) {
+                    const auto path = output_dir / (to_hex(target->id) + ".bin");
+                    target->status = target->file.finish(path.string(), options->password, options->password_len,
+                                                        target->result);
+                }
+            } catch (const std::exception &e) {
+                fprintf(stderr, "Stream decode error: %s\n", e.what());
+                target->queue.close();
+                target->status = MS_ERR_DECODE_FAILED;
             }
-        }
+            std::memcpy(target->result.file_id, target->id.data(), sizeof(target->result.file_id));
+            target->done = true;
+            ++finished;
+        });
+    };
 
+    try {
+        const auto vdec = open_stream(options->stream_url, options->timeout_sec);
         const int64_t total = vdec->total_frames();
+        std::vector<PacketBatch> routed;
 
         while (!vdec->is_eof()) {
-            if (found_last_chunk && decoded_chunks >= last_chunk_index + 1)
+            if (options->expected_files > 0 && finished >= options->expected_files)
                 break;
 
             if (options->progress) {
                 const auto cur = static_cast<uint64_t>(vdec->frames_read());
                 if (const uint64_t tot = total >= 0 ? static_cast<uint64_t>(total) : 0; options->progress(cur, tot, options->progress_user) != 0) {
-                    return MS_ERR_DECODE_FAILED;
+                    cancelled = true;
+                    status = MS_ERR_DECODE_FAILED;
+                    break;
                 }
             }
 
             auto frame_packets = vdec->decode_next_frame();
             if (frame_packets.empty()) continue;
 
-            for (auto &pkt_data : frame_packets) {
-                ++total_extracted;
-
-                if (pkt_data.size() >= HEADER_SIZE &&
-                    Decoder::validate_raw_packet_crc(
-                        std::span<const std::byte>(pkt_data.data(), pkt_data.size()))) {
-                    const auto flags = static_cast<uint8_t>(pkt_data[FLAGS_OFF]);
-                    uint32_t chunk_idx = 0;
-                    std::memcpy(&chunk_idx, pkt_data.data() + CHUNK_INDEX_OFF,
-                                sizeof(chunk_idx));
-                    if (chunk_idx > max_chunk_index) max_chunk_index = chunk_idx;
-                    if (flags & LastChunk) {
-                        found_last_chunk = true;
-                        last_chunk_index = chunk_idx;
-                    }
+            // Packets with a damaged header cannot be routed and are dropped,
+            // like any other lost packet.
+            routed.assign(targets.size(), {});
+            for (auto &pkt_data: frame_packets) {
+                const auto id = raw_packet_file_id(std::span<const std::byte>(pkt_data.data(), pkt_data.size()));
+                if (!id) continue;
+                const auto it = std::ranges::find_if(targets, [&](const auto &target) { return target->id == *id; });
+                std::size_t index = static_cast<std::size_t>(it - targets.begin());
+                if (it == targets.end()) {
+                    if (targets.size() == MAX_DEMUX_FILES) continue;
+                    auto target = std::make_unique<DemuxFile>();
+                    target->id = *id;
+                    target->file.decoder.set_limits(to_internal_limits(options->limits));
+                    start_worker(target.get());
+                    targets.push_back(std::move(target));
+                    routed.emplace_back();
                 }
-
-                const std::span<const std::byte> data(pkt_data.data(), pkt_data.size());
-                if (auto res = decoder.process_packet(data, false);
-                    res && res->success) {
-                    ++decoded_chunks;
+                routed[index].push_back(std::move(pkt_data));
+            }
+            for (std::size_t i = 0; i < targets.size(); ++i) {
+                // A finished file's queue is closed and the push is a no-op.
+                if (!routed[i].empty() && !targets[i]->done) {
+                    targets[i]->queue.push(std::move(routed[i]));
                 }
             }
         }
@@ -497,51 +3024,207 @@ ms_status_t ms_stream_decode(const ms_stream_decode_options_t *options, ms_resul
         total_frames_read = vdec->frames_read();
     } catch (const std::exception &e) {
         fprintf(stderr, "Stream decode error: %s\n", e.what());
-        return MS_ERR_DECODE_FAILED;
+        cancelled = true;
+        status = MS_ERR_DECODE_FAILED;
     } catch (...) {
         fprintf(stderr, "Stream decode error: unknown exception\n");
-        return MS_ERR_DECODE_FAILED;
+        cancelled = true;
+        status = MS_ERR_DECODE_FAILED;
     }
 
-    if (total_extracted == 0) {
+    for (const auto &target: targets) {
+        target->queue.close();
+        target->worker.join();
+    }
+
+    if (file_count) {
+        *file_count = targets.size();
+    }
+    if (status != MS_OK) {
+        return status;
+    }
+    if (targets.empty()) {
         return MS_ERR_DECODE_FAILED;
     }
 
-    const uint32_t expected_chunks = found_last_chunk
-        ? last_chunk_index + 1
-        : max_chunk_index + 1;
+    for (std::size_t i = 0; i < targets.size(); ++i) {
+        DemuxFile &target = *targets[i];
+        target.result.total_frames = static_cast<uint64_t>(total_frames_read);
+        if (target.status != MS_OK) {
+            status = MS_ERR_INCOMPLETE;
+        }
+        if (i < capacity) {
+            files[i].status = target.status;
+            files[i].result = target.result;
+        }
+    }
+    return status;
+}
 
-    if (decoded_chunks < expected_chunks) {
-        return MS_ERR_INCOMPLETE;
+static bool to_raw_frame_options(const ms_frame_format_t format, const ms_pixel_format_t pixel_format,
+                                 RawFrameOptions &out) {
+    if ((format != MS_FRAME_FORMAT_Y4M && format != MS_FRAME_FORMAT_RAW) ||
+        (pixel_format != MS_PIXEL_FORMAT_GRAY8 && pixel_format != MS_PIXEL_FORMAT_YUV420P)) {
+        return false;
     }
+    out.format = format == MS_FRAME_FORMAT_Y4M ? RawFrameFormat::Y4M : RawFrameFormat::RawVideo;
+    out.pixel_format = pixel_format == MS_PIXEL_FORMAT_GRAY8 ? RawPixelFormat::Gray8 : RawPixelFormat::YUV420P;
+    return true;
+}
 
-    if (decoder.is_encrypted()) {
-        if (!options->password || options->password_len == 0) {
-            return MS_ERR_CRYPTO;
+ms_status_t ms_export_frames(const ms_export_frames_options_t *options, ms_result_t *result) {
+    if (!options || !options->input_path || !options->outputs || options->output_count == 0) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    if (options->encrypt && (!options->password || options->password_len == 0)) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    if (options->width < 0 || options->height < 0 || options->width % 8 != 0 || options->height % 8 != 0) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    if (!(options->repair_overhead >= 0.0 && options->repair_overhead <= MAX_REPAIR_OVERHEAD)) {
+        return MS_ERR_INVALID_ARGS;
+    }
+
+    RawFrameOptions frame_options;
+    if (!to_raw_frame_options(options->format, options->pixel_format, frame_options)) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    frame_options.width = options->width > 0 ? options->width : FRAME_WIDTH;
+    frame_options.height = options->height > 0 ? options->height : FRAME_HEIGHT;
+    frame_options.pattern_set = to_internal_patterns(options->pattern_set);
+    if (static_cast<std::size_t>(compute_frame_layout(frame_options.width, frame_options.height).bytes_per_frame) <
+        PACKET_SIZE) {
+        return MS_ERR_INVALID_ARGS;
+    }
+
+    std::vector<std::string> outputs;
+    for (std::size_t i = 0; i < options->output_count; ++i) {
+        if (!options->outputs[i]) {
+            return MS_ERR_INVALID_ARGS;
         }
-        const std::span<const std::byte> pw(
-            reinterpret_cast<const std::byte *>(options->password),
-            options->password_len);
-        auto key = derive_key(pw, *decoder.file_id());
-        decoder.set_decrypt_key(key);
-        secure_zero(std::span<std::byte>(key));
+        outputs.emplace_back(options->outputs[i]);
+    }
+    if (!std::filesystem::exists(options->input_path)) {
+        return MS_ERR_FILE_NOT_FOUND;
     }
 
-    if (!decoder.write_assembled_file(output_path, expected_chunks)) {
-        if (decoder.is_encrypted()) decoder.clear_decrypt_key();
-        return MS_ERR_DECODE_FAILED;
+    StreamFileJob job;
+    job.input_path = options->input_path;
+    job.encrypt = options->encrypt != 0;
+    if (job.encrypt) {
+        job.password = std::span(reinterpret_cast<const std::byte *>(options->password), options->password_len);
+    }
+    job.hash_algo = to_internal_hash(options->hash_algorithm);
+    job.width = frame_options.width;
+    job.height = frame_options.height;
+    if (options->repair_overhead > 0.0) {
+        job.repair_overhead = options->repair_overhead;
     }
 
-    if (decoder.is_encrypted()) decoder.clear_decrypt_key();
+    std::function<bool(uint64_t, uint64_t)> progress;
+    if (options->progress) {
+        progress = [options](const uint64_t current, const uint64_t total) {
+            return options->progress(current, total, options->progress_user) == 0;
+        };
+    }
+
+    ms_result_t stats{};
+    try {
+        RawFrameWriter writer(outputs, frame_options);
+        if (!stream_file(job, writer, progress, stats)) {
+            return MS_ERR_ENCODE_FAILED;
+        }
+        writer.finalize();
+        stats.total_frames = static_cast<uint64_t>(writer.frames_written());
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Frame export error: %s\n", e.what());
+        return MS_ERR_ENCODE_FAILED;
+    } catch (...) {
+        fprintf(stderr, "Frame export error: unknown exception\n");
+        return MS_ERR_ENCODE_FAILED;
+    }
 
     if (result) {
-        result->input_size = 0;
-        result->output_size = std::filesystem::file_size(output_path);
-        result->total_chunks = expected_chunks;
-        result->total_packets = total_extracted;
-        result->total_frames = static_cast<uint64_t>(total_frames_read);
+        *result = stats;
+    }
+    return MS_OK;
+}
+
+ms_status_t ms_import_frames(const ms_import_frames_options_t *options, ms_result_t *result) {
+    if (!options || !options->input_path || !options->output_path) {
+        return MS_ERR_INVALID_ARGS;
+    }
+
+    RawFrameOptions frame_options;
+    if (!to_raw_frame_options(options->format, options->pixel_format, frame_options)) {
+        return MS_ERR_INVALID_ARGS;
+    }
+    if (frame_options.format == RawFrameFormat::RawVideo) {
+        if (options->width < 0 || options->height < 0) {
+            return MS_ERR_INVALID_ARGS;
+        }
+        frame_options.width = options->width > 0 ? options->width : FRAME_WIDTH;
+        frame_options.height = options->height > 0 ? options->height : FRAME_HEIGHT;
+    }
+    const std::string input_path(options->input_path);
+    if (input_path != "-" && !std::filesystem::exists(input_path)) {
+        return MS_ERR_FILE_NOT_FOUND;
+    }
+
+    StreamFileDecode file;
+    std::optional<Encoder::FileId> file_id;
+    int64_t frames_read = 0;
+    try {
+        file.decoder.set_limits(to_internal_limits(options->limits));
+        RawFrameReader reader(input_path, frame_options);
+
+        std::vector<std::vector<std::byte> > frame_packets;
+        while (!file.complete()) {
+            if (options->progress &&
+                options->progress(static_cast<uint64_t>(reader.frames_read()), 0, options->progress_user) != 0) {
+                return MS_ERR_DECODE_FAILED;
+            }
+
+            frame_packets.clear();
+            if (!reader.decode_next_frame(frame_packets)) {
+                break;
+            }
+            for (const auto &pkt_data: frame_packets) {
+                const std::span<const std::byte> data(pkt_data.data(), pkt_data.size());
+                const auto id = raw_packet_file_id(data);
+                // Like a stream, the frames may interleave several files.
+                if (id) {
+                    if (!file_id) {
+                        file_id = id;
+                    } else if (*id != *file_id) {
+                        continue;
+                    }
+                }
+                file.feed(data, id.has_value());
+            }
+        }
+        frames_read = reader.frames_read();
+    } catch (const std::invalid_argument &e) {
+        fprintf(stderr, "Frame import error: %s\n", e.what());
+        return MS_ERR_INVALID_ARGS;
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Frame import error: %s\n", e.what());
+        return MS_ERR_DECODE_FAILED;
+    } catch (...) {
+        fprintf(stderr, "Frame import error: unknown exception\n");
+        return MS_ERR_DECODE_FAILED;
     }
 
+    ms_result_t stats{};
+    if (const ms_status_t status = file.finish(options->output_path, options->password, options->password_len, stats);
+        status != MS_OK) {
+        return status;
+    }
+    stats.total_frames = static_cast<uint64_t>(frames_read);
+    if (result) {
+        *result = stats;
+    }
     return MS_OK;
 }
 
@@ -555,10 +3238,11 @@ const char *ms_status_string(const ms_status_t status) {
         case MS_ERR_DECODE_FAILED: return "decoding failed";
         case MS_ERR_CRYPTO:      return "encryption/decryption error";
         case MS_ERR_INCOMPLETE:  return "incomplete data";
+        case MS_ERR_INTEGRITY:   return "integrity check failed";
         default:                 return "unknown error";
     }
 }
 
 const char *ms_version(void) {
-    return "1.0.0";
+    return "2.0.0";
 }
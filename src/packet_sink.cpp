@@ -0,0 +1,77 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "packet_sink.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+std::size_t repair_prefix_length(const uint32_t k, const double repair_overhead, const std::size_t available) {
+    const auto repair = static_cast<std::size_t>(std::ceil(static_cast<double>(k) * repair_overhead));
+    const std::size_t source = INCLUDE_SOURCE ? k : 0;
+    return std::min(available, source + repair);
+}
+
+void PacketFanOut::add_sink(PacketSink &sink, const double repair_overhead) {
+    if (!(repair_overhead >= 0.0)) {
+        throw std::invalid_argument("repair overhead must not be negative");
+    }
+    targets_.push_back(Target{&sink, repair_overhead, 0});
+}
+
+double PacketFanOut::max_repair_overhead() const {
+    double overhead = 0.0;
+    for (const Target &target: targets_) {
+        overhead = std::max(overhead, target.repair_overhead);
+    }
+    return overhead;
+}
+
+void PacketFanOut::write_chunk(const std::span<const Packet> packets, const uint32_t k) {
+    for (Target &target: targets_) {
+        const std::size_t count = repair_prefix_length(k, target.repair_overhead, packets.size());
+        target.sink->encode_packets(packets.first(count));
+        target.packets += count;
+    }
+}
+
+void PacketFanOut::write_all(const std::span<const Packet> packets) {
+    for (Target &target: targets_) {
+        target.sink->encode_packets(packets);
+        target.packets += packets.size();
+    }
+}
+
+void PacketFanOut::write_to(const std::size_t index, const std::span<const Packet> packets) {
+    Target &target = targets_.at(index);
+    target.sink->encode_packets(packets);
+    target.packets += packets.size();
+}
+
+void PacketFanOut::finalize() {
+    for (const Target &target: targets_) {
+        target.sink->finalize();
+    }
+}
+
+int64_t PacketFanOut::frames_written() const {
+    int64_t frames = 0;
+    for (const Target &target: targets_) {
+        frames = std::max(frames, target.sink->frames_written());
+    }
+    return frames;
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "encoder.h"
+
+// Anything that turns packets into frames: a video file, a live stream.
+class PacketSink {
+public:
+    virtual ~PacketSink() = default;
+
+    virtual void encode_packets(std::span<const Packet> packets) = 0;
+
+    virtual void finalize() = 0;
+
+    [[nodiscard]] virtual int64_t frames_written() const = 0;
+};
+
+// Number of leading packets of a chunk a sink with the given repair overhead
+// takes: the k source symbols plus ceil(k * repair_overhead) repair symbols,
+// capped at what the chunk actually has. Relies on the encoder emitting source
+// symbols first and repair symbols in ESI order.
+[[nodiscard]] std::size_t repair_prefix_length(uint32_t k, double repair_overhead, std::size_t available);
+
+// Drives several sinks from one FEC pass. The encoder runs at the largest
+// repair overhead of any sink and every sink gets a prefix of each chunk's
+// packets, so a lean live stream and a heavily protected archive share the
+// same reading, encryption and wirehair work. The sinks are borrowed. As a
+// sink itself it passes packets to every sink in full, like write_all.
+class PacketFanOut final : public PacketSink {
+public:
+    void add_sink(PacketSink &sink, double repair_overhead);
+
+    [[nodiscard]] std::size_t size() const { return targets_.size(); }
+
+    [[nodiscard]] PacketSink &sink(const std::size_t index) const { return *targets_[index].sink; }
+
+    [[nodiscard]] double max_repair_overhead() const;
+
+    // Sends each sink its share of one data chunk with k source symbols.
+    void write_chunk(std::span<const Packet> packets, uint32_t k);
+
+    // Sends the packets to every sink in full (manifest segments).
+    void write_all(std::span<const Packet> packets);
+
+    // Sends the packets in full to a single sink, e.g. its own FileInfo.
+    void write_to(std::size_t index, std::span<const Packet> packets);
+
+    void encode_packets(std::span<const Packet> packets) override { write_all(packets); }
+
+    void finalize() override;
+
+    // The most frames any sink has written.
+    [[nodiscard]] int64_t frames_written() const override;
+
+    [[nodiscard]] std::size_t packets_written(const std::size_t index) const { return targets_[index].packets; }
+
+private:
+    struct Target {
+        PacketSink *sink = nullptr;
+        double repair_overhead = 0.0;
+        std::size_t packets = 0;
+    };
+
+    std::vector<Target> targets_;
+};
@@ -0,0 +1,290 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "raw_frames.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "frame_codec.h"
+
+namespace {
+    constexpr std::size_t RAW_FRAME_IO_BUFFER = 4u * 1024u * 1024u;
+    constexpr std::size_t Y4M_MAX_LINE = 1024;
+
+    void set_binary(std::FILE *file) {
+#ifdef _WIN32
+        _setmode(_fileno(file), _O_BINARY);
+#else
+        (void) file;
+#endif
+    }
+
+    FrameLayout checked_layout(const int width, const int height) {
+        if (width <= 0 || height <= 0 || width % 2 != 0 || height % 2 != 0) {
+            throw std::invalid_argument("Raw frame size must be positive and even");
+        }
+        const FrameLayout layout = compute_frame_layout(width, height);
+        if (static_cast<std::size_t>(layout.bytes_per_frame) < PACKET_SIZE) {
+            throw std::invalid_argument("Raw frame too small to carry a packet");
+        }
+        return layout;
+    }
+
+    // Reads one '\n'-terminated line without the terminator. Returns false if
+    // the input ended before the first byte.
+    bool read_line(std::FILE *file, std::string &line) {
+        line.clear();
+        int c = std::fgetc(file);
+        if (c == EOF) {
+            return false;
+        }
+        while (c != '\n') {
+            if (c == EOF || line.size() == Y4M_MAX_LINE) {
+                throw std::runtime_error("Malformed Y4M stream");
+            }
+            line.push_back(static_cast<char>(c));
+            c = std::fgetc(file);
+        }
+        return true;
+    }
+
+    std::size_t y4m_chroma_bytes(const std::string_view tag, const int width, const int height) {
+        const auto w = static_cast<std::size_t>(width);
+        const auto h = static_cast<std::size_t>(height);
+        const std::size_t half_w = (w + 1) / 2;
+        if (tag == "mono") return 0;
+        if (tag.starts_with("420") && tag.find("p1") == std::string_view::npos) {
+            return half_w * ((h + 1) / 2) * 2;
+        }
+        if (tag == "422") return half_w * h * 2;
+        if (tag == "444") return w * h * 2;
+        if (tag == "444alpha") return w * h * 3;
+        throw std::runtime_error("Unsupported Y4M colorspace: C" + std::string(tag));
+    }
+}
+
+std::size_t raw_chroma_bytes(const RawPixelFormat pixel_format, const int width, const int height) {
+    if (pixel_format == RawPixelFormat::Gray8) {
+        return 0;
+    }
+    return y4m_chroma_bytes("420", width, height);
+}
+
+RawFrameWriter::RawFrameWriter(const std::vector<std::string> &paths, const RawFrameOptions &options)
+    : options_(options), layout_(checked_layout(options.width, options.height)) {
+    if (paths.empty()) {
+        throw std::invalid_argument("No raw frame output");
+    }
+
+    frame_capacity_ = static_cast<std::size_t>(layout_.bytes_per_frame) / PACKET_SIZE * PACKET_SIZE;
+    luma_.resize(static_cast<std::size_t>(options.width) * options.height);
+    chroma_.assign(raw_chroma_bytes(options.pixel_format, options.width, options.height), 128);
+
+    for (const std::string &path: paths) {
+        std::FILE *file = nullptr;
+        if (path == "-") {
+            file = stdout;
+            set_binary(file);
+        } else {
+            file = std::fopen(path.c_str(), "wb");
+            if (file) {
+                std::setvbuf(file, nullptr, _IOFBF, RAW_FRAME_IO_BUFFER);
+            }
+        }
+        if (!file) {
+            for (std::FILE *open: outputs_) {
+                if (open != stdout) std::fclose(open);
+            }
+            throw std::runtime_error("Could not open raw frame output: " + path);
+        }
+        outputs_.push_back(file);
+    }
+
+    if (options.format == RawFrameFormat::Y4M) {
+        const std::string header = "YUV4MPEG2 W" + std::to_string(options.width) +
+                                   " H" + std::to_string(options.height) +
+                                   " F" + std::to_string(FRAME_FPS) + ":1 Ip A1:1 C" +
+                                   (options.pixel_format == RawPixelFormat::Gray8 ? "mono" : "420jpeg") + "\n";
+        write_all(header.data(), header.size());
+    }
+}
+
+RawFrameWriter::~RawFrameWriter() {
+    if (!finalized_) {
+        try { finalize(); } catch (...) {
+        }
+    }
+    for (std::FILE *file: outputs_) {
+        if (file != stdout) std::fclose(file);
+    }
+}
+
+void RawFrameWriter::write_all(const void *data, const std::size_t size) {
+    for (std::FILE *file: outputs_) {
+        if (std::fwrite(data, 1, size, file) != size) {
+            throw std::runtime_error("Error writing raw frames");
+        }
+    }
+}
+
+void RawFrameWriter::encode_packets(const std::span<const Packet> packets) {
+    if (finalized_) {
+        throw std::runtime_error("Encoder already finalized");
+    }
+    for (const Packet &packet: packets) {
+        if (frame_data_buffer_.size() + packet.bytes.size() > frame_capacity_) {
+            flush_frame_buffer();
+        }
+        frame_data_buffer_.insert(frame_data_buffer_.end(), packet.bytes.begin(), packet.bytes.end());
+    }
+}
+
+void RawFrameWriter::flush_frame_buffer() {
+    if (frame_data_buffer_.empty()) return;
+
+    embed_frame_data(frame_data_buffer_, layout_, options_.pattern_set, luma_.data(), options_.width);
+    if (options_.format == RawFrameFormat::Y4M) {
+        write_all("FRAME\n", 6);
+    }
+    write_all(luma_.data(), luma_.size());
+    if (!chroma_.empty()) {
+        write_all(chroma_.data(), chroma_.size());
+    }
+    ++frame_index_;
+    frame_data_buffer_.clear();
+}
+
+void RawFrameWriter::finalize() {
+    if (finalized_) return;
+    finalized_ = true;
+    flush_frame_buffer();
+    for (std::FILE *file: outputs_) {
+        if (std::fflush(file) != 0) {
+            throw std::runtime_error("Error writing raw frames");
+        }
+    }
+}
+
+RawFrameReader::RawFrameReader(const std::string &path, const RawFrameOptions &options) : options_(options) {
+    if (path == "-") {
+        input_ = stdin;
+        set_binary(input_);
+    } else {
+        input_ = std::fopen(path.c_str(), "rb");
+        if (!input_) {
+            throw std::runtime_error("Could not open raw frame input: " + path);
+        }
+        owns_input_ = true;
+        std::setvbuf(input_, nullptr, _IOFBF, RAW_FRAME_IO_BUFFER);
+    }
+
+    try {
+        if (options.format == RawFrameFormat::Y4M) {
+            read_y4m_header();
+        } else {
+            layout_ = checked_layout(options.width, options.height);
+            chroma_bytes_ = raw_chroma_bytes(options.pixel_format, options.width, options.height);
+        }
+    } catch (...) {
+        if (owns_input_) std::fclose(input_);
+        throw;
+    }
+    luma_.resize(static_cast<std::size_t>(layout_.frame_width) * layout_.frame_height);
+}
+
+RawFrameReader::~RawFrameReader() {
+    if (owns_input_) {
+        std::fclose(input_);
+    }
+}
+
+void RawFrameReader::read_y4m_header() {
+    std::string line;
+    if (!read_line(input_, line) || !line.starts_with("YUV4MPEG2")) {
+        throw std::runtime_error("Not a Y4M stream");
+    }
+
+    int width = 0;
+    int height = 0;
+    std::string chroma = "420jpeg";
+    std::size_t pos = 0;
+    while ((pos = line.find(' ', pos)) != std::string::npos) {
+        ++pos;
+        const std::size_t end = line.find(' ', pos);
+        const std::string token = line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        if (token.empty()) continue;
+        try {
+            if (token[0] == 'W') width = std::stoi(token.substr(1));
+            else if (token[0] == 'H') height = std::stoi(token.substr(1));
+            else if (token[0] == 'C') chroma = token.substr(1);
+        } catch (const std::exception &) {
+            throw std::runtime_error("Malformed Y4M header");
+        }
+    }
+
+    if (width <= 0 || height <= 0) {
+        throw std::runtime_error("Malformed Y4M header");
+    }
+    const FrameLayout layout = compute_frame_layout(width, height);
+    if (static_cast<std::size_t>(layout.bytes_per_frame) < PACKET_SIZE) {
+        throw std::runtime_error("Y4M frames too small to carry a packet");
+    }
+    layout_ = layout;
+    chroma_bytes_ = y4m_chroma_bytes(chroma, width, height);
+}
+
+bool RawFrameReader::decode_next_frame(std::vector<std::vector<std::byte> > &out) {
+    if (options_.format == RawFrameFormat::Y4M) {
+        std::string line;
+        if (!read_line(input_, line)) {
+            return false;
+        }
+        if (!line.starts_with("FRAME")) {
+            throw std::runtime_error("Malformed Y4M frame header");
+        }
+    }
+
+    const std::size_t got = std::fread(luma_.data(), 1, luma_.size(), input_);
+    if (got == 0 && options_.format == RawFrameFormat::RawVideo && std::feof(input_)) {
+        return false;
+    }
+    if (got != luma_.size()) {
+        throw std::runtime_error("Truncated raw frame");
+    }
+
+    // Chroma carries nothing; pipes cannot seek past it.
+    std::byte discard[4096];
+    for (std::size_t left = chroma_bytes_; left > 0;) {
+        const std::size_t n = std::min(left, sizeof(discard));
+        if (std::fread(discard, 1, n, input_) != n) {
+            throw std::runtime_error("Truncated raw frame");
+        }
+        left -= n;
+    }
+
+    extract_frame_data(luma_.data(), layout_.frame_width, layout_, accumulated_);
+    split_packets(accumulated_, out);
+    ++frames_read_;
+    return true;
+}
@@ -0,0 +1,126 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "configuration.h"
+#include "dct_common.h"
+#include "packet_sink.h"
+
+// Uncompressed frames on a pipe, for handing the embedded pixels to an
+// external encoder (ffmpeg, x264, SVT-AV1, a hardware encoder's CLI) and for
+// reading frames it decoded back without going through libavformat.
+enum class RawFrameFormat : uint8_t {
+    Y4M,      // YUV4MPEG2: self-describing header, then "FRAME" + planes
+    RawVideo, // bare planes back to back; both ends must agree on the size
+};
+
+enum class RawPixelFormat : uint8_t {
+    Gray8,   // luma only
+    YUV420P, // luma plus two quarter-size mid-grey chroma planes
+};
+
+struct RawFrameOptions {
+    RawFrameFormat format = RawFrameFormat::Y4M;
+    RawPixelFormat pixel_format = RawPixelFormat::Gray8;
+    // Ignored by RawFrameReader for Y4M, whose header carries them.
+    int width = FRAME_WIDTH;
+    int height = FRAME_HEIGHT;
+    PatternSet pattern_set = PatternSet::Cosine;
+};
+
+// Bytes of one frame's chroma planes; zero for Gray8.
+[[nodiscard]] std::size_t raw_chroma_bytes(RawPixelFormat pixel_format, int width, int height);
+
+// Embeds packets into frames exactly as VideoEncoder does and writes the frames
+// uncompressed to every output. "-" is stdout; named pipes work like files, so
+// one pass can feed several encoder processes.
+class RawFrameWriter final : public PacketSink {
+public:
+    RawFrameWriter(const std::vector<std::string> &paths, const RawFrameOptions &options);
+
+    ~RawFrameWriter() override;
+
+    RawFrameWriter(const RawFrameWriter &) = delete;
+
+    RawFrameWriter &operator=(const RawFrameWriter &) = delete;
+
+    void encode_packets(std::span<const Packet> packets) override;
+
+    void finalize() override;
+
+    [[nodiscard]] int64_t frames_written() const override { return frame_index_; }
+
+private:
+    RawFrameOptions options_;
+    FrameLayout layout_{};
+    std::vector<std::FILE *> outputs_;
+    std::vector<uint8_t> luma_;
+    std::vector<uint8_t> chroma_;
+    std::vector<std::byte> frame_data_buffer_;
+    std::size_t frame_capacity_ = 0;
+    int64_t frame_index_ = 0;
+    bool finalized_ = false;
+
+    void write_all(const void *data, std::size_t size);
+
+    void flush_frame_buffer();
+};
+
+// Reads frames written by RawFrameWriter, or by an external decoder, and
+// splits the luma plane back into packets. "-" is stdin.
+class RawFrameReader {
+public:
+    RawFrameReader(const std::string &path, const RawFrameOptions &options);
+
+    ~RawFrameReader();
+
+    RawFrameReader(const RawFrameReader &) = delete;
+
+    RawFrameReader &operator=(const RawFrameReader &) = delete;
+
+    // Appends the packets completed by the next frame to out. Returns false
+    // once the input ends; throws on a truncated frame or malformed Y4M.
+    bool decode_next_frame(std::vector<std::vector<std::byte> > &out);
+
+    [[nodiscard]] int width() const { return layout_.frame_width; }
+
+    [[nodiscard]] int height() const { return layout_.frame_height; }
+
+    [[nodiscard]] int64_t frames_read() const { return frames_read_; }
+
+private:
+    RawFrameOptions options_;
+    FrameLayout layout_{};
+    std::FILE *input_ = nullptr;
+    bool owns_input_ = false;
+    std::size_t chroma_bytes_ = 0;
+    std::vector<uint8_t> luma_;
+    std::vector<std::byte> accumulated_;
+    int64_t frames_read_ = 0;
+
+    void read_y4m_header();
+};
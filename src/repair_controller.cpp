@@ -0,0 +1,143 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "repair_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include "integrity.h"
+#include "job_protocol.h"
+
+// Planned loss is capped so the overhead stays finite on a dead channel;
+// max_overhead bounds it anyway.
+static constexpr double MAX_PLANNED_LOSS = 0.9;
+
+RepairController::RepairController(RepairControllerOptions options) : options_(options) {
+    if (!(options_.min_overhead >= 0.0) || !(options_.max_overhead >= options_.min_overhead) ||
+        options_.max_overhead > MAX_REPAIR_OVERHEAD || !(options_.safety >= 1.0) ||
+        !(options_.smoothing > 0.0 && options_.smoothing <= 1.0) || !(options_.margin >= 0.0) ||
+        options_.history == 0) {
+        throw std::invalid_argument("invalid repair controller options");
+    }
+}
+
+double RepairController::planned_loss() const {
+    return std::min(loss_ * options_.safety, MAX_PLANNED_LOSS);
+}
+
+double RepairController::overhead() const {
+    const std::lock_guard lock(mutex_);
+    if (reports_ == 0) {
+        return options_.max_overhead;
+    }
+    // Sent symbols (source included) times the surviving fraction must cover
+    // k plus the margin.
+    const double overhead = (1.0 + options_.margin) / (1.0 - planned_loss()) - 1.0;
+    return std::clamp(overhead, options_.min_overhead, options_.max_overhead);
+}
+
+double RepairController::loss_estimate() const {
+    const std::lock_guard lock(mutex_);
+    return loss_;
+}
+
+void RepairController::chunk_sent(const uint32_t chunk_index, const uint32_t k, const std::size_t packets) {
+    const std::lock_guard lock(mutex_);
+    chunks_[chunk_index] = ChunkRecord{k, packets, false, false};
+    while (chunks_.size() > options_.history) {
+        chunks_.erase(chunks_.begin());
+    }
+}
+
+bool RepairController::report(const uint32_t chunk_index, const std::size_t received) {
+    const std::lock_guard lock(mutex_);
+    const auto it = chunks_.find(chunk_index);
+    if (it == chunks_.end()) {
+        return false;
+    }
+    ChunkRecord &chunk = it->second;
+    const std::size_t arrived = std::min(received, chunk.sent);
+
+    // Only the first report feeds the estimate; later ones count re-sends the
+    // original pass did not have.
+    if (!chunk.reported && chunk.sent > 0) {
+        const double loss = 1.0 - static_cast<double>(arrived) / static_cast<double>(chunk.sent);
+        loss_ = reports_ == 0 ? loss : loss_ + options_.smoothing * (loss - loss_);
+        chunk.reported = true;
+        ++reports_;
+    }
+
+    const std::size_t wanted =
+        chunk.k + static_cast<std::size_t>(std::ceil(static_cast<double>(chunk.k) * options_.margin));
+    if (arrived < wanted && !chunk.resend_queued) {
+        const double missing = static_cast<double>(wanted - arrived);
+        pending_.push_back(RepairResend{
+            chunk_index, chunk.sent, static_cast<std::size_t>(std::ceil(missing / (1.0 - planned_loss())))
+        });
+        chunk.resend_queued = true;
+    }
+    return true;
+}
+
+std::vector<RepairResend> RepairController::take_resends() {
+    const std::lock_guard lock(mutex_);
+    return std::exchange(pending_, {});
+}
+
+void RepairController::resent(const uint32_t chunk_index, const std::size_t packets) {
+    const std::lock_guard lock(mutex_);
+    if (const auto it = chunks_.find(chunk_index); it != chunks_.end()) {
+        it->second.sent += packets;
+    }
+    resent_packets_ += packets;
+}
+
+uint64_t RepairController::reports() const {
+    const std::lock_guard lock(mutex_);
+    return reports_;
+}
+
+uint64_t RepairController::resent_packets() const {
+    const std::lock_guard lock(mutex_);
+    return resent_packets_;
+}
+
+std::string format_repair_report(const RepairReport &report) {
+    JobMessage message{"loss", {}};
+    message.add("file", to_hex(report.file_id));
+    message.add("chunk", std::to_string(report.chunk_index));
+    message.add("received", std::to_string(report.received));
+    return format_job_message(message);
+}
+
+std::optional<RepairReport> parse_repair_report(const std::string_view line) {
+    const auto message = parse_job_message(line);
+    if (!message || message->verb != "loss") {
+        return std::nullopt;
+    }
+    RepairReport report;
+    const std::string *file = message->find("file");
+    const std::string *chunk = message->find("chunk");
+    const std::string *received = message->find("received");
+    if (!file || !from_hex(*file, report.file_id) || !chunk || !parse_number(*chunk, report.chunk_index) ||
+        !received || !parse_number(*received, report.received)) {
+        return std::nullopt;
+    }
+    return report;
+}
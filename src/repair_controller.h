@@ -0,0 +1,116 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "configuration.h"
+#include "encoder.h"
+
+struct RepairControllerOptions {
+    double min_overhead = 0.25;            // never send less repair than this
+    double max_overhead = REPAIR_OVERHEAD; // what the encoder generates
+    double safety = 2.0;                   // multiple of the observed loss planned for
+    double smoothing = 0.25;               // weight of the newest report in the loss estimate
+    double margin = 0.1;                   // symbols beyond k a chunk should arrive with
+    std::size_t history = 256;             // chunks remembered for reports and re-sends
+};
+
+struct RepairResend {
+    uint32_t chunk_index = 0;
+    std::size_t first_packet = 0; // packets of the chunk already sent
+    std::size_t packets = 0;
+};
+
+// Closed-loop repair rate of a live stream. The encoder generates every chunk
+// at max_overhead, sends a prefix sized by overhead() and records it with
+// chunk_sent(); a monitor decoding the published rendition reports how many
+// packets of each chunk survived. The smoothed loss sets the overhead of the
+// chunks still to come, and a chunk that arrived with too few symbols to
+// decode reliably is queued once for a re-send of repair symbols it has not
+// sent yet.
+// Until the first report the controller assumes the worst and runs at
+// max_overhead. Thread-safe: reports come from a listener thread.
+class RepairController {
+public:
+    explicit RepairController(RepairControllerOptions options = {});
+
+    [[nodiscard]] const RepairControllerOptions &options() const { return options_; }
+
+    // Repair symbols per source symbol for the next chunk.
+    [[nodiscard]] double overhead() const;
+
+    // Smoothed fraction of packets lost, 0 before the first report.
+    [[nodiscard]] double loss_estimate() const;
+
+    void chunk_sent(uint32_t chunk_index, uint32_t k, std::size_t packets);
+
+    // received counts every intact packet of the chunk seen so far, re-sends
+    // included. False for a chunk that was never sent or has been forgotten.
+    bool report(uint32_t chunk_index, std::size_t received);
+
+    [[nodiscard]] std::vector<RepairResend> take_resends();
+
+    // Records packets actually re-sent, which may be fewer than requested
+    // once a chunk's repair tail runs out.
+    void resent(uint32_t chunk_index, std::size_t packets);
+
+    [[nodiscard]] uint64_t reports() const;
+
+    [[nodiscard]] uint64_t resent_packets() const;
+
+private:
+    struct ChunkRecord {
+        uint32_t k = 0;
+        std::size_t sent = 0;
+        bool reported = false;
+        bool resend_queued = false;
+    };
+
+    [[nodiscard]] double planned_loss() const;
+
+    RepairControllerOptions options_;
+    mutable std::mutex mutex_;
+    std::map<uint32_t, ChunkRecord> chunks_;
+    std::vector<RepairResend> pending_;
+    double loss_ = 0.0;
+    uint64_t reports_ = 0;
+    uint64_t resent_packets_ = 0;
+};
+
+// A monitor's report on one chunk, sent as one job_protocol.h line:
+//   loss file=<32 hex digits> chunk=<index> received=<packets>
+struct RepairReport {
+    Encoder::FileId file_id{};
+    uint32_t chunk_index = 0;
+    std::size_t received = 0;
+};
+
+[[nodiscard]] std::string format_repair_report(const RepairReport &report);
+
+// nullopt for anything but a well-formed loss line.
+[[nodiscard]] std::optional<RepairReport> parse_repair_report(std::string_view line);
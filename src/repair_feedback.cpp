@@ -0,0 +1,138 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "repair_feedback.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// A report line is well under this.
+static constexpr std::size_t MAX_REPORT_BYTES = 512;
+
+#ifdef _WIN32
+
+RepairFeedbackReceiver::RepairFeedbackReceiver(std::string socket_path) : path_(std::move(socket_path)) {
+    throw std::runtime_error("repair feedback needs Unix domain sockets, which this build does not support");
+}
+
+RepairFeedbackReceiver::~RepairFeedbackReceiver() = default;
+
+std::optional<RepairReport> RepairFeedbackReceiver::receive(std::chrono::milliseconds) {
+    return std::nullopt;
+}
+
+RepairFeedbackSender::RepairFeedbackSender(std::string socket_path) : path_(std::move(socket_path)) {
+}
+
+RepairFeedbackSender::~RepairFeedbackSender() = default;
+
+bool RepairFeedbackSender::send(const RepairReport &) {
+    return false;
+}
+
+#else
+
+static bool make_address(const std::string &path, sockaddr_un &address) {
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+RepairFeedbackReceiver::RepairFeedbackReceiver(std::string socket_path) : path_(std::move(socket_path)) {
+    sockaddr_un address{};
+    if (!make_address(path_, address)) {
+        throw std::runtime_error("socket path is empty or too long");
+    }
+
+    // A socket file left behind by an encoder that died is replaced; anything
+    // else at that path is not touched.
+    std::error_code ec;
+    if (std::filesystem::is_socket(path_, ec)) {
+        std::filesystem::remove(path_, ec);
+    }
+
+    fd_ = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd_ < 0) {
+        throw std::runtime_error("cannot create socket");
+    }
+    const mode_t old_mask = ::umask(0177);
+    const int bound = ::bind(fd_, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+    ::umask(old_mask);
+    if (bound != 0) {
+        const std::string reason = std::strerror(errno);
+        ::close(fd_);
+        throw std::runtime_error("cannot bind " + path_ + ": " + reason);
+    }
+}
+
+RepairFeedbackReceiver::~RepairFeedbackReceiver() {
+    ::close(fd_);
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+}
+
+std::optional<RepairReport> RepairFeedbackReceiver::receive(const std::chrono::milliseconds timeout) {
+    pollfd waiting{fd_, POLLIN, 0};
+    if (::poll(&waiting, 1, static_cast<int>(timeout.count())) <= 0) {
+        return std::nullopt;
+    }
+    char buffer[MAX_REPORT_BYTES];
+    const ssize_t n = ::recv(fd_, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+        return std::nullopt;
+    }
+    std::string_view line(buffer, static_cast<std::size_t>(n));
+    if (line.ends_with('\n')) {
+        line.remove_suffix(1);
+    }
+    return parse_repair_report(line);
+}
+
+RepairFeedbackSender::RepairFeedbackSender(std::string socket_path) : path_(std::move(socket_path)) {
+    fd_ = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+}
+
+RepairFeedbackSender::~RepairFeedbackSender() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool RepairFeedbackSender::send(const RepairReport &report) {
+    sockaddr_un address{};
+    if (fd_ < 0 || !make_address(path_, address)) {
+        return false;
+    }
+    const std::string line = format_repair_report(report);
+    return ::sendto(fd_, line.data(), line.size(), MSG_DONTWAIT, reinterpret_cast<const sockaddr *>(&address),
+                    sizeof(address)) == static_cast<ssize_t>(line.size());
+}
+
+#endif
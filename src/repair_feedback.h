@@ -0,0 +1,68 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+#include "repair_controller.h"
+
+// Unix datagram socket a live stream encoder listens on for RepairReports.
+// Each datagram is one report line, so a monitor needs no connection and can
+// start before or after the encoder. Only the owner may send (the socket is
+// created 0600). Throws std::runtime_error if the socket cannot be bound or
+// this build has no Unix domain sockets.
+class RepairFeedbackReceiver {
+public:
+    explicit RepairFeedbackReceiver(std::string socket_path);
+
+    ~RepairFeedbackReceiver();
+
+    RepairFeedbackReceiver(const RepairFeedbackReceiver &) = delete;
+
+    RepairFeedbackReceiver &operator=(const RepairFeedbackReceiver &) = delete;
+
+    // Waits up to timeout for a report; nullopt on timeout or a malformed one.
+    [[nodiscard]] std::optional<RepairReport> receive(std::chrono::milliseconds timeout);
+
+private:
+    std::string path_;
+    int fd_ = -1;
+};
+
+// The monitor's end. Reports are best effort: nobody listening, or a full
+// receive buffer, just drops them.
+class RepairFeedbackSender {
+public:
+    explicit RepairFeedbackSender(std::string socket_path);
+
+    ~RepairFeedbackSender();
+
+    RepairFeedbackSender(const RepairFeedbackSender &) = delete;
+
+    RepairFeedbackSender &operator=(const RepairFeedbackSender &) = delete;
+
+    bool send(const RepairReport &report);
+
+private:
+    std::string path_;
+    int fd_ = -1;
+};
@@ -0,0 +1,58 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "shard_plan.h"
+
+#include <algorithm>
+
+#include "manifest.h"
+
+uint64_t shard_manifest_packets(const Encoder &encoder, const uint32_t chunk_count,
+                                const std::size_t file_info_bytes) {
+    uint64_t packets = encoder.packet_count(file_info_bytes) + encoder.packet_count(SHARD_INFO_SIZE);
+    for (uint32_t first = 0; first < chunk_count; first += MANIFEST_DIGESTS_PER_SEGMENT) {
+        const std::size_t count = std::min<std::size_t>(MANIFEST_DIGESTS_PER_SEGMENT, chunk_count - first);
+        packets += encoder.packet_count(MANIFEST_TABLE_HEADER_SIZE + count * sizeof(Sha256Digest));
+    }
+    return packets;
+}
+
+std::vector<ShardRange> plan_shards(const Encoder &encoder, const ShardPlanParams &params) {
+    const uint64_t chunk_packets = encoder.packet_count(params.chunk_bytes);
+    const uint64_t last_chunk_packets = encoder.packet_count(params.last_chunk_bytes);
+
+    std::vector<ShardRange> shards;
+    uint32_t next = 0;
+    while (next < params.chunk_count) {
+        ShardRange shard{next, 0};
+        uint64_t data_packets = 0;
+        while (next < params.chunk_count && shard.chunk_count < MAX_CHUNKS_PER_SHARD) {
+            const uint64_t packets = next + 1 == params.chunk_count ? last_chunk_packets : chunk_packets;
+            if (data_packets + packets +
+                shard_manifest_packets(encoder, shard.chunk_count + 1, params.file_info_bytes) > params.max_packets) {
+                break;
+            }
+            data_packets += packets;
+            ++shard.chunk_count;
+            ++next;
+        }
+        if (shard.chunk_count == 0 || shards.size() == MAX_SHARD_COUNT) {
+            return {};
+        }
+        shards.push_back(shard);
+    }
+    return shards;
+}
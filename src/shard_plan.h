@@ -0,0 +1,49 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "encoder.h"
+
+struct ShardRange {
+    uint32_t first_chunk = 0;
+    uint32_t chunk_count = 0;
+};
+
+struct ShardPlanParams {
+    uint32_t chunk_count = 0;
+    std::size_t chunk_bytes = 0;      // FEC input size of every chunk but the last
+    std::size_t last_chunk_bytes = 0;
+    std::size_t file_info_bytes = 0;  // serialized FileInfo, repeated in every shard
+    uint64_t max_packets = 0;         // per shard, manifest included
+};
+
+// Packets a shard of chunk_count chunks adds for its manifest: FileInfo,
+// ShardInfo and the digest table of its own chunks.
+[[nodiscard]] uint64_t shard_manifest_packets(const Encoder &encoder, uint32_t chunk_count,
+                                              std::size_t file_info_bytes);
+
+// Splits the chunks into consecutive shards, each as large as max_packets
+// allows. Packet counts are exact, so a frame limit translates into
+// max_packets without slack. Returns an empty plan if a single chunk does not
+// fit or more than MAX_SHARD_COUNT shards would be needed.
+[[nodiscard]] std::vector<ShardRange> plan_shards(const Encoder &encoder, const ShardPlanParams &params);
@@ -265,52 +265,7 @@ int StreamEncoder::packets_per_frame() {
 }
 
 void StreamEncoder::embed_data_in_frame(const std::vector<std::byte> &data) {
-#if defined(__APPLE__) && defined(_OPENMP)
-    const auto &blocks = get_precomputed_blocks();
-    const auto &patterns = blocks.patterns;
-#else
-    const auto &patterns = get_precomputed_blocks().patterns;
-#endif
-
-    const std::size_t total_bits = data.size() * 8;
-    const int total_blocks = layout_.blocks_per_row * layout_.blocks_per_col;
-    const int active_blocks = static_cast<int>(
-        std::min(static_cast<std::size_t>(total_blocks),
-                 (total_bits + BITS_PER_BLOCK - 1) / BITS_PER_BLOCK));
-    const auto *src = reinterpret_cast<const uint8_t *>(data.data());
-    const int blocks_per_row = layout_.blocks_per_row;
-
-    uint8_t *dst_base = gray_buffer_.data();
-    const int dst_stride = width_;
-    std::memset(dst_base, 128, gray_buffer_.size());
-
-#pragma omp parallel for schedule(static)
-    for (int block_idx = 0; block_idx < active_blocks; ++block_idx) {
-        const int block_row = block_idx / blocks_per_row;
-        const int block_col = block_idx % blocks_per_row;
-        const int base_x = block_col * 8;
-        const int base_y = block_row * 8;
-
-        const std::size_t bit_start = static_cast<std::size_t>(block_idx) * BITS_PER_BLOCK;
-        const std::size_t bit_end = std::min(bit_start + BITS_PER_BLOCK, total_bits);
-
-        int pattern = 0;
-        for (std::size_t bit_index = bit_start; bit_index < bit_end; ++bit_index) {
-            const std::size_t byte_idx = bit_index / 8;
-            const int bit_pos = 7 - static_cast<int>(bit_index % 8);
-            const int bit = (src[byte_idx] >> bit_pos) & 1;
-            pattern = (pattern << 1) | bit;
-        }
-
-        const int bits_extracted = static_cast<int>(bit_end - bit_start);
-        pattern <<= (BITS_PER_BLOCK - bits_extracted);
-
-        const auto &block = patterns[pattern];
-        for (int y = 0; y < 8; ++y) {
-            std::memcpy(dst_base + (base_y + y) * dst_stride + base_x,
-                        block[y], 8);
-        }
-    }
+    embed_frame_data(data, layout_, PatternSet::Cosine, gray_buffer_.data(), width_);
 
     const uint8_t *src_data[1] = {gray_buffer_.data()};
     const int src_linesize[1] = {width_};
@@ -369,7 +324,7 @@ void StreamEncoder::add_packet(const Packet &packet) {
                               packet.bytes.end());
 }
 
-void StreamEncoder::encode_packets(const std::vector<Packet> &packets) {
+void StreamEncoder::encode_packets(const std::span<const Packet> packets) {
     for (const auto &pkt: packets) {
         add_packet(pkt);
     }
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <cstddef>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -32,13 +33,14 @@ extern "C" {
 
 #include "configuration.h"
 #include "encoder.h"
+#include "packet_sink.h"
 
-class StreamEncoder {
+class StreamEncoder final : public PacketSink {
 public:
     explicit StreamEncoder(const std::string &rtmp_url, int bitrate_kbps = 35000,
                            int width = FRAME_WIDTH, int height = FRAME_HEIGHT);
 
-    ~StreamEncoder();
+    ~StreamEncoder() override;
 
     StreamEncoder(const StreamEncoder &) = delete;
 
@@ -50,11 +52,11 @@ public:
 
     void add_packet(const Packet &packet);
 
-    void encode_packets(const std::vector<Packet> &packets);
+    void encode_packets(std::span<const Packet> packets) override;
 
-    void finalize();
+    void finalize() override;
 
-    [[nodiscard]] int64_t frames_written() const { return frame_index_; }
+    [[nodiscard]] int64_t frames_written() const override { return frame_index_; }
 
     [[nodiscard]] static int packets_per_frame();
 
@@ -0,0 +1,169 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "stream_mux.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+StreamMultiplexer::StreamMultiplexer(PacketSink &sink, const std::size_t schedule_packets,
+                                     const std::size_t lane_capacity)
+    : sink_(sink), schedule_packets_(std::max<std::size_t>(1, schedule_packets)),
+      lane_capacity_(std::max<std::size_t>(1, lane_capacity)) {
+}
+
+std::size_t StreamMultiplexer::add_lane(const double weight) {
+    if (!(weight > 0.0) || !std::isfinite(weight)) {
+        throw std::invalid_argument("lane weight must be positive");
+    }
+    const std::lock_guard lock(mutex_);
+    lanes_.emplace_back();
+    weights_.push_back(weight);
+    // The lightest lane sends one packet per turn, the others in proportion.
+    const double lightest = *std::ranges::min_element(weights_);
+    for (std::size_t i = 0; i < lanes_.size(); ++i) {
+        lanes_[i].quantum = weights_[i] / lightest;
+    }
+    return lanes_.size() - 1;
+}
+
+bool StreamMultiplexer::submit(const std::size_t lane, const std::span<const Packet> packets) {
+    std::unique_lock lock(mutex_);
+    Lane &target = lanes_.at(lane);
+    for (const Packet &packet: packets) {
+        if (target.queue.size() >= lane_capacity_) {
+            ready_.notify_one();
+            space_.wait(lock, [&] { return stopped_ || target.queue.size() < lane_capacity_; });
+        }
+        if (stopped_) {
+            return false;
+        }
+        target.queue.push_back(packet);
+    }
+    ready_.notify_one();
+    return true;
+}
+
+void StreamMultiplexer::close_lane(const std::size_t lane) {
+    {
+        const std::lock_guard lock(mutex_);
+        lanes_.at(lane).closed = true;
+    }
+    ready_.notify_one();
+}
+
+void StreamMultiplexer::stop() {
+    {
+        const std::lock_guard lock(mutex_);
+        stopped_ = true;
+    }
+    ready_.notify_all();
+    space_.notify_all();
+}
+
+std::size_t StreamMultiplexer::lane_count() const {
+    const std::lock_guard lock(mutex_);
+    return lanes_.size();
+}
+
+uint64_t StreamMultiplexer::packets_written(const std::size_t lane) const {
+    const std::lock_guard lock(mutex_);
+    return lanes_.at(lane).written;
+}
+
+bool StreamMultiplexer::has_queued() const {
+    return std::ranges::any_of(lanes_, [](const Lane &lane) { return !lane.queue.empty(); });
+}
+
+bool StreamMultiplexer::all_closed() const {
+    return std::ranges::all_of(lanes_, [](const Lane &lane) { return lane.closed; });
+}
+
+void StreamMultiplexer::next_lane() {
+    current_ = (current_ + 1) % lanes_.size();
+    turn_open_ = false;
+}
+
+void StreamMultiplexer::schedule(std::vector<Packet> &batch) {
+    while (batch.size() < schedule_packets_ && has_queued()) {
+        Lane &lane = lanes_[current_];
+        if (lane.queue.empty()) {
+            // An idle lane banks no credit, or it would burst when it resumes.
+            lane.deficit = 0.0;
+            next_lane();
+            continue;
+        }
+        if (!turn_open_) {
+            lane.deficit += lane.quantum;
+            turn_open_ = true;
+        }
+        const std::size_t count = std::min({
+            static_cast<std::size_t>(lane.deficit), lane.queue.size(), schedule_packets_ - batch.size()
+        });
+        for (std::size_t i = 0; i < count; ++i) {
+            batch.push_back(std::move(lane.queue.front()));
+            lane.queue.pop_front();
+        }
+        lane.deficit -= static_cast<double>(count);
+        lane.written += count;
+        if (lane.queue.empty()) {
+            lane.deficit = 0.0;
+            next_lane();
+        } else if (lane.deficit < 1.0) {
+            next_lane();
+        }
+        // Otherwise the batch is full and the lane resumes its turn next round.
+    }
+}
+
+void StreamMultiplexer::run() {
+    std::vector<Packet> batch;
+    batch.reserve(schedule_packets_);
+    while (true) {
+        {
+            std::unique_lock lock(mutex_);
+            ready_.wait(lock, [&] { return stopped_ || has_queued() || all_closed(); });
+            if (stopped_) {
+                return;
+            }
+            if (!has_queued()) {
+                break; // every lane closed and drained
+            }
+            batch.clear();
+            schedule(batch);
+        }
+        space_.notify_all();
+        try {
+            sink_.encode_packets(batch);
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+    try {
+        sink_.finalize();
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+void StreamMultiplexer::LaneSink::encode_packets(const std::span<const Packet> packets) {
+    if (!mux_.submit(lane_, packets)) {
+        throw std::runtime_error("stream multiplexer stopped");
+    }
+}
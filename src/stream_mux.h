@@ -0,0 +1,119 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "encoder.h"
+#include "packet_sink.h"
+
+// Shares one packet sink, typically a live stream, between several producers.
+// Each producer writes into a lane with a weight, and the packets are
+// interleaved into the sink by deficit round robin: every turn a lane may send
+// its weight (relative to the lightest lane) in packets, so under contention
+// each lane gets frame capacity in proportion to its weight, and a lane with
+// nothing queued gives its share to the others. A full lane blocks its
+// producer, so a fast FEC encoder cannot run ahead of the stream. The sink is
+// borrowed.
+class StreamMultiplexer {
+public:
+    // lane_capacity is in packets; schedule_packets is how many packets one
+    // scheduling round hands to the sink, usually a frame's worth.
+    StreamMultiplexer(PacketSink &sink, std::size_t schedule_packets, std::size_t lane_capacity);
+
+    // Adds a producer lane. Call before run(). Throws std::invalid_argument
+    // unless weight is positive.
+    std::size_t add_lane(double weight);
+
+    // Queues packets on a lane, blocking while it is full. False if the
+    // multiplexer stopped before all of them were queued.
+    bool submit(std::size_t lane, std::span<const Packet> packets);
+
+    // The lane will get no more packets.
+    void close_lane(std::size_t lane);
+
+    // Feeds the sink until every lane is closed and drained, then finalizes
+    // it. If the sink throws, producers are released (submit returns false)
+    // and the exception propagates.
+    void run();
+
+    // Ends run() early and releases producers; queued packets are dropped and
+    // the sink is not finalized.
+    void stop();
+
+    [[nodiscard]] std::size_t lane_count() const;
+
+    [[nodiscard]] uint64_t packets_written(std::size_t lane) const;
+
+    // A lane as a PacketSink, so a job writes into the multiplexer with the
+    // same code that writes a file or a stream of its own. finalize() closes
+    // the lane; encode_packets throws std::runtime_error once stopped.
+    class LaneSink final : public PacketSink {
+    public:
+        LaneSink(StreamMultiplexer &mux, const std::size_t lane) : mux_(mux), lane_(lane) {
+        }
+
+        void encode_packets(std::span<const Packet> packets) override;
+
+        void finalize() override { mux_.close_lane(lane_); }
+
+        // Frames are the shared sink's; a lane has none of its own.
+        [[nodiscard]] int64_t frames_written() const override { return 0; }
+
+    private:
+        StreamMultiplexer &mux_;
+        std::size_t lane_;
+    };
+
+private:
+    struct Lane {
+        double quantum = 1.0; // packets per turn
+        double deficit = 0.0;
+        std::deque<Packet> queue;
+        bool closed = false;
+        uint64_t written = 0;
+    };
+
+    // Moves up to one round of packets into batch by deficit round robin.
+    void schedule(std::vector<Packet> &batch);
+
+    void next_lane();
+
+    [[nodiscard]] bool has_queued() const;
+
+    [[nodiscard]] bool all_closed() const;
+
+    PacketSink &sink_;
+    std::size_t schedule_packets_;
+    std::size_t lane_capacity_;
+    std::vector<double> weights_;
+    std::vector<Lane> lanes_;
+    std::size_t current_ = 0;
+    bool turn_open_ = false;
+    bool stopped_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::condition_variable space_;
+};
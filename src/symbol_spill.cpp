@@ -0,0 +1,98 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "symbol_spill.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+
+static std::string make_spill_path(const std::string &directory) {
+    static std::atomic<uint64_t> counter{0};
+    const std::filesystem::path dir = directory.empty()
+                                          ? std::filesystem::temp_directory_path()
+                                          : std::filesystem::path(directory);
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    return (dir / ("media_storage_spill_" + std::to_string(stamp) + "_" +
+                   std::to_string(counter.fetch_add(1)) + ".bin")).string();
+}
+
+SymbolSpill::SymbolSpill(const std::string &directory)
+    : path_(make_spill_path(directory))
+      , file_(path_, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc) {
+    if (!file_) {
+        throw std::runtime_error("failed to create spill file");
+    }
+}
+
+SymbolSpill::~SymbolSpill() {
+    file_.close();
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+}
+
+void SymbolSpill::append(const uint32_t chunk_index, const uint32_t esi, const std::span<const std::byte> symbol) {
+    if (symbol.size() > std::numeric_limits<uint16_t>::max()) {
+        throw std::invalid_argument("symbol too large to spill");
+    }
+    const auto length = static_cast<uint16_t>(symbol.size());
+
+    std::array<char, RECORD_HEADER_SIZE> header{};
+    std::memcpy(header.data(), &chunk_index, sizeof(chunk_index));
+    std::memcpy(header.data() + 4, &esi, sizeof(esi));
+    std::memcpy(header.data() + 8, &length, sizeof(length));
+
+    file_.seekp(static_cast<std::streamoff>(end_));
+    file_.write(header.data(), header.size());
+    file_.write(reinterpret_cast<const char *>(symbol.data()), static_cast<std::streamsize>(symbol.size()));
+    if (!file_) {
+        throw std::runtime_error("spill write failed");
+    }
+
+    index_[chunk_index].push_back(Record{end_, esi, length});
+    end_ += RECORD_HEADER_SIZE + symbol.size();
+}
+
+std::vector<SpilledSymbol> SymbolSpill::take(const uint32_t chunk_index) {
+    const auto it = index_.find(chunk_index);
+    if (it == index_.end()) {
+        return {};
+    }
+
+    file_.flush();
+    std::vector<SpilledSymbol> symbols;
+    symbols.reserve(it->second.size());
+    for (const auto &[offset, esi, length]: it->second) {
+        SpilledSymbol symbol{esi, std::vector<std::byte>(length)};
+        file_.seekg(static_cast<std::streamoff>(offset + RECORD_HEADER_SIZE));
+        file_.read(reinterpret_cast<char *>(symbol.data.data()), length);
+        if (!file_) {
+            throw std::runtime_error("spill read failed");
+        }
+        symbols.push_back(std::move(symbol));
+    }
+    index_.erase(it);
+    return symbols;
+}
+
+std::size_t SymbolSpill::symbol_count(const uint32_t chunk_index) const {
+    const auto it = index_.find(chunk_index);
+    return it == index_.end() ? 0 : it->second.size();
+}
@@ -0,0 +1,77 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct SpilledSymbol {
+    uint32_t esi = 0;
+    std::vector<std::byte> data;
+};
+
+// Append-only scratch file holding FEC symbols of chunks that were evicted from
+// memory. Records are {chunk_index u32, esi u32, length u16, payload}; the
+// per-chunk record index lives in memory. Space is reclaimed when the spill is
+// destroyed, which also deletes the file.
+class SymbolSpill {
+public:
+    explicit SymbolSpill(const std::string &directory);
+
+    ~SymbolSpill();
+
+    SymbolSpill(const SymbolSpill &) = delete;
+
+    SymbolSpill &operator=(const SymbolSpill &) = delete;
+
+    SymbolSpill(SymbolSpill &&) = delete;
+
+    SymbolSpill &operator=(SymbolSpill &&) = delete;
+
+    void append(uint32_t chunk_index, uint32_t esi, std::span<const std::byte> symbol);
+
+    [[nodiscard]] std::vector<SpilledSymbol> take(uint32_t chunk_index);
+
+    [[nodiscard]] bool contains(uint32_t chunk_index) const { return index_.contains(chunk_index); }
+
+    [[nodiscard]] std::size_t symbol_count(uint32_t chunk_index) const;
+
+    [[nodiscard]] std::size_t chunk_count() const { return index_.size(); }
+
+    [[nodiscard]] uint64_t bytes_written() const { return end_; }
+
+private:
+    struct Record {
+        uint64_t offset;
+        uint32_t esi;
+        uint16_t length;
+    };
+
+    static constexpr std::size_t RECORD_HEADER_SIZE = 10;
+
+    std::string path_;
+    std::fstream file_;
+    uint64_t end_ = 0;
+    std::unordered_map<uint32_t, std::vector<Record> > index_;
+};
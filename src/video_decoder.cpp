@@ -21,24 +21,143 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdlib>
 #include <cstring>
+#include <omp.h>
 #include <span>
 #include <stdexcept>
 
-VideoDecoder::VideoDecoder(const std::string &input_path) {
-    init_decoder(input_path);
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+namespace {
+    constexpr int FOLLOW_IO_BUFFER_SIZE = 1 << 16;
+    // Frame threads fill their pipeline over the first frames; the adaptive
+    // mode measures the frames after that.
+    constexpr int64_t ADAPTIVE_WARMUP_FRAMES = 8;
+    constexpr int64_t ADAPTIVE_SAMPLE_FRAMES = 32;
+
+    int read_follow(void *opaque, uint8_t *buf, const int buf_size) {
+        auto *reader = static_cast<FollowReader *>(opaque);
+        const std::size_t got = reader->read(reinterpret_cast<std::byte *>(buf), static_cast<std::size_t>(buf_size));
+        return got > 0 ? static_cast<int>(got) : AVERROR_EOF;
+    }
+
+    bool has_title(const AVStream *stream, const char *name) {
+        const AVDictionaryEntry *title = av_dict_get(stream->metadata, "title", nullptr, 0);
+        return title && std::strcmp(title->value, name) == 0;
+    }
+
+    bool is_raw_packet_track(const AVStream *stream) {
+        return stream->codecpar->codec_id == AV_CODEC_ID_RAWVIDEO && has_title(stream, RAW_PACKET_TRACK_NAME);
+    }
+
+    bool is_audio_data_track(const AVStream *stream) {
+        return stream->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+               stream->codecpar->codec_id == AV_CODEC_ID_PCM_S16LE && has_title(stream, AUDIO_DATA_TRACK_NAME);
+    }
+
+    // Slices per frame VideoEncoder was asked for, 0 if it left the codec
+    // default (or the video was made elsewhere).
+    int stream_slices(const AVStream *stream) {
+        const AVDictionaryEntry *slices = av_dict_get(stream->metadata, SLICES_TAG, nullptr, 0);
+        return slices ? std::max(0, std::atoi(slices->value)) : 0;
+    }
+
+    // Whether the first plane is 8-bit luma, one byte per pixel: gray, planar
+    // and semi-planar YUV as lossy decoders output them. Full-range variants
+    // qualify too; the block projections have zero mean, so a linear range
+    // change does not flip a bit.
+    bool has_plain_luma_plane(const int format) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(format));
+        if (!desc || desc->nb_components == 0 ||
+            (desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM |
+                            AV_PIX_FMT_FLAG_HWACCEL))) {
+            return false;
+        }
+        const AVComponentDescriptor &luma = desc->comp[0];
+        return luma.plane == 0 && luma.step == 1 && luma.offset == 0 && luma.shift == 0 && luma.depth == 8;
+    }
+
+    double seconds(const std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration<double>(duration).count();
+    }
+}
+
+VideoDecoder::VideoDecoder(const std::string &input_path, const VideoDecoderOptions &options) {
+    // The destructor does not run for a constructor that throws.
+    try {
+        init_decoder(input_path, options);
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+VideoDecoder::VideoDecoder(const AVCodecParameters *video_params, const VideoDecoderOptions &options) {
+    layout_ = compute_frame_layout(video_params->width, video_params->height);
+    try {
+        init_codec(video_params, options, 0);
+    } catch (...) {
+        release();
+        throw;
+    }
 }
 
 VideoDecoder::~VideoDecoder() {
-    if (sws_ctx_) sws_freeContext(sws_ctx_);
+    release();
+}
+
+void VideoDecoder::release() {
+    if (sws_ctx_) {
+        sws_freeContext(sws_ctx_);
+        sws_ctx_ = nullptr;
+    }
     if (av_packet_) av_packet_free(&av_packet_);
     if (gray_frame_) av_frame_free(&gray_frame_);
     if (frame_) av_frame_free(&frame_);
     if (codec_ctx_) avcodec_free_context(&codec_ctx_);
     if (format_ctx_) avformat_close_input(&format_ctx_);
+    if (avio_ctx_) {
+        av_freep(&avio_ctx_->buffer);
+        avio_context_free(&avio_ctx_);
+    }
+}
+
+void VideoDecoder::init_follow_io(const std::string &input_path, const VideoDecoderOptions &options) {
+    follow_reader_ = std::make_unique<FollowReader>(input_path, options.follow_idle_timeout_ms,
+                                                    options.follow_poll_interval_ms);
+    if (options.follow_wait) {
+        follow_reader_->set_wait_callback(options.follow_wait);
+    }
+
+    auto *buffer = static_cast<unsigned char *>(av_malloc(FOLLOW_IO_BUFFER_SIZE));
+    if (!buffer) {
+        throw std::runtime_error("Failed to allocate IO buffer");
+    }
+
+    // Non-seekable on purpose: the demuxer must not jump to the (not yet written) end of the file.
+    avio_ctx_ = avio_alloc_context(buffer, FOLLOW_IO_BUFFER_SIZE, 0, follow_reader_.get(),
+                                   read_follow, nullptr, nullptr);
+    if (!avio_ctx_) {
+        av_free(buffer);
+        throw std::runtime_error("Failed to allocate IO context");
+    }
+
+    format_ctx_ = avformat_alloc_context();
+    if (!format_ctx_) {
+        throw std::runtime_error("Failed to allocate format context");
+    }
+    format_ctx_->pb = avio_ctx_;
+    format_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
 }
 
-void VideoDecoder::init_decoder(const std::string &input_path) {
+void VideoDecoder::init_decoder(const std::string &input_path, const VideoDecoderOptions &options) {
+    if (options.follow) {
+        init_follow_io(input_path, options);
+    }
+
     int ret = avformat_open_input(&format_ctx_, input_path.c_str(), nullptr, nullptr);
     if (ret < 0) {
         throw std::runtime_error("Failed to open input file");
@@ -50,9 +169,18 @@ void VideoDecoder::init_decoder(const std::string &input_path) {
     }
 
     for (unsigned i = 0; i < format_ctx_->nb_streams; ++i) {
-        if (format_ctx_->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+        const AVStream *candidate = format_ctx_->streams[i];
+        if (is_audio_data_track(candidate)) {
+            if (audio_stream_index_ < 0) audio_stream_index_ = static_cast<int>(i);
+            continue;
+        }
+        if (candidate->codecpar->codec_type != AVMEDIA_TYPE_VIDEO) {
+            continue;
+        }
+        if (is_raw_packet_track(candidate)) {
+            if (raw_stream_index_ < 0) raw_stream_index_ = static_cast<int>(i);
+        } else if (video_stream_index_ < 0) {
             video_stream_index_ = static_cast<int>(i);
-            break;
         }
     }
 
@@ -60,8 +188,33 @@ void VideoDecoder::init_decoder(const std::string &input_path) {
         throw std::runtime_error("No video stream found");
     }
 
-    const AVStream *stream = format_ctx_->streams[video_stream_index_];
-    const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    av_packet_ = av_packet_alloc();
+    if (!av_packet_) {
+        throw std::runtime_error("Failed to allocate packet");
+    }
+
+    const AVCodecParameters *video_par = format_ctx_->streams[video_stream_index_]->codecpar;
+    layout_ = compute_frame_layout(video_par->width, video_par->height);
+
+    // The demuxer skips the blocks of discarded tracks, so only the tracks that
+    // are actually read cost I/O. The raw track holds the audio data too.
+    read_raw_ = raw_stream_index_ >= 0 && options.use_raw_packet_track;
+    if (read_raw_) {
+        format_ctx_->streams[video_stream_index_]->discard = AVDISCARD_ALL;
+        if (audio_stream_index_ >= 0) {
+            format_ctx_->streams[audio_stream_index_]->discard = AVDISCARD_ALL;
+        }
+        return;
+    }
+    if (raw_stream_index_ >= 0) {
+        format_ctx_->streams[raw_stream_index_]->discard = AVDISCARD_ALL;
+    }
+    init_codec(video_par, options, stream_slices(format_ctx_->streams[video_stream_index_]));
+}
+
+void VideoDecoder::init_codec(const AVCodecParameters *video_params, const VideoDecoderOptions &options,
+                              const int slices) {
+    const AVCodec *codec = avcodec_find_decoder(video_params->codec_id);
     if (!codec) {
         throw std::runtime_error("Failed to find decoder");
     }
@@ -71,13 +224,19 @@ void VideoDecoder::init_decoder(const std::string &input_path) {
         throw std::runtime_error("Failed to allocate codec context");
     }
 
-    ret = avcodec_parameters_to_context(codec_ctx_, stream->codecpar);
+    int ret = avcodec_parameters_to_context(codec_ctx_, video_params);
     if (ret < 0) {
         throw std::runtime_error("Failed to copy codec parameters");
     }
 
-    codec_ctx_->thread_count = 0;
-    codec_ctx_->thread_type = FF_THREAD_SLICE;
+    const AVCodecDescriptor *descriptor = avcodec_descriptor_get(video_params->codec_id);
+    const bool intra_only = descriptor && (descriptor->props & AV_CODEC_PROP_INTRA_ONLY);
+    const DecoderThreading threading = choose_decoder_threading(intra_only, slices, options.decoder_threads,
+                                                                omp_get_max_threads());
+    codec_ctx_->thread_count = threading.thread_count;
+    codec_ctx_->thread_type = (threading.frame_threads ? FF_THREAD_FRAME : 0) |
+                              (threading.slice_threads ? FF_THREAD_SLICE : 0);
+    adaptive_ = options.adaptive_threads;
 
     ret = avcodec_open2(codec_ctx_, codec, nullptr);
     if (ret < 0) {
@@ -85,41 +244,65 @@ void VideoDecoder::init_decoder(const std::string &input_path) {
     }
 
     frame_ = av_frame_alloc();
-    av_packet_ = av_packet_alloc();
+    if (!frame_) {
+        throw std::runtime_error("Failed to allocate frame");
+    }
+
+    extract_buffer_.reserve(static_cast<std::size_t>(layout_.bytes_per_frame) * 2);
+}
 
-    if (!frame_ || !av_packet_) {
-        throw std::runtime_error("Failed to allocate frame/packet");
+// Set up on the first frame rather than at open: lossy decoders may only
+// settle their output format once they have seen the bitstream.
+void VideoDecoder::init_luma_path(const int format, const int width, const int height) {
+    if (sws_ctx_) {
+        sws_freeContext(sws_ctx_);
+        sws_ctx_ = nullptr;
     }
-    is_gray8_ = (codec_ctx_->pix_fmt == AV_PIX_FMT_GRAY8);
+    if (gray_frame_) av_frame_free(&gray_frame_);
 
-    if (!is_gray8_) {
-        gray_frame_ = av_frame_alloc();
-        if (!gray_frame_) {
-            throw std::runtime_error("Failed to allocate gray frame");
-        }
+    luma_format_ = format;
+    luma_direct_ = has_plain_luma_plane(format);
+    if (luma_direct_) {
+        return;
+    }
 
-        gray_frame_->format = AV_PIX_FMT_GRAY8;
-        gray_frame_->width = codec_ctx_->width;
-        gray_frame_->height = codec_ctx_->height;
+    gray_frame_ = av_frame_alloc();
+    if (!gray_frame_) {
+        throw std::runtime_error("Failed to allocate gray frame");
+    }
 
-        ret = av_frame_get_buffer(gray_frame_, 0);
-        if (ret < 0) {
-            throw std::runtime_error("Failed to allocate gray frame buffer");
-        }
+    gray_frame_->format = AV_PIX_FMT_GRAY8;
+    gray_frame_->width = width;
+    gray_frame_->height = height;
+
+    if (av_frame_get_buffer(gray_frame_, 0) < 0) {
+        throw std::runtime_error("Failed to allocate gray frame buffer");
+    }
 
-        sws_ctx_ = sws_getContext(
-            codec_ctx_->width, codec_ctx_->height, codec_ctx_->pix_fmt,
-            codec_ctx_->width, codec_ctx_->height, AV_PIX_FMT_GRAY8,
-            SWS_POINT, nullptr, nullptr, nullptr
-        );
+    sws_ctx_ = sws_getContext(
+        width, height, static_cast<AVPixelFormat>(format),
+        width, height, AV_PIX_FMT_GRAY8,
+        SWS_POINT, nullptr, nullptr, nullptr
+    );
 
-        if (!sws_ctx_) {
-            throw std::runtime_error("Failed to create swscale context");
-        }
+    if (!sws_ctx_) {
+        throw std::runtime_error("Failed to create swscale context");
     }
+}
 
-    layout_ = compute_frame_layout(codec_ctx_->width, codec_ctx_->height);
-    extract_buffer_.reserve(static_cast<std::size_t>(layout_.bytes_per_frame) * 2);
+void VideoDecoder::sample_stage_times(const std::chrono::steady_clock::time_point started,
+                                      const std::chrono::steady_clock::time_point decoded) {
+    const auto now = std::chrono::steady_clock::now();
+    if (frame_index_ > ADAPTIVE_WARMUP_FRAMES) {
+        stage_times_.decode_seconds += seconds(decoded - started);
+        stage_times_.extract_seconds += seconds(now - decoded);
+        stage_times_.consume_seconds += seconds(started - last_return_);
+        if (++stage_times_.frames == ADAPTIVE_SAMPLE_FRAMES) {
+            extract_threads_ = balance_extract_threads(stage_times_, omp_get_max_threads(), frame_threaded());
+            adaptive_ = false;
+        }
+    }
+    last_return_ = now;
 }
 
 int64_t VideoDecoder::total_frames() const {
@@ -138,59 +321,8 @@ int64_t VideoDecoder::total_frames() const {
 }
 
 void VideoDecoder::extract_data_into(std::vector<std::byte> &dest) const {
-#if defined(__APPLE__) && defined(_OPENMP)
-    const auto &projections = get_decoder_projections();
-    const auto &vectors = projections.vectors;
-#else
-    const auto &vectors = get_decoder_projections().vectors;
-#endif
-
-    const int blocks_per_row = layout_.blocks_per_row;
-    const int total_blocks = layout_.total_blocks;
-    constexpr int blocks_per_byte = 8 / BITS_PER_BLOCK;
-
-    const int total_bytes = total_blocks / blocks_per_byte;
-    const uint8_t *src_base;
-    int src_stride;
-    if (is_gray8_) {
-        src_base = frame_->data[0];
-        src_stride = frame_->linesize[0];
-    } else {
-        src_base = gray_frame_->data[0];
-        src_stride = gray_frame_->linesize[0];
-    }
-
-    const std::size_t base = dest.size();
-    dest.resize(base + total_bytes);
-    auto *out = reinterpret_cast<uint8_t *>(dest.data() + base);
-    std::memset(out, 0, total_bytes);
-
-#pragma omp parallel for schedule(static)
-    for (int byte_idx = 0; byte_idx < total_bytes; ++byte_idx) {
-        uint8_t current_byte = 0;
-
-        for (int sub = 0; sub < blocks_per_byte; ++sub) {
-            const int block_idx = byte_idx * blocks_per_byte + sub;
-            const int block_row = block_idx / blocks_per_row;
-            const int block_col = block_idx % blocks_per_row;
-            const int base_x = block_col * 8;
-            const int base_y = block_row * 8;
-
-            alignas(32) float block_flat[64];
-            for (int y = 0; y < 8; ++y) {
-                const uint8_t *row = src_base + (base_y + y) * src_stride + base_x;
-                for (int x = 0; x < 8; ++x)
-                    block_flat[y * 8 + x] = static_cast<float>(row[x]);
-            }
-
-            for (int b = 0; b < BITS_PER_BLOCK; ++b) {
-                const float sum = dot_product_64(block_flat, vectors[b]);
-                current_byte = (current_byte << 1) | (sum > 0.0f ? 1 : 0);
-            }
-        }
-
-        out[byte_idx] = current_byte;
-    }
+    const AVFrame *luma = luma_direct_ ? frame_ : gray_frame_;
+    extract_frame_data(luma->data[0], luma->linesize[0], layout_, dest, extract_threads_);
 }
 
 std::vector<std::byte> VideoDecoder::extract_data_from_frame() const {
@@ -199,45 +331,15 @@ std::vector<std::byte> VideoDecoder::extract_data_from_frame() const {
     return data;
 }
 
-std::size_t get_packet_size(const std::span<const std::byte> data) {
-    if (data.size() < 5) {
-        return HEADER_SIZE + SYMBOL_SIZE_BYTES;
-    }
-    const auto version = static_cast<uint8_t>(data[4]);
-    return (version == VERSION_ID_V2)
-               ? (HEADER_SIZE_V2 + SYMBOL_SIZE_BYTES)
-               : (HEADER_SIZE + SYMBOL_SIZE_BYTES);
-}
-
 void VideoDecoder::extract_packets_from_buffer(std::vector<std::byte> &accumulated,
                                                std::vector<std::vector<std::byte> > &out_packets) {
-    std::size_t offset = 0;
-
-    while (offset + 4 <= accumulated.size()) {
-        uint32_t magic = 0;
-        std::memcpy(&magic, accumulated.data() + offset, sizeof(magic));
-        if (magic == MAGIC_ID) {
-            const std::size_t pkt_size = get_packet_size(
-                std::span<const std::byte>(accumulated.data() + offset,
-                                           accumulated.size() - offset));
-            if (offset + pkt_size > accumulated.size()) break;
-            out_packets.emplace_back(
-                accumulated.begin() + static_cast<std::ptrdiff_t>(offset),
-                accumulated.begin() + static_cast<std::ptrdiff_t>(offset + pkt_size));
-            offset += pkt_size;
-        } else {
-            ++offset;
-        }
-    }
-
-    accumulated.erase(accumulated.begin(),
-                      accumulated.begin() + static_cast<std::ptrdiff_t>(offset));
+    split_packets(accumulated, out_packets);
 }
 
 std::vector<std::vector<std::byte> > VideoDecoder::extract_packets_from_frame() const {
     const auto raw_data = extract_data_from_frame();
     std::vector<std::vector<std::byte> > packets;
-    const std::size_t packet_size = get_packet_size(std::span(raw_data));
+    const std::size_t packet_size = packet_size_at(std::span(raw_data));
     packets.reserve(raw_data.size() / packet_size);
     std::size_t offset = 0;
     while (offset + packet_size <= raw_data.size()) {
@@ -258,7 +360,10 @@ std::vector<std::vector<std::byte> > VideoDecoder::extract_packets_from_frame()
 }
 
 void VideoDecoder::prepare_frame_for_extraction() {
-    if (!is_gray8_) {
+    if (frame_->format != luma_format_) {
+        init_luma_path(frame_->format, frame_->width, frame_->height);
+    }
+    if (!luma_direct_) {
         sws_scale(sws_ctx_, frame_->data, frame_->linesize, 0, frame_->height,
                   gray_frame_->data, gray_frame_->linesize);
     }
@@ -292,12 +397,102 @@ std::vector<std::vector<std::byte> > VideoDecoder::flush_decoder_and_collect_pac
     return collected;
 }
 
+std::vector<std::vector<std::byte> > VideoDecoder::read_raw_packets() {
+    while (av_read_frame(format_ctx_, av_packet_) >= 0) {
+        if (av_packet_->stream_index != raw_stream_index_) {
+            av_packet_unref(av_packet_);
+            continue;
+        }
+
+        const auto *data = reinterpret_cast<const std::byte *>(av_packet_->data);
+        extract_buffer_.insert(extract_buffer_.end(), data, data + av_packet_->size);
+        av_packet_unref(av_packet_);
+        ++frame_index_;
+
+        std::vector<std::vector<std::byte> > packets;
+        extract_packets_from_buffer(extract_buffer_, packets);
+        return packets;
+    }
+
+    eof_ = true;
+    return {};
+}
+
+std::vector<std::vector<std::byte> > VideoDecoder::take_audio_packets() {
+    const auto *data = reinterpret_cast<const std::byte *>(av_packet_->data);
+    auto packets = decode_audio(std::span(data, static_cast<std::size_t>(av_packet_->size)));
+    av_packet_unref(av_packet_);
+    return packets;
+}
+
+std::vector<std::vector<std::byte> > VideoDecoder::decode_audio(const std::span<const std::byte> samples) {
+    audio_buffer_.insert(audio_buffer_.end(), samples.begin(), samples.end());
+
+    std::vector<std::vector<std::byte> > packets;
+    extract_packets_from_buffer(audio_buffer_, packets);
+    return packets;
+}
+
+std::vector<std::vector<std::byte> > VideoDecoder::decode_packet(const AVPacket *packet) {
+    if (!packet) {
+        auto packets = flush_decoder_and_collect_packets();
+        extract_packets_from_buffer(extract_buffer_, packets);
+        return packets;
+    }
+
+    if (avcodec_send_packet(codec_ctx_, packet) < 0) {
+        return {};
+    }
+    std::vector<std::vector<std::byte> > packets;
+    while (true) {
+        const int ret = avcodec_receive_frame(codec_ctx_, frame_);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            break;
+        }
+        if (ret < 0) {
+            throw std::runtime_error("Error receiving frame");
+        }
+        prepare_frame_for_extraction();
+        for (auto &p: accumulate_frame_and_extract_packets()) {
+            packets.push_back(std::move(p));
+        }
+    }
+    return packets;
+}
+
+std::vector<std::vector<std::byte> > VideoDecoder::take_decoded_frame(
+    const std::chrono::steady_clock::time_point started) {
+    const auto decoded = std::chrono::steady_clock::now();
+    prepare_frame_for_extraction();
+    auto packets = accumulate_frame_and_extract_packets();
+    if (adaptive_) {
+        sample_stage_times(started, decoded);
+    }
+    return packets;
+}
+
 std::vector<std::vector<std::byte> > VideoDecoder::decode_next_frame() {
     if (eof_) {
         return {};
     }
+    if (read_raw_) {
+        return read_raw_packets();
+    }
 
+    const auto started = std::chrono::steady_clock::now();
+    // Decoders with delay, frame threads among them, can hold more than one
+    // finished frame. Hand those out before feeding more packets, so that
+    // avcodec_send_packet never has to refuse one.
+    if (avcodec_receive_frame(codec_ctx_, frame_) == 0) {
+        return take_decoded_frame(started);
+    }
     while (av_read_frame(format_ctx_, av_packet_) >= 0) {
+        if (av_packet_->stream_index == audio_stream_index_) {
+            if (auto packets = take_audio_packets(); !packets.empty()) {
+                return packets;
+            }
+            continue;
+        }
         if (av_packet_->stream_index != video_stream_index_) {
             av_packet_unref(av_packet_);
             continue;
@@ -321,8 +516,7 @@ std::vector<std::vector<std::byte> > VideoDecoder::decode_next_frame() {
             throw std::runtime_error("Error receiving frame");
         }
 
-        prepare_frame_for_extraction();
-        return accumulate_frame_and_extract_packets();
+        return take_decoded_frame(started);
     }
 
     eof_ = true;
@@ -337,6 +531,27 @@ std::vector<std::vector<std::byte> > VideoDecoder::decode_next_frame() {
     return {};
 }
 
+bool VideoDecoder::seek_to_frame(const int64_t frame) {
+    if (follow_reader_ || !format_ctx_ || frame < 0) {
+        return false;
+    }
+    const int stream_index = read_raw_ ? raw_stream_index_ : video_stream_index_;
+    const AVStream *stream = format_ctx_->streams[stream_index];
+    const int64_t timestamp = av_rescale_q(frame, {1, FRAME_FPS}, stream->time_base);
+    if (av_seek_frame(format_ctx_, stream_index, timestamp, AVSEEK_FLAG_BACKWARD) < 0) {
+        return false;
+    }
+    if (codec_ctx_) {
+        avcodec_flush_buffers(codec_ctx_);
+    }
+    // Leftovers belong to the frames before the seek point.
+    extract_buffer_.clear();
+    audio_buffer_.clear();
+    frame_index_ = frame;
+    eof_ = false;
+    return true;
+}
+
 std::vector<std::vector<std::byte> > VideoDecoder::decode_all_frames() {
     std::vector<std::vector<std::byte> > results;
     while (!eof_) {
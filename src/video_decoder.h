@@ -18,7 +18,11 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -29,11 +33,37 @@ extern "C" {
 #include <libswscale/swscale.h>
 }
 
+#include "decode_threads.h"
+#include "follow_reader.h"
 #include "video_encoder.h"
 
+struct VideoDecoderOptions {
+    // Keep reading a recording that is still being written instead of stopping
+    // at its current end; gives up once no new data arrives for the idle timeout.
+    bool follow = false;
+    int follow_idle_timeout_ms = 10000;
+    int follow_poll_interval_ms = 200;
+    // Called whenever a followed read waits for the writer; returning false
+    // ends the input there, so a cancelled caller is not held until the timeout.
+    std::function<bool()> follow_wait;
+    // Read packets from the raw packet track when the file has one, skipping
+    // video decode and extraction entirely.
+    bool use_raw_packet_track = true;
+    // FFmpeg decoder threads (0 = chosen by codec, see choose_decoder_threading).
+    int decoder_threads = 0;
+    // Time the decoder, block extraction and the caller's work over the first
+    // frames, then size the extraction team so frame-threaded decoding keeps
+    // the cores it needs. The codec's own threads are fixed once it is open.
+    bool adaptive_threads = false;
+};
+
 class VideoDecoder {
 public:
-    explicit VideoDecoder(const std::string &input_path);
+    explicit VideoDecoder(const std::string &input_path, const VideoDecoderOptions &options = {});
+
+    // Packet-fed decoder with no container: compressed frames of a stream
+    // described by video_params are handed in through decode_packet().
+    explicit VideoDecoder(const AVCodecParameters *video_params, const VideoDecoderOptions &options = {});
 
     ~VideoDecoder();
 
@@ -49,12 +79,49 @@ public:
 
     std::vector<std::vector<std::byte> > decode_all_frames();
 
+    // Continues reading at the given frame. Every ffv1 frame is a keyframe, so
+    // the seek is exact up to the demuxer's index. False for followed or
+    // unseekable inputs, whose position is then unchanged.
+    bool seek_to_frame(int64_t frame);
+
+    // Decodes one compressed video packet, or drains the codec when packet is
+    // null, and returns the packets extracted from the resulting frames.
+    std::vector<std::vector<std::byte> > decode_packet(const AVPacket *packet);
+
+    // Returns the packets carried by a chunk of audio data track samples.
+    std::vector<std::vector<std::byte> > decode_audio(std::span<const std::byte> samples);
+
     [[nodiscard]] int64_t frames_read() const { return frame_index_; }
 
     [[nodiscard]] int64_t total_frames() const;
 
     [[nodiscard]] bool is_eof() const { return eof_; }
 
+    [[nodiscard]] int frame_width() const { return layout_.frame_width; }
+
+    [[nodiscard]] int frame_height() const { return layout_.frame_height; }
+
+    [[nodiscard]] bool has_raw_packet_track() const { return raw_stream_index_ >= 0; }
+
+    [[nodiscard]] bool has_audio_data_track() const { return audio_stream_index_ >= 0; }
+
+    // Whether packets come from the raw packet track rather than the pixels.
+    [[nodiscard]] bool reads_raw_packet_track() const { return read_raw_; }
+
+    // Threads the codec runs, 0 before it is open or when packets come from
+    // the raw track.
+    [[nodiscard]] int decoder_threads() const { return codec_ctx_ ? codec_ctx_->thread_count : 0; }
+
+    [[nodiscard]] bool frame_threaded() const {
+        return codec_ctx_ && (codec_ctx_->active_thread_type & FF_THREAD_FRAME);
+    }
+
+    // OpenMP team extracting blocks (0 = the default team).
+    [[nodiscard]] int extract_threads() const { return extract_threads_; }
+
+    // What the adaptive mode measured; frames is 0 until it has decided.
+    [[nodiscard]] const DecodeStageTimes &stage_times() const { return stage_times_; }
+
 private:
     AVFormatContext *format_ctx_ = nullptr;
     AVCodecContext *codec_ctx_ = nullptr;
@@ -62,15 +129,43 @@ private:
     AVFrame *gray_frame_ = nullptr;
     AVPacket *av_packet_ = nullptr;
     SwsContext *sws_ctx_ = nullptr;
+    AVIOContext *avio_ctx_ = nullptr;
+    std::unique_ptr<FollowReader> follow_reader_;
 
     int video_stream_index_ = -1;
+    int raw_stream_index_ = -1;
+    int audio_stream_index_ = -1;
     int64_t frame_index_ = 0;
     bool eof_ = false;
-    bool is_gray8_ = false;
+    bool read_raw_ = false;
+    // Frames whose first plane is 8-bit luma are read in place; others are
+    // converted into gray_frame_ first.
+    bool luma_direct_ = false;
+    int luma_format_ = -1;
     FrameLayout layout_{};
+    int extract_threads_ = 0;
+    bool adaptive_ = false;
+    DecodeStageTimes stage_times_{};
+    std::chrono::steady_clock::time_point last_return_{};
     std::vector<std::byte> extract_buffer_{};
+    std::vector<std::byte> audio_buffer_{};
+
+    void release();
+
+    void init_decoder(const std::string &input_path, const VideoDecoderOptions &options);
+
+    void init_follow_io(const std::string &input_path, const VideoDecoderOptions &options);
 
-    void init_decoder(const std::string &input_path);
+    void init_codec(const AVCodecParameters *video_params, const VideoDecoderOptions &options, int slices);
+
+    void init_luma_path(int format, int width, int height);
+
+    void sample_stage_times(std::chrono::steady_clock::time_point started,
+                            std::chrono::steady_clock::time_point decoded);
+
+    [[nodiscard]] std::vector<std::vector<std::byte> > read_raw_packets();
+
+    [[nodiscard]] std::vector<std::vector<std::byte> > take_audio_packets();
 
     [[nodiscard]] std::vector<std::byte> extract_data_from_frame() const;
 
@@ -86,4 +181,7 @@ private:
     [[nodiscard]] std::vector<std::vector<std::byte> > accumulate_frame_and_extract_packets();
 
     [[nodiscard]] std::vector<std::vector<std::byte> > flush_decoder_and_collect_packets();
+
+    [[nodiscard]] std::vector<std::vector<std::byte> > take_decoded_frame(
+        std::chrono::steady_clock::time_point started);
 };
@@ -23,28 +23,10 @@
 #include <iostream>
 #include <stdexcept>
 
-FrameLayout compute_frame_layout() {
-    return compute_frame_layout(FRAME_WIDTH, FRAME_HEIGHT);
-}
-
-FrameLayout compute_frame_layout(const int width, const int height) {
-    FrameLayout layout{};
-    layout.frame_width = width;
-    layout.frame_height = height;
-    layout.blocks_per_row = width / 8;
-    layout.blocks_per_col = height / 8;
-    layout.total_blocks = layout.blocks_per_row * layout.blocks_per_col;
-    layout.bits_per_frame = layout.total_blocks * BITS_PER_BLOCK;
-    layout.bytes_per_frame = layout.bits_per_frame / 8;
-    return layout;
-}
-
-std::size_t max_packet_bytes_per_frame() {
-    return static_cast<std::size_t>(compute_frame_layout().bytes_per_frame);
-}
-
-VideoEncoder::VideoEncoder(const std::string &output_path) {
-    init_encoder(output_path);
+VideoEncoder::VideoEncoder(const std::string &output_path, const int width, const int height,
+                           const VideoEncoderOptions &options)
+    : width_(width), height_(height) {
+    init_encoder(output_path, options);
 }
 
 VideoEncoder::~VideoEncoder() {
@@ -62,7 +44,7 @@ VideoEncoder::~VideoEncoder() {
     }
 }
 
-void VideoEncoder::init_encoder(const std::string &output_path) {
+void VideoEncoder::init_encoder(const std::string &output_path, const VideoEncoderOptions &options) {
     int ret = avformat_alloc_output_context2(&format_ctx, nullptr, nullptr, output_path.c_str());
     if (ret < 0 || !format_ctx) {
         throw std::runtime_error("Failed to create output context");
@@ -83,8 +65,8 @@ void VideoEncoder::init_encoder(const std::string &output_path) {
         throw std::runtime_error("Failed to allocate codec context");
     }
 
-    codec_ctx->width = FRAME_WIDTH;
-    codec_ctx->height = FRAME_HEIGHT;
+    codec_ctx->width = width_;
+    codec_ctx->height = height_;
     codec_ctx->time_base = {1, FRAME_FPS};
     codec_ctx->framerate = {FRAME_FPS, 1};
     codec_ctx->gop_size = 30;
@@ -92,6 +74,7 @@ void VideoEncoder::init_encoder(const std::string &output_path) {
     codec_ctx->pix_fmt = AV_PIX_FMT_GRAY8;
     codec_ctx->thread_count = 0;
     codec_ctx->thread_type = FF_THREAD_SLICE;
+    codec_ctx->slices = std::max(0, options.slices);
 
     if (format_ctx->oformat->flags & AVFMT_GLOBALHEADER) {
         codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
@@ -110,6 +93,13 @@ void VideoEncoder::init_encoder(const std::string &output_path) {
     }
 
     stream->time_base = codec_ctx->time_base;
+    if (options.slices > 0) {
+        av_dict_set_int(&stream->metadata, SLICES_TAG, options.slices, 0);
+    }
+
+    if (options.verify) {
+        verifier_ = std::make_unique<EncodeVerifier>(stream->codecpar);
+    }
 
     frame = av_frame_alloc();
     if (!frame) {
@@ -131,10 +121,10 @@ void VideoEncoder::init_encoder(const std::string &output_path) {
     }
 
     if (codec_ctx->pix_fmt != AV_PIX_FMT_GRAY8) {
-        gray_buffer.resize(static_cast<std::size_t>(FRAME_WIDTH) * FRAME_HEIGHT);
+        gray_buffer.resize(static_cast<std::size_t>(width_) * height_);
         sws_ctx = sws_getContext(
-            FRAME_WIDTH, FRAME_HEIGHT, AV_PIX_FMT_GRAY8,
-            FRAME_WIDTH, FRAME_HEIGHT, codec_ctx->pix_fmt,
+            width_, height_, AV_PIX_FMT_GRAY8,
+            width_, height_, codec_ctx->pix_fmt,
             SWS_POINT, nullptr, nullptr, nullptr
         );
         if (!sws_ctx) {
@@ -142,8 +132,21 @@ void VideoEncoder::init_encoder(const std::string &output_path) {
         }
     }
 
-    layout_ = compute_frame_layout();
-    frame_data_buffer.reserve(layout_.bytes_per_frame);
+    layout_ = compute_frame_layout(width_, height_);
+    pattern_set_ = options.pattern_set;
+    video_bytes_ = static_cast<std::size_t>(layout_.bytes_per_frame) / PACKET_SIZE * PACKET_SIZE;
+    frame_capacity_ = video_bytes_;
+    if (options.audio_data_track) {
+        frame_capacity_ += static_cast<std::size_t>(audio_packets_per_frame()) * PACKET_SIZE;
+    }
+    frame_data_buffer.reserve(frame_capacity_);
+
+    if (options.audio_data_track) {
+        add_audio_stream();
+    }
+    if (options.raw_packet_track) {
+        add_raw_stream();
+    }
 
     ret = avio_open(&format_ctx->pb, output_path.c_str(), AVIO_FLAG_WRITE);
     if (ret < 0) {
@@ -156,75 +159,121 @@ void VideoEncoder::init_encoder(const std::string &output_path) {
     }
 }
 
-int VideoEncoder::packets_per_frame() {
-    const auto layout = compute_frame_layout();
-    constexpr std::size_t packet_size = HEADER_SIZE_V2 + SYMBOL_SIZE_BYTES;
-    return static_cast<int>(layout.bytes_per_frame / packet_size);
+// Matroska only muxes audio, video and subtitle tracks, and attachments have to
+// be complete when the header is written. The packet bytes therefore go into a
+// GRAY8 rawvideo track one row high, one row per frame; readers take the
+// demuxed bytes as they are and never open a decoder for it.
+void VideoEncoder::add_raw_stream() {
+    raw_stream = avformat_new_stream(format_ctx, nullptr);
+    if (!raw_stream) {
+        throw std::runtime_error("Failed to create raw packet stream");
+    }
+
+    AVCodecParameters *par = raw_stream->codecpar;
+    par->codec_type = AVMEDIA_TYPE_VIDEO;
+    par->codec_id = AV_CODEC_ID_RAWVIDEO;
+    par->format = AV_PIX_FMT_GRAY8;
+    par->width = static_cast<int>(frame_capacity_);
+    par->height = 1;
+    raw_stream->time_base = {1, FRAME_FPS};
+    av_dict_set(&raw_stream->metadata, "title", RAW_PACKET_TRACK_NAME, 0);
+}
+
+void VideoEncoder::write_raw_packet() {
+    AVPacket *raw = av_packet_alloc();
+    if (!raw) {
+        throw std::runtime_error("Failed to allocate packet");
+    }
+
+    int ret = av_new_packet(raw, static_cast<int>(frame_data_buffer.size()));
+    if (ret >= 0) {
+        std::memcpy(raw->data, frame_data_buffer.data(), frame_data_buffer.size());
+        raw->pts = raw->dts = av_rescale_q(frame_index, {1, FRAME_FPS}, raw_stream->time_base);
+        raw->duration = av_rescale_q(1, {1, FRAME_FPS}, raw_stream->time_base);
+        raw->flags |= AV_PKT_FLAG_KEY;
+        raw->stream_index = raw_stream->index;
+        ret = av_interleaved_write_frame(format_ctx, raw);
+    }
+    av_packet_free(&raw);
+    if (ret < 0) {
+        throw std::runtime_error("Error writing raw packet track");
+    }
 }
 
-void VideoEncoder::embed_data_in_frame(const std::vector<std::byte> &data) {
-#if defined(__APPLE__) && defined(_OPENMP)
-    const auto &blocks = get_precomputed_blocks(); // avoid structured bindings on Apple OpenMP
-    const auto &patterns = blocks.patterns;
+// PCM needs no encoder: each frame time's share of the packet bytes, padded
+// with silence, is muxed as-is as AUDIO_DATA_SAMPLES_PER_FRAME samples. FLAC
+// would only spend CPU, since FEC symbols and ciphertext do not compress.
+void VideoEncoder::add_audio_stream() {
+    audio_stream = avformat_new_stream(format_ctx, nullptr);
+    if (!audio_stream) {
+        throw std::runtime_error("Failed to create audio data stream");
+    }
+
+    AVCodecParameters *par = audio_stream->codecpar;
+    par->codec_type = AVMEDIA_TYPE_AUDIO;
+    par->codec_id = AV_CODEC_ID_PCM_S16LE;
+    par->format = AV_SAMPLE_FMT_S16;
+    par->sample_rate = AUDIO_DATA_SAMPLE_RATE;
+#if LIBAVUTIL_VERSION_MAJOR >= 57
+    av_channel_layout_default(&par->ch_layout, AUDIO_DATA_CHANNELS);
 #else
-    const auto &patterns = get_precomputed_blocks().patterns;
+    par->channels = AUDIO_DATA_CHANNELS;
+    par->channel_layout = av_get_default_channel_layout(AUDIO_DATA_CHANNELS);
 #endif
+    par->bits_per_coded_sample = 16;
+    par->block_align = AUDIO_DATA_CHANNELS * 2;
+    par->bit_rate = static_cast<int64_t>(AUDIO_DATA_SAMPLE_RATE) * AUDIO_DATA_CHANNELS * 16;
+    audio_stream->time_base = {1, AUDIO_DATA_SAMPLE_RATE};
+    av_dict_set(&audio_stream->metadata, "title", AUDIO_DATA_TRACK_NAME, 0);
+}
 
-    const std::size_t total_bits = data.size() * 8;
-    const int total_blocks = layout_.blocks_per_row * layout_.blocks_per_col;
-    const int active_blocks = static_cast<int>(
-        std::min(static_cast<std::size_t>(total_blocks),
-                 (total_bits + BITS_PER_BLOCK - 1) / BITS_PER_BLOCK));
-    const auto *src = reinterpret_cast<const uint8_t *>(data.data());
-    const int blocks_per_row = layout_.blocks_per_row;
+void VideoEncoder::write_audio_packet(const std::span<const std::byte> data) {
+    AVPacket *audio = av_packet_alloc();
+    if (!audio) {
+        throw std::runtime_error("Failed to allocate packet");
+    }
 
-    uint8_t *dst_base;
-    int dst_stride;
-    if (sws_ctx) {
-        dst_base = gray_buffer.data();
-        dst_stride = FRAME_WIDTH;
-        std::memset(dst_base, 128, gray_buffer.size());
-    } else {
-        av_frame_make_writable(frame);
-        dst_base = frame->data[0];
-        dst_stride = frame->linesize[0];
-        for (int y = 0; y < FRAME_HEIGHT; ++y)
-            std::memset(dst_base + y * dst_stride, 128, FRAME_WIDTH);
-    }
-
-#pragma omp parallel for schedule(static)
-    for (int block_idx = 0; block_idx < active_blocks; ++block_idx) {
-        const int block_row = block_idx / blocks_per_row;
-        const int block_col = block_idx % blocks_per_row;
-        const int base_x = block_col * 8;
-        const int base_y = block_row * 8;
-
-        const std::size_t bit_start = static_cast<std::size_t>(block_idx) * BITS_PER_BLOCK;
-        const std::size_t bit_end = std::min(bit_start + BITS_PER_BLOCK, total_bits);
-
-        int pattern = 0;
-        for (std::size_t bit_index = bit_start; bit_index < bit_end; ++bit_index) {
-            const std::size_t byte_idx = bit_index / 8;
-            const int bit_pos = 7 - static_cast<int>(bit_index % 8);
-            const int bit = (src[byte_idx] >> bit_pos) & 1;
-            pattern = (pattern << 1) | bit;
+    int ret = av_new_packet(audio, static_cast<int>(AUDIO_DATA_BYTES_PER_FRAME));
+    if (ret >= 0) {
+        std::memcpy(audio->data, data.data(), data.size());
+        std::memset(audio->data + data.size(), 0, AUDIO_DATA_BYTES_PER_FRAME - data.size());
+        audio->pts = audio->dts = av_rescale_q(frame_index * AUDIO_DATA_SAMPLES_PER_FRAME,
+                                               {1, AUDIO_DATA_SAMPLE_RATE}, audio_stream->time_base);
+        audio->duration = av_rescale_q(AUDIO_DATA_SAMPLES_PER_FRAME, {1, AUDIO_DATA_SAMPLE_RATE},
+                                       audio_stream->time_base);
+        audio->flags |= AV_PKT_FLAG_KEY;
+        audio->stream_index = audio_stream->index;
+        if (verifier_) {
+            verifier_->submit_audio(audio);
         }
+        ret = av_interleaved_write_frame(format_ctx, audio);
+    }
+    av_packet_free(&audio);
+    if (ret < 0) {
+        throw std::runtime_error("Error writing audio data track");
+    }
+}
 
-        const int bits_extracted = static_cast<int>(bit_end - bit_start);
-        pattern <<= (BITS_PER_BLOCK - bits_extracted);
+int VideoEncoder::audio_packets_per_frame() {
+    return static_cast<int>(AUDIO_DATA_BYTES_PER_FRAME / PACKET_SIZE);
+}
 
-        const auto &block = patterns[pattern];
-        for (int y = 0; y < 8; ++y) {
-            std::memcpy(dst_base + (base_y + y) * dst_stride + base_x,
-                        block[y], 8);
-        }
-    }
+int VideoEncoder::packets_per_frame() {
+    const auto layout = compute_frame_layout();
+    constexpr std::size_t packet_size = HEADER_SIZE_V2 + SYMBOL_SIZE_BYTES;
+    return static_cast<int>(layout.bytes_per_frame / packet_size);
+}
 
+void VideoEncoder::embed_data_in_frame(const std::span<const std::byte> data) {
     if (sws_ctx) {
+        embed_frame_data(data, layout_, pattern_set_, gray_buffer.data(), width_);
         const uint8_t *src_data[1] = {gray_buffer.data()};
-        constexpr int src_linesize[1] = {FRAME_WIDTH};
-        sws_scale(sws_ctx, src_data, src_linesize, 0, FRAME_HEIGHT,
+        const int src_linesize[1] = {width_};
+        sws_scale(sws_ctx, src_data, src_linesize, 0, height_,
                   frame->data, frame->linesize);
+    } else {
+        av_frame_make_writable(frame);
+        embed_frame_data(data, layout_, pattern_set_, frame->data[0], frame->linesize[0]);
     }
 }
 
@@ -252,6 +301,9 @@ void VideoEncoder::encode_frame() {
 
         av_packet_rescale_ts(av_packet, codec_ctx->time_base, stream->time_base);
         av_packet->stream_index = stream->index;
+        if (verifier_) {
+            verifier_->submit_video(av_packet);
+        }
 
         ret = av_interleaved_write_frame(format_ctx, av_packet);
         if (ret < 0) {
@@ -267,8 +319,7 @@ void VideoEncoder::add_packet(const Packet &packet) {
         throw std::runtime_error("Encoder already finalized");
     }
 
-    if (const auto max_bytes = static_cast<std::size_t>(layout_.bytes_per_frame);
-        frame_data_buffer.size() + packet.bytes.size() > max_bytes) {
+    if (frame_data_buffer.size() + packet.bytes.size() > frame_capacity_) {
         flush_frame_buffer();
     }
 
@@ -277,7 +328,7 @@ void VideoEncoder::add_packet(const Packet &packet) {
                              packet.bytes.end());
 }
 
-void VideoEncoder::encode_packets(const std::vector<Packet> &packets) {
+void VideoEncoder::encode_packets(const std::span<const Packet> packets) {
     for (const auto &pkt: packets) {
         add_packet(pkt);
     }
@@ -286,7 +337,16 @@ void VideoEncoder::encode_packets(const std::vector<Packet> &packets) {
 void VideoEncoder::flush_frame_buffer() {
     if (frame_data_buffer.empty()) return;
 
-    embed_data_in_frame(frame_data_buffer);
+    // Pixels take the first packets of the frame time, the audio track the rest.
+    const std::span<const std::byte> data(frame_data_buffer);
+    const std::size_t video_size = std::min(data.size(), video_bytes_);
+    embed_data_in_frame(data.first(video_size));
+    if (audio_stream) {
+        write_audio_packet(data.subspan(video_size));
+    }
+    if (raw_stream) {
+        write_raw_packet();
+    }
     encode_frame();
     frame_data_buffer.clear();
 }
@@ -305,6 +365,9 @@ void VideoEncoder::flush_encoder() const {
 
         av_packet_rescale_ts(av_packet, codec_ctx->time_base, stream->time_base);
         av_packet->stream_index = stream->index;
+        if (verifier_) {
+            verifier_->submit_video(av_packet);
+        }
 
         av_interleaved_write_frame(format_ctx, av_packet);
         av_packet_unref(av_packet);
@@ -317,4 +380,7 @@ void VideoEncoder::finalize() {
     flush_frame_buffer();
     flush_encoder();
     av_write_trailer(format_ctx);
+    if (verifier_) {
+        verifier_->finish();
+    }
 }
@@ -19,6 +19,8 @@
 #pragma once
 
 #include <cstddef>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -30,18 +32,44 @@ extern "C" {
 }
 
 #include "configuration.h"
+#include "dct_common.h"
+#include "encode_verifier.h"
 #include "encoder.h"
+#include "frame_codec.h"
+#include "packet_sink.h"
+
+// Track names of the extra tracks VideoEncoder can mux next to the video.
+inline constexpr const char *RAW_PACKET_TRACK_NAME = "media-storage packets";
+inline constexpr const char *AUDIO_DATA_TRACK_NAME = "media-storage audio data";
+// Video stream tag holding the ffv1 slice count the encoder asked for, which
+// bounds how many slice threads a decoder can use.
+inline constexpr const char *SLICES_TAG = "MEDIA_STORAGE_SLICES";
+
+struct VideoEncoderOptions {
+    // Also mux each frame's packet bytes as a second, uncompressed track. Local
+    // decodes read it through the demuxer alone; the pixel track is still
+    // written for copies that lose the extra track to a platform re-encode.
+    bool raw_packet_track = false;
+    // Carry AUDIO_DATA_BYTES_PER_FRAME more packet bytes per frame time as PCM
+    // samples in an audio track. Only for lossless file targets: any audio
+    // re-encode destroys the payload.
+    bool audio_data_track = false;
+    // Block design drawn into the pixels; decoders read every set alike.
+    PatternSet pattern_set = PatternSet::Cosine;
+    // Decode the video and audio data tracks back on a worker thread as they
+    // are written; see verifier(). The raw packet track is not read back.
+    bool verify = false;
+    // ffv1 slices per frame (0 = codec default). More slices encode and decode
+    // on more threads at a small cost in compression.
+    int slices = 0;
+};
 
-FrameLayout compute_frame_layout();
-FrameLayout compute_frame_layout(int width, int height);
-
-std::size_t max_packet_bytes_per_frame();
-
-class VideoEncoder {
+class VideoEncoder final : public PacketSink {
 public:
-    explicit VideoEncoder(const std::string &output_path);
+    explicit VideoEncoder(const std::string &output_path, int width = FRAME_WIDTH, int height = FRAME_HEIGHT,
+                          const VideoEncoderOptions &options = {});
 
-    ~VideoEncoder();
+    ~VideoEncoder() override;
 
     VideoEncoder(const VideoEncoder &) = delete;
 
@@ -53,31 +81,55 @@ public:
 
     void add_packet(const Packet &packet);
 
-    void encode_packets(const std::vector<Packet> &packets);
+    void encode_packets(std::span<const Packet> packets) override;
 
-    void finalize();
+    void finalize() override;
 
-    [[nodiscard]] int64_t frames_written() const { return frame_index; }
+    [[nodiscard]] int64_t frames_written() const override { return frame_index; }
+
+    // What the verifier recovered from the written tracks, complete once
+    // finalize() returned; null unless VideoEncoderOptions::verify was set.
+    [[nodiscard]] const EncodeVerifier *verifier() const { return verifier_.get(); }
 
     [[nodiscard]] static int packets_per_frame();
 
+    // Packets the audio data track adds to every frame time.
+    [[nodiscard]] static int audio_packets_per_frame();
+
 private:
     AVFormatContext *format_ctx = nullptr;
     AVCodecContext *codec_ctx = nullptr;
     AVStream *stream = nullptr;
+    AVStream *raw_stream = nullptr;
+    AVStream *audio_stream = nullptr;
     AVFrame *frame = nullptr;
     AVPacket *av_packet = nullptr;
     SwsContext *sws_ctx = nullptr;
+    std::unique_ptr<EncodeVerifier> verifier_;
+
+    int width_;
+    int height_;
 
     std::vector<uint8_t> gray_buffer;
     std::vector<std::byte> frame_data_buffer;
     FrameLayout layout_{};
+    PatternSet pattern_set_ = PatternSet::Cosine;
+    std::size_t video_bytes_ = 0; // whole packets that fit in the pixels
+    std::size_t frame_capacity_ = 0;
     int64_t frame_index = 0;
     bool finalized = false;
 
-    void init_encoder(const std::string &output_path);
+    void init_encoder(const std::string &output_path, const VideoEncoderOptions &options);
+
+    void add_raw_stream();
+
+    void write_raw_packet();
+
+    void add_audio_stream();
+
+    void write_audio_packet(std::span<const std::byte> data);
 
-    void embed_data_in_frame(const std::vector<std::byte> &data);
+    void embed_data_in_frame(std::span<const std::byte> data);
 
     void encode_frame();
 
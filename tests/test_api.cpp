@@ -17,12 +17,21 @@
 #include <gtest/gtest.h>
 
 #include "../include/media_storage.h"
-
+#include "chunker.h"
+#include "encoder.h"
+#include "integrity.h"
+#include "manifest.h"
+#include "test_util.h"
+#include "video_encoder.h"
+
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -63,6 +72,57 @@ namespace {
         ifs.read(data.data(), size);
         return data;
     }
+
+    enum class Tamper { None, FileDigest, ChunkTable, DropFileDigest };
+
+    // Writes the file at input_path as an unsharded archive laid out like
+    // ms_encode's, damaging its closing manifest segments as asked.
+    void write_tampered_archive(const std::string &input_path, const std::string &output_path,
+                                const Tamper tamper) {
+        const FileChunkReader reader(input_path.c_str());
+        const auto file_id = make_test_id(0x5A);
+        const Encoder encoder(file_id);
+        VideoEncoder video_encoder(output_path);
+
+        FileInfo info;
+        info.file_id = file_id;
+        info.file_size = reader.file_size();
+        info.chunk_count = static_cast<uint32_t>(reader.num_chunks());
+        info.chunk_size = static_cast<uint32_t>(reader.chunk_size());
+        info.symbol_size = static_cast<uint16_t>(SYMBOL_SIZE_BYTES);
+        info.frame_width = FRAME_WIDTH;
+        info.frame_height = FRAME_HEIGHT;
+        video_encoder.encode_packets(encoder.encode_manifest_segment(MANIFEST_FILE_INFO_SEGMENT,
+                                                                     serialize_file_info(info)));
+
+        std::vector<Sha256Digest> digests;
+        for (std::size_t i = 0; i < reader.num_chunks(); ++i) {
+            auto [packets, entry] = encoder.encode_chunk(static_cast<uint32_t>(i), reader.read_chunk(i),
+                                                         i + 1 == reader.num_chunks());
+            video_encoder.encode_packets(packets);
+            digests.push_back(entry.sha256);
+        }
+
+        // The FileDigest stays honest when only the table is damaged, so the
+        // table check alone has to catch it.
+        FileDigest file_digest{static_cast<uint32_t>(digests.size()), merkle_root(digests)};
+        if (tamper == Tamper::ChunkTable) {
+            digests.back().bytes[0] ^= std::byte{1};
+        } else if (tamper == Tamper::FileDigest) {
+            file_digest.root.bytes[0] ^= std::byte{1};
+        }
+
+        const auto table = serialize_chunk_table(digests);
+        for (std::size_t i = 0; i < table.size(); ++i) {
+            video_encoder.encode_packets(encoder.encode_manifest_segment(
+                MANIFEST_FIRST_TABLE_SEGMENT + static_cast<uint32_t>(i), table[i]));
+        }
+        if (tamper != Tamper::DropFileDigest) {
+            video_encoder.encode_packets(encoder.encode_manifest_segment(MANIFEST_FILE_DIGEST_SEGMENT,
+                                                                         serialize_file_digest(file_digest)));
+        }
+        video_encoder.finalize();
+    }
 } // namespace
 
 TEST(API, Version_ReturnsNonEmpty) {
@@ -80,6 +140,7 @@ TEST(API, StatusString_AllCodes) {
     EXPECT_STREQ(ms_status_string(MS_ERR_DECODE_FAILED), "decoding failed");
     EXPECT_STREQ(ms_status_string(MS_ERR_CRYPTO), "encryption/decryption error");
     EXPECT_STREQ(ms_status_string(MS_ERR_INCOMPLETE), "incomplete data");
+    EXPECT_STREQ(ms_status_string(MS_ERR_INTEGRITY), "integrity check failed");
 }
 
 TEST(API, StatusString_UnknownCode) {
@@ -200,6 +261,22 @@ TEST(API, StreamEncode_EncryptRequiresPassword) {
     EXPECT_EQ(ms_stream_encode(&opts, nullptr), MS_ERR_INVALID_ARGS);
 }
 
+TEST(API, StreamEncode_InvalidRepairBoundsRejected) {
+    const TempFile input("api_stream_enc_repair.bin");
+    write_test_file(input.path_str, 1024);
+
+    ms_stream_encode_options_t opts{};
+    opts.input_path = input.c_str();
+    opts.stream_url = "rtmp://example/live";
+    opts.min_repair_overhead = 2.0;
+    opts.max_repair_overhead = 1.0;
+    EXPECT_EQ(ms_stream_encode(&opts, nullptr), MS_ERR_INVALID_ARGS);
+
+    opts.min_repair_overhead = 0.0;
+    opts.max_repair_overhead = 1000.0;
+    EXPECT_EQ(ms_stream_encode(&opts, nullptr), MS_ERR_INVALID_ARGS);
+}
+
 TEST(API, StreamDecode_NullOptionsReturnsInvalidArgs) {
     EXPECT_EQ(ms_stream_decode(nullptr, nullptr), MS_ERR_INVALID_ARGS);
 }
@@ -224,6 +301,124 @@ TEST(API, StreamDecode_MissingOutputPathReturnsInvalidArgs) {
     EXPECT_EQ(ms_stream_decode(&opts, nullptr), MS_ERR_INVALID_ARGS);
 }
 
+TEST(API, StreamEncodeMux_InvalidJobsRejected) {
+    EXPECT_EQ(ms_stream_encode_mux(nullptr, nullptr), MS_ERR_INVALID_ARGS);
+
+    const TempFile input("api_stream_mux_in.bin");
+    write_test_file(input.path_str, 1024);
+
+    ms_stream_job_t jobs[2]{};
+    jobs[0].input_path = input.c_str();
+    jobs[1].input_path = input.c_str();
+    ms_stream_mux_options_t opts{};
+    opts.jobs = jobs;
+    opts.job_count = 2;
+    EXPECT_EQ(ms_stream_encode_mux(&opts, nullptr), MS_ERR_INVALID_ARGS);
+
+    opts.stream_url = "rtmp://example/live";
+    opts.job_count = 0;
+    EXPECT_EQ(ms_stream_encode_mux(&opts, nullptr), MS_ERR_INVALID_ARGS);
+
+    opts.job_count = 2;
+    jobs[1].weight = -1.0;
+    EXPECT_EQ(ms_stream_encode_mux(&opts, nullptr), MS_ERR_INVALID_ARGS);
+
+    jobs[1].weight = 2.0;
+    jobs[1].encrypt = 1;
+    EXPECT_EQ(ms_stream_encode_mux(&opts, nullptr), MS_ERR_INVALID_ARGS);
+
+    jobs[1].encrypt = 0;
+    jobs[1].input_path = "nonexistent_mux_input.bin";
+    EXPECT_EQ(ms_stream_encode_mux(&opts, nullptr), MS_ERR_FILE_NOT_FOUND);
+}
+
+TEST(API, StreamDecodeDemux_InvalidArgs) {
+    EXPECT_EQ(ms_stream_decode_demux(nullptr, nullptr, 0, nullptr), MS_ERR_INVALID_ARGS);
+
+    ms_stream_demux_options_t opts{};
+    opts.output_dir = ".";
+    EXPECT_EQ(ms_stream_decode_demux(&opts, nullptr, 0, nullptr), MS_ERR_INVALID_ARGS);
+
+    opts.stream_url = "rtmp://example/live";
+    opts.output_dir = nullptr;
+    EXPECT_EQ(ms_stream_decode_demux(&opts, nullptr, 0, nullptr), MS_ERR_INVALID_ARGS);
+
+    opts.output_dir = ".";
+    EXPECT_EQ(ms_stream_decode_demux(&opts, nullptr, 4, nullptr), MS_ERR_INVALID_ARGS);
+}
+
+TEST(API, ExportImportFrames_InvalidArgs) {
+    EXPECT_EQ(ms_export_frames(nullptr, nullptr), MS_ERR_INVALID_ARGS);
+    EXPECT_EQ(ms_import_frames(nullptr, nullptr), MS_ERR_INVALID_ARGS);
+
+    const TempFile input("api_export_invalid_in.bin");
+    write_test_file(input.path_str, 1024);
+    const char *outputs[] = {"-"};
+
+    ms_export_frames_options_t opts{};
+    opts.input_path = input.c_str();
+    EXPECT_EQ(ms_export_frames(&opts, nullptr), MS_ERR_INVALID_ARGS);
+
+    opts.outputs = outputs;
+    opts.output_count = 1;
+    opts.width = 1000;
+    opts.height = 720;
+    EXPECT_EQ(ms_export_frames(&opts, nullptr), MS_ERR_INVALID_ARGS);
+
+    opts.width = 64;
+    opts.height = 64;
+    EXPECT_EQ(ms_export_frames(&opts, nullptr), MS_ERR_INVALID_ARGS);
+
+    opts.width = 0;
+    opts.height = 0;
+    opts.format = static_cast<ms_frame_format_t>(7);
+    EXPECT_EQ(ms_export_frames(&opts, nullptr), MS_ERR_INVALID_ARGS);
+
+    ms_import_frames_options_t import_opts{};
+    import_opts.input_path = "-";
+    EXPECT_EQ(ms_import_frames(&import_opts, nullptr), MS_ERR_INVALID_ARGS);
+}
+
+TEST(API, ExportImportFrames_Roundtrip) {
+    const TempFile input("api_frames_input.bin");
+    const TempFile first("api_frames_first.y4m");
+    const TempFile second("api_frames_second.y4m");
+    const TempFile decoded("api_frames_output.bin");
+
+    write_test_file(input.path_str, 200000);
+
+    const char *outputs[] = {first.c_str(), second.c_str()};
+    ms_export_frames_options_t opts{};
+    opts.input_path = input.c_str();
+    opts.outputs = outputs;
+    opts.output_count = 2;
+    opts.pixel_format = MS_PIXEL_FORMAT_YUV420P;
+    opts.width = 1280;
+    opts.height = 720;
+    opts.encrypt = 1;
+    opts.password = "frames";
+    opts.password_len = 6;
+    opts.repair_overhead = 0.5;
+
+    ms_result_t export_result{};
+    ASSERT_EQ(ms_export_frames(&opts, &export_result), MS_OK);
+    EXPECT_GT(export_result.total_frames, 0u);
+    EXPECT_EQ(read_test_file(first.path_str), read_test_file(second.path_str));
+
+    ms_import_frames_options_t import_opts{};
+    import_opts.input_path = second.c_str();
+    import_opts.output_path = decoded.c_str();
+    EXPECT_EQ(ms_import_frames(&import_opts, nullptr), MS_ERR_CRYPTO);
+
+    import_opts.password = "frames";
+    import_opts.password_len = 6;
+    ms_result_t import_result{};
+    ASSERT_EQ(ms_import_frames(&import_opts, &import_result), MS_OK);
+    EXPECT_EQ(import_result.total_chunks, export_result.total_chunks);
+    EXPECT_EQ(std::memcmp(import_result.file_id, export_result.file_id, sizeof(import_result.file_id)), 0);
+    EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str));
+}
+
 TEST(API, EncodeDecodeRoundtrip) {
     const TempFile input("api_rt_input.bin");
     const TempFile encoded("api_rt.mkv");
@@ -253,6 +448,341 @@ TEST(API, EncodeDecodeRoundtrip) {
     EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str));
 }
 
+TEST(API, EncodeDecodeRoundtrip_WithRawPacketTrack) {
+    const TempFile input("api_raw_input.bin");
+    const TempFile encoded("api_raw.mkv");
+    const TempFile decoded("api_raw_output.bin");
+    const TempFile decoded_pixels("api_raw_pixels_output.bin");
+
+    write_test_file(input.path_str, 300000);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+    enc_opts.raw_packet_track = 1;
+    ASSERT_EQ(ms_encode(&enc_opts, nullptr), MS_OK);
+
+    ms_info_t info{};
+    ASSERT_EQ(ms_probe(encoded.c_str(), &info), MS_OK);
+    EXPECT_EQ(info.has_raw_packet_track, 1);
+    EXPECT_EQ(info.has_manifest, 1);
+
+    for (const auto &[ignore_raw, output]: {std::pair{0, &decoded}, std::pair{1, &decoded_pixels}}) {
+        ms_decode_options_t dec_opts{};
+        dec_opts.input_path = encoded.c_str();
+        dec_opts.output_path = output->c_str();
+        dec_opts.ignore_raw_packet_track = ignore_raw;
+        ASSERT_EQ(ms_decode(&dec_opts, nullptr), MS_OK);
+        EXPECT_EQ(read_test_file(input.path_str), read_test_file(output->path_str));
+    }
+}
+
+TEST(API, EncodeDecodeRoundtrip_WithAudioDataTrack) {
+    const TempFile input("api_audio_input.bin");
+    const TempFile encoded("api_audio.mkv");
+    const TempFile decoded("api_audio_output.bin");
+
+    write_test_file(input.path_str, 300000);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+    ms_result_t plain_result{};
+    ASSERT_EQ(ms_encode(&enc_opts, &plain_result), MS_OK);
+
+    enc_opts.audio_data_track = 1;
+    ms_result_t audio_result{};
+    ASSERT_EQ(ms_encode(&enc_opts, &audio_result), MS_OK);
+    EXPECT_EQ(audio_result.total_packets, plain_result.total_packets);
+    EXPECT_LT(audio_result.total_frames, plain_result.total_frames);
+
+    ms_info_t info{};
+    ASSERT_EQ(ms_probe(encoded.c_str(), &info), MS_OK);
+    EXPECT_EQ(info.has_audio_data_track, 1);
+    EXPECT_EQ(info.has_manifest, 1);
+
+    ms_decode_options_t dec_opts{};
+    dec_opts.input_path = encoded.c_str();
+    dec_opts.output_path = decoded.c_str();
+    ASSERT_EQ(ms_decode(&dec_opts, nullptr), MS_OK);
+    EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str));
+}
+
+TEST(API, EncodeDecodeRoundtrip_EachPatternSet) {
+    const TempFile input("api_patterns_input.bin");
+    const TempFile encoded("api_patterns.mkv");
+    const TempFile decoded("api_patterns_output.bin");
+
+    write_test_file(input.path_str, 65536);
+
+    for (const ms_pattern_set_t set: {MS_PATTERN_COSINE, MS_PATTERN_QUANTIZED_COSINE, MS_PATTERN_STEP}) {
+        ms_encode_options_t enc_opts{};
+        enc_opts.input_path = input.c_str();
+        enc_opts.output_path = encoded.c_str();
+        enc_opts.pattern_set = set;
+        ASSERT_EQ(ms_encode(&enc_opts, nullptr), MS_OK) << set;
+
+        ms_decode_options_t dec_opts{};
+        dec_opts.input_path = encoded.c_str();
+        dec_opts.output_path = decoded.c_str();
+        ASSERT_EQ(ms_decode(&dec_opts, nullptr), MS_OK) << set;
+        EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str)) << set;
+    }
+}
+
+TEST(API, Encode_InlineVerifyReadsBackEveryChunk) {
+    const TempFile input("api_inline_verify_input.bin");
+    const TempFile encoded("api_inline_verify.mkv");
+
+    write_test_file(input.path_str, 2 * 1024 * 1024 + 999);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+    enc_opts.audio_data_track = 1;
+    enc_opts.verify = 1;
+
+    ms_result_t result{};
+    ASSERT_EQ(ms_encode(&enc_opts, &result), MS_OK);
+    EXPECT_EQ(result.total_chunks, 3u);
+    EXPECT_EQ(result.verified_chunks, result.total_chunks);
+
+    // Without the flag nothing is read back.
+    enc_opts.verify = 0;
+    ms_result_t plain{};
+    ASSERT_EQ(ms_encode(&enc_opts, &plain), MS_OK);
+    EXPECT_EQ(plain.verified_chunks, 0u);
+}
+
+TEST(API, Encode_CacheReusesVideosAndChunks) {
+    const TempFile input("api_cache_input.bin");
+    const TempFile first("api_cache_first.mkv");
+    const TempFile second("api_cache_second.mkv");
+    const TempFile decoded("api_cache_output.bin");
+    const std::string cache_dir = (std::filesystem::temp_directory_path() / "api_cache_dir").string();
+    std::filesystem::remove_all(cache_dir);
+
+    write_test_file(input.path_str, 2 * 1024 * 1024 + 999);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = first.c_str();
+    enc_opts.cache_dir = cache_dir.c_str();
+    enc_opts.cache_chunks = 1;
+
+    ms_result_t miss{};
+    ASSERT_EQ(ms_encode(&enc_opts, &miss), MS_OK);
+    EXPECT_EQ(miss.cache_hit, 0);
+    EXPECT_EQ(miss.cached_chunks, 0u);
+
+    enc_opts.output_path = second.c_str();
+    ms_result_t hit{};
+    ASSERT_EQ(ms_encode(&enc_opts, &hit), MS_OK);
+    EXPECT_EQ(hit.cache_hit, 1);
+    EXPECT_EQ(hit.total_packets, miss.total_packets);
+    // The linked video is the first encode's, id included.
+    EXPECT_EQ(std::memcmp(hit.file_id, miss.file_id, sizeof(hit.file_id)), 0);
+    EXPECT_EQ(std::memcmp(hit.file_digest, miss.file_digest, sizeof(hit.file_digest)), 0);
+    EXPECT_EQ(read_test_file(second.path_str), read_test_file(first.path_str));
+
+    // Appending to the input keeps its first two chunks; only the rest is
+    // encoded, and the reused packets decode at their new position.
+    write_test_file(input.path_str, 3 * 1024 * 1024 + 4321);
+    ms_result_t partial{};
+    ASSERT_EQ(ms_encode(&enc_opts, &partial), MS_OK);
+    EXPECT_EQ(partial.cache_hit, 0);
+    EXPECT_EQ(partial.cached_chunks, 2u);
+    EXPECT_NE(std::memcmp(partial.file_id, miss.file_id, sizeof(partial.file_id)), 0);
+
+    ms_decode_options_t dec_opts{};
+    dec_opts.input_path = second.c_str();
+    dec_opts.output_path = decoded.c_str();
+    ASSERT_EQ(ms_decode(&dec_opts, nullptr), MS_OK);
+    EXPECT_EQ(read_test_file(decoded.path_str), read_test_file(input.path_str));
+
+    std::filesystem::remove_all(cache_dir);
+}
+
+TEST(API, ReadRange_DecodesOnlyTheRangeAndCachesIt) {
+    const TempFile input("api_range_input.bin");
+    const TempFile encoded("api_range.mkv");
+    const std::string password = "range_password";
+
+    write_test_file(input.path_str, 3 * 1024 * 1024 + 500);
+    const std::vector<char> original = read_test_file(input.path_str);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+    enc_opts.encrypt = 1;
+    enc_opts.password = password.c_str();
+    enc_opts.password_len = password.size();
+    ASSERT_EQ(ms_encode(&enc_opts, nullptr), MS_OK);
+
+    ms_chunk_cache_options_t cache_opts{};
+    cache_opts.memory_bytes = 8 * 1024 * 1024;
+    ASSERT_EQ(ms_chunk_cache_configure(&cache_opts), MS_OK);
+    ms_chunk_cache_clear();
+
+    // Straddles the boundary between the first two chunks.
+    std::vector<char> buffer(4096);
+    ms_read_range_options_t opts{};
+    opts.input_path = encoded.c_str();
+    opts.password = password.c_str();
+    opts.password_len = password.size();
+    opts.offset = 1024 * 1024 - 100;
+    opts.length = buffer.size();
+    opts.buffer = buffer.data();
+
+    ms_chunk_cache_stats_t before{};
+    ASSERT_EQ(ms_chunk_cache_stats(&before), MS_OK);
+    uint64_t bytes_read = 0;
+    ASSERT_EQ(ms_read_range(&opts, &bytes_read), MS_OK);
+    ASSERT_EQ(bytes_read, buffer.size());
+    EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), original.begin() + static_cast<long>(opts.offset)));
+
+    std::ranges::fill(buffer, 0);
+    ASSERT_EQ(ms_read_range(&opts, &bytes_read), MS_OK);
+    EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), original.begin() + static_cast<long>(opts.offset)));
+    ms_chunk_cache_stats_t after{};
+    ASSERT_EQ(ms_chunk_cache_stats(&after), MS_OK);
+    EXPECT_EQ(after.memory_hits - before.memory_hits, 2u);
+
+    // A range running past the end is cut short.
+    opts.offset = original.size() - 10;
+    ASSERT_EQ(ms_read_range(&opts, &bytes_read), MS_OK);
+    EXPECT_EQ(bytes_read, 10u);
+
+    // The cached plaintext is not served for a wrong password.
+    const std::string wrong = "wrong_password";
+    opts.offset = 1024 * 1024 - 100;
+    opts.password = wrong.c_str();
+    opts.password_len = wrong.size();
+    EXPECT_EQ(ms_read_range(&opts, &bytes_read), MS_ERR_CRYPTO);
+
+    ms_chunk_cache_clear();
+    cache_opts.memory_bytes = 0;
+    ms_chunk_cache_configure(&cache_opts);
+}
+
+TEST(API, Decode_ServesCachedChunks) {
+    const TempFile input("api_decode_cache_input.bin");
+    const TempFile encoded("api_decode_cache.mkv");
+    const TempFile decoded("api_decode_cache_output.bin");
+    const std::string password = "decode_cache_password";
+
+    write_test_file(input.path_str, 2 * CHUNK_SIZE_BYTES + 500);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+    enc_opts.encrypt = 1;
+    enc_opts.password = password.c_str();
+    enc_opts.password_len = password.size();
+    ms_result_t enc_result{};
+    ASSERT_EQ(ms_encode(&enc_opts, &enc_result), MS_OK);
+
+    ms_chunk_cache_options_t cache_opts{};
+    cache_opts.memory_bytes = 8 * 1024 * 1024;
+    ASSERT_EQ(ms_chunk_cache_configure(&cache_opts), MS_OK);
+    ms_chunk_cache_clear();
+
+    ms_decode_options_t dec_opts{};
+    dec_opts.input_path = encoded.c_str();
+    dec_opts.output_path = decoded.c_str();
+    dec_opts.password = password.c_str();
+    dec_opts.password_len = password.size();
+
+    ms_chunk_cache_stats_t before{};
+    ASSERT_EQ(ms_chunk_cache_stats(&before), MS_OK);
+    ms_result_t dec_result{};
+    ASSERT_EQ(ms_decode(&dec_opts, &dec_result), MS_OK);
+    ms_chunk_cache_stats_t filled{};
+    ASSERT_EQ(ms_chunk_cache_stats(&filled), MS_OK);
+    EXPECT_EQ(filled.memory_hits, before.memory_hits);
+    EXPECT_EQ(filled.insertions - before.insertions, enc_result.total_chunks);
+
+    // The second decode takes every chunk from the cache and still checks the
+    // whole-file digest through the chunk table.
+    std::filesystem::remove(decoded.path_str);
+    ASSERT_EQ(ms_decode(&dec_opts, &dec_result), MS_OK);
+    ms_chunk_cache_stats_t after{};
+    ASSERT_EQ(ms_chunk_cache_stats(&after), MS_OK);
+    EXPECT_EQ(after.memory_hits - filled.memory_hits, enc_result.total_chunks);
+    EXPECT_EQ(after.insertions, filled.insertions);
+    EXPECT_EQ(dec_result.file_digest_verified, 1);
+    EXPECT_EQ(std::memcmp(enc_result.file_digest, dec_result.file_digest, sizeof(enc_result.file_digest)), 0);
+    EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str));
+
+    ms_chunk_cache_clear();
+    cache_opts.memory_bytes = 0;
+    ms_chunk_cache_configure(&cache_opts);
+}
+
+TEST(API, Decode_RejectsAndDropsDamagedCachedChunk) {
+    const TempFile input("api_decode_damaged_input.bin");
+    const TempFile encoded("api_decode_damaged.mkv");
+    const TempFile decoded("api_decode_damaged_output.bin");
+    const TempPath cache_dir("api_decode_damaged_cache");
+
+    write_test_file(input.path_str, 2 * CHUNK_SIZE_BYTES + 500);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+    ASSERT_EQ(ms_encode(&enc_opts, nullptr), MS_OK);
+
+    // Disk tier only, so every cached chunk is a file that can be damaged.
+    const std::string cache_path = cache_dir.path.string();
+    ms_chunk_cache_options_t cache_opts{};
+    cache_opts.disk_dir = cache_path.c_str();
+    cache_opts.disk_bytes = 8 * 1024 * 1024;
+    ASSERT_EQ(ms_chunk_cache_configure(&cache_opts), MS_OK);
+    ms_chunk_cache_clear();
+
+    ms_decode_options_t dec_opts{};
+    dec_opts.input_path = encoded.c_str();
+    dec_opts.output_path = decoded.c_str();
+    ASSERT_EQ(ms_decode(&dec_opts, nullptr), MS_OK);
+    EXPECT_EQ(std::filesystem::status(cache_dir.path).permissions() & std::filesystem::perms::all,
+              std::filesystem::perms::owner_all);
+
+    // Flip a byte and fix up the entry's CRC, as a tampered cache would.
+    std::filesystem::path damaged;
+    for (const auto &file: std::filesystem::directory_iterator(cache_dir.path)) {
+        if (file.path().filename().string().ends_with("-1.chunk")) {
+            damaged = file.path();
+        }
+    }
+    ASSERT_FALSE(damaged.empty());
+    EXPECT_EQ(std::filesystem::status(damaged).permissions() & std::filesystem::perms::all,
+              std::filesystem::perms::owner_read | std::filesystem::perms::owner_write);
+    {
+        std::ifstream in(damaged, std::ios::binary);
+        std::vector<std::byte> entry(std::filesystem::file_size(damaged));
+        in.read(reinterpret_cast<char *>(entry.data()), static_cast<std::streamsize>(entry.size()));
+        in.close();
+        entry[100] ^= std::byte{0x5a};
+        const uint32_t crc = crc32c(std::span(entry).subspan(13));
+        std::memcpy(entry.data() + 5, &crc, sizeof(crc));
+        std::ofstream out(damaged, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(entry.data()), static_cast<std::streamsize>(entry.size()));
+    }
+
+    std::filesystem::remove(decoded.path_str);
+    EXPECT_EQ(ms_decode(&dec_opts, nullptr), MS_ERR_INTEGRITY);
+    EXPECT_FALSE(std::filesystem::exists(damaged));
+
+    // With the entry gone the chunk is decoded from the video again.
+    ASSERT_EQ(ms_decode(&dec_opts, nullptr), MS_OK);
+    EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str));
+
+    ms_chunk_cache_clear();
+    cache_opts.disk_dir = nullptr;
+    cache_opts.disk_bytes = 0;
+    ms_chunk_cache_configure(&cache_opts);
+}
+
 TEST(API, EncodeDecodeRoundtrip_WithEncryption) {
     const TempFile input("api_enc_input.bin");
     const TempFile encoded("api_enc.mkv");
@@ -302,6 +832,447 @@ TEST(API, EncodeDecodeRoundtrip_WithXXHash) {
     EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str));
 }
 
+TEST(API, Verify_NullOptionsReturnsInvalidArgs) {
+    EXPECT_EQ(ms_verify(nullptr, nullptr), MS_ERR_INVALID_ARGS);
+    ms_verify_options_t opts{};
+    EXPECT_EQ(ms_verify(&opts, nullptr), MS_ERR_INVALID_ARGS);
+}
+
+TEST(API, EncodeVerify_MatchesManifest) {
+    const TempFile input("api_verify_input.bin");
+    const TempFile encoded("api_verify.mkv");
+
+    write_test_file(input.path_str, 3 * 1024 * 1024 + 777);
+
+    const std::string password = "verify_password";
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+    enc_opts.encrypt = 1;
+    enc_opts.password = password.c_str();
+    enc_opts.password_len = password.size();
+
+    ms_result_t enc_result{};
+    ASSERT_EQ(ms_encode(&enc_opts, &enc_result), MS_OK);
+
+    ms_verify_options_t opts{};
+    opts.input_path = encoded.c_str();
+    opts.threads = 3;
+
+    ms_verify_result_t result{};
+    ASSERT_EQ(ms_verify(&opts, &result), MS_OK);
+    EXPECT_EQ(result.total_chunks, enc_result.total_chunks);
+    EXPECT_EQ(result.recoverable_chunks, enc_result.total_chunks);
+    EXPECT_EQ(result.verified_chunks, enc_result.total_chunks);
+    EXPECT_EQ(result.hash_mismatches, 0u);
+    EXPECT_EQ(result.has_manifest, 1);
+    EXPECT_EQ(result.file_digest_verified, 1);
+    EXPECT_GT(result.mean_spare_ratio, 0.0);
+
+    uint64_t histogram_total = 0;
+    for (const uint64_t count: result.margin_histogram) {
+        histogram_total += count;
+    }
+    EXPECT_EQ(histogram_total, result.recoverable_chunks);
+}
+
+TEST(API, EncodeDecode_FileDigestMatches) {
+    const TempFile input("api_digest_input.bin");
+    const TempFile encoded("api_digest.mkv");
+    const TempFile decoded("api_digest_output.bin");
+
+    write_test_file(input.path_str, 3 * 1024 * 1024 + 123);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+
+    ms_result_t enc_result{};
+    ASSERT_EQ(ms_encode(&enc_opts, &enc_result), MS_OK);
+    ASSERT_EQ(enc_result.has_file_digest, 1);
+
+    ms_decode_options_t dec_opts{};
+    dec_opts.input_path = encoded.c_str();
+    dec_opts.output_path = decoded.c_str();
+
+    ms_result_t dec_result{};
+    ASSERT_EQ(ms_decode(&dec_opts, &dec_result), MS_OK);
+    ASSERT_EQ(dec_result.has_file_digest, 1);
+    EXPECT_EQ(dec_result.file_digest_verified, 1);
+    EXPECT_EQ(std::memcmp(enc_result.file_digest, dec_result.file_digest, sizeof(enc_result.file_digest)), 0);
+    EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str));
+}
+
+TEST(API, EncodeDecode_FileDigestWithFullLastChunk) {
+    const TempFile input("api_digest_full_input.bin");
+    const TempFile encoded("api_digest_full.mkv");
+    const TempFile decoded("api_digest_full_output.bin");
+
+    // The last chunk decodes well before the chunk table and FileDigest
+    // segment that follow it have been read.
+    write_test_file(input.path_str, 3 * CHUNK_SIZE_BYTES);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+
+    ms_result_t enc_result{};
+    ASSERT_EQ(ms_encode(&enc_opts, &enc_result), MS_OK);
+
+    ms_decode_options_t dec_opts{};
+    dec_opts.input_path = encoded.c_str();
+    dec_opts.output_path = decoded.c_str();
+
+    ms_result_t dec_result{};
+    ASSERT_EQ(ms_decode(&dec_opts, &dec_result), MS_OK);
+    EXPECT_EQ(dec_result.file_digest_verified, 1);
+    EXPECT_EQ(std::memcmp(enc_result.file_digest, dec_result.file_digest, sizeof(enc_result.file_digest)), 0);
+    EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str));
+}
+
+TEST(API, Decode_TamperedManifestFailsIntegrity) {
+    const TempFile input("api_tamper_input.bin");
+    const TempFile encoded("api_tamper.mkv");
+    const TempFile decoded("api_tamper_output.bin");
+
+    write_test_file(input.path_str, 2 * CHUNK_SIZE_BYTES);
+
+    for (const Tamper tamper: {Tamper::FileDigest, Tamper::ChunkTable}) {
+        write_tampered_archive(input.path_str, encoded.path_str, tamper);
+
+        ms_decode_options_t dec_opts{};
+        dec_opts.input_path = encoded.c_str();
+        dec_opts.output_path = decoded.c_str();
+
+        ms_result_t dec_result{};
+        EXPECT_EQ(ms_decode(&dec_opts, &dec_result), MS_ERR_INTEGRITY);
+        EXPECT_FALSE(std::filesystem::exists(decoded.path_str));
+    }
+}
+
+TEST(API, Decode_ReportsMissingFileDigest) {
+    const TempFile input("api_no_digest_input.bin");
+    const TempFile encoded("api_no_digest.mkv");
+    const TempFile decoded("api_no_digest_output.bin");
+
+    write_test_file(input.path_str, 2 * CHUNK_SIZE_BYTES);
+    write_tampered_archive(input.path_str, encoded.path_str, Tamper::None);
+
+    ms_decode_options_t dec_opts{};
+    dec_opts.input_path = encoded.c_str();
+    dec_opts.output_path = decoded.c_str();
+
+    ms_result_t dec_result{};
+    ASSERT_EQ(ms_decode(&dec_opts, &dec_result), MS_OK);
+    EXPECT_EQ(dec_result.file_digest_verified, 1);
+
+    write_tampered_archive(input.path_str, encoded.path_str, Tamper::DropFileDigest);
+    ASSERT_EQ(ms_decode(&dec_opts, &dec_result), MS_OK);
+    EXPECT_EQ(dec_result.file_digest_verified, 0);
+    EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str));
+}
+
+TEST(API, Probe_InvalidArgs) {
+    ms_info_t info{};
+    EXPECT_EQ(ms_probe(nullptr, &info), MS_ERR_INVALID_ARGS);
+    EXPECT_EQ(ms_probe("/nonexistent/path/video.mkv", &info), MS_ERR_FILE_NOT_FOUND);
+}
+
+TEST(API, Probe_ReadsManifest) {
+    const TempFile input("api_probe_input.bin");
+    const TempFile encoded("api_probe.mkv");
+
+    write_test_file(input.path_str, 2 * 1024 * 1024 + 5);
+
+    const std::string password = "probe_password";
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+    enc_opts.encrypt = 1;
+    enc_opts.password = password.c_str();
+    enc_opts.password_len = password.size();
+    enc_opts.hash_algorithm = MS_HASH_XXHASH32;
+
+    ms_result_t enc_result{};
+    ASSERT_EQ(ms_encode(&enc_opts, &enc_result), MS_OK);
+
+    ms_info_t info{};
+    ASSERT_EQ(ms_probe(encoded.c_str(), &info), MS_OK);
+    EXPECT_EQ(info.has_manifest, 1);
+    EXPECT_EQ(info.file_size, enc_result.input_size);
+    EXPECT_EQ(info.chunk_count, enc_result.total_chunks);
+    EXPECT_EQ(info.encrypted, 1);
+    EXPECT_EQ(info.hash_algorithm, MS_HASH_XXHASH32);
+    EXPECT_GT(info.symbol_size, 0u);
+    EXPECT_GT(info.frame_width, 0u);
+    EXPECT_GT(info.frame_height, 0u);
+}
+
+TEST(API, Refresh_ProducesDecodableVideo) {
+    const TempFile input("api_refresh_input.bin");
+    const TempFile encoded("api_refresh.mkv");
+    const TempFile refreshed("api_refresh_new.mkv");
+    const TempFile decoded("api_refresh_output.bin");
+
+    write_test_file(input.path_str, 1024 * 1024 + 4096);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+    ms_result_t enc_result{};
+    ASSERT_EQ(ms_encode(&enc_opts, &enc_result), MS_OK);
+
+    ms_refresh_options_t refresh_opts{};
+    refresh_opts.input_path = encoded.c_str();
+    refresh_opts.output_path = refreshed.c_str();
+    ms_result_t refresh_result{};
+    ASSERT_EQ(ms_refresh(&refresh_opts, &refresh_result), MS_OK);
+    EXPECT_EQ(refresh_result.total_chunks, enc_result.total_chunks);
+
+    ms_info_t info{};
+    ASSERT_EQ(ms_probe(refreshed.c_str(), &info), MS_OK);
+    EXPECT_EQ(info.has_manifest, 1);
+    EXPECT_EQ(info.file_size, enc_result.input_size);
+
+    ms_decode_options_t dec_opts{};
+    dec_opts.input_path = refreshed.c_str();
+    dec_opts.output_path = decoded.c_str();
+    ASSERT_EQ(ms_decode(&dec_opts, nullptr), MS_OK);
+    EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str));
+}
+
+TEST(API, EncodeMulti_InvalidSinksRejected) {
+    EXPECT_EQ(ms_encode_multi(nullptr, nullptr), MS_ERR_INVALID_ARGS);
+
+    ms_sink_t sink{};
+    sink.kind = MS_SINK_FILE;
+    sink.target = "unused.mkv";
+    sink.width = 100;
+
+    ms_encode_multi_options_t opts{};
+    opts.input_path = "unused.bin";
+    opts.sinks = &sink;
+    opts.sink_count = 1;
+    EXPECT_EQ(ms_encode_multi(&opts, nullptr), MS_ERR_INVALID_ARGS);
+
+    sink.width = 0;
+    sink.repair_overhead = -1.0;
+    EXPECT_EQ(ms_encode_multi(&opts, nullptr), MS_ERR_INVALID_ARGS);
+}
+
+TEST(API, EncodeMulti_EachSinkDecodes) {
+    const TempFile input("api_multi_input.bin");
+    const TempFile full("api_multi_full.mkv");
+    const TempFile lean("api_multi_lean.mkv");
+    const TempFile decoded_full("api_multi_full_output.bin");
+    const TempFile decoded_lean("api_multi_lean_output.bin");
+
+    write_test_file(input.path_str, 1024 * 1024 + 4096);
+
+    std::array<ms_sink_t, 2> sinks{};
+    sinks[0].kind = MS_SINK_FILE;
+    sinks[0].target = full.c_str();
+    sinks[1].kind = MS_SINK_FILE;
+    sinks[1].target = lean.c_str();
+    sinks[1].width = 1920;
+    sinks[1].height = 1080;
+    sinks[1].repair_overhead = 0.5;
+
+    ms_encode_multi_options_t opts{};
+    opts.input_path = input.c_str();
+    opts.sinks = sinks.data();
+    opts.sink_count = sinks.size();
+
+    std::array<ms_result_t, 2> results{};
+    ASSERT_EQ(ms_encode_multi(&opts, results.data()), MS_OK);
+    EXPECT_EQ(results[0].total_chunks, results[1].total_chunks);
+    EXPECT_GT(results[0].total_packets, results[1].total_packets);
+
+    ms_info_t info{};
+    ASSERT_EQ(ms_probe(lean.c_str(), &info), MS_OK);
+    EXPECT_EQ(info.frame_width, 1920u);
+    EXPECT_EQ(info.frame_height, 1080u);
+
+    for (const auto &[encoded, decoded]: {std::pair{&full, &decoded_full}, std::pair{&lean, &decoded_lean}}) {
+        ms_decode_options_t dec_opts{};
+        dec_opts.input_path = encoded->c_str();
+        dec_opts.output_path = decoded->c_str();
+        ASSERT_EQ(ms_decode(&dec_opts, nullptr), MS_OK);
+        EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded->path_str));
+    }
+}
+
+TEST(API, ShardPath_NumbersBeforeExtension) {
+    std::array<char, 64> buffer{};
+    ASSERT_EQ(ms_shard_path("backup.mkv", 7, buffer.data(), buffer.size()), MS_OK);
+    EXPECT_STREQ(buffer.data(), "backup.part007.mkv");
+    EXPECT_EQ(ms_shard_path("backup.mkv", 7, buffer.data(), 8), MS_ERR_INVALID_ARGS);
+    EXPECT_EQ(ms_shard_path(nullptr, 0, buffer.data(), buffer.size()), MS_ERR_INVALID_ARGS);
+}
+
+TEST(API, EncodeSharded_ShardsDecodeInAnyOrder) {
+    const TempFile input("api_shard_input.bin");
+    const TempFile encoded("api_shard.mkv");
+    const TempFile first("api_shard.part000.mkv");
+    const TempFile second("api_shard.part001.mkv");
+    const TempFile decoded("api_shard_output.bin");
+
+    // Three chunks, the last one short: a full chunk needs about 473 frames,
+    // so a 480 frame limit puts the first chunk alone and the other two together.
+    write_test_file(input.path_str, 2 * 1024 * 1024 + 4096);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+    enc_opts.max_shard_frames = 480;
+    ms_result_t enc_result{};
+    ASSERT_EQ(ms_encode(&enc_opts, &enc_result), MS_OK);
+    EXPECT_EQ(enc_result.total_shards, 2u);
+    EXPECT_EQ(enc_result.total_chunks, 3u);
+    EXPECT_FALSE(std::filesystem::exists(encoded.path_str));
+
+    ms_info_t info{};
+    ASSERT_EQ(ms_probe(second.c_str(), &info), MS_OK);
+    EXPECT_EQ(info.chunk_count, 3u);
+    EXPECT_EQ(info.shard_count, 2u);
+    EXPECT_EQ(info.shard_index, 1u);
+    EXPECT_EQ(info.shard_first_chunk, 1u);
+    EXPECT_EQ(info.shard_chunk_count, 2u);
+
+    ms_verify_options_t verify_opts{};
+    verify_opts.input_path = second.c_str();
+    ms_verify_result_t verify_result{};
+    ASSERT_EQ(ms_verify(&verify_opts, &verify_result), MS_OK);
+    EXPECT_EQ(verify_result.has_manifest, 1);
+    EXPECT_EQ(verify_result.verified_chunks, 2u);
+
+    const std::array<const char *, 2> inputs{second.c_str(), first.c_str()};
+    ms_decode_options_t dec_opts{};
+    dec_opts.input_paths = inputs.data();
+    dec_opts.input_count = inputs.size();
+    dec_opts.output_path = decoded.c_str();
+    ms_result_t dec_result{};
+    ASSERT_EQ(ms_decode(&dec_opts, &dec_result), MS_OK);
+    EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str));
+
+    // No shard carries the whole-file digest, but both sides still derive it.
+    ASSERT_EQ(dec_result.has_file_digest, 1);
+    EXPECT_EQ(dec_result.file_digest_verified, 0);
+    EXPECT_EQ(std::memcmp(enc_result.file_digest, dec_result.file_digest, sizeof(enc_result.file_digest)), 0);
+}
+
+TEST(API, Refresh_KeepsShardRange) {
+    const TempFile input("api_refresh_shard_input.bin");
+    const TempFile encoded("api_refresh_shard.mkv");
+    const TempFile first("api_refresh_shard.part000.mkv");
+    const TempFile second("api_refresh_shard.part001.mkv");
+    const TempFile refreshed("api_refresh_shard_new.mkv");
+    const TempFile decoded("api_refresh_shard_output.bin");
+
+    write_test_file(input.path_str, 2 * 1024 * 1024 + 4096);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+    enc_opts.max_shard_frames = 480;
+    ASSERT_EQ(ms_encode(&enc_opts, nullptr), MS_OK);
+
+    ms_refresh_options_t refresh_opts{};
+    refresh_opts.input_path = second.c_str();
+    refresh_opts.output_path = refreshed.c_str();
+    ms_result_t refresh_result{};
+    ASSERT_EQ(ms_refresh(&refresh_opts, &refresh_result), MS_OK);
+    EXPECT_EQ(refresh_result.total_chunks, 2u);
+
+    ms_info_t info{};
+    ASSERT_EQ(ms_probe(refreshed.c_str(), &info), MS_OK);
+    EXPECT_EQ(info.chunk_count, 3u);
+    EXPECT_EQ(info.shard_count, 2u);
+    EXPECT_EQ(info.shard_index, 1u);
+    EXPECT_EQ(info.shard_first_chunk, 1u);
+    EXPECT_EQ(info.shard_chunk_count, 2u);
+
+    ms_verify_options_t verify_opts{};
+    verify_opts.input_path = refreshed.c_str();
+    ms_verify_result_t verify_result{};
+    ASSERT_EQ(ms_verify(&verify_opts, &verify_result), MS_OK);
+    EXPECT_EQ(verify_result.verified_chunks, 2u);
+
+    const std::array<const char *, 2> inputs{first.c_str(), refreshed.c_str()};
+    ms_decode_options_t dec_opts{};
+    dec_opts.input_paths = inputs.data();
+    dec_opts.input_count = inputs.size();
+    dec_opts.output_path = decoded.c_str();
+    ASSERT_EQ(ms_decode(&dec_opts, nullptr), MS_OK);
+    EXPECT_EQ(read_test_file(input.path_str), read_test_file(decoded.path_str));
+}
+
+TEST(API, Catalog_RecordsEncodeAndSeeksRangeReads) {
+    const TempFile input("api_catalog_input.bin");
+    const TempFile encoded("api_catalog.mkv");
+    const TempFile first("api_catalog.part000.mkv");
+    const TempFile second("api_catalog.part001.mkv");
+    const TempFile catalog("api_catalog.catalog");
+
+    write_test_file(input.path_str, 2 * 1024 * 1024 + 4096);
+    const auto original = read_test_file(input.path_str);
+
+    ms_encode_options_t enc_opts{};
+    enc_opts.input_path = input.c_str();
+    enc_opts.output_path = encoded.c_str();
+    enc_opts.max_shard_frames = 480;
+    enc_opts.catalog_path = catalog.c_str();
+    ms_result_t enc_result{};
+    ASSERT_EQ(ms_encode(&enc_opts, &enc_result), MS_OK);
+
+    std::array<ms_catalog_entry_t, 2> entries{};
+    size_t count = 0;
+    ASSERT_EQ(ms_catalog_search(catalog.c_str(), "catalog_input", entries.data(), entries.size(), &count), MS_OK);
+    ASSERT_EQ(count, 1u);
+    const ms_catalog_entry_t &entry = entries[0];
+    EXPECT_STREQ(entry.name, "api_catalog_input.bin");
+    EXPECT_EQ(entry.file_size, original.size());
+    EXPECT_EQ(entry.video_count, 2u);
+    EXPECT_EQ(entry.has_frame_index, 1);
+    EXPECT_EQ(std::memcmp(entry.file_digest, enc_result.file_digest, sizeof(entry.file_digest)), 0);
+
+    char path[4096];
+    ASSERT_EQ(ms_catalog_video_path(catalog.c_str(), entry.file_id, 1, path, sizeof(path)), MS_OK);
+    EXPECT_TRUE(std::filesystem::equivalent(path, second.path_str));
+    EXPECT_EQ(ms_catalog_video_path(catalog.c_str(), entry.file_id, 2, path, sizeof(path)), MS_ERR_FILE_NOT_FOUND);
+
+    // The range sits in the last chunk, in the second shard: the first shard
+    // is skipped and the second is entered at the chunk's frame.
+    const std::array<const char *, 2> inputs{first.c_str(), second.c_str()};
+    std::vector<char> buffer(8192);
+    ms_read_range_options_t read_opts{};
+    read_opts.input_paths = inputs.data();
+    read_opts.input_count = inputs.size();
+    read_opts.offset = 2 * 1024 * 1024 - 4096;
+    read_opts.length = buffer.size();
+    read_opts.buffer = buffer.data();
+    read_opts.catalog_path = catalog.c_str();
+    uint64_t bytes_read = 0;
+    ASSERT_EQ(ms_read_range(&read_opts, &bytes_read), MS_OK);
+    ASSERT_EQ(bytes_read, buffer.size());
+    EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), original.begin() + static_cast<long>(read_opts.offset)));
+
+    // Probing a shard again keeps the name and frame index from the encode.
+    ASSERT_EQ(ms_catalog_add(catalog.c_str(), first.c_str(), nullptr), MS_OK);
+    ms_catalog_entry_t found{};
+    ASSERT_EQ(ms_catalog_find(catalog.c_str(), entry.file_id, &found), MS_OK);
+    EXPECT_STREQ(found.name, "api_catalog_input.bin");
+    EXPECT_EQ(found.has_frame_index, 1);
+
+    // Once the videos are gone, prune drops the entry.
+    std::filesystem::remove(first.path_str);
+    std::filesystem::remove(second.path_str);
+    size_t removed = 0;
+    ASSERT_EQ(ms_catalog_prune(catalog.c_str(), &removed), MS_OK);
+    EXPECT_EQ(removed, 1u);
+    EXPECT_EQ(ms_catalog_find(catalog.c_str(), entry.file_id, &found), MS_ERR_FILE_NOT_FOUND);
+}
+
 TEST(API, EncodeProgressCallback_IsCalled) {
     const TempFile input("api_prog_input.bin");
     const TempFile encoded("api_prog.mkv");
@@ -0,0 +1,157 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "catalog.h"
+#include "test_util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    CatalogEntry make_entry(const uint8_t seed, const std::string &name) {
+        CatalogEntry entry;
+        entry.file_id = make_test_id(seed);
+        entry.name = name;
+        entry.file_size = 3 * 1024 * 1024 + 17;
+        entry.chunk_count = 4;
+        entry.chunk_size = 1024 * 1024;
+        entry.has_digest = true;
+        entry.digest = make_test_digest(seed);
+        entry.videos.push_back(CatalogVideo{"/videos/" + name + ".mkv", 0, 0, 4});
+        entry.chunk_frames = {0, 40, 81, 122};
+        return entry;
+    }
+}
+
+TEST(Catalog, MergePersistsAcrossReloads) {
+    const TempPath dir("ms_catalog_persist");
+    const auto path = dir.path / "nested" / "catalog";
+    {
+        Catalog catalog(path);
+        EXPECT_EQ(catalog.size(), 0u);
+        catalog.merge(make_entry(1, "report.pdf"));
+        catalog.merge(make_entry(40, "photos.tar"));
+    }
+
+    const Catalog catalog(path);
+    ASSERT_EQ(catalog.size(), 2u);
+    const auto entry = catalog.find(make_test_id(1));
+    ASSERT_TRUE(entry.has_value());
+    EXPECT_EQ(entry->name, "report.pdf");
+    EXPECT_EQ(entry->file_size, 3u * 1024 * 1024 + 17);
+    EXPECT_EQ(entry->chunk_frames, (std::vector<uint32_t>{0, 40, 81, 122}));
+    EXPECT_TRUE(entry->has_digest);
+    EXPECT_EQ(entry->digest, make_test_digest(1));
+    EXPECT_GT(entry->recorded, 0);
+    ASSERT_EQ(entry->videos.size(), 1u);
+    EXPECT_EQ(entry->videos[0].path, "/videos/report.pdf.mkv");
+    EXPECT_FALSE(catalog.find(make_test_id(99)).has_value());
+}
+
+TEST(Catalog, MergeKeepsWhatAnUpdateLacks) {
+    const TempPath dir("ms_catalog_merge");
+    Catalog catalog(dir.path / "catalog");
+
+    CatalogEntry first = make_entry(1, "movie.mkv");
+    first.shard_count = 2;
+    first.videos = {CatalogVideo{"/v/shard_001.mkv", 1, 2, 2}};
+    catalog.merge(first);
+
+    // A probe of the other shard: no name, digest or frame index.
+    CatalogEntry probe;
+    probe.file_id = first.file_id;
+    probe.file_size = first.file_size;
+    probe.chunk_count = first.chunk_count;
+    probe.shard_count = 2;
+    probe.videos = {CatalogVideo{"/v/shard_000.mkv", 0, 0, 2}};
+    catalog.merge(probe);
+
+    const auto entry = catalog.find(first.file_id);
+    ASSERT_TRUE(entry.has_value());
+    EXPECT_EQ(entry->name, "movie.mkv");
+    EXPECT_TRUE(entry->has_digest);
+    EXPECT_EQ(entry->chunk_frames.size(), 4u);
+    ASSERT_EQ(entry->videos.size(), 2u);
+    EXPECT_EQ(entry->videos[0].path, "/v/shard_000.mkv");
+    EXPECT_EQ(entry->videos[1].path, "/v/shard_001.mkv");
+    EXPECT_EQ(entry->video_for_chunk(1), &entry->videos[0]);
+    EXPECT_EQ(entry->video_for_chunk(3), &entry->videos[1]);
+    EXPECT_EQ(entry->video_for_chunk(4), nullptr);
+}
+
+TEST(Catalog, SearchRemoveAndCompact) {
+    const TempPath dir("ms_catalog_search");
+    const auto path = dir.path / "catalog";
+    Catalog catalog(path);
+    catalog.merge(make_entry(1, "b_notes.txt"));
+    catalog.merge(make_entry(20, "a_notes.txt"));
+    catalog.merge(make_entry(40, "song.flac"));
+    for (int i = 0; i < 5; ++i) {
+        catalog.merge(make_entry(40, "song.flac"));
+    }
+
+    const auto notes = catalog.search("notes");
+    ASSERT_EQ(notes.size(), 2u);
+    EXPECT_EQ(notes[0].name, "a_notes.txt");
+    EXPECT_EQ(notes[1].name, "b_notes.txt");
+    EXPECT_EQ(catalog.search().size(), 3u);
+
+    EXPECT_TRUE(catalog.remove(make_test_id(1)));
+    EXPECT_FALSE(catalog.remove(make_test_id(1)));
+    EXPECT_EQ(Catalog(path).size(), 2u);
+
+    const auto before = std::filesystem::file_size(path);
+    catalog.compact();
+    EXPECT_LT(std::filesystem::file_size(path), before);
+    const Catalog reloaded(path);
+    EXPECT_EQ(reloaded.size(), 2u);
+    EXPECT_FALSE(reloaded.find(make_test_id(1)).has_value());
+}
+
+TEST(Catalog, TornRecordIsSkipped) {
+    const TempPath dir("ms_catalog_torn");
+    const auto path = dir.path / "catalog";
+    {
+        Catalog catalog(path);
+        catalog.merge(make_entry(1, "kept.bin"));
+        catalog.merge(make_entry(20, "torn.bin"));
+    }
+    const auto torn_size = std::filesystem::file_size(path) - 5;
+    std::filesystem::resize_file(path, torn_size);
+
+    {
+        Catalog catalog(path);
+        EXPECT_EQ(catalog.size(), 1u);
+        EXPECT_TRUE(catalog.find(make_test_id(1)).has_value());
+        EXPECT_EQ(std::filesystem::file_size(path), torn_size);
+        // Records appended after the damage must load again.
+        catalog.merge(make_entry(60, "later.bin"));
+    }
+    Catalog catalog(path);
+    EXPECT_EQ(catalog.size(), 2u);
+    EXPECT_TRUE(catalog.find(make_test_id(60)).has_value());
+    catalog.compact();
+    EXPECT_EQ(Catalog(path).size(), 2u);
+
+    std::ofstream(dir.path / "other", std::ios::binary) << "not a catalog";
+    EXPECT_THROW(Catalog(dir.path / "other"), std::runtime_error);
+}
@@ -0,0 +1,126 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "chunk_cache.h"
+#include "test_util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    ChunkCacheKey make_key(const uint32_t chunk_index, const uint64_t key_tag = 0) {
+        ChunkCacheKey key;
+        key.file_id = make_test_id(0xA0);
+        key.key_tag = key_tag;
+        key.chunk_index = chunk_index;
+        return key;
+    }
+}
+
+TEST(ChunkCache, DisabledByDefault) {
+    ChunkCache cache;
+    EXPECT_FALSE(cache.enabled());
+    cache.put(make_key(0), make_test_bytes(16, 1));
+    EXPECT_FALSE(cache.get(make_key(0)).has_value());
+}
+
+TEST(ChunkCache, MemoryTierEvictsLeastRecentlyUsed) {
+    ChunkCache cache;
+    cache.configure(300, {}, 0);
+    cache.put(make_key(0), make_test_bytes(100, 0));
+    cache.put(make_key(1), make_test_bytes(100, 1));
+    cache.put(make_key(2), make_test_bytes(100, 2));
+
+    // Touching chunk 0 makes chunk 1 the oldest.
+    EXPECT_EQ(cache.get(make_key(0)), make_test_bytes(100, 0));
+    cache.put(make_key(3), make_test_bytes(100, 3));
+    EXPECT_FALSE(cache.get(make_key(1)).has_value());
+    EXPECT_TRUE(cache.get(make_key(0)).has_value());
+    EXPECT_TRUE(cache.get(make_key(3)).has_value());
+
+    const ChunkCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.memory_hits, 3u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.memory_bytes, 300u);
+
+    // Entries are per key tag: another key never sees this plaintext.
+    EXPECT_FALSE(cache.get(make_key(0, 42)).has_value());
+}
+
+TEST(ChunkCache, SpillsToDiskAndPromotesBack) {
+    const TempPath dir("ms_chunk_cache_disk");
+    {
+        ChunkCache cache;
+        cache.configure(200, dir.path, 1000);
+        for (uint32_t i = 0; i < 5; ++i) {
+            cache.put(make_key(i, 7), make_test_bytes(100, static_cast<uint8_t>(i)));
+        }
+        ChunkCacheStats stats = cache.stats();
+        EXPECT_EQ(stats.memory_bytes, 200u);
+        EXPECT_EQ(stats.disk_bytes, 300u);
+
+        EXPECT_EQ(cache.get(make_key(0, 7)), make_test_bytes(100, 0));
+        stats = cache.stats();
+        EXPECT_EQ(stats.disk_hits, 1u);
+        EXPECT_EQ(stats.memory_bytes, 200u);
+        EXPECT_EQ(stats.disk_bytes, 300u);
+    }
+
+    // A new cache over the same directory picks the files up again.
+    ChunkCache reopened;
+    reopened.configure(0, dir.path, 1000);
+    EXPECT_EQ(reopened.stats().disk_bytes, 300u);
+    EXPECT_EQ(reopened.get(make_key(2, 7)), make_test_bytes(100, 2));
+
+    // A damaged file is a miss, not bad data.
+    for (const auto &file: std::filesystem::directory_iterator(dir.path)) {
+        std::fstream f(file.path(), std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(50);
+        f.put('\x33');
+    }
+    reopened.configure(0, {}, 0);
+    reopened.configure(0, dir.path, 1000);
+    std::size_t hits = 0;
+    for (uint32_t i = 0; i < 5; ++i) {
+        hits += reopened.get(make_key(i, 7)).has_value();
+    }
+    EXPECT_EQ(hits, 0u);
+
+    reopened.clear();
+    EXPECT_TRUE(std::filesystem::is_empty(dir.path));
+}
+
+TEST(ChunkCache, DiskEntryLargerThanItsFileIsAMiss) {
+    const TempPath dir("ms_chunk_cache_size");
+    ChunkCache cache;
+    cache.configure(0, dir.path, 1000);
+    cache.put(make_key(0), make_test_bytes(100));
+
+    // A header claiming 4 GiB must not be allocated for a 100 byte entry.
+    for (const auto &file: std::filesystem::directory_iterator(dir.path)) {
+        std::fstream f(file.path(), std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(9);
+        f.write("\xff\xff\xff\xff", 4);
+    }
+    EXPECT_FALSE(cache.get(make_key(0)).has_value());
+}
@@ -0,0 +1,146 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "chunk_table.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+TEST(ChunkTable, EmptyTable) {
+    const ChunkStateTable table;
+    EXPECT_EQ(table.size(), 0u);
+    EXPECT_EQ(table.complete_count(), 0u);
+    EXPECT_EQ(table.first_missing(), 0u);
+    EXPECT_FALSE(table.is_complete(0));
+    EXPECT_EQ(table.state(7), ChunkState::Missing);
+}
+
+TEST(ChunkTable, MarkCompleteTracksStateAndSize) {
+    ChunkStateTable table;
+    table.set_state(3, ChunkState::Receiving);
+    EXPECT_EQ(table.size(), 4u);
+    EXPECT_EQ(table.state(3), ChunkState::Receiving);
+
+    table.mark_complete(3, 1000);
+    EXPECT_TRUE(table.is_complete(3));
+    EXPECT_EQ(table.state(3), ChunkState::Complete);
+    EXPECT_EQ(table.output_size(3), 1000u);
+    EXPECT_EQ(table.complete_count(), 1u);
+
+    table.mark_complete(3, 5);
+    EXPECT_EQ(table.complete_count(), 1u);
+    EXPECT_EQ(table.output_size(3), 1000u);
+
+    table.set_state(3, ChunkState::Spilled);
+    EXPECT_EQ(table.state(3), ChunkState::Complete);
+}
+
+TEST(ChunkTable, LiveSlotsDefaultToNone) {
+    ChunkStateTable table;
+    EXPECT_EQ(table.live_slot(5), ChunkStateTable::NO_SLOT);
+
+    table.set_live_slot(5, 2);
+    EXPECT_EQ(table.size(), 6u);
+    EXPECT_EQ(table.live_slot(5), 2u);
+    EXPECT_EQ(table.live_slot(4), ChunkStateTable::NO_SLOT);
+
+    table.set_live_slot(5, ChunkStateTable::NO_SLOT);
+    EXPECT_EQ(table.live_slot(5), ChunkStateTable::NO_SLOT);
+}
+
+TEST(ChunkTable, FirstMissingAdvancesAcrossWords) {
+    ChunkStateTable table;
+    table.grow(200);
+    for (uint32_t i = 0; i < 130; ++i) {
+        table.mark_complete(i, 1);
+    }
+    EXPECT_EQ(table.first_missing(), 130u);
+
+    table.mark_complete(131, 1);
+    EXPECT_EQ(table.first_missing(), 130u);
+
+    table.mark_complete(130, 1);
+    EXPECT_EQ(table.first_missing(), 132u);
+}
+
+TEST(ChunkTable, FirstMissingEqualsSizeWhenAllComplete) {
+    ChunkStateTable table;
+    for (uint32_t i = 0; i < 70; ++i) {
+        table.mark_complete(i, 1);
+    }
+    EXPECT_EQ(table.first_missing(), 70u);
+}
+
+TEST(ChunkTable, RangeComplete) {
+    ChunkStateTable table;
+    table.grow(300);
+    for (uint32_t i = 10; i < 250; ++i) {
+        table.mark_complete(i, 1);
+    }
+    EXPECT_TRUE(table.range_complete(10, 250));
+    EXPECT_TRUE(table.range_complete(64, 192));
+    EXPECT_TRUE(table.range_complete(5, 5));
+    EXPECT_FALSE(table.range_complete(9, 250));
+    EXPECT_FALSE(table.range_complete(10, 251));
+    EXPECT_FALSE(table.range_complete(0, 400));
+}
+
+TEST(ChunkTable, CompleteIndicesAreSorted) {
+    ChunkStateTable table;
+    for (const uint32_t i: {90u, 3u, 64u, 0u}) {
+        table.mark_complete(i, 1);
+    }
+    EXPECT_EQ(table.complete_indices(), (std::vector<uint32_t>{0, 3, 64, 90}));
+}
+
+TEST(ChunkTable, OffsetsArePrefixSums) {
+    ChunkStateTable table;
+    table.mark_complete(0, 100);
+    table.mark_complete(1, 50);
+    table.mark_complete(2, 7);
+    EXPECT_EQ(table.offsets(3), (std::vector<uint64_t>{0, 100, 150, 157}));
+}
+
+TEST(ChunkTable, SerializeRoundtrip) {
+    ChunkStateTable table;
+    table.grow(129);
+    table.mark_complete(0, 11);
+    table.mark_complete(64, 22);
+    table.mark_complete(128, 33);
+    table.set_state(5, ChunkState::Receiving);
+
+    const auto bytes = table.serialize();
+    const auto restored = ChunkStateTable::deserialize(bytes);
+    ASSERT_TRUE(restored.has_value());
+    EXPECT_EQ(restored->size(), 129u);
+    EXPECT_EQ(restored->complete_count(), 3u);
+    EXPECT_EQ(restored->output_size(64), 22u);
+    EXPECT_EQ(restored->output_size(128), 33u);
+    EXPECT_EQ(restored->state(5), ChunkState::Missing);
+    EXPECT_EQ(restored->complete_indices(), table.complete_indices());
+}
+
+TEST(ChunkTable, DeserializeRejectsTruncatedData) {
+    ChunkStateTable table;
+    table.mark_complete(2, 9);
+    auto bytes = table.serialize();
+    bytes.pop_back();
+    EXPECT_FALSE(ChunkStateTable::deserialize(bytes).has_value());
+    EXPECT_FALSE(ChunkStateTable::deserialize({}).has_value());
+}
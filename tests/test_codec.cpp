@@ -404,3 +404,202 @@ TEST(Codec, Decoder_IncompleteChunkNotAccessible) {
     EXPECT_FALSE(decoder.is_chunk_complete(0));
     EXPECT_FALSE(decoder.get_chunk_data(0).has_value());
 }
+
+TEST(Codec, Decoder_MemoryBudgetSpillsAndRecovers) {
+    constexpr uint32_t chunk_count = 8;
+    const Encoder encoder(make_test_file_id());
+
+    std::vector<std::vector<std::byte> > originals;
+    std::vector<std::vector<Packet> > chunk_packets;
+    for (uint32_t i = 0; i < chunk_count; ++i) {
+        auto data = make_test_data(SYMBOL_SIZE_BYTES * 256 + i * 100);
+        data[0] = std::byte{static_cast<uint8_t>(i)};
+        auto [packets, manifest] = encoder.encode_chunk(i, data, i == chunk_count - 1);
+        originals.push_back(std::move(data));
+        chunk_packets.push_back(std::move(packets));
+    }
+
+    Decoder decoder;
+    decoder.set_memory_budget(SYMBOL_SIZE_BYTES * 256);
+
+    // Round-robin across chunks so every chunk is partially received at once.
+    for (std::size_t round = 0;; ++round) {
+        bool fed = false;
+        for (const auto &packets: chunk_packets) {
+            if (round < packets.size()) {
+                (void) decoder.process_packet(packet_span(packets[round]));
+                fed = true;
+            }
+        }
+        if (!fed) break;
+    }
+
+    const DecoderMemoryStats stats = decoder.memory_stats();
+    EXPECT_GT(stats.evictions, 0u);
+    EXPECT_GT(stats.reingests, 0u);
+    EXPECT_GT(stats.spill_bytes, 0u);
+    EXPECT_EQ(stats.live_decoders, 0u);
+
+    ASSERT_EQ(decoder.chunks_completed(), chunk_count);
+    for (uint32_t i = 0; i < chunk_count; ++i) {
+        const auto recovered = decoder.get_chunk_data(i);
+        ASSERT_TRUE(recovered.has_value());
+        EXPECT_EQ(*recovered, originals[i]);
+    }
+}
+
+TEST(Codec, Decoder_BuffersSymbolsOnlyUnderABudget) {
+    constexpr uint32_t k = 64;
+    const Encoder encoder(make_test_file_id());
+    const auto [packets, manifest] = encoder.encode_chunk(0, make_test_data(SYMBOL_SIZE_BYTES * k), false);
+
+    // Without a budget the first symbol goes straight to a wirehair decoder.
+    Decoder direct;
+    (void) direct.process_packet(packet_span(packets[0]));
+    EXPECT_GE(direct.memory_stats().live_bytes, std::size_t{k} * SYMBOL_SIZE_BYTES);
+
+    // Under one, symbols wait in a buffer until k of them have arrived.
+    Decoder buffered;
+    buffered.set_memory_budget(SYMBOL_SIZE_BYTES * 1024);
+    (void) buffered.process_packet(packet_span(packets[0]));
+    EXPECT_LT(buffered.memory_stats().live_bytes, std::size_t{k} * SYMBOL_SIZE_BYTES);
+
+    EXPECT_TRUE(feed_all_packets_to_decoder(direct, packets));
+    EXPECT_TRUE(feed_all_packets_to_decoder(buffered, packets));
+}
+
+TEST(Codec, Decoder_LimitsRejectChunkIndexBeyondCount) {
+    const Encoder encoder(make_test_file_id());
+    const auto [packets, manifest] = encoder.encode_chunk(5, make_test_data(4096), false);
+
+    Decoder decoder;
+    DecoderLimits limits;
+    limits.max_chunk_count = 4;
+    decoder.set_limits(limits);
+
+    EXPECT_FALSE(feed_all_packets_to_decoder(decoder, packets));
+    EXPECT_EQ(decoder.packets_rejected(), packets.size());
+    EXPECT_EQ(decoder.memory_stats().live_decoders, 0u);
+}
+
+TEST(Codec, Decoder_UnconfirmedCountBoundsTableGrowth) {
+    const Encoder encoder(make_test_file_id());
+    const auto [far_packets, m0] = encoder.encode_chunk(MAX_CHUNK_COUNT - 1, make_test_data(4096), false);
+    const auto [near_packets, m1] = encoder.encode_chunk(UNCONFIRMED_CHUNK_WINDOW - 1, make_test_data(4096), false);
+
+    // A chunk far past anything decoded is dropped before the table grows.
+    Decoder decoder;
+    EXPECT_FALSE(decoder.process_packet(packet_span(far_packets[0])).has_value());
+    EXPECT_EQ(decoder.packets_rejected(), 1u);
+    EXPECT_EQ(decoder.chunk_table().size(), 0u);
+
+    EXPECT_TRUE(feed_all_packets_to_decoder(decoder, near_packets));
+    EXPECT_EQ(decoder.chunk_table().size(), UNCONFIRMED_CHUNK_WINDOW);
+}
+
+TEST(Codec, Decoder_LastChunkNarrowsAcceptedRange) {
+    const Encoder encoder(make_test_file_id());
+    const auto [last_packets, m0] = encoder.encode_chunk(1, make_test_data(4096), true);
+    const auto [stray_packets, m1] = encoder.encode_chunk(7, make_test_data(4096), false);
+
+    Decoder decoder;
+    EXPECT_TRUE(feed_all_packets_to_decoder(decoder, last_packets));
+    EXPECT_FALSE(feed_all_packets_to_decoder(decoder, stray_packets));
+    EXPECT_EQ(decoder.packets_rejected(), stray_packets.size());
+}
+
+TEST(Codec, Decoder_SingleLastChunkPacketDoesNotNarrowRange) {
+    const Encoder encoder(make_test_file_id());
+    const auto [forged_packets, m0] = encoder.encode_chunk(1, make_test_data(4096), true);
+    const auto chunk7_data = make_test_data(4096);
+    const auto [packets7, m1] = encoder.encode_chunk(7, chunk7_data, false);
+
+    Decoder decoder;
+    (void) decoder.process_packet(packet_span(forged_packets[0]));
+    EXPECT_TRUE(feed_all_packets_to_decoder(decoder, packets7));
+    EXPECT_EQ(decoder.packets_rejected(), 0u);
+    const auto recovered = decoder.get_chunk_data(7);
+    ASSERT_TRUE(recovered.has_value());
+    EXPECT_EQ(*recovered, chunk7_data);
+}
+
+TEST(Codec, Decoder_LimitsCapLiveDecoders) {
+    const auto chunk0_data = make_test_data(4096);
+    const Encoder encoder(make_test_file_id());
+    const auto [packets0, m0] = encoder.encode_chunk(0, chunk0_data, false);
+    const auto [packets1, m1] = encoder.encode_chunk(1, make_test_data(4096), false);
+
+    Decoder decoder;
+    DecoderLimits limits;
+    limits.max_live_decoders = 1;
+    decoder.set_limits(limits);
+
+    (void) decoder.process_packet(packet_span(packets0[0]));
+    (void) decoder.process_packet(packet_span(packets1[0]));
+    EXPECT_EQ(decoder.packets_rejected(), 1u);
+    EXPECT_EQ(decoder.memory_stats().live_decoders, 1u);
+
+    EXPECT_TRUE(feed_all_packets_to_decoder(decoder, packets0));
+    const auto recovered = decoder.get_chunk_data(0);
+    ASSERT_TRUE(recovered.has_value());
+    EXPECT_EQ(*recovered, chunk0_data);
+}
+
+TEST(Codec, Decoder_RejectsInconsistentGeometry) {
+    const Encoder encoder(make_test_file_id());
+    auto [packets, manifest] = encoder.encode_chunk(0, make_test_data(4096), false);
+
+    // Claim a 512 MiB chunk while keeping k and a valid checksum.
+    auto &bytes = packets[0].bytes;
+    constexpr uint32_t huge_size = 512u * 1024u * 1024u;
+    std::memcpy(bytes.data() + CHUNK_SIZE_OFF, &huge_size, sizeof(huge_size));
+    const uint32_t crc = packet_checksum(std::span<const std::byte>(bytes.data(), HEADER_SIZE_V2),
+                                         std::span<const std::byte>(bytes.data() + HEADER_SIZE_V2, SYMBOL_SIZE_BYTES),
+                                         CRC_OFF_V2, HashAlgorithm::CRC32, CRC_SIZE);
+    std::memcpy(bytes.data() + CRC_OFF_V2, &crc, sizeof(crc));
+    ASSERT_TRUE(Decoder::validate_raw_packet_crc(packet_span(packets[0])));
+
+    Decoder decoder;
+    EXPECT_FALSE(decoder.process_packet(packet_span(packets[0])).has_value());
+    EXPECT_EQ(decoder.packets_rejected(), 1u);
+    EXPECT_EQ(decoder.memory_stats().live_decoders, 0u);
+}
+
+TEST(Codec, Encoder_AllPacketsPassChecksum) {
+    for (const HashAlgorithm algo: {HashAlgorithm::CRC32, HashAlgorithm::XXHash32}) {
+        const Encoder encoder(make_test_file_id(), algo);
+        // Not a multiple of the symbol size, so the last source symbol is short.
+        const auto [packets, manifest] = encode_test_data(encoder, make_test_data(SYMBOL_SIZE_BYTES * 5 + 17), 3, true);
+        for (const Packet &packet: packets) {
+            EXPECT_TRUE(Decoder::validate_raw_packet_crc(packet_span(packet)));
+        }
+    }
+}
+
+TEST(Codec, Decoder_HandsOffCodecForReencoding) {
+    const Encoder encoder(make_test_file_id(), HashAlgorithm::XXHash32);
+    const auto original = make_test_data(SYMBOL_SIZE_BYTES * 40 + 99);
+    const auto [packets, manifest] = encode_test_data(encoder, original, 7, true);
+
+    // Keep only every third packet, as a damaged archive would.
+    Decoder damaged;
+    damaged.set_retain_chunk_data(false);
+    damaged.set_hand_off_codecs(true);
+    std::optional<ChunkDecodeResult> recovered;
+    for (std::size_t i = 0; i < packets.size() && !recovered; i += 3) {
+        if (auto res = damaged.process_packet(packet_span(packets[i])); res && res->success) {
+            recovered = std::move(res);
+        }
+    }
+    ASSERT_TRUE(recovered.has_value());
+    ASSERT_TRUE(static_cast<bool>(recovered->codec));
+
+    const PacketHeader &hdr = recovered->codec.header();
+    const auto fresh = encoder.encode_recovered(recovered->codec.get(), hdr.chunk_index, hdr.chunk_size,
+                                                hdr.original_size, hdr.k, (hdr.flags & LastChunk) != 0,
+                                                (hdr.flags & Encrypted) != 0);
+    ASSERT_EQ(fresh.size(), packets.size());
+    for (std::size_t i = 0; i < fresh.size(); ++i) {
+        EXPECT_EQ(fresh[i].bytes, packets[i].bytes);
+    }
+}
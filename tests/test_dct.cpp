@@ -21,6 +21,7 @@
 #include "video_encoder.h"
 
 #include <cstdint>
+#include <set>
 
 TEST(DCT, PrecomputedBlocks_PatternCountMatchesBitsPerBlock) {
     constexpr int expected_patterns = 1 << BITS_PER_BLOCK;
@@ -138,3 +139,43 @@ TEST(DCT, DifferentPatternsProduceDifferentBlocks) {
     }
     EXPECT_TRUE(any_differ);
 }
+
+TEST(DCT, EmbedExtract_EveryPatternSetDecodesAlike) {
+    const auto &[vectors] = get_decoder_projections();
+
+    for (int set = 0; set < PATTERN_SET_COUNT; ++set) {
+        const auto &[patterns] = get_precomputed_blocks(static_cast<PatternSet>(set));
+        for (int pattern = 0; pattern < PrecomputedBlocks::NUM_PATTERNS; ++pattern) {
+            alignas(32) float block_flat[64];
+            for (int y = 0; y < 8; ++y) {
+                for (int x = 0; x < 8; ++x) {
+                    block_flat[y * 8 + x] = static_cast<float>(patterns[pattern][y][x]);
+                }
+            }
+
+            int recovered = 0;
+            for (int b = 0; b < BITS_PER_BLOCK; ++b) {
+                const float sum = dot_product_64(block_flat, vectors[b]);
+                recovered = (recovered << 1) | (sum > 0.0f ? 1 : 0);
+            }
+            EXPECT_EQ(recovered, pattern) << "Set " << set << ", pattern " << pattern;
+        }
+    }
+}
+
+TEST(DCT, StepPatterns_UseTwoLevelsPerBit) {
+    if constexpr (BITS_PER_BLOCK != 1) {
+        GTEST_SKIP() << "Two levels only with one bit per block";
+    }
+
+    const auto &[patterns] = get_precomputed_blocks(PatternSet::Step);
+    for (int pattern = 0; pattern < PrecomputedBlocks::NUM_PATTERNS; ++pattern) {
+        std::set<uint8_t> levels;
+        for (int y = 0; y < 8; ++y) {
+            for (int x = 0; x < 8; ++x) {
+                levels.insert(patterns[pattern][y][x]);
+            }
+        }
+        EXPECT_EQ(levels.size(), 2u);
+    }
+}
@@ -0,0 +1,59 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "decode_threads.h"
+
+TEST(DecodeThreads, IntraCodecUsesSliceThreadsUpToSlices) {
+    const DecoderThreading unknown = choose_decoder_threading(true, 0, 0, 16);
+    EXPECT_FALSE(unknown.frame_threads);
+    EXPECT_TRUE(unknown.slice_threads);
+    EXPECT_EQ(unknown.thread_count, 0);
+
+    EXPECT_EQ(choose_decoder_threading(true, 4, 0, 16).thread_count, 4);
+    EXPECT_EQ(choose_decoder_threading(true, 64, 0, 16).thread_count, 16);
+    EXPECT_EQ(choose_decoder_threading(true, 4, 0, 0).thread_count, 1);
+}
+
+TEST(DecodeThreads, InterCodecUsesFrameThreads) {
+    const DecoderThreading threading = choose_decoder_threading(false, 0, 0, 16);
+    EXPECT_TRUE(threading.frame_threads);
+    EXPECT_TRUE(threading.slice_threads);
+    EXPECT_EQ(threading.thread_count, 0);
+}
+
+TEST(DecodeThreads, RequestedCountOverrides) {
+    EXPECT_EQ(choose_decoder_threading(true, 4, 12, 16).thread_count, 12);
+    EXPECT_EQ(choose_decoder_threading(false, 0, 3, 16).thread_count, 3);
+}
+
+TEST(DecodeThreads, SequentialDecoderLeavesExtractionEveryCore) {
+    const DecodeStageTimes times{0.9, 0.1, 0.0, 32};
+    EXPECT_EQ(balance_extract_threads(times, 8, false), 8);
+    EXPECT_EQ(balance_extract_threads(DecodeStageTimes{}, 8, true), 8);
+}
+
+TEST(DecodeThreads, FrameThreadsShareCoresByStageTime) {
+    // Extraction takes a quarter of the frame time, so it gets a quarter of
+    // the cores and the frame threads the rest.
+    EXPECT_EQ(balance_extract_threads(DecodeStageTimes{0.5, 0.25, 0.25, 32}, 16, true), 4);
+    // An extraction-bound decode keeps nearly every core for it.
+    EXPECT_EQ(balance_extract_threads(DecodeStageTimes{0.05, 0.9, 0.05, 32}, 8, true), 7);
+    // Never starved entirely.
+    EXPECT_EQ(balance_extract_threads(DecodeStageTimes{1.0, 0.001, 0.0, 32}, 8, true), 1);
+    EXPECT_EQ(balance_extract_threads(DecodeStageTimes{0.5, 0.5, 0.0, 32}, 0, true), 1);
+}
@@ -0,0 +1,140 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "decoder.h"
+#include "encode_cache.h"
+#include "encoder.h"
+#include "test_util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+TEST(EncodeCache, ChunkRoundtripRestampsForNewPosition) {
+    const TempPath dir("ms_encode_cache_chunks");
+    const EncodeCache cache(dir.path);
+
+    const auto chunk = make_test_bytes(SYMBOL_SIZE_BYTES * 30 + 11);
+    const Encoder original(make_test_id(1));
+    auto [packets, entry] = original.encode_chunk(0, chunk, false);
+    const Sha256Digest key = EncodeCache::chunk_key(entry.sha256, original.repair_overhead());
+    EXPECT_FALSE(cache.load_chunk(key).has_value());
+    ASSERT_TRUE(cache.store_chunk(key, CachedChunk{entry, packets}));
+
+    auto cached = cache.load_chunk(key);
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(cached->entry.original_size, entry.original_size);
+    EXPECT_EQ(cached->entry.N, entry.N);
+    ASSERT_EQ(cached->packets.size(), packets.size());
+
+    // Reused as the last chunk of another file, the packets carry the new
+    // position and decode to the same bytes.
+    const Encoder reuser(make_test_id(40));
+    reuser.restamp_chunk(cached->packets, cached->entry, 7, true);
+    Decoder decoder;
+    bool decoded = false;
+    for (const Packet &packet: cached->packets) {
+        if (auto res = decoder.process_packet(std::span<const std::byte>(packet.bytes.data(), packet.bytes.size()));
+            res && res->success) {
+            EXPECT_EQ(res->chunk_index, 7u);
+            EXPECT_EQ(decoder.get_chunk_data(7), chunk);
+            decoded = true;
+            break;
+        }
+    }
+    EXPECT_TRUE(decoded);
+    EXPECT_EQ(decoder.file_id(), reuser.file_id());
+
+    // A different overhead is a different entry.
+    EXPECT_NE(EncodeCache::chunk_key(entry.sha256, 1.0), key);
+}
+
+TEST(EncodeCache, DamagedChunkIsAMiss) {
+    const TempPath dir("ms_encode_cache_damaged");
+    const EncodeCache cache(dir.path);
+
+    const Encoder encoder(make_test_id(1));
+    const auto [packets, entry] = encoder.encode_chunk(0, make_test_bytes(SYMBOL_SIZE_BYTES * 4), false);
+    const Sha256Digest key = EncodeCache::chunk_key(entry.sha256, encoder.repair_overhead());
+    ASSERT_TRUE(cache.store_chunk(key, CachedChunk{entry, packets}));
+
+    for (const auto &file: std::filesystem::recursive_directory_iterator(dir.path / "chunks")) {
+        if (file.is_regular_file()) {
+            std::fstream f(file.path(), std::ios::binary | std::ios::in | std::ios::out);
+            f.seekp(100);
+            f.put('\x5a');
+        }
+    }
+    EXPECT_FALSE(cache.load_chunk(key).has_value());
+}
+
+TEST(EncodeCache, VideoStoreAndFetch) {
+    const TempPath dir("ms_encode_cache_videos");
+    const EncodeCache cache(dir.path);
+    const auto video = dir.path / "source.mkv";
+    const auto fetched = dir.path / "fetched.mkv";
+    {
+        std::ofstream out(video, std::ios::binary);
+        out << "not really a video";
+    }
+
+    const std::vector<std::byte> profile{std::byte{1}, std::byte{2}};
+    const Sha256Digest content = sha256(make_test_bytes(64));
+    const Sha256Digest key = EncodeCache::video_key(content, profile);
+    EXPECT_NE(EncodeCache::video_key(content, std::span(profile).first(1)), key);
+    EXPECT_FALSE(cache.fetch_video(key, fetched).has_value());
+
+    ASSERT_TRUE(cache.store_video(key, video, CachedEncode{120, 4, 3, 0, make_test_id(9)}));
+    const auto hit = cache.fetch_video(key, fetched);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->total_packets, 120u);
+    EXPECT_EQ(hit->total_frames, 4u);
+    EXPECT_EQ(hit->total_chunks, 3u);
+    EXPECT_EQ(hit->file_id, make_test_id(9));
+    EXPECT_EQ(std::filesystem::file_size(fetched), std::filesystem::file_size(video));
+}
+
+TEST(EncodeCache, InputKeyFollowsTheFile) {
+    const TempPath dir("ms_encode_cache_inputs");
+    const EncodeCache cache(dir.path);
+    const auto input = dir.path / "input.bin";
+    {
+        std::ofstream out(input, std::ios::binary);
+        out << "first contents";
+    }
+
+    const std::vector<std::byte> profile{std::byte{1}};
+    const Sha256Digest key = EncodeCache::input_key(input, profile);
+    EXPECT_EQ(EncodeCache::input_key(input, profile), key);
+    EXPECT_NE(EncodeCache::input_key(input, {}), key);
+    EXPECT_FALSE(cache.find_input(key).has_value());
+
+    const Sha256Digest content = sha256(make_test_bytes(64));
+    ASSERT_TRUE(cache.store_input(key, content));
+    EXPECT_EQ(cache.find_input(key), content);
+
+    {
+        std::ofstream out(input, std::ios::binary | std::ios::app);
+        out << ", then more";
+    }
+    EXPECT_NE(EncodeCache::input_key(input, profile), key);
+}
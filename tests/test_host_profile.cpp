@@ -0,0 +1,93 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <gtest/gtest.h>
+
+#include "host_profile.h"
+#include "test_util.h"
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+TEST(HostProfile, FormatParseRoundtrip) {
+    HostProfile profile;
+    profile.target = "platform";
+    profile.threads = 6;
+    profile.ffv1_slices = 16;
+    profile.hash = "xxhash";
+    profile.encode_mib_s = 42.5;
+    profile.decode_mib_s = 120.25;
+
+    const auto parsed = parse_host_profile(format_host_profile(profile));
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->target, "platform");
+    EXPECT_EQ(parsed->threads, 6);
+    EXPECT_EQ(parsed->ffv1_slices, 16);
+    EXPECT_EQ(parsed->patterns, "cosine");
+    EXPECT_EQ(parsed->hash, "xxhash");
+    EXPECT_DOUBLE_EQ(parsed->encode_mib_s, 42.5);
+    EXPECT_DOUBLE_EQ(parsed->decode_mib_s, 120.25);
+}
+
+TEST(HostProfile, ParseRejectsBadValuesAndIgnoresUnknownKeys) {
+    const auto parsed = parse_host_profile("# comment\r\nversion=1\r\n\r\n  threads = 4 \r\nfuture_knob=yes\n");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->threads, 4);
+    EXPECT_EQ(parsed->target, "local");
+
+    EXPECT_FALSE(parse_host_profile("threads=4\n").has_value());
+    EXPECT_FALSE(parse_host_profile("version=2\n").has_value());
+    EXPECT_FALSE(parse_host_profile("version=1\nthreads=-1\n").has_value());
+    EXPECT_FALSE(parse_host_profile("version=1\nthreads=four\n").has_value());
+    EXPECT_FALSE(parse_host_profile("version=1\npatterns=zigzag\n").has_value());
+    EXPECT_FALSE(parse_host_profile("version=1\nhash=md5\n").has_value());
+    EXPECT_FALSE(parse_host_profile("version=1\ntarget=cloud\n").has_value());
+    EXPECT_FALSE(parse_host_profile("version=1\nno equals sign\n").has_value());
+    EXPECT_FALSE(parse_host_profile("version=1\nencode_mib_s=12.5MiB\n").has_value());
+    EXPECT_FALSE(parse_host_profile("version=1\nencode_mib_s=\n").has_value());
+}
+
+TEST(HostProfile, PlatformTargetNeedsCosinePatterns) {
+    HostProfile profile;
+    profile.patterns = "step";
+    EXPECT_TRUE(host_profile_meets_target(profile));
+    profile.target = "platform";
+    EXPECT_FALSE(host_profile_meets_target(profile));
+    profile.patterns = "cosine";
+    EXPECT_TRUE(host_profile_meets_target(profile));
+}
+
+TEST(HostProfile, SaveAndLoad) {
+    const TempPath dir("ms_host_profile");
+    const auto path = dir.path / "nested" / "host_profile";
+
+    EXPECT_FALSE(load_host_profile(path).has_value());
+
+    HostProfile profile;
+    profile.threads = 3;
+    profile.patterns = "quantized";
+    save_host_profile(path, profile);
+    const auto loaded = load_host_profile(path);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->threads, 3);
+    EXPECT_EQ(loaded->patterns, "quantized");
+
+    std::ofstream(path, std::ios::trunc) << "garbage\n";
+    EXPECT_THROW((void) load_host_profile(path), std::runtime_error);
+}
@@ -19,7 +19,9 @@
 #include "integrity.h"
 
 #include <cstring>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -65,6 +67,19 @@ TEST(Integrity, Sha256_HexOutputContainsOnlyHexChars) {
     }
 }
 
+TEST(Integrity, HexRoundtrip) {
+    const std::vector<std::byte> bytes{std::byte{0x00}, std::byte{0x9f}, std::byte{0xA0}, std::byte{0xff}};
+    EXPECT_EQ(to_hex(bytes), "009fa0ff");
+    EXPECT_EQ(to_hex(bytes, true), "009FA0FF");
+
+    std::vector<std::byte> parsed(bytes.size());
+    EXPECT_TRUE(from_hex("009FA0ff", parsed));
+    EXPECT_EQ(parsed, bytes);
+    EXPECT_FALSE(from_hex("009fa0f", parsed));
+    EXPECT_FALSE(from_hex("009fa0fg", parsed));
+    EXPECT_FALSE(from_hex("+09fa0ff", parsed));
+}
+
 TEST(Integrity, Sha256_EqualInputsProduceEqualDigests) {
     const std::vector<std::byte> same_data = bytes_from_string("same");
     const std::vector<std::byte> different_data = bytes_from_string("diff");
@@ -179,3 +194,70 @@ TEST(Integrity, XXHash_EmptyPayload) {
     const uint32_t hash_again = xxhash32_packet(header, empty_payload, 0);
     EXPECT_EQ(hash, hash_again);
 }
+
+TEST(Integrity, IncrementalChecksum_MatchesPacketChecksum) {
+    std::vector<std::byte> header = bytes_from_string("header-bytes-with-crc-slot-at-the-end....");
+    const std::vector<std::byte> payload = bytes_from_string("payload data for the incremental check");
+    const std::size_t crc_offset = header.size() - 4;
+    write_u32_le(header, crc_offset, 0);
+
+    for (const HashAlgorithm algo: {HashAlgorithm::CRC32, HashAlgorithm::XXHash32}) {
+        PacketChecksum prefix(algo);
+        prefix.update(std::span(header).first(10));
+
+        PacketChecksum checksum = prefix;
+        checksum.update(std::span(header).subspan(10));
+        checksum.update(payload);
+        EXPECT_EQ(checksum.digest(), packet_checksum(header, payload, crc_offset, algo));
+
+        // The shared prefix state is untouched by the copy.
+        PacketChecksum again = prefix;
+        again.update(std::span(header).subspan(10));
+        again.update(payload);
+        EXPECT_EQ(again.digest(), checksum.digest());
+    }
+}
+
+TEST(Integrity, MerkleRoot_MatchesManualTree) {
+    const std::vector<Sha256Digest> leaves = {
+        sha256(bytes_from_string("chunk 0")),
+        sha256(bytes_from_string("chunk 1")),
+        sha256(bytes_from_string("chunk 2")),
+    };
+
+    const auto node = [](const Sha256Digest &left, const Sha256Digest &right) {
+        std::vector<std::byte> data{std::byte{0x01}};
+        data.insert(data.end(), left.bytes.begin(), left.bytes.end());
+        data.insert(data.end(), right.bytes.begin(), right.bytes.end());
+        return sha256(data);
+    };
+    const auto seal = [](const uint64_t count, const Sha256Digest &top) {
+        std::vector<std::byte> data(1 + sizeof(count));
+        data[0] = std::byte{0x02};
+        std::memcpy(data.data() + 1, &count, sizeof(count));
+        data.insert(data.end(), top.bytes.begin(), top.bytes.end());
+        return sha256(data);
+    };
+
+    // The odd third leaf moves up a level unchanged.
+    EXPECT_EQ(merkle_root(leaves), seal(3, node(node(leaves[0], leaves[1]), leaves[2])));
+    EXPECT_EQ(merkle_root(std::span(leaves).first(1)), seal(1, leaves[0]));
+}
+
+TEST(Integrity, MerkleRoot_CommitsToOrderAndCount) {
+    std::vector<Sha256Digest> leaves(5000);
+    for (std::size_t i = 0; i < leaves.size(); ++i) {
+        leaves[i] = sha256(bytes_from_string("chunk " + std::to_string(i)));
+    }
+    const Sha256Digest root = merkle_root(leaves);
+    EXPECT_EQ(merkle_root(leaves), root);
+
+    std::vector<Sha256Digest> swapped = leaves;
+    std::swap(swapped[1234], swapped[1235]);
+    EXPECT_NE(merkle_root(swapped), root);
+
+    // A truncated file whose last level happens to pair up differently still
+    // yields a different root.
+    EXPECT_NE(merkle_root(std::span(leaves).first(4999)), root);
+    EXPECT_NE(merkle_root(std::span(leaves).first(4096)), merkle_root(std::span(leaves).first(4097)));
+}
@@ -0,0 +1,79 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "job_protocol.h"
+
+#include <cstdint>
+#include <string>
+
+TEST(JobProtocol, RoundtripEscapesAwkwardValues) {
+    JobMessage message{"decode", {}};
+    message.add("input", "/videos/my archive.part000.mkv");
+    message.add("input", "/videos/100%=done\tnow.mkv");
+    message.add("output", "");
+
+    const std::string line = format_job_message(message);
+    EXPECT_EQ(line.find('\t'), std::string::npos);
+    EXPECT_EQ(line, "decode input=/videos/my%20archive.part000.mkv input=/videos/100%25%3Ddone%09now.mkv output=");
+
+    const auto parsed = parse_job_message(line);
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->verb, "decode");
+    EXPECT_EQ(parsed->find_all("input"),
+              (std::vector<std::string>{"/videos/my archive.part000.mkv", "/videos/100%=done\tnow.mkv"}));
+    ASSERT_NE(parsed->find("output"), nullptr);
+    EXPECT_TRUE(parsed->find("output")->empty());
+    EXPECT_EQ(parsed->find("password"), nullptr);
+}
+
+TEST(JobProtocol, ToleratesExtraSpacesAndCarriageReturn) {
+    const auto parsed = parse_job_message("  probe   input=a.mkv \r");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->verb, "probe");
+    ASSERT_EQ(parsed->fields.size(), 1u);
+    EXPECT_EQ(*parsed->find("input"), "a.mkv");
+
+    const auto bare = parse_job_message("metrics");
+    ASSERT_TRUE(bare.has_value());
+    EXPECT_TRUE(bare->fields.empty());
+}
+
+TEST(JobProtocol, RejectsMalformedLines) {
+    EXPECT_FALSE(parse_job_message("").has_value());
+    EXPECT_FALSE(parse_job_message("   ").has_value());
+    EXPECT_FALSE(parse_job_message("encode input").has_value());
+    EXPECT_FALSE(parse_job_message("encode =value").has_value());
+    EXPECT_FALSE(parse_job_message("encode input=a%2").has_value());
+    EXPECT_FALSE(parse_job_message("encode input=a%zz").has_value());
+}
+
+TEST(JobProtocol, ParseNumberTakesTheWholeText) {
+    uint32_t count = 0;
+    EXPECT_TRUE(parse_number("4096", count));
+    EXPECT_EQ(count, 4096u);
+    EXPECT_FALSE(parse_number("", count));
+    EXPECT_FALSE(parse_number("12x", count));
+    EXPECT_FALSE(parse_number("-1", count));
+    EXPECT_FALSE(parse_number("4294967296", count));
+
+    double rate = 0;
+    EXPECT_TRUE(parse_number("812.5", rate));
+    EXPECT_DOUBLE_EQ(rate, 812.5);
+    EXPECT_FALSE(parse_number("812.5 MiB", rate));
+    EXPECT_FALSE(parse_number("1e999", rate));
+}
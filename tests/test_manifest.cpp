@@ -0,0 +1,305 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "decoder.h"
+#include "encoder.h"
+#include "manifest.h"
+#include "test_util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace {
+    FileInfo make_test_info(const uint32_t chunk_count) {
+        FileInfo info;
+        info.file_id = make_test_id(0xA0);
+        info.file_size = 123456789;
+        info.chunk_count = chunk_count;
+        info.chunk_size = CHUNK_SIZE_BYTES;
+        info.symbol_size = SYMBOL_SIZE_BYTES;
+        info.encrypted = true;
+        info.hash_algorithm = HashAlgorithm::XXHash32;
+        info.frame_width = FRAME_WIDTH;
+        info.frame_height = FRAME_HEIGHT;
+        return info;
+    }
+
+    void feed(Decoder &decoder, const std::vector<Packet> &packets) {
+        for (const Packet &packet: packets) {
+            (void) decoder.process_packet(std::span<const std::byte>(packet.bytes.data(), packet.bytes.size()));
+        }
+    }
+}
+
+TEST(Manifest, FileInfoRoundtrip) {
+    const FileInfo info = make_test_info(42);
+    const auto parsed = parse_file_info(serialize_file_info(info));
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->file_id, info.file_id);
+    EXPECT_EQ(parsed->file_size, info.file_size);
+    EXPECT_EQ(parsed->chunk_count, 42u);
+    EXPECT_EQ(parsed->chunk_size, info.chunk_size);
+    EXPECT_EQ(parsed->symbol_size, info.symbol_size);
+    EXPECT_TRUE(parsed->encrypted);
+    EXPECT_EQ(parsed->hash_algorithm, HashAlgorithm::XXHash32);
+    EXPECT_EQ(parsed->frame_width, static_cast<uint32_t>(FRAME_WIDTH));
+    EXPECT_EQ(parsed->frame_height, static_cast<uint32_t>(FRAME_HEIGHT));
+}
+
+TEST(Manifest, FileInfoSkipsUnknownTags) {
+    auto data = serialize_file_info(make_test_info(7));
+    const uint16_t tag = 0x7FFF;
+    const uint16_t length = 3;
+    const auto *tag_bytes = reinterpret_cast<const std::byte *>(&tag);
+    const auto *length_bytes = reinterpret_cast<const std::byte *>(&length);
+    data.insert(data.end(), tag_bytes, tag_bytes + 2);
+    data.insert(data.end(), length_bytes, length_bytes + 2);
+    data.insert(data.end(), 3, std::byte{0xEE});
+
+    const auto parsed = parse_file_info(data);
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->chunk_count, 7u);
+}
+
+TEST(Manifest, FileInfoRejectsTruncatedOrCorrupt) {
+    auto data = serialize_file_info(make_test_info(7));
+    EXPECT_FALSE(parse_file_info(std::span<const std::byte>(data).first(data.size() - 1)).has_value());
+    data[0] = std::byte{0};
+    EXPECT_FALSE(parse_file_info(data).has_value());
+}
+
+TEST(Manifest, ChunkTableSplitsIntoSegments) {
+    const uint32_t count = static_cast<uint32_t>(MANIFEST_DIGESTS_PER_SEGMENT) + 5;
+    std::vector<Sha256Digest> digests(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        digests[i] = make_test_digest(i);
+    }
+
+    const auto segments = serialize_chunk_table(digests);
+    ASSERT_EQ(segments.size(), 2u);
+    EXPECT_EQ(manifest_table_segment_count(count), 2u);
+
+    ArchiveManifest manifest;
+    EXPECT_TRUE(manifest.add_segment(MANIFEST_FILE_INFO_SEGMENT, serialize_file_info(make_test_info(count))));
+    EXPECT_TRUE(manifest.add_segment(MANIFEST_FIRST_TABLE_SEGMENT + 1, segments[1]));
+    EXPECT_FALSE(manifest.has_chunk_digests());
+    EXPECT_TRUE(manifest.add_segment(MANIFEST_FIRST_TABLE_SEGMENT, segments[0]));
+    EXPECT_TRUE(manifest.has_chunk_digests());
+
+    EXPECT_EQ(manifest.chunk_digest(0), digests[0]);
+    EXPECT_EQ(manifest.chunk_digest(count - 1), digests[count - 1]);
+    EXPECT_FALSE(manifest.chunk_digest(count).has_value());
+}
+
+TEST(Manifest, ChunkTableRejectsMisplacedSegment) {
+    const std::vector<Sha256Digest> digests{make_test_digest(1), make_test_digest(2)};
+    const auto segments = serialize_chunk_table(digests);
+    ASSERT_EQ(segments.size(), 1u);
+
+    ArchiveManifest manifest;
+    EXPECT_FALSE(manifest.add_segment(MANIFEST_FIRST_TABLE_SEGMENT + 1, segments[0]));
+    EXPECT_TRUE(manifest.add_segment(MANIFEST_FILE_INFO_SEGMENT, serialize_file_info(make_test_info(1))));
+    EXPECT_FALSE(manifest.add_segment(MANIFEST_FIRST_TABLE_SEGMENT, segments[0]));
+}
+
+TEST(Manifest, DecoderCollectsManifestAndMargins) {
+    const FileInfo info = make_test_info(3);
+    const Encoder encoder(info.file_id);
+
+    std::vector<Sha256Digest> digests;
+    std::vector<std::vector<Packet> > chunk_packets;
+    for (uint32_t i = 0; i < info.chunk_count; ++i) {
+        auto [packets, entry] = encoder.encode_chunk(i, make_test_bytes(5000 + i * 1000, i), i + 1 == info.chunk_count);
+        digests.push_back(entry.sha256);
+        chunk_packets.push_back(std::move(packets));
+    }
+
+    Decoder decoder;
+    decoder.set_retain_chunk_data(false);
+    feed(decoder, encoder.encode_manifest_segment(MANIFEST_FILE_INFO_SEGMENT, serialize_file_info(info)));
+    ASSERT_TRUE(decoder.manifest().file_info().has_value());
+    EXPECT_EQ(decoder.expected_chunk_count(), info.chunk_count);
+    EXPECT_EQ(decoder.chunks_completed(), 0u);
+
+    std::vector<std::optional<Sha256Digest> > decoded(info.chunk_count);
+    for (const auto &packets: chunk_packets) {
+        for (const Packet &packet: packets) {
+            if (auto res = decoder.process_packet(std::span<const std::byte>(packet.bytes.data(), packet.bytes.size()));
+                res && res->success) {
+                decoded[res->chunk_index] = res->sha256;
+            }
+        }
+    }
+
+    const auto segments = serialize_chunk_table(digests);
+    for (std::size_t s = 0; s < segments.size(); ++s) {
+        feed(decoder, encoder.encode_manifest_segment(MANIFEST_FIRST_TABLE_SEGMENT + static_cast<uint32_t>(s),
+                                                      segments[s]));
+    }
+    ASSERT_TRUE(decoder.manifest().has_chunk_digests());
+
+    for (uint32_t i = 0; i < info.chunk_count; ++i) {
+        ASSERT_TRUE(decoded[i].has_value());
+        EXPECT_EQ(decoder.manifest().chunk_digest(i), decoded[i]);
+        EXPECT_FALSE(decoder.get_chunk_data(i).has_value());
+
+        const auto margin = decoder.chunk_margin(i);
+        ASSERT_TRUE(margin.has_value());
+        EXPECT_GE(margin->used, margin->k);
+        EXPECT_EQ(margin->used + margin->spare, chunk_packets[i].size());
+    }
+    EXPECT_FALSE(decoder.assemble_file(info.chunk_count).has_value());
+}
+
+TEST(Manifest, ManifestPacketsDoNotDecideEncryption) {
+    FileInfo info = make_test_info(1);
+    info.encrypted = false;
+    const Encoder encoder(info.file_id);
+
+    Decoder decoder;
+    feed(decoder, encoder.encode_manifest_segment(MANIFEST_FILE_INFO_SEGMENT, serialize_file_info(info)));
+    EXPECT_FALSE(decoder.is_encrypted());
+
+    auto [packets, entry] = encoder.encode_chunk(0, make_test_bytes(4000, 9), true, true);
+    feed(decoder, packets);
+    EXPECT_TRUE(decoder.is_encrypted());
+}
+
+TEST(Manifest, ShardInfoRoundtrip) {
+    const ShardInfo shard{2, 5, 40, 20};
+    const auto data = serialize_shard_info(shard);
+    EXPECT_EQ(data.size(), SHARD_INFO_SIZE);
+
+    const auto parsed = parse_shard_info(data);
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->shard_index, 2u);
+    EXPECT_EQ(parsed->shard_count, 5u);
+    EXPECT_EQ(parsed->first_chunk, 40u);
+    EXPECT_EQ(parsed->chunk_count, 20u);
+
+    EXPECT_FALSE(parse_shard_info(std::span<const std::byte>(data).first(data.size() - 1)).has_value());
+    EXPECT_FALSE(parse_shard_info(serialize_shard_info(ShardInfo{5, 5, 0, 1})).has_value());
+}
+
+TEST(Manifest, ShardsMergeInAnyOrder) {
+    FileInfo info = make_test_info(5);
+    info.shard_count = 2;
+    std::vector<Sha256Digest> digests;
+    for (uint32_t i = 0; i < info.chunk_count; ++i) {
+        digests.push_back(make_test_digest(i));
+    }
+    const ShardInfo first{0, 2, 0, 3};
+    const ShardInfo second{1, 2, 3, 2};
+    const auto first_table = serialize_chunk_table(std::span<const Sha256Digest>(digests).first(3), 0);
+    const auto second_table = serialize_chunk_table(std::span<const Sha256Digest>(digests).subspan(3), 3);
+
+    ArchiveManifest manifest;
+    EXPECT_TRUE(manifest.accepts_segment(manifest_shard_segment(1, 0), 0));
+    EXPECT_FALSE(manifest.add_segment(manifest_shard_segment(1, 1), second_table[0]));
+    EXPECT_TRUE(manifest.add_segment(manifest_shard_segment(1, 0), serialize_shard_info(second)));
+    EXPECT_FALSE(manifest.add_segment(manifest_shard_segment(0, 0), serialize_shard_info(second)));
+    EXPECT_TRUE(manifest.add_segment(manifest_shard_segment(1, 1), second_table[0]));
+    EXPECT_TRUE(manifest.add_segment(MANIFEST_FILE_INFO_SEGMENT, serialize_file_info(info)));
+
+    EXPECT_TRUE(manifest.has_chunk_digests(3, 2));
+    EXPECT_FALSE(manifest.has_chunk_digests());
+    EXPECT_FALSE(manifest.chunk_digest(0).has_value());
+    EXPECT_EQ(manifest.chunk_digest(4), digests[4]);
+
+    // The second shard's table cannot stand in for the first shard's range.
+    EXPECT_TRUE(manifest.add_segment(manifest_shard_segment(0, 0), serialize_shard_info(first)));
+    EXPECT_FALSE(manifest.add_segment(manifest_shard_segment(0, 1), second_table[0]));
+    EXPECT_TRUE(manifest.add_segment(manifest_shard_segment(0, 1), first_table[0]));
+
+    EXPECT_TRUE(manifest.has_chunk_digests());
+    EXPECT_EQ(manifest.shards().size(), 2u);
+    EXPECT_EQ(manifest.chunk_digest(0), digests[0]);
+}
+
+TEST(Manifest, DecoderKeepsShardTableThatArrivesBeforeShardInfo) {
+    FileInfo info = make_test_info(5);
+    info.shard_count = 2;
+    std::vector<Sha256Digest> digests;
+    for (uint32_t i = 0; i < info.chunk_count; ++i) {
+        digests.push_back(make_test_digest(i));
+    }
+    const ShardInfo second{1, 2, 3, 2};
+    const auto second_table = serialize_chunk_table(std::span<const Sha256Digest>(digests).subspan(3), 3);
+    const Encoder encoder(info.file_id);
+
+    // The table decodes first and cannot be placed yet; it must not be dropped.
+    Decoder decoder;
+    feed(decoder, encoder.encode_manifest_segment(manifest_shard_segment(1, 1), second_table[0]));
+    EXPECT_FALSE(decoder.manifest().has_chunk_digests(3, 2));
+    feed(decoder, encoder.encode_manifest_segment(manifest_shard_segment(1, 0), serialize_shard_info(second)));
+    EXPECT_TRUE(decoder.manifest().has_chunk_digests(3, 2));
+    EXPECT_EQ(decoder.manifest().chunk_digest(4), digests[4]);
+
+    // Without the held copy, a later copy of the table still decodes.
+    Decoder retry;
+    feed(retry, encoder.encode_manifest_segment(manifest_shard_segment(1, 1), second_table[0]));
+    feed(retry, encoder.encode_manifest_segment(manifest_shard_segment(1, 0), serialize_shard_info(second)));
+    feed(retry, encoder.encode_manifest_segment(manifest_shard_segment(1, 1), second_table[0]));
+    EXPECT_TRUE(retry.manifest().has_chunk_digests(3, 2));
+}
+
+TEST(Manifest, ShardInfoMustAgreeWithFileInfo) {
+    FileInfo info = make_test_info(5);
+    info.shard_count = 2;
+
+    ArchiveManifest manifest;
+    EXPECT_TRUE(manifest.add_segment(MANIFEST_FILE_INFO_SEGMENT, serialize_file_info(info)));
+    EXPECT_FALSE(manifest.add_segment(manifest_shard_segment(0, 0), serialize_shard_info(ShardInfo{0, 3, 0, 3})));
+    EXPECT_FALSE(manifest.add_segment(manifest_shard_segment(1, 0), serialize_shard_info(ShardInfo{1, 2, 3, 4})));
+    EXPECT_TRUE(manifest.add_segment(manifest_shard_segment(1, 0), serialize_shard_info(ShardInfo{1, 2, 3, 2})));
+    EXPECT_FALSE(manifest.accepts_segment(manifest_shard_segment(2, 0), info.chunk_count));
+}
+
+TEST(Manifest, FileDigestRoundtripAndAgreesWithFileInfo) {
+    std::vector<Sha256Digest> digests;
+    for (uint32_t i = 0; i < 4; ++i) {
+        digests.push_back(make_test_digest(i));
+    }
+    const FileDigest digest{4, merkle_root(digests)};
+    const auto bytes = serialize_file_digest(digest);
+    ASSERT_EQ(bytes.size(), FILE_DIGEST_SIZE);
+
+    const auto parsed = parse_file_digest(bytes);
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->chunk_count, 4u);
+    EXPECT_EQ(parsed->root, digest.root);
+    EXPECT_FALSE(parse_file_digest(std::span<const std::byte>(bytes).first(FILE_DIGEST_SIZE - 1)).has_value());
+
+    // The digest may arrive before FileInfo; the two must then agree.
+    ArchiveManifest manifest;
+    EXPECT_TRUE(manifest.accepts_segment(MANIFEST_FILE_DIGEST_SEGMENT, 1));
+    EXPECT_TRUE(manifest.add_segment(MANIFEST_FILE_DIGEST_SEGMENT, bytes));
+    EXPECT_FALSE(manifest.add_segment(MANIFEST_FILE_INFO_SEGMENT, serialize_file_info(make_test_info(5))));
+    EXPECT_TRUE(manifest.add_segment(MANIFEST_FILE_INFO_SEGMENT, serialize_file_info(make_test_info(4))));
+    ASSERT_TRUE(manifest.file_digest().has_value());
+    EXPECT_EQ(manifest.file_digest()->root, digest.root);
+
+    ArchiveManifest other;
+    EXPECT_TRUE(other.add_segment(MANIFEST_FILE_INFO_SEGMENT, serialize_file_info(make_test_info(3))));
+    EXPECT_FALSE(other.add_segment(MANIFEST_FILE_DIGEST_SEGMENT, bytes));
+    EXPECT_FALSE(other.file_digest().has_value());
+}
@@ -0,0 +1,132 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "decoder.h"
+#include "encoder.h"
+#include "packet_sink.h"
+#include "test_util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    class RecordingSink final : public PacketSink {
+    public:
+        void encode_packets(const std::span<const Packet> packets) override {
+            received.insert(received.end(), packets.begin(), packets.end());
+        }
+
+        void finalize() override { finalized = true; }
+
+        [[nodiscard]] int64_t frames_written() const override { return 0; }
+
+        std::vector<Packet> received;
+        bool finalized = false;
+    };
+
+    bool decodes(const std::vector<Packet> &packets, const std::vector<std::byte> &expected) {
+        Decoder decoder;
+        for (const Packet &packet: packets) {
+            if (auto res = decoder.process_packet(std::span<const std::byte>(packet.bytes.data(), packet.bytes.size()));
+                res && res->success) {
+                return decoder.get_chunk_data(res->chunk_index) == expected;
+            }
+        }
+        return false;
+    }
+}
+
+TEST(PacketSink, RepairPrefixLength) {
+    EXPECT_EQ(repair_prefix_length(10, 0.0, 60), 10u);
+    EXPECT_EQ(repair_prefix_length(10, 0.25, 60), 13u);
+    EXPECT_EQ(repair_prefix_length(10, 2.0, 60), 30u);
+    EXPECT_EQ(repair_prefix_length(10, 8.0, 60), 60u);
+}
+
+TEST(PacketSink, EncoderRepairOverhead) {
+    Encoder encoder(make_test_id());
+    EXPECT_EQ(encoder.repair_overhead(), REPAIR_OVERHEAD);
+    EXPECT_THROW(encoder.set_repair_overhead(-0.5), std::invalid_argument);
+    EXPECT_THROW(encoder.set_repair_overhead(MAX_REPAIR_OVERHEAD + 1.0), std::invalid_argument);
+
+    encoder.set_repair_overhead(1.0);
+    const auto [packets, entry] = encoder.encode_chunk(0, make_test_bytes(SYMBOL_SIZE_BYTES * 20), true);
+    EXPECT_EQ(entry.N, 20u);
+    EXPECT_EQ(packets.size(), 40u);
+}
+
+TEST(PacketSink, FanOutSplitsRepairTail) {
+    Encoder encoder(make_test_id());
+    RecordingSink archive;
+    RecordingSink live;
+
+    PacketFanOut fan_out;
+    fan_out.add_sink(archive, 3.0);
+    fan_out.add_sink(live, 0.5);
+    EXPECT_THROW(fan_out.add_sink(live, -1.0), std::invalid_argument);
+    ASSERT_EQ(fan_out.size(), 2u);
+    encoder.set_repair_overhead(fan_out.max_repair_overhead());
+
+    const auto chunk = make_test_bytes(SYMBOL_SIZE_BYTES * 40 + 17);
+    const auto [packets, entry] = encoder.encode_chunk(0, chunk, true);
+    fan_out.write_chunk(packets, entry.N);
+    fan_out.finalize();
+
+    EXPECT_EQ(archive.received.size(), packets.size());
+    EXPECT_EQ(live.received.size(), entry.N + (entry.N + 1) / 2);
+    EXPECT_EQ(fan_out.packets_written(1), live.received.size());
+    EXPECT_TRUE(archive.finalized);
+    EXPECT_TRUE(live.finalized);
+
+    // The lean sink's packets are the archive's leading packets byte for byte.
+    for (std::size_t i = 0; i < live.received.size(); ++i) {
+        ASSERT_EQ(live.received[i].bytes, archive.received[i].bytes);
+    }
+
+    // The archive's repair tail alone still recovers the chunk, and so does the
+    // lean sink's share.
+    std::vector<Packet> archive_repair(archive.received.begin() + entry.N, archive.received.end());
+    EXPECT_TRUE(decodes(archive_repair, chunk));
+    EXPECT_TRUE(decodes(live.received, chunk));
+}
+
+TEST(PacketSink, WriteAllAndWriteTo) {
+    RecordingSink first;
+    RecordingSink second;
+    PacketFanOut fan_out;
+    fan_out.add_sink(first, 0.0);
+    fan_out.add_sink(second, 1.0);
+
+    const std::vector<Packet> packets(3);
+    fan_out.write_all(packets);
+    fan_out.write_to(1, packets);
+
+    EXPECT_EQ(first.received.size(), 3u);
+    EXPECT_EQ(second.received.size(), 6u);
+    EXPECT_EQ(fan_out.packets_written(1), 6u);
+    EXPECT_THROW(fan_out.write_to(2, packets), std::out_of_range);
+
+    // Used as a sink itself, the fan-out sends everything in full.
+    PacketSink &sink = fan_out;
+    sink.encode_packets(packets);
+    EXPECT_EQ(first.received.size(), 6u);
+    EXPECT_EQ(fan_out.packets_written(1), 9u);
+}
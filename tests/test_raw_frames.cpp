@@ -0,0 +1,177 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "decoder.h"
+#include "encoder.h"
+#include "raw_frames.h"
+#include "test_util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr int WIDTH = 1280;
+    constexpr int HEIGHT = 720;
+
+    RawFrameOptions small_frames(const RawFrameFormat format, const RawPixelFormat pixel_format) {
+        RawFrameOptions options;
+        options.format = format;
+        options.pixel_format = pixel_format;
+        options.width = WIDTH;
+        options.height = HEIGHT;
+        return options;
+    }
+
+    std::vector<Packet> encode(const std::vector<std::byte> &chunk) {
+        Encoder encoder(make_test_id(0x40));
+        encoder.set_repair_overhead(0.5);
+        return encoder.encode_chunk(0, chunk, true).first;
+    }
+
+    int64_t write_frames(const std::string &path, const RawFrameOptions &options, const std::vector<Packet> &packets) {
+        RawFrameWriter writer({path}, options);
+        writer.encode_packets(packets);
+        writer.finalize();
+        return writer.frames_written();
+    }
+
+    // Reads every frame back and feeds the packets to a decoder; returns the
+    // chunk once it decodes.
+    std::vector<std::byte> read_chunk(RawFrameReader &reader) {
+        Decoder decoder;
+        std::vector<std::vector<std::byte> > packets;
+        while (reader.decode_next_frame(packets)) {
+            for (const auto &packet: packets) {
+                if (auto res = decoder.process_packet(packet); res && res->success) {
+                    return decoder.get_chunk_data(res->chunk_index).value_or(std::vector<std::byte>{});
+                }
+            }
+            packets.clear();
+        }
+        return {};
+    }
+
+    std::vector<char> slurp(const std::filesystem::path &path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+}
+
+TEST(RawFrames, Y4MGrayRoundtrip) {
+    const TempPath file("ms_raw_frames_gray");
+    const auto options = small_frames(RawFrameFormat::Y4M, RawPixelFormat::Gray8);
+    const auto chunk = make_test_bytes(SYMBOL_SIZE_BYTES * 12 + 40);
+    const int64_t frames = write_frames(file.path.string(), options, encode(chunk));
+    EXPECT_GT(frames, 1);
+
+    const auto bytes = slurp(file.path);
+    const std::string header = "YUV4MPEG2 W1280 H720 F30:1 Ip A1:1 Cmono\n";
+    ASSERT_GE(bytes.size(), header.size());
+    EXPECT_EQ(std::string(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(header.size())), header);
+    EXPECT_EQ(bytes.size(), header.size() + static_cast<std::size_t>(frames) * (6 + WIDTH * HEIGHT));
+
+    RawFrameReader reader(file.path.string(), RawFrameOptions{});
+    EXPECT_EQ(reader.width(), WIDTH);
+    EXPECT_EQ(reader.height(), HEIGHT);
+    EXPECT_EQ(read_chunk(reader), chunk);
+}
+
+TEST(RawFrames, RawYuv420Roundtrip) {
+    const TempPath file("ms_raw_frames_420");
+    const auto options = small_frames(RawFrameFormat::RawVideo, RawPixelFormat::YUV420P);
+    const auto chunk = make_test_bytes(SYMBOL_SIZE_BYTES * 9 + 1);
+    const int64_t frames = write_frames(file.path.string(), options, encode(chunk));
+
+    EXPECT_EQ(std::filesystem::file_size(file.path),
+              static_cast<std::size_t>(frames) * (WIDTH * HEIGHT + raw_chroma_bytes(RawPixelFormat::YUV420P,
+                                                                                    WIDTH, HEIGHT)));
+
+    RawFrameReader reader(file.path.string(), options);
+    EXPECT_EQ(read_chunk(reader), chunk);
+    std::vector<std::vector<std::byte> > rest;
+    while (reader.decode_next_frame(rest)) {
+    }
+    EXPECT_EQ(reader.frames_read(), frames);
+}
+
+TEST(RawFrames, ReadsForeignY4MColorspace) {
+    // An external decoder may hand back 4:4:4 frames; only luma matters.
+    const TempPath raw("ms_raw_frames_luma");
+    const TempPath y4m("ms_raw_frames_444");
+    const auto chunk = make_test_bytes(SYMBOL_SIZE_BYTES * 7);
+    const int64_t frames = write_frames(raw.path.string(),
+                                        small_frames(RawFrameFormat::RawVideo, RawPixelFormat::Gray8),
+                                        encode(chunk));
+
+    const auto luma = slurp(raw.path);
+    {
+        std::ofstream out(y4m.path, std::ios::binary);
+        out << "YUV4MPEG2 W1280 H720 F25:1 It A0:0 C444 XYSCSS=444\n";
+        const std::vector<char> chroma(static_cast<std::size_t>(WIDTH) * HEIGHT * 2, static_cast<char>(90));
+        for (int64_t i = 0; i < frames; ++i) {
+            out << "FRAME Ixyz\n";
+            out.write(luma.data() + i * WIDTH * HEIGHT, WIDTH * HEIGHT);
+            out.write(chroma.data(), static_cast<std::streamsize>(chroma.size()));
+        }
+    }
+
+    RawFrameReader reader(y4m.path.string(), RawFrameOptions{});
+    EXPECT_EQ(read_chunk(reader), chunk);
+}
+
+TEST(RawFrames, RejectsMalformedInput) {
+    const TempPath file("ms_raw_frames_bad");
+    {
+        std::ofstream out(file.path, std::ios::binary);
+        out << "YUV4MPEG2 W1280 H720 C420p10\n";
+    }
+    EXPECT_THROW(RawFrameReader(file.path.string(), RawFrameOptions{}), std::runtime_error);
+
+    {
+        std::ofstream out(file.path, std::ios::binary);
+        out << "RIFF not a y4m\n";
+    }
+    EXPECT_THROW(RawFrameReader(file.path.string(), RawFrameOptions{}), std::runtime_error);
+
+    {
+        std::ofstream out(file.path, std::ios::binary);
+        out << "YUV4MPEG2 W1280 H720 Cmono\nFRAME\n" << std::string(100, '\x80');
+    }
+    RawFrameReader reader(file.path.string(), RawFrameOptions{});
+    std::vector<std::vector<std::byte> > packets;
+    EXPECT_THROW(reader.decode_next_frame(packets), std::runtime_error);
+}
+
+TEST(RawFrames, WriterRejectsUnusableSizes) {
+    const TempPath file("ms_raw_frames_size");
+    RawFrameOptions options;
+    options.width = 1279;
+    options.height = 720;
+    EXPECT_THROW(RawFrameWriter({file.path.string()}, options), std::invalid_argument);
+    options.width = 64;
+    options.height = 64;
+    EXPECT_THROW(RawFrameWriter({file.path.string()}, options), std::invalid_argument);
+    EXPECT_THROW(RawFrameWriter({}, RawFrameOptions{}), std::invalid_argument);
+}
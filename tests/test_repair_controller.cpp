@@ -0,0 +1,134 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "repair_controller.h"
+#include "repair_feedback.h"
+#include "test_util.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+TEST(RepairController, StartsAtMaximumUntilFirstReport) {
+    RepairControllerOptions options;
+    options.max_overhead = 3.0;
+    RepairController repair(options);
+    EXPECT_DOUBLE_EQ(repair.overhead(), 3.0);
+    EXPECT_DOUBLE_EQ(repair.loss_estimate(), 0.0);
+
+    repair.chunk_sent(0, 100, 400);
+    EXPECT_TRUE(repair.report(0, 400));
+    EXPECT_EQ(repair.reports(), 1u);
+    // A clean channel only needs the floor.
+    EXPECT_DOUBLE_EQ(repair.overhead(), options.min_overhead);
+    EXPECT_TRUE(repair.take_resends().empty());
+}
+
+TEST(RepairController, LossRaisesOverhead) {
+    RepairController repair;
+    repair.chunk_sent(0, 100, 200);
+    ASSERT_TRUE(repair.report(0, 160));
+    EXPECT_NEAR(repair.loss_estimate(), 0.2, 1e-9);
+    // Plans for twice the loss: 1.1 / (1 - 0.4) symbols per source symbol.
+    EXPECT_NEAR(repair.overhead(), 1.1 / 0.6 - 1.0, 1e-9);
+
+    // Later reports are smoothed in.
+    repair.chunk_sent(1, 100, 200);
+    ASSERT_TRUE(repair.report(1, 200));
+    EXPECT_NEAR(repair.loss_estimate(), 0.15, 1e-9);
+
+    // The ratio never exceeds what the encoder generates.
+    for (uint32_t i = 2; i < 40; ++i) {
+        repair.chunk_sent(i, 100, 200);
+        ASSERT_TRUE(repair.report(i, 20));
+    }
+    EXPECT_DOUBLE_EQ(repair.overhead(), repair.options().max_overhead);
+}
+
+TEST(RepairController, ShortChunkIsResentOnce) {
+    RepairController repair;
+    repair.chunk_sent(7, 100, 125);
+    ASSERT_TRUE(repair.report(7, 90));
+
+    const auto resends = repair.take_resends();
+    ASSERT_EQ(resends.size(), 1u);
+    EXPECT_EQ(resends[0].chunk_index, 7u);
+    EXPECT_EQ(resends[0].first_packet, 125u);
+    // 20 short of k plus the margin, inflated for the planned loss of 2 * 0.28.
+    EXPECT_EQ(resends[0].packets, 46u);
+    EXPECT_TRUE(repair.take_resends().empty());
+
+    repair.resent(7, resends[0].packets);
+    EXPECT_EQ(repair.resent_packets(), 46u);
+    ASSERT_TRUE(repair.report(7, 95));
+    EXPECT_TRUE(repair.take_resends().empty());
+    // Only the first report of a chunk counts towards the loss estimate.
+    EXPECT_EQ(repair.reports(), 1u);
+}
+
+TEST(RepairController, ForgetsOldChunks) {
+    RepairControllerOptions options;
+    options.history = 4;
+    RepairController repair(options);
+    for (uint32_t i = 0; i < 10; ++i) {
+        repair.chunk_sent(i, 10, 20);
+    }
+    EXPECT_FALSE(repair.report(5, 20));
+    EXPECT_TRUE(repair.report(6, 20));
+    EXPECT_FALSE(repair.report(42, 20));
+
+    options.min_overhead = 2.0;
+    options.max_overhead = 1.0;
+    EXPECT_THROW(RepairController{options}, std::invalid_argument);
+}
+
+TEST(RepairController, ReportLineRoundTrip) {
+    const RepairReport report{make_test_id(0xA0), 12345, 678};
+    const std::string line = format_repair_report(report);
+    EXPECT_EQ(line, "loss file=a0a1a2a3a4a5a6a7a8a9aaabacadaeaf chunk=12345 received=678");
+
+    const auto parsed = parse_repair_report(line);
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->file_id, report.file_id);
+    EXPECT_EQ(parsed->chunk_index, 12345u);
+    EXPECT_EQ(parsed->received, 678u);
+
+    EXPECT_FALSE(parse_repair_report("loss file=a0 chunk=1 received=2"));
+    EXPECT_FALSE(parse_repair_report("loss file=a0a1a2a3a4a5a6a7a8a9aaabacadaeaf chunk=x received=2"));
+    EXPECT_FALSE(parse_repair_report("encode input=a output=b"));
+}
+
+#ifndef _WIN32
+TEST(RepairController, FeedbackSocketDeliversReports) {
+    const TempPath socket("ms_repair_feedback");
+    RepairFeedbackReceiver receiver(socket.path.string());
+    RepairFeedbackSender sender(socket.path.string());
+
+    ASSERT_TRUE(sender.send(RepairReport{make_test_id(0xA0), 3, 40}));
+    const auto report = receiver.receive(std::chrono::milliseconds(1000));
+    ASSERT_TRUE(report);
+    EXPECT_EQ(report->chunk_index, 3u);
+    EXPECT_EQ(report->received, 40u);
+    EXPECT_FALSE(receiver.receive(std::chrono::milliseconds(10)));
+
+    const TempPath unbound("ms_repair_nobody");
+    RepairFeedbackSender nobody(unbound.path.string());
+    EXPECT_FALSE(nobody.send(RepairReport{}));
+}
+#endif
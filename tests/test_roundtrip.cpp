@@ -22,6 +22,7 @@
 #include "decoder.h"
 #include "encoder.h"
 #include "integrity.h"
+#include "test_util.h"
 
 #include <algorithm>
 #include <array>
@@ -29,8 +30,10 @@
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
 #include <optional>
 #include <span>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -221,6 +224,61 @@ TEST(Roundtrip, WithEncryptionAndXXHash) {
     secure_zero(std::span<std::byte>(key));
 }
 
+TEST(Roundtrip, WriteAssembledFileTakesSuppliedChunks) {
+    const Encoder::FileId file_id = make_test_file_id();
+    const Encoder encoder(file_id);
+    Decoder decoder;
+
+    static constexpr std::byte password[] = {
+        std::byte{'t'}, std::byte{'e'}, std::byte{'s'}, std::byte{'t'}
+    };
+    auto key = derive_key(std::span(password), file_id);
+
+    std::vector<std::vector<std::byte> > plain;
+    for (uint32_t i = 0; i < 3; ++i) {
+        plain.push_back(make_test_bytes(4096 + i, static_cast<uint8_t>(i)));
+    }
+    // Chunk 1 never arrives; the caller holds its plaintext instead.
+    for (const uint32_t i: {0u, 2u}) {
+        const std::vector<std::byte> encrypted = encrypt_chunk(plain[i], key, file_id, i);
+        for (auto [packets, manifest] = encoder.encode_chunk(i, encrypted, i == 2, true);
+             const Packet &packet: packets) {
+            (void) decoder.process_packet(packet_span(packet), false);
+        }
+    }
+    decoder.set_decrypt_key(key);
+
+    const TempPath output("roundtrip_supplied");
+    Decoder::SuppliedChunks supplied(3);
+    std::vector<std::pair<uint32_t, std::vector<std::byte> > > written;
+    const auto record = [&](const uint32_t chunk_index, const std::span<const std::byte> plaintext) {
+        written.emplace_back(chunk_index, std::vector<std::byte>(plaintext.begin(), plaintext.end()));
+    };
+    EXPECT_FALSE(decoder.write_assembled_file(output.path.string(), 3, supplied, record));
+
+    supplied[1] = plain[1];
+    ASSERT_TRUE(decoder.write_assembled_file(output.path.string(), 3, supplied, record));
+    decoder.clear_decrypt_key();
+    secure_zero(std::span<std::byte>(key));
+
+    std::vector<std::byte> expected;
+    for (const auto &chunk: plain) {
+        expected.insert(expected.end(), chunk.begin(), chunk.end());
+    }
+    std::ifstream in(output.path, std::ios::binary);
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    ASSERT_EQ(bytes.size(), expected.size());
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), bytes.begin(),
+                           [](const std::byte a, const char b) { return a == static_cast<std::byte>(b); }));
+
+    // Only the chunks the decoder decoded are reported, already decrypted.
+    ASSERT_EQ(written.size(), 2u);
+    EXPECT_EQ(written[0].first, 0u);
+    EXPECT_EQ(written[0].second, plain[0]);
+    EXPECT_EQ(written[1].first, 2u);
+    EXPECT_EQ(written[1].second, plain[2]);
+}
+
 TEST(Roundtrip, EmptyData) {
     const std::vector<std::byte> original_data;
     const Encoder encoder(make_test_file_id());
@@ -0,0 +1,87 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "encoder.h"
+#include "manifest.h"
+#include "shard_plan.h"
+#include "test_util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+    ShardPlanParams make_params(const uint32_t chunk_count) {
+        ShardPlanParams params;
+        params.chunk_count = chunk_count;
+        params.chunk_bytes = 64 * 1024;
+        params.last_chunk_bytes = 1000;
+        params.file_info_bytes = 80;
+        return params;
+    }
+}
+
+TEST(ShardPlan, PacketCountMatchesEncoder) {
+    const Encoder encoder(make_test_id());
+    for (const std::size_t size: {std::size_t{0}, std::size_t{100}, std::size_t{4096}, std::size_t{70001}}) {
+        const std::vector<std::byte> data(size, std::byte{7});
+        EXPECT_EQ(encoder.packet_count(size), encoder.encode_chunk(0, data, true).first.size()) << size;
+        EXPECT_EQ(encoder.packet_count(size), encoder.encode_manifest_segment(0, data).size()) << size;
+    }
+}
+
+TEST(ShardPlan, SplitsAtChunkBoundaries) {
+    const Encoder encoder(make_test_id());
+    ShardPlanParams params = make_params(5);
+    const uint64_t chunk_packets = encoder.packet_count(params.chunk_bytes);
+    params.max_packets = 2 * chunk_packets + shard_manifest_packets(encoder, 2, params.file_info_bytes);
+
+    const auto plan = plan_shards(encoder, params);
+    ASSERT_EQ(plan.size(), 3u);
+    EXPECT_EQ(plan[0].first_chunk, 0u);
+    EXPECT_EQ(plan[0].chunk_count, 2u);
+    EXPECT_EQ(plan[1].first_chunk, 2u);
+    EXPECT_EQ(plan[1].chunk_count, 2u);
+    EXPECT_EQ(plan[2].first_chunk, 4u);
+    EXPECT_EQ(plan[2].chunk_count, 1u);
+
+    // One packet less and two full chunks no longer fit, but the short last
+    // chunk still shares a shard with its predecessor.
+    --params.max_packets;
+    const auto tight = plan_shards(encoder, params);
+    ASSERT_EQ(tight.size(), 4u);
+    EXPECT_EQ(tight[2].chunk_count, 1u);
+    EXPECT_EQ(tight[3].first_chunk, 3u);
+    EXPECT_EQ(tight[3].chunk_count, 2u);
+}
+
+TEST(ShardPlan, RejectsLimitBelowOneChunk) {
+    const Encoder encoder(make_test_id());
+    ShardPlanParams params = make_params(3);
+    params.max_packets = encoder.packet_count(params.chunk_bytes);
+    EXPECT_TRUE(plan_shards(encoder, params).empty());
+}
+
+TEST(ShardPlan, UnlimitedBudgetKeepsOneShard) {
+    const Encoder encoder(make_test_id());
+    ShardPlanParams params = make_params(100);
+    params.max_packets = UINT64_MAX;
+    const auto plan = plan_shards(encoder, params);
+    ASSERT_EQ(plan.size(), 1u);
+    EXPECT_EQ(plan[0].chunk_count, 100u);
+}
@@ -21,11 +21,14 @@
 #include "crypto.h"
 #include "decoder.h"
 #include "encoder.h"
+#include "follow_reader.h"
 #include "stream.h"
 #include "video_decoder.h"
 #include "video_encoder.h"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -34,6 +37,7 @@
 #include <optional>
 #include <span>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace {
@@ -116,8 +120,9 @@ namespace {
     }
 
     std::vector<std::byte> stream_decode_file(const std::string &flv_path,
-                                              const std::string &password = {}) {
-        VideoDecoder video_decoder(flv_path);
+                                              const std::string &password = {},
+                                              const VideoDecoderOptions &options = {}) {
+        VideoDecoder video_decoder(flv_path, options);
         Decoder decoder;
         std::size_t total_extracted = 0;
         std::size_t decoded_chunks = 0;
@@ -323,6 +328,206 @@ TEST(Stream, MKV_Roundtrip) {
     }
 }
 
+TEST(Stream, MKV_RawPacketTrackMatchesPixels) {
+    const TempFile mkv("test_mkv_raw_track.mkv");
+    const Encoder encoder(make_test_file_id());
+    const auto chunk = make_random_data(20000);
+    const auto [packets, manifest] = encoder.encode_chunk(0, chunk, true);
+
+    {
+        VideoEncoderOptions options;
+        options.raw_packet_track = true;
+        VideoEncoder video_encoder(mkv.path, FRAME_WIDTH, FRAME_HEIGHT, options);
+        video_encoder.encode_packets(packets);
+        video_encoder.finalize();
+    }
+
+    std::vector<std::vector<std::byte> > expected;
+    for (const Packet &packet: packets) {
+        expected.emplace_back(packet.bytes.begin(), packet.bytes.end());
+    }
+
+    VideoDecoder raw_decoder(mkv.path);
+    EXPECT_TRUE(raw_decoder.has_raw_packet_track());
+    EXPECT_TRUE(raw_decoder.reads_raw_packet_track());
+    EXPECT_EQ(raw_decoder.frame_width(), FRAME_WIDTH);
+    EXPECT_EQ(raw_decoder.decode_all_frames(), expected);
+
+    VideoDecoderOptions pixel_options;
+    pixel_options.use_raw_packet_track = false;
+    VideoDecoder pixel_decoder(mkv.path, pixel_options);
+    EXPECT_TRUE(pixel_decoder.has_raw_packet_track());
+    EXPECT_FALSE(pixel_decoder.reads_raw_packet_track());
+    EXPECT_EQ(pixel_decoder.decode_all_frames(), expected);
+    EXPECT_EQ(pixel_decoder.frames_read(), raw_decoder.frames_read());
+}
+
+TEST(Stream, MKV_SlicesTagBoundsDecoderThreads) {
+    const TempFile mkv("test_mkv_slices.mkv");
+    const Encoder encoder(make_test_file_id());
+    const auto chunk = make_random_data(20000);
+    const auto [packets, manifest] = encoder.encode_chunk(0, chunk, true);
+
+    {
+        VideoEncoderOptions options;
+        options.slices = 4;
+        VideoEncoder video_encoder(mkv.path, FRAME_WIDTH, FRAME_HEIGHT, options);
+        video_encoder.encode_packets(packets);
+        video_encoder.finalize();
+    }
+
+    std::vector<std::vector<std::byte> > expected;
+    for (const Packet &packet: packets) {
+        expected.emplace_back(packet.bytes.begin(), packet.bytes.end());
+    }
+
+    VideoDecoder video_decoder(mkv.path);
+    EXPECT_FALSE(video_decoder.frame_threaded());
+    EXPECT_GE(video_decoder.decoder_threads(), 1);
+    EXPECT_LE(video_decoder.decoder_threads(), 4);
+    EXPECT_EQ(video_decoder.decode_all_frames(), expected);
+}
+
+TEST(Stream, AdaptiveThreads_DecodeMatches) {
+    const auto original = make_random_data(32768);
+    const TempFile input("test_stream_adaptive_input.bin");
+    const TempFile flv("test_stream_adaptive.flv");
+    write_file(input.path, original);
+
+    ASSERT_NO_THROW(stream_encode_file(input.path, flv.path, 4000, 1280, 720));
+
+    VideoDecoderOptions options;
+    options.adaptive_threads = true;
+    EXPECT_EQ(stream_decode_file(flv.path, {}, options), original);
+
+    VideoDecoder video_decoder(flv.path, options);
+    EXPECT_EQ(video_decoder.extract_threads(), 0);
+    const auto packets = video_decoder.decode_all_frames();
+    EXPECT_FALSE(packets.empty());
+    ASSERT_GT(video_decoder.frames_read(), 40);
+    // The frames after the warm-up were measured and the team sized from them.
+    EXPECT_EQ(video_decoder.stage_times().frames, 32);
+    EXPECT_GE(video_decoder.extract_threads(), 1);
+}
+
+TEST(Stream, MKV_AudioDataTrackCarriesPackets) {
+    const TempFile mkv("test_mkv_audio_track.mkv");
+    const Encoder encoder(make_test_file_id());
+    const auto chunk = make_random_data(60000);
+    const auto [packets, manifest] = encoder.encode_chunk(0, chunk, true);
+
+    {
+        VideoEncoderOptions options;
+        options.audio_data_track = true;
+        options.raw_packet_track = true;
+        VideoEncoder video_encoder(mkv.path, FRAME_WIDTH, FRAME_HEIGHT, options);
+        video_encoder.encode_packets(packets);
+        video_encoder.finalize();
+    }
+
+    std::vector<std::vector<std::byte> > expected;
+    for (const Packet &packet: packets) {
+        expected.emplace_back(packet.bytes.begin(), packet.bytes.end());
+    }
+    std::ranges::sort(expected);
+
+    const auto per_frame = static_cast<std::size_t>(VideoEncoder::packets_per_frame() +
+                                                    VideoEncoder::audio_packets_per_frame());
+    for (const bool use_raw: {false, true}) {
+        VideoDecoderOptions options;
+        options.use_raw_packet_track = use_raw;
+        VideoDecoder video_decoder(mkv.path, options);
+        EXPECT_TRUE(video_decoder.has_audio_data_track());
+
+        // Pixel and audio packets of a frame time arrive in either order.
+        auto decoded = video_decoder.decode_all_frames();
+        std::ranges::sort(decoded);
+        EXPECT_EQ(decoded, expected) << "raw track: " << use_raw;
+        EXPECT_EQ(static_cast<std::size_t>(video_decoder.frames_read()),
+                  (packets.size() + per_frame - 1) / per_frame);
+    }
+}
+
+TEST(Stream, MKV_FollowGrowingFile) {
+    const auto original = make_random_data(CHUNK_SIZE_BYTES + 4096);
+    const TempFile input("test_mkv_follow_input.bin");
+    const TempFile mkv("test_mkv_follow_source.mkv");
+    const TempFile growing("test_mkv_follow_growing.mkv");
+    write_file(input.path, original);
+
+    {
+        const FileChunkReader reader(input.path.c_str());
+        const Encoder encoder(make_test_file_id());
+        VideoEncoder video_encoder(mkv.path);
+
+        for (std::size_t i = 0; i < reader.num_chunks(); ++i) {
+            auto chunk_data = reader.read_chunk(i);
+            const bool is_last = (i == reader.num_chunks() - 1);
+            auto [packets, manifest] = encoder.encode_chunk(
+                static_cast<uint32_t>(i), chunk_data, is_last);
+            video_encoder.encode_packets(packets);
+        }
+        video_encoder.finalize();
+    }
+
+    // Replay the finished recording into a second file in small pieces, the way a
+    // capture tool would, while the decoder is already reading it.
+    const auto encoded = read_file(mkv.path);
+    ASSERT_FALSE(encoded.empty());
+    std::ofstream out(growing.path, std::ios::binary);
+    ASSERT_TRUE(out.is_open());
+
+    std::thread writer([&out, &encoded] {
+        constexpr std::size_t step = 256 * 1024;
+        for (std::size_t offset = 0; offset < encoded.size(); offset += step) {
+            const std::size_t len = std::min(step, encoded.size() - offset);
+            out.write(reinterpret_cast<const char *>(encoded.data() + offset),
+                      static_cast<std::streamsize>(len));
+            out.flush();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+
+    VideoDecoderOptions options;
+    options.follow = true;
+    options.follow_idle_timeout_ms = 2000;
+    options.follow_poll_interval_ms = 20;
+
+    std::vector<std::byte> decoded;
+    EXPECT_NO_THROW(decoded = stream_decode_file(growing.path, {}, options));
+    writer.join();
+    EXPECT_EQ(decoded, original);
+}
+
+TEST(Stream, FollowReader_StopsWithoutIdleTimeout) {
+    const TempFile file("test_follow_reader_stop.bin");
+    write_file(file.path, make_random_data(100));
+
+    std::array<std::byte, 256> buffer{};
+    const auto started = std::chrono::steady_clock::now();
+    {
+        // A wait callback that declines ends the read at the next wait.
+        FollowReader reader(file.path, 60000, 20);
+        int waits = 0;
+        reader.set_wait_callback([&waits] { return ++waits < 3; });
+        EXPECT_EQ(reader.read(buffer.data(), buffer.size()), 100u);
+        EXPECT_EQ(reader.read(buffer.data(), buffer.size()), 0u);
+        EXPECT_EQ(waits, 3);
+    }
+    {
+        // stop() from another thread wakes a reader that is waiting.
+        FollowReader reader(file.path, 60000, 60000);
+        EXPECT_EQ(reader.read(buffer.data(), buffer.size()), 100u);
+        std::thread stopper([&reader] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            reader.stop();
+        });
+        EXPECT_EQ(reader.read(buffer.data(), buffer.size()), 0u);
+        stopper.join();
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(10));
+}
+
 TEST(Stream, Roundtrip_WithXXHash) {
     const auto original = make_random_data(65536);
     const TempFile input("test_stream_xxhash_input.bin");
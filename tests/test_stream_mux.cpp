@@ -0,0 +1,161 @@
+// This file is part of yt-media-storage, a tool for encoding media.
+// Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "stream_mux.h"
+#include "test_util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+    class RecordingSink final : public PacketSink {
+    public:
+        void encode_packets(const std::span<const Packet> packets) override {
+            if (fail) {
+                throw std::runtime_error("sink failed");
+            }
+            received.insert(received.end(), packets.begin(), packets.end());
+        }
+
+        void finalize() override { finalized = true; }
+
+        [[nodiscard]] int64_t frames_written() const override { return 0; }
+
+        std::vector<Packet> received;
+        bool finalized = false;
+        bool fail = false;
+    };
+}
+
+TEST(StreamMux, WeightsSplitCapacity) {
+    RecordingSink sink;
+    StreamMultiplexer mux(sink, 8, 1000);
+    const auto heavy = mux.add_lane(3.0);
+    const auto light = mux.add_lane(1.0);
+    ASSERT_EQ(mux.lane_count(), 2u);
+
+    ASSERT_TRUE(mux.submit(heavy, make_test_packets(0, 400)));
+    ASSERT_TRUE(mux.submit(light, make_test_packets(1, 400)));
+    mux.close_lane(heavy);
+    mux.close_lane(light);
+    mux.run();
+
+    ASSERT_EQ(sink.received.size(), 800u);
+    EXPECT_TRUE(sink.finalized);
+    EXPECT_EQ(mux.packets_written(heavy), 400u);
+    EXPECT_EQ(mux.packets_written(light), 400u);
+
+    // While both lanes have data, the heavy one gets three packets per light one.
+    std::size_t heavy_share = 0;
+    for (std::size_t i = 0; i < 400; ++i) {
+        heavy_share += test_packet_tag(sink.received[i]) == 0;
+    }
+    EXPECT_EQ(heavy_share, 300u);
+
+    // Each lane's packets keep their order.
+    std::size_t next[2] = {0, 0};
+    for (const Packet &packet: sink.received) {
+        ASSERT_EQ(test_packet_sequence(packet), next[test_packet_tag(packet)]++);
+    }
+}
+
+TEST(StreamMux, IdleLaneGivesUpItsShare) {
+    RecordingSink sink;
+    StreamMultiplexer mux(sink, 4, 1000);
+    const auto first = mux.add_lane(1.0);
+    const auto second = mux.add_lane(1.0);
+
+    ASSERT_TRUE(mux.submit(first, make_test_packets(0, 5)));
+    ASSERT_TRUE(mux.submit(second, make_test_packets(1, 50)));
+    mux.close_lane(first);
+    mux.close_lane(second);
+    mux.run();
+
+    ASSERT_EQ(sink.received.size(), 55u);
+    // Once the first lane runs dry the second fills the stream on its own.
+    for (std::size_t i = 10; i < sink.received.size(); ++i) {
+        EXPECT_EQ(test_packet_tag(sink.received[i]), 1u);
+    }
+}
+
+TEST(StreamMux, ConcurrentProducersThroughLaneSinks) {
+    RecordingSink sink;
+    StreamMultiplexer mux(sink, 4, 6);
+    StreamMultiplexer::LaneSink first(mux, mux.add_lane(1.0));
+    StreamMultiplexer::LaneSink second(mux, mux.add_lane(2.0));
+
+    const auto produce = [](PacketSink &lane, const uint8_t tag) {
+        const auto packets = make_test_packets(tag, 300);
+        for (std::size_t i = 0; i < packets.size(); i += 10) {
+            lane.encode_packets(std::span(packets).subspan(i, 10));
+        }
+        lane.finalize();
+    };
+    std::thread a(produce, std::ref(first), 0);
+    std::thread b(produce, std::ref(second), 1);
+    mux.run();
+    a.join();
+    b.join();
+
+    EXPECT_EQ(sink.received.size(), 600u);
+    EXPECT_TRUE(sink.finalized);
+    std::size_t next[2] = {0, 0};
+    for (const Packet &packet: sink.received) {
+        ASSERT_EQ(test_packet_sequence(packet), next[test_packet_tag(packet)]++);
+    }
+}
+
+TEST(StreamMux, StopReleasesProducers) {
+    RecordingSink sink;
+    StreamMultiplexer mux(sink, 4, 2);
+    const auto lane = mux.add_lane(1.0);
+    StreamMultiplexer::LaneSink lane_sink(mux, lane);
+
+    bool submitted = true;
+    std::thread producer([&] { submitted = mux.submit(lane, make_test_packets(0, 10)); });
+    mux.stop();
+    producer.join();
+    EXPECT_FALSE(submitted);
+
+    mux.run();
+    EXPECT_FALSE(sink.finalized);
+    EXPECT_THROW(lane_sink.encode_packets(make_test_packets(0, 1)), std::runtime_error);
+}
+
+TEST(StreamMux, SinkErrorStopsTheStream) {
+    RecordingSink sink;
+    sink.fail = true;
+    StreamMultiplexer mux(sink, 4, 100);
+    const auto lane = mux.add_lane(1.0);
+    ASSERT_TRUE(mux.submit(lane, make_test_packets(0, 10)));
+
+    EXPECT_THROW(mux.run(), std::runtime_error);
+    EXPECT_FALSE(mux.submit(lane, make_test_packets(0, 1)));
+}
+
+TEST(StreamMux, RejectsInvalidWeight) {
+    RecordingSink sink;
+    StreamMultiplexer mux(sink, 4, 4);
+    EXPECT_THROW(mux.add_lane(0.0), std::invalid_argument);
+    EXPECT_THROW(mux.add_lane(-1.0), std::invalid_argument);
+    EXPECT_EQ(mux.lane_count(), 0u);
+}
@@ -0,0 +1,100 @@
+/*
+ * This file is part of yt-media-storage, a tool for encoding media.
+ * Copyright (C) 2026 Brandon Li <https://brandonli.me/>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "encoder.h"
+#include "integrity.h"
+
+// Deterministic bytes; different seeds give different contents.
+inline std::vector<std::byte> make_test_bytes(const std::size_t size, const uint8_t seed = 0) {
+    std::vector<std::byte> data(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data[i] = std::byte{static_cast<uint8_t>((i * 29 + seed) % 251)};
+    }
+    return data;
+}
+
+// A file id whose bytes count up from base.
+inline std::array<std::byte, 16> make_test_id(const uint8_t base = 1) {
+    std::array<std::byte, 16> id{};
+    for (std::size_t i = 0; i < id.size(); ++i) {
+        id[i] = std::byte{static_cast<uint8_t>(base + i)};
+    }
+    return id;
+}
+
+// A digest-shaped value that is not the hash of anything; different seeds
+// give different digests.
+inline Sha256Digest make_test_digest(const uint8_t seed = 0) {
+    Sha256Digest digest;
+    for (std::size_t i = 0; i < digest.bytes.size(); ++i) {
+        digest.bytes[i] = std::byte{static_cast<uint8_t>(seed * 31 + i)};
+    }
+    return digest;
+}
+
+// Packets whose first bytes hold tag and their sequence number in the batch,
+// so a test can tell after reordering where each one came from.
+inline std::vector<Packet> make_test_packets(const uint8_t tag, const std::size_t count) {
+    std::vector<Packet> packets(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        packets[i].bytes[0] = std::byte{tag};
+        packets[i].bytes[1] = std::byte{static_cast<uint8_t>(i)};
+        packets[i].bytes[2] = std::byte{static_cast<uint8_t>(i >> 8)};
+    }
+    return packets;
+}
+
+inline uint8_t test_packet_tag(const Packet &packet) { return std::to_integer<uint8_t>(packet.bytes[0]); }
+
+inline std::size_t test_packet_sequence(const Packet &packet) {
+    return std::to_integer<std::size_t>(packet.bytes[1]) | std::to_integer<std::size_t>(packet.bytes[2]) << 8;
+}
+
+// A path under the temp directory that no other test, or other test process
+// under ctest -j, is using. Whatever ends up there is removed on destruction.
+struct TempPath {
+    std::filesystem::path path;
+
+    explicit TempPath(const std::string &prefix) {
+        static const uint64_t process_tag = std::random_device{}();
+        static std::atomic<uint32_t> counter{0};
+        path = std::filesystem::temp_directory_path() /
+               (prefix + "_" + std::to_string(process_tag) + "_" + std::to_string(counter.fetch_add(1)));
+    }
+
+    ~TempPath() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+
+    TempPath(const TempPath &) = delete;
+
+    TempPath &operator=(const TempPath &) = delete;
+};